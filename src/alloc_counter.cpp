@@ -0,0 +1,102 @@
+#include "alloc_counter.h"
+
+#ifdef MATRIX_COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace {
+
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_deallocations{0};
+std::atomic<uint64_t> g_bytes{0};
+
+void* CountedAllocate(size_t size, size_t alignment) {
+    if (size == 0) size = 1;
+
+    // Relaxed is enough: the counters are only ever read as a snapshot
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    if (alignment <= alignof(std::max_align_t)) {
+        return std::malloc(size);
+    }
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    // aligned_alloc requires the size to be a multiple of the alignment
+    return std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+#endif
+}
+
+void CountedFree(void* ptr, size_t alignment) noexcept {
+    if (!ptr) return;
+
+    g_deallocations.fetch_add(1, std::memory_order_relaxed);
+
+#ifdef _WIN32
+    if (alignment > alignof(std::max_align_t)) {
+        _aligned_free(ptr);
+        return;
+    }
+#else
+    (void)alignment;
+#endif
+    std::free(ptr);
+}
+
+void* CountedNew(size_t size, size_t alignment) {
+    void* ptr = CountedAllocate(size, alignment);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+} // namespace
+
+AllocationStats GetAllocationStats() {
+    AllocationStats stats;
+    stats.allocations = g_allocations.load(std::memory_order_relaxed);
+    stats.deallocations = g_deallocations.load(std::memory_order_relaxed);
+    stats.bytes = g_bytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+constexpr size_t DEFAULT_ALIGNMENT = alignof(std::max_align_t);
+
+void* operator new(size_t size) { return CountedNew(size, DEFAULT_ALIGNMENT); }
+void* operator new[](size_t size) { return CountedNew(size, DEFAULT_ALIGNMENT); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return CountedAllocate(size, DEFAULT_ALIGNMENT); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return CountedAllocate(size, DEFAULT_ALIGNMENT); }
+void* operator new(size_t size, std::align_val_t align) { return CountedNew(size, static_cast<size_t>(align)); }
+void* operator new[](size_t size, std::align_val_t align) { return CountedNew(size, static_cast<size_t>(align)); }
+void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return CountedAllocate(size, static_cast<size_t>(align));
+}
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return CountedAllocate(size, static_cast<size_t>(align));
+}
+
+void operator delete(void* ptr) noexcept { CountedFree(ptr, DEFAULT_ALIGNMENT); }
+void operator delete[](void* ptr) noexcept { CountedFree(ptr, DEFAULT_ALIGNMENT); }
+void operator delete(void* ptr, size_t) noexcept { CountedFree(ptr, DEFAULT_ALIGNMENT); }
+void operator delete[](void* ptr, size_t) noexcept { CountedFree(ptr, DEFAULT_ALIGNMENT); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { CountedFree(ptr, DEFAULT_ALIGNMENT); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { CountedFree(ptr, DEFAULT_ALIGNMENT); }
+void operator delete(void* ptr, std::align_val_t align) noexcept { CountedFree(ptr, static_cast<size_t>(align)); }
+void operator delete[](void* ptr, std::align_val_t align) noexcept { CountedFree(ptr, static_cast<size_t>(align)); }
+void operator delete(void* ptr, size_t, std::align_val_t align) noexcept { CountedFree(ptr, static_cast<size_t>(align)); }
+void operator delete[](void* ptr, size_t, std::align_val_t align) noexcept { CountedFree(ptr, static_cast<size_t>(align)); }
+void operator delete(void* ptr, std::align_val_t align, const std::nothrow_t&) noexcept {
+    CountedFree(ptr, static_cast<size_t>(align));
+}
+void operator delete[](void* ptr, std::align_val_t align, const std::nothrow_t&) noexcept {
+    CountedFree(ptr, static_cast<size_t>(align));
+}
+
+#endif // MATRIX_COUNT_ALLOCATIONS
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+// Process-wide heap allocation counters.
+//
+// Built with MATRIX_COUNT_ALLOCATIONS, alloc_counter.cpp replaces the global
+// operator new/delete with versions that count every call. Without it these
+// functions compile to constants and the default allocator is untouched.
+struct AllocationStats {
+    uint64_t allocations = 0;   // operator new calls since startup
+    uint64_t deallocations = 0; // operator delete calls since startup
+    uint64_t bytes = 0;         // Bytes requested since startup
+};
+
+#ifdef MATRIX_COUNT_ALLOCATIONS
+
+AllocationStats GetAllocationStats();
+constexpr bool IsAllocationCountingEnabled() { return true; }
+
+#else
+
+inline AllocationStats GetAllocationStats() { return {}; }
+constexpr bool IsAllocationCountingEnabled() { return false; }
+
+#endif
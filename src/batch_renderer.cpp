@@ -1,5 +1,81 @@
 #include "batch_renderer.h"
 #include "logger.h"
+#include <algorithm>
+#include <cstddef>
+
+// GlyphRun offsets are handed to DirectWrite as-is
+static_assert(sizeof(GlyphRunOffset) == sizeof(DWRITE_GLYPH_OFFSET), "GlyphRunOffset must match DWRITE_GLYPH_OFFSET");
+static_assert(offsetof(GlyphRunOffset, ascenderOffset) == offsetof(DWRITE_GLYPH_OFFSET, ascenderOffset),
+              "GlyphRunOffset must match DWRITE_GLYPH_OFFSET");
+
+namespace {
+
+// The text of one glyph, as the system font fallback reads it. Lives on the
+// stack for a single MapCharacters call, so references are not counted.
+class GlyphTextSource : public IDWriteTextAnalysisSource {
+public:
+    GlyphTextSource(const std::wstring& text, const wchar_t* localeName)
+        : m_text(text), m_localeName(localeName) {}
+    
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override {
+        if (riid == __uuidof(IUnknown) || riid == __uuidof(IDWriteTextAnalysisSource)) {
+            *object = this;
+            return S_OK;
+        }
+        *object = nullptr;
+        return E_NOINTERFACE;
+    }
+    ULONG STDMETHODCALLTYPE AddRef() override { return 1; }
+    ULONG STDMETHODCALLTYPE Release() override { return 1; }
+    
+    HRESULT STDMETHODCALLTYPE GetTextAtPosition(UINT32 textPosition, const WCHAR** textString,
+                                                UINT32* textLength) override {
+        if (textPosition >= m_text.length()) {
+            *textString = nullptr;
+            *textLength = 0;
+        } else {
+            *textString = m_text.c_str() + textPosition;
+            *textLength = static_cast<UINT32>(m_text.length()) - textPosition;
+        }
+        return S_OK;
+    }
+    
+    HRESULT STDMETHODCALLTYPE GetTextBeforePosition(UINT32 textPosition, const WCHAR** textString,
+                                                    UINT32* textLength) override {
+        if (textPosition == 0 || textPosition > m_text.length()) {
+            *textString = nullptr;
+            *textLength = 0;
+        } else {
+            *textString = m_text.c_str();
+            *textLength = textPosition;
+        }
+        return S_OK;
+    }
+    
+    DWRITE_READING_DIRECTION STDMETHODCALLTYPE GetParagraphReadingDirection() override {
+        return DWRITE_READING_DIRECTION_LEFT_TO_RIGHT;
+    }
+    
+    HRESULT STDMETHODCALLTYPE GetLocaleName(UINT32 textPosition, UINT32* textLength,
+                                            const WCHAR** localeName) override {
+        *textLength = static_cast<UINT32>(m_text.length()) - std::min<UINT32>(textPosition, static_cast<UINT32>(m_text.length()));
+        *localeName = m_localeName;
+        return S_OK;
+    }
+    
+    HRESULT STDMETHODCALLTYPE GetNumberSubstitution(UINT32 textPosition, UINT32* textLength,
+                                                    IDWriteNumberSubstitution** numberSubstitution) override {
+        *textLength = static_cast<UINT32>(m_text.length()) - std::min<UINT32>(textPosition, static_cast<UINT32>(m_text.length()));
+        *numberSubstitution = nullptr;
+        return S_OK;
+    }
+
+private:
+    const std::wstring& m_text;
+    const wchar_t* m_localeName;
+};
+
+} // namespace
 
 BatchRenderer::BatchRenderer() {
 }
@@ -11,7 +87,7 @@ void BatchRenderer::Initialize(size_t maxBatchSize) {
     m_maxBatchSize = maxBatchSize;
     m_batches.reserve(50); // Pre-allocate for common batch count
     
-    LOG_DEBUG("BatchRenderer initialized with max batch size: " + std::to_string(maxBatchSize));
+    LOG_DEBUG("BatchRenderer initialized with max batch size: {}", maxBatchSize);
 }
 
 void BatchRenderer::Reset() {
@@ -21,11 +97,11 @@ void BatchRenderer::Reset() {
     m_totalCharacters = 0;
 }
 
-void BatchRenderer::AddCharacter(const std::wstring& character,
+void BatchRenderer::AddCharacter(GlyphId glyph,
                                 const D2D1_RECT_F& position,
                                 const D2D1_COLOR_F& color,
                                 float fontSize) {
-    if (!m_enabled) return;
+    if (!m_enabled || glyph == INVALID_GLYPH) return;
     
     // Create batch key
     BatchKey key;
@@ -33,7 +109,7 @@ void BatchRenderer::AddCharacter(const std::wstring& character,
     key.fontSize = static_cast<int>(fontSize);
     
     // Get or create batch
-    auto& batch = m_batches[key];
+    auto& batch = m_batches.try_emplace(key, m_frameArena).first->second;
     
     // Initialize batch if new
     if (batch.positions.empty()) {
@@ -42,9 +118,9 @@ void BatchRenderer::AddCharacter(const std::wstring& character,
         batch.Reserve(m_maxBatchSize / 10); // Estimate characters per batch
     }
     
-    // Add character to batch
-    batch.text += character;
-    batch.positions.push_back(position);
+    // Add glyph to batch; glyph and position indices always line up
+    batch.glyphs.push_back(glyph);
+    batch.positions.push_back({position.left, position.top, position.right, position.bottom});
     m_totalCharacters++;
     
     // Flush if batch is full
@@ -61,6 +137,11 @@ void BatchRenderer::Flush(ID2D1RenderTarget* renderTarget,
     }
     
     size_t charactersRendered = 0;
+    m_drawCalls = 0;
+    m_flushedBatches = 0;
+    
+    IDWriteFontFace* fontFace = GetOrCreateFontFace(writeFactory, defaultFormat);
+    GlyphRun run(m_frameArena);
     
     for (auto& [key, batch] : m_batches) {
         if (batch.positions.empty()) continue;
@@ -71,29 +152,40 @@ void BatchRenderer::Flush(ID2D1RenderTarget* renderTarget,
         
         if (!brush || !format) continue;
         
-        // For batch rendering, we can either:
-        // 1. Draw each character individually (current approach but batched by color/size)
-        // 2. Create a single text layout with positioned glyphs (more complex but faster)
-        
-        // Option 1: Individual character drawing (batched by properties)
-        for (size_t i = 0; i < batch.positions.size() && i < batch.text.length(); ++i) {
-            wchar_t singleChar[2] = { batch.text[i], L'\0' };
+        if (fontFace) {
+            // Draw every glyph of the batch with positioned glyph runs
+            ResolveGlyphs(batch);
+            GlyphRunBuilder::Build(batch.glyphs.data(), batch.positions.data(), batch.glyphs.size(),
+                                   batch.fontSize, m_glyphMetrics, run);
             
-            renderTarget->DrawText(
-                singleChar,
-                1,
-                format,
-                &batch.positions[i],
-                brush
-            );
-            
-            charactersRendered++;
+            // One draw per face: the format's font, then any fallback fonts
+            for (const GlyphRunSpan& span : run.spans) {
+                const ResolvedFontFace& face = m_fontFaces[span.fontFace];
+                
+                DWRITE_GLYPH_RUN glyphRun = {};
+                glyphRun.fontFace = face.face.Get();
+                glyphRun.fontEmSize = batch.fontSize * face.scale;
+                glyphRun.glyphCount = static_cast<UINT32>(span.count);
+                glyphRun.glyphIndices = run.indices.data() + span.first;
+                glyphRun.glyphAdvances = run.advances.data() + span.first;
+                glyphRun.glyphOffsets = reinterpret_cast<const DWRITE_GLYPH_OFFSET*>(run.offsets.data() + span.first);
+                
+                renderTarget->DrawGlyphRun(D2D1::Point2F(0.0f, 0.0f), &glyphRun, brush);
+                m_drawCalls++;
+            }
+        } else {
+            // No font face: everything goes through the text fallback
+            GlyphRunBuilder::Build(batch.glyphs.data(), batch.positions.data(), batch.glyphs.size(),
+                                   batch.fontSize, GlyphMetricsCache(), run);
         }
+        
+        DrawFallbackText(renderTarget, batch, run, format, brush);
+        charactersRendered += batch.glyphs.size();
+        m_flushedBatches++;
     }
     
     if (charactersRendered > 0) {
-        LOG_DEBUG("BatchRenderer flushed " + std::to_string(charactersRendered) + 
-                 " characters in " + std::to_string(m_batches.size()) + " batches");
+        LOG_DEBUG("BatchRenderer flushed {} characters in {} draw calls", charactersRendered, m_drawCalls);
     }
     
     // Clear batches for next frame
@@ -172,4 +264,186 @@ IDWriteTextFormat* BatchRenderer::GetOrCreateFormat(IDWriteFactory* writeFactory
     }
     
     return defaultFormat;
+}
+
+IDWriteFontFace* BatchRenderer::GetOrCreateFontFace(IDWriteFactory* writeFactory,
+                                                    IDWriteTextFormat* defaultFormat) {
+    if (!writeFactory || !defaultFormat) return nullptr;
+    
+    if (m_fontFaceFormat.Get() == defaultFormat) {
+        return m_fontFaces.empty() ? nullptr : m_fontFaces[0].face.Get();
+    }
+    
+    // New default format: glyph indices and metrics belong to the old fonts
+    m_fontFaceFormat = defaultFormat;
+    m_fontFaces.clear();
+    m_glyphMetrics.Clear();
+    m_fontFallback.Reset();
+    m_fontCollection.Reset();
+    
+    defaultFormat->GetFontCollection(&m_fontCollection);
+    if (!m_fontCollection) {
+        writeFactory->GetSystemFontCollection(&m_fontCollection);
+    }
+    if (!m_fontCollection) return nullptr;
+    
+    WCHAR fontName[256];
+    defaultFormat->GetFontFamilyName(fontName, 256);
+    m_fontFamilyName = fontName;
+    
+    WCHAR localeName[LOCALE_NAME_MAX_LENGTH] = {};
+    defaultFormat->GetLocaleName(localeName, LOCALE_NAME_MAX_LENGTH);
+    m_localeName = localeName;
+    
+    UINT32 familyIndex = 0;
+    BOOL exists = FALSE;
+    HRESULT hr = m_fontCollection->FindFamilyName(fontName, &familyIndex, &exists);
+    if (FAILED(hr) || !exists) {
+        LOG_WARNING("BatchRenderer: font family not found, using text fallback");
+        return nullptr;
+    }
+    
+    ResolvedFontFace primary;
+    Microsoft::WRL::ComPtr<IDWriteFontFamily> family;
+    hr = m_fontCollection->GetFontFamily(familyIndex, &family);
+    if (SUCCEEDED(hr)) {
+        hr = family->GetFirstMatchingFont(defaultFormat->GetFontWeight(),
+                                          defaultFormat->GetFontStretch(),
+                                          defaultFormat->GetFontStyle(),
+                                          &primary.font);
+    }
+    if (SUCCEEDED(hr)) {
+        hr = primary.font->CreateFontFace(&primary.face);
+    }
+    if (FAILED(hr)) {
+        LOG_WARNING("BatchRenderer: failed to create font face, using text fallback");
+        return nullptr;
+    }
+    
+    DWRITE_FONT_METRICS fontMetrics = {};
+    primary.face->GetMetrics(&fontMetrics);
+    if (fontMetrics.designUnitsPerEm > 0) {
+        float unitsPerEm = static_cast<float>(fontMetrics.designUnitsPerEm);
+        m_glyphMetrics.SetFontMetrics(fontMetrics.ascent / unitsPerEm, fontMetrics.descent / unitsPerEm);
+    }
+    m_fontFaces.push_back(std::move(primary));
+    
+    // The system fallback (Windows 8.1 and later) finds fonts for what the
+    // format's font lacks, the katakana in most Latin fonts; without it those
+    // glyphs are drawn as text
+    Microsoft::WRL::ComPtr<IDWriteFactory2> factory2;
+    if (SUCCEEDED(writeFactory->QueryInterface(IID_PPV_ARGS(&factory2)))) {
+        factory2->GetSystemFontFallback(&m_fontFallback);
+    }
+    if (!m_fontFallback) {
+        LOG_WARNING("BatchRenderer: no system font fallback, glyphs missing from the font use text fallback");
+    }
+    
+    return m_fontFaces[0].face.Get();
+}
+
+void BatchRenderer::ResolveGlyphs(const CharacterBatch& batch) {
+    if (m_fontFaces.empty()) return;
+    
+    const GlyphTable& table = GlyphTable::Instance();
+    
+    for (GlyphId glyph : batch.glyphs) {
+        if (m_glyphMetrics.IsResolved(glyph)) continue;
+        
+        GlyphMetrics metrics;
+        
+        // Only a single code point maps to a single font glyph; anything
+        // else (or a glyph no font has) is left to DrawText
+        const std::wstring& text = table.GetGlyph(glyph);
+        UINT32 codePoint = 0;
+        bool single = false;
+        if (text.length() == 1 && (text[0] < 0xD800 || text[0] > 0xDFFF)) {
+            codePoint = text[0];
+            single = true;
+        } else if (text.length() == 2 && text[0] >= 0xD800 && text[0] <= 0xDBFF &&
+                   text[1] >= 0xDC00 && text[1] <= 0xDFFF) {
+            codePoint = 0x10000 + ((static_cast<UINT32>(text[0]) - 0xD800) << 10) + (text[1] - 0xDC00);
+            single = true;
+        }
+        
+        size_t faceIndex = 0;
+        if (single && FindFontFace(text, codePoint, faceIndex)) {
+            const ResolvedFontFace& face = m_fontFaces[faceIndex];
+            
+            DWRITE_FONT_METRICS fontMetrics = {};
+            face.face->GetMetrics(&fontMetrics);
+            float unitsPerEm = fontMetrics.designUnitsPerEm > 0 ? static_cast<float>(fontMetrics.designUnitsPerEm) : 1.0f;
+            
+            UINT16 glyphIndex = 0;
+            DWRITE_GLYPH_METRICS glyphMetrics = {};
+            if (SUCCEEDED(face.face->GetGlyphIndices(&codePoint, 1, &glyphIndex)) && glyphIndex != 0 &&
+                SUCCEEDED(face.face->GetDesignGlyphMetrics(&glyphIndex, 1, &glyphMetrics, FALSE))) {
+                metrics.fontGlyphIndex = glyphIndex;
+                metrics.fontFace = static_cast<uint8_t>(faceIndex);
+                metrics.advance = glyphMetrics.advanceWidth / unitsPerEm * face.scale;
+                metrics.drawable = true;
+            }
+        }
+        
+        m_glyphMetrics.Set(glyph, metrics);
+    }
+}
+
+bool BatchRenderer::FindFontFace(const std::wstring& text, UINT32 codePoint, size_t& faceIndex) {
+    // A face already in use is preferred, so a batch keeps to as few draws as it can
+    for (size_t i = 0; i < m_fontFaces.size(); ++i) {
+        BOOL exists = FALSE;
+        if (SUCCEEDED(m_fontFaces[i].font->HasCharacter(codePoint, &exists)) && exists) {
+            faceIndex = i;
+            return true;
+        }
+    }
+    
+    if (!m_fontFallback || m_fontFaces.size() >= MAX_GLYPH_FONT_FACES) return false;
+    
+    // Ask the system fallback, as DrawText would, for a font that has it
+    GlyphTextSource source(text, m_localeName.c_str());
+    UINT32 mappedLength = 0;
+    ResolvedFontFace fallback;
+    HRESULT hr = m_fontFallback->MapCharacters(&source, 0, static_cast<UINT32>(text.length()),
+                                               m_fontCollection.Get(), m_fontFamilyName.c_str(),
+                                               m_fontFaceFormat->GetFontWeight(),
+                                               m_fontFaceFormat->GetFontStyle(),
+                                               m_fontFaceFormat->GetFontStretch(),
+                                               &mappedLength, &fallback.font, &fallback.scale);
+    if (FAILED(hr) || !fallback.font || mappedLength < text.length()) return false;
+    
+    BOOL exists = FALSE;
+    if (FAILED(fallback.font->HasCharacter(codePoint, &exists)) || !exists ||
+        FAILED(fallback.font->CreateFontFace(&fallback.face))) {
+        return false;
+    }
+    
+    faceIndex = m_fontFaces.size();
+    m_fontFaces.push_back(std::move(fallback));
+    LOG_DEBUG("BatchRenderer: font fallback added face {} for U+{:04X}", faceIndex, codePoint);
+    return true;
+}
+
+void BatchRenderer::DrawFallbackText(ID2D1RenderTarget* renderTarget,
+                                     const CharacterBatch& batch,
+                                     const GlyphRun& run,
+                                     IDWriteTextFormat* format,
+                                     ID2D1SolidColorBrush* brush) {
+    const GlyphTable& table = GlyphTable::Instance();
+    
+    for (size_t index : run.fallback) {
+        // Draw the whole glyph string, however many code units it spans
+        const std::wstring& text = table.GetGlyph(batch.glyphs[index]);
+        const GlyphCellRect& rect = batch.positions[index];
+        
+        renderTarget->DrawText(
+            text.c_str(),
+            static_cast<UINT32>(text.length()),
+            format,
+            D2D1::RectF(rect.left, rect.top, rect.right, rect.bottom),
+            brush
+        );
+        m_drawCalls++;
+    }
 }
\ No newline at end of file
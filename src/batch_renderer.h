@@ -1,22 +1,34 @@
 #pragma once
 
 #include "common.h"
+#include "frame_arena.h"
+#include "glyph_run_builder.h"
+#include <dwrite_2.h>
+#include <string>
 #include <vector>
 #include <unordered_map>
 
+// Per-frame batch; glyphs and positions live in the renderer's frame arena.
+// glyphs[i] is drawn centered in positions[i].
 struct CharacterBatch {
-    std::wstring text;
-    std::vector<D2D1_RECT_F> positions;
+    FrameVector<GlyphId> glyphs;
+    FrameVector<GlyphCellRect> positions;
     D2D1_COLOR_F color;
     float fontSize;
     
+    explicit CharacterBatch(FrameArena* arena = nullptr)
+        : glyphs(ArenaAllocator<GlyphId>(arena)),
+          positions(ArenaAllocator<GlyphCellRect>(arena)) {}
+    
+    // Drop storage rather than just clearing, since the arena is reset at
+    // the end of every frame and must not be referenced afterwards
     void Clear() {
-        text.clear();
-        positions.clear();
+        glyphs = FrameVector<GlyphId>(glyphs.get_allocator());
+        positions = FrameVector<GlyphCellRect>(positions.get_allocator());
     }
     
     void Reserve(size_t capacity) {
-        text.reserve(capacity);
+        glyphs.reserve(capacity);
         positions.reserve(capacity);
     }
 };
@@ -29,22 +41,27 @@ public:
     void Initialize(size_t maxBatchSize = 1000);
     void Reset();
     
-    // Add a character to the batch
-    void AddCharacter(const std::wstring& character, 
+    // Add an interned glyph to the batch
+    void AddCharacter(GlyphId glyph,
                      const D2D1_RECT_F& position,
                      const D2D1_COLOR_F& color,
                      float fontSize);
     
-    // Flush all batches to the render target
+    // Flush all batches to the render target, one glyph run per batch and font face
     void Flush(ID2D1RenderTarget* renderTarget,
               IDWriteFactory* writeFactory,
               IDWriteTextFormat* defaultFormat);
     
     size_t GetBatchCount() const { return m_batches.size(); }
     size_t GetTotalCharacters() const { return m_totalCharacters; }
+    size_t GetDrawCallCount() const { return m_drawCalls; } // Draw calls issued by the last Flush
+    size_t GetFlushedBatchCount() const { return m_flushedBatches; } // Non-empty batches in the last Flush
     
     void SetEnabled(bool enabled) { m_enabled = enabled; }
     bool IsEnabled() const { return m_enabled; }
+    
+    // Arena used for per-frame batch storage (nullptr uses the heap)
+    void SetFrameArena(FrameArena* arena) { m_frameArena = arena; }
 
 private:
     struct BatchKey {
@@ -64,8 +81,11 @@ private:
     };
     
     bool m_enabled = false;
+    FrameArena* m_frameArena = nullptr;
     size_t m_maxBatchSize = 1000;
     size_t m_totalCharacters = 0;
+    size_t m_drawCalls = 0;
+    size_t m_flushedBatches = 0;
     
     // Batches grouped by color and font size
     std::unordered_map<BatchKey, CharacterBatch, BatchKeyHash> m_batches;
@@ -76,10 +96,41 @@ private:
     // Cached text formats for different font sizes
     std::unordered_map<int, Microsoft::WRL::ComPtr<IDWriteTextFormat>> m_formatCache;
     
+    // A face glyphs are drawn from; scale is the size the system font
+    // fallback asks for relative to the format's font
+    struct ResolvedFontFace {
+        Microsoft::WRL::ComPtr<IDWriteFont> font;
+        Microsoft::WRL::ComPtr<IDWriteFontFace> face;
+        float scale = 1.0f;
+    };
+    
+    // Font faces behind the default format, and em-unit glyph metrics for
+    // them. Face 0 is the format's font; glyphs it lacks are mapped through
+    // the system font fallback and the faces found are added after it. The
+    // format is held so a recreated one is never mistaken for it.
+    Microsoft::WRL::ComPtr<IDWriteTextFormat> m_fontFaceFormat;
+    std::vector<ResolvedFontFace> m_fontFaces;
+    GlyphMetricsCache m_glyphMetrics;
+    
+    // What the fallback maps from: the format's collection, family, style and locale
+    Microsoft::WRL::ComPtr<IDWriteFontFallback> m_fontFallback;
+    Microsoft::WRL::ComPtr<IDWriteFontCollection> m_fontCollection;
+    std::wstring m_fontFamilyName;
+    std::wstring m_localeName;
+    
     UINT32 ColorToHash(const D2D1_COLOR_F& color) const;
     ID2D1SolidColorBrush* GetOrCreateBrush(ID2D1RenderTarget* renderTarget, 
                                            const D2D1_COLOR_F& color);
     IDWriteTextFormat* GetOrCreateFormat(IDWriteFactory* writeFactory,
                                         float fontSize,
                                         IDWriteTextFormat* defaultFormat);
+    IDWriteFontFace* GetOrCreateFontFace(IDWriteFactory* writeFactory,
+                                        IDWriteTextFormat* defaultFormat);
+    void ResolveGlyphs(const CharacterBatch& batch);
+    bool FindFontFace(const std::wstring& text, UINT32 codePoint, size_t& faceIndex);
+    void DrawFallbackText(ID2D1RenderTarget* renderTarget,
+                         const CharacterBatch& batch,
+                         const GlyphRun& run,
+                         IDWriteTextFormat* format,
+                         ID2D1SolidColorBrush* brush);
 };
\ No newline at end of file
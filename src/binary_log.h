@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+// Binary structured log format (.mlog).
+//
+// A file is a sequence of sessions, one per logger start, each beginning with
+// a session record that anchors the raw tick counter to wall-clock time.
+// Format strings are written once per session as definition records; messages
+// then carry only the format ID, a raw tick count and their packed arguments.
+// Integers are little-endian and records are unaligned. matrix_logdump
+// (tools/) turns a file back into the text log layout.
+//
+//   Session:  kind, magic[4], version u16, ticksPerSecond i64,
+//             startTicks i64, startWallClockUs i64 (Unix epoch)
+//   Format:   kind, id u16, length u16, text[length]
+//   Message:  kind, level u8, formatId u16, ticks i64, length u16, payload
+//   Dropped:  kind, ticks i64, count u64
+//
+// Format ID 0 is reserved for plain messages, whose payload is the text itself.
+
+constexpr char BINARY_LOG_MAGIC[4] = { 'M', 'X', 'B', 'L' };
+constexpr uint16_t BINARY_LOG_VERSION = 1;
+constexpr uint16_t BINARY_LOG_PLAIN_FORMAT = 0;
+
+enum class BinaryLogRecordKind : uint8_t {
+    Session = 1,
+    Format = 2,
+    Message = 3,
+    Dropped = 4
+};
+
+// Tag byte in front of every packed argument
+enum class BinaryLogArgType : uint8_t {
+    Int = 1,        // int64
+    UInt = 2,       // uint64
+    Double = 3,     // IEEE double
+    Bool = 4,       // uint8
+    Char = 5,       // uint8
+    String = 6,     // u16 length + bytes
+    Pointer = 7     // uint64
+};
+
+// Packs format arguments into a fixed buffer (a logger queue slot). Arguments
+// that no longer fit are dropped and the decoder shows them as "{?}"; strings
+// are cut to the space left.
+class BinaryArgWriter {
+public:
+    BinaryArgWriter(char* buffer, size_t capacity)
+        : m_buffer(buffer), m_capacity(capacity) {}
+
+    size_t GetLength() const { return m_length; }
+
+    template<typename T>
+    void Add(const T& value) {
+        using Type = std::remove_cvref_t<T>;
+
+        if constexpr (std::is_same_v<Type, bool>) {
+            AddScalar(BinaryLogArgType::Bool, static_cast<uint8_t>(value));
+        } else if constexpr (std::is_same_v<Type, char>) {
+            AddScalar(BinaryLogArgType::Char, static_cast<uint8_t>(value));
+        } else if constexpr (std::is_integral_v<Type> && std::is_signed_v<Type>) {
+            AddScalar(BinaryLogArgType::Int, static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral_v<Type>) {
+            AddScalar(BinaryLogArgType::UInt, static_cast<uint64_t>(value));
+        } else if constexpr (std::is_enum_v<Type>) {
+            Add(static_cast<std::underlying_type_t<Type>>(value));
+        } else if constexpr (std::is_floating_point_v<Type>) {
+            AddScalar(BinaryLogArgType::Double, static_cast<double>(value));
+        } else if constexpr (std::is_convertible_v<const Type&, std::string_view>) {
+            AddString(std::string_view(value));
+        } else if constexpr (std::is_pointer_v<Type> || std::is_null_pointer_v<Type>) {
+            AddScalar(BinaryLogArgType::Pointer, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+        } else {
+            static_assert(sizeof(Type) == 0, "Binary logging supports arithmetic, string and pointer arguments only");
+        }
+    }
+
+private:
+    template<typename T>
+    void AddScalar(BinaryLogArgType type, T value) {
+        if (m_full || m_length + 1 + sizeof(T) > m_capacity) {
+            m_full = true;
+            return;
+        }
+        m_buffer[m_length++] = static_cast<char>(type);
+        std::memcpy(m_buffer + m_length, &value, sizeof(T));
+        m_length += sizeof(T);
+    }
+
+    void AddString(std::string_view text) {
+        if (m_full || m_length + 1 + sizeof(uint16_t) > m_capacity) {
+            m_full = true;
+            return;
+        }
+        size_t room = m_capacity - m_length - 1 - sizeof(uint16_t);
+        uint16_t length = static_cast<uint16_t>(std::min<size_t>({ text.size(), room, UINT16_MAX }));
+
+        m_buffer[m_length++] = static_cast<char>(BinaryLogArgType::String);
+        std::memcpy(m_buffer + m_length, &length, sizeof(length));
+        m_length += sizeof(length);
+        std::memcpy(m_buffer + m_length, text.data(), length);
+        m_length += length;
+    }
+
+    char* m_buffer;
+    size_t m_capacity;
+    size_t m_length = 0;
+    bool m_full = false;    // Later arguments are dropped, never partially written
+};
@@ -0,0 +1,503 @@
+#include "binary_log_reader.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <ctime>
+
+namespace {
+
+const char* GetLevelString(uint8_t level) {
+    switch (level) {
+        case 0:  return "[DEBUG]";
+        case 1:  return "[INFO] ";
+        case 2:  return "[WARN] ";
+        case 3:  return "[ERROR]";
+        default: return "[UNKN] ";
+    }
+}
+
+bool IsIntegerPresentation(char type) {
+    return type == 'd' || type == 'x' || type == 'X' || type == 'b' || type == 'B' ||
+           type == 'o' || type == 'c';
+}
+
+// Digits of `value` in the base selected by the presentation type, plus the
+// matching '#' prefix
+void FormatUnsigned(uint64_t value, char type, bool alternate, std::string& prefix, std::string& digits) {
+    int base = 10;
+    switch (type) {
+        case 'x': case 'X': base = 16; if (alternate) prefix += (type == 'x') ? "0x" : "0X"; break;
+        case 'b': case 'B': base = 2;  if (alternate) prefix += (type == 'b') ? "0b" : "0B"; break;
+        case 'o':           base = 8;  if (alternate && value != 0) prefix += '0'; break;
+        default: break;
+    }
+
+    char buffer[72];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, base);
+    digits.assign(buffer, result.ptr);
+    if (type == 'X') {
+        std::transform(digits.begin(), digits.end(), digits.begin(), [](char c) { return static_cast<char>(std::toupper(c)); });
+    }
+}
+
+void FormatDouble(double value, char type, int precision, std::string& digits) {
+    char buffer[400];
+    std::to_chars_result result;
+
+    switch (type) {
+        case 'f': case 'F':
+            result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, precision < 0 ? 6 : precision);
+            break;
+        case 'e': case 'E':
+            result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::scientific, precision < 0 ? 6 : precision);
+            break;
+        case 'g': case 'G':
+            result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, precision < 0 ? 6 : precision);
+            break;
+        case 'a': case 'A':
+            result = precision < 0
+                ? std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::hex)
+                : std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::hex, precision);
+            break;
+        default:
+            // std::format's default: shortest round-trip form
+            result = precision < 0
+                ? std::to_chars(buffer, buffer + sizeof(buffer), value)
+                : std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, precision);
+            break;
+    }
+
+    digits.assign(buffer, result.ptr);
+    if (type == 'F' || type == 'E' || type == 'G' || type == 'A') {
+        std::transform(digits.begin(), digits.end(), digits.begin(), [](char c) { return static_cast<char>(std::toupper(c)); });
+    }
+}
+
+} // namespace
+
+std::string FormatLogArg(const BinaryLogArg& arg, std::string_view spec) {
+    // [[fill]align][sign]['#']['0'][width]['.' precision][type]
+    size_t p = 0;
+    char fill = ' ';
+    char align = 0;
+    auto isAlign = [](char c) { return c == '<' || c == '>' || c == '^'; };
+
+    if (spec.size() >= 2 && isAlign(spec[1])) {
+        fill = spec[0];
+        align = spec[1];
+        p = 2;
+    } else if (!spec.empty() && isAlign(spec[0])) {
+        align = spec[0];
+        p = 1;
+    }
+
+    char sign = '-';
+    if (p < spec.size() && (spec[p] == '+' || spec[p] == '-' || spec[p] == ' ')) {
+        sign = spec[p++];
+    }
+
+    bool alternate = false;
+    if (p < spec.size() && spec[p] == '#') {
+        alternate = true;
+        p++;
+    }
+
+    bool zeroPad = false;
+    if (p < spec.size() && spec[p] == '0') {
+        zeroPad = true;
+        p++;
+    }
+
+    size_t width = 0;
+    while (p < spec.size() && std::isdigit(static_cast<unsigned char>(spec[p]))) {
+        width = width * 10 + static_cast<size_t>(spec[p++] - '0');
+    }
+
+    int precision = -1;
+    if (p < spec.size() && spec[p] == '.') {
+        p++;
+        precision = 0;
+        while (p < spec.size() && std::isdigit(static_cast<unsigned char>(spec[p]))) {
+            precision = precision * 10 + (spec[p++] - '0');
+        }
+    }
+
+    char type = p < spec.size() ? spec[p] : 0;
+
+    // Render the value as sign + prefix + digits so zero padding can go between
+    bool numeric = true;
+    bool negative = false;
+    std::string prefix;
+    std::string digits;
+
+    switch (arg.type) {
+        case BinaryLogArgType::String:
+            numeric = false;
+            digits.assign(arg.text.substr(0, precision < 0 ? arg.text.size() : static_cast<size_t>(precision)));
+            break;
+
+        case BinaryLogArgType::Bool:
+            if (IsIntegerPresentation(type) && type != 'c') {
+                FormatUnsigned(arg.u, type, alternate, prefix, digits);
+            } else {
+                numeric = false;
+                digits = arg.u ? "true" : "false";
+            }
+            break;
+
+        case BinaryLogArgType::Char:
+            if (IsIntegerPresentation(type) && type != 'c') {
+                FormatUnsigned(arg.u, type, alternate, prefix, digits);
+            } else {
+                numeric = false;
+                digits.assign(1, static_cast<char>(arg.u));
+            }
+            break;
+
+        case BinaryLogArgType::Int:
+            if (type == 'c') {
+                numeric = false;
+                digits.assign(1, static_cast<char>(arg.i));
+                break;
+            }
+            negative = arg.i < 0;
+            FormatUnsigned(negative ? 0 - static_cast<uint64_t>(arg.i) : static_cast<uint64_t>(arg.i),
+                           type, alternate, prefix, digits);
+            break;
+
+        case BinaryLogArgType::UInt:
+            if (type == 'c') {
+                numeric = false;
+                digits.assign(1, static_cast<char>(arg.u));
+                break;
+            }
+            FormatUnsigned(arg.u, type, alternate, prefix, digits);
+            break;
+
+        case BinaryLogArgType::Pointer:
+            prefix = "0x";
+            FormatUnsigned(arg.u, type == 'P' ? 'X' : 'x', false, prefix, digits);
+            break;
+
+        case BinaryLogArgType::Double:
+            FormatDouble(arg.d, type, precision, digits);
+            if (!digits.empty() && digits[0] == '-') {
+                negative = true;
+                digits.erase(0, 1);
+            }
+            break;
+    }
+
+    std::string body;
+    if (numeric) {
+        if (negative) {
+            body += '-';
+        } else if (sign == '+' || sign == ' ') {
+            body += sign;
+        }
+        body += prefix;
+    }
+
+    // '0' pads between sign/prefix and digits, and only without an explicit alignment
+    if (numeric && zeroPad && align == 0 && body.size() + digits.size() < width) {
+        body.append(width - body.size() - digits.size(), '0');
+    }
+    body += digits;
+
+    if (body.size() >= width) {
+        return body;
+    }
+
+    size_t padding = width - body.size();
+    if (align == 0) {
+        align = numeric ? '>' : '<';
+    }
+
+    std::string out;
+    out.reserve(width);
+    size_t before = align == '>' ? padding : align == '^' ? padding / 2 : 0;
+    out.append(before, fill);
+    out += body;
+    out.append(padding - before, fill);
+    return out;
+}
+
+bool BinaryLogReader::NextLine(std::string& line) {
+    line.clear();
+
+    while (m_error.empty() && m_offset < m_data.size()) {
+        uint8_t kind = 0;
+        Read(kind);
+
+        switch (static_cast<BinaryLogRecordKind>(kind)) {
+            case BinaryLogRecordKind::Session:
+                return ReadSession(line);
+            case BinaryLogRecordKind::Format:
+                if (!ReadFormat()) return false;
+                break;
+            case BinaryLogRecordKind::Message:
+                return ReadMessage(line);
+            case BinaryLogRecordKind::Dropped:
+                return ReadDropped(line);
+            default:
+                m_error = "unknown record kind " + std::to_string(kind) + " at offset " + std::to_string(m_offset - 1);
+                return false;
+        }
+    }
+
+    return false;
+}
+
+template<typename T>
+bool BinaryLogReader::Read(T& value) {
+    if (m_data.size() - m_offset < sizeof(T)) {
+        m_error = "truncated record at offset " + std::to_string(m_offset);
+        m_offset = m_data.size();
+        return false;
+    }
+    std::memcpy(&value, m_data.data() + m_offset, sizeof(T));
+    m_offset += sizeof(T);
+    return true;
+}
+
+bool BinaryLogReader::ReadBytes(size_t length, std::string_view& bytes) {
+    if (m_data.size() - m_offset < length) {
+        m_error = "truncated record at offset " + std::to_string(m_offset);
+        m_offset = m_data.size();
+        return false;
+    }
+    bytes = m_data.substr(m_offset, length);
+    m_offset += length;
+    return true;
+}
+
+bool BinaryLogReader::ReadSession(std::string& line) {
+    size_t start = m_offset - 1;
+    std::string_view magic;
+    uint16_t version = 0;
+
+    if (!ReadBytes(sizeof(BINARY_LOG_MAGIC), magic) || !Read(version)) return false;
+    if (magic != std::string_view(BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC))) {
+        m_error = "bad session magic at offset " + std::to_string(start);
+        return false;
+    }
+    if (version != BINARY_LOG_VERSION) {
+        m_error = "unsupported format version " + std::to_string(version);
+        return false;
+    }
+    if (!Read(m_ticksPerSecond) || !Read(m_startTicks) || !Read(m_startWallClockUs)) return false;
+
+    if (m_ticksPerSecond <= 0) {
+        m_error = "invalid tick rate in session at offset " + std::to_string(start);
+        return false;
+    }
+
+    // IDs restart with every session
+    m_formats.clear();
+    m_inSession = true;
+
+    // Same banner the text log writes
+    if (start > 0) {
+        line += '\n';
+    }
+    line += "===== Matrix Screensaver Started =====";
+    return true;
+}
+
+bool BinaryLogReader::ReadFormat() {
+    uint16_t id = 0;
+    uint16_t length = 0;
+    std::string_view text;
+
+    if (!Read(id) || !Read(length) || !ReadBytes(length, text)) return false;
+
+    if (m_formats.size() <= id) {
+        m_formats.resize(static_cast<size_t>(id) + 1);
+    }
+    m_formats[id] = text;
+    return true;
+}
+
+bool BinaryLogReader::ReadMessage(std::string& line) {
+    uint8_t level = 0;
+    uint16_t formatId = 0;
+    int64_t ticks = 0;
+    uint16_t length = 0;
+    std::string_view payload;
+
+    if (!Read(level) || !Read(formatId) || !Read(ticks) || !Read(length) || !ReadBytes(length, payload)) {
+        return false;
+    }
+
+    AppendTimestamp(line, ticks);
+    line += ' ';
+    line += GetLevelString(level);
+    line += ' ';
+
+    if (formatId == BINARY_LOG_PLAIN_FORMAT) {
+        line += payload;
+    } else if (formatId >= m_formats.size() || m_formats[formatId].empty()) {
+        line += "<unknown format " + std::to_string(formatId) + ">";
+    } else {
+        DecodeArgs(payload);
+        FormatMessage(m_formats[formatId], line);
+    }
+    return true;
+}
+
+bool BinaryLogReader::ReadDropped(std::string& line) {
+    int64_t ticks = 0;
+    uint64_t count = 0;
+
+    if (!Read(ticks) || !Read(count)) return false;
+
+    AppendTimestamp(line, ticks);
+    line += ' ';
+    line += GetLevelString(2);
+    line += " Log queue full, dropped " + std::to_string(count) + " messages";
+    return true;
+}
+
+void BinaryLogReader::AppendTimestamp(std::string& line, int64_t ticks) const {
+    if (!m_inSession) {
+        line += "[NO_SESSION]";
+        return;
+    }
+
+    // Split the conversion so multi-day offsets at nanosecond ticks cannot overflow
+    int64_t elapsed = ticks - m_startTicks;
+    int64_t elapsedUs = (elapsed / m_ticksPerSecond) * 1000000 +
+                        (elapsed % m_ticksPerSecond) * 1000000 / m_ticksPerSecond;
+    int64_t wallUs = m_startWallClockUs + elapsedUs;
+
+    int64_t seconds = wallUs / 1000000;
+    int64_t micros = wallUs % 1000000;
+    if (micros < 0) {
+        seconds--;
+        micros += 1000000;
+    }
+
+    std::time_t time = static_cast<std::time_t>(seconds);
+    std::tm parts{};
+#ifdef _WIN32
+    bool converted = (m_utc ? gmtime_s(&parts, &time) : localtime_s(&parts, &time)) == 0;
+#else
+    bool converted = (m_utc ? gmtime_r(&time, &parts) : localtime_r(&time, &parts)) != nullptr;
+#endif
+    if (!converted) {
+        line += "[TIMESTAMP_ERROR]";
+        return;
+    }
+
+    char buffer[32];
+    size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &parts);
+    line.append(buffer, length);
+
+    std::snprintf(buffer, sizeof(buffer), ".%03d", static_cast<int>(micros / 1000));
+    line += buffer;
+}
+
+bool BinaryLogReader::DecodeArgs(std::string_view payload) {
+    m_args.clear();
+    size_t p = 0;
+
+    auto take = [&](void* value, size_t size) {
+        if (payload.size() - p < size) return false;
+        std::memcpy(value, payload.data() + p, size);
+        p += size;
+        return true;
+    };
+
+    while (p < payload.size()) {
+        BinaryLogArg arg;
+        arg.type = static_cast<BinaryLogArgType>(payload[p++]);
+
+        bool ok = true;
+        switch (arg.type) {
+            case BinaryLogArgType::Int:
+                ok = take(&arg.i, sizeof(arg.i));
+                break;
+            case BinaryLogArgType::UInt:
+            case BinaryLogArgType::Pointer:
+                ok = take(&arg.u, sizeof(arg.u));
+                break;
+            case BinaryLogArgType::Double:
+                ok = take(&arg.d, sizeof(arg.d));
+                break;
+            case BinaryLogArgType::Bool:
+            case BinaryLogArgType::Char: {
+                uint8_t value = 0;
+                ok = take(&value, sizeof(value));
+                arg.u = value;
+                break;
+            }
+            case BinaryLogArgType::String: {
+                uint16_t length = 0;
+                ok = take(&length, sizeof(length)) && payload.size() - p >= length;
+                if (ok) {
+                    arg.text = payload.substr(p, length);
+                    p += length;
+                }
+                break;
+            }
+            default:
+                ok = false;
+                break;
+        }
+
+        if (!ok) return false;
+        m_args.push_back(arg);
+    }
+    return true;
+}
+
+void BinaryLogReader::FormatMessage(std::string_view format, std::string& out) const {
+    size_t nextArg = 0;
+    size_t i = 0;
+
+    while (i < format.size()) {
+        char c = format[i];
+
+        if (c == '}') {
+            // "}}" is an escaped brace; a lone one is passed through
+            out += '}';
+            i += (i + 1 < format.size() && format[i + 1] == '}') ? 2 : 1;
+            continue;
+        }
+        if (c != '{') {
+            out += c;
+            i++;
+            continue;
+        }
+        if (i + 1 < format.size() && format[i + 1] == '{') {
+            out += '{';
+            i += 2;
+            continue;
+        }
+
+        size_t close = format.find('}', i + 1);
+        if (close == std::string_view::npos) {
+            out += format.substr(i);
+            break;
+        }
+
+        // {[index][:spec]}
+        std::string_view field = format.substr(i + 1, close - i - 1);
+        size_t colon = field.find(':');
+        std::string_view index = field.substr(0, colon);
+        std::string_view spec = colon == std::string_view::npos ? std::string_view() : field.substr(colon + 1);
+
+        size_t argIndex = nextArg++;
+        if (!index.empty()) {
+            std::from_chars(index.data(), index.data() + index.size(), argIndex);
+        }
+
+        if (argIndex < m_args.size()) {
+            out += FormatLogArg(m_args[argIndex], spec);
+        } else {
+            out += "{?}";   // Dropped when the message slot filled up
+        }
+        i = close + 1;
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "binary_log.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One decoded message argument; strings point into the file data
+struct BinaryLogArg {
+    BinaryLogArgType type = BinaryLogArgType::Int;
+    int64_t i = 0;          // Int
+    uint64_t u = 0;         // UInt, Bool, Char, Pointer
+    double d = 0.0;         // Double
+    std::string_view text;  // String
+};
+
+// Render one argument with a std::format replacement-field spec (the part
+// after ':'). Covers fill/align, sign, '#', '0', width, precision and the
+// standard presentation types; nested (dynamic) widths are not supported.
+std::string FormatLogArg(const BinaryLogArg& arg, std::string_view spec);
+
+// Decodes a binary log (see binary_log.h) back into the text log layout:
+//   2024-05-01 12:00:00.123 [INFO]  message
+// Kept free of platform headers so the decoder builds anywhere.
+class BinaryLogReader {
+public:
+    explicit BinaryLogReader(std::string_view data) : m_data(data) {}
+
+    // Show times in UTC instead of local time
+    void SetUtc(bool utc) { m_utc = utc; }
+
+    // Decode the next record into `line` (without a newline). Returns false at
+    // the end of the data; format definitions produce no line and are skipped.
+    bool NextLine(std::string& line);
+
+    // Set when decoding stopped early on a truncated or unrecognized record
+    bool HasError() const { return !m_error.empty(); }
+    const std::string& GetError() const { return m_error; }
+
+private:
+    template<typename T>
+    bool Read(T& value);
+    bool ReadBytes(size_t length, std::string_view& bytes);
+
+    bool ReadSession(std::string& line);
+    bool ReadFormat();
+    bool ReadMessage(std::string& line);
+    bool ReadDropped(std::string& line);
+
+    void AppendTimestamp(std::string& line, int64_t ticks) const;
+    bool DecodeArgs(std::string_view payload);
+    void FormatMessage(std::string_view format, std::string& out) const;
+
+    std::string_view m_data;
+    size_t m_offset = 0;
+    bool m_utc = false;
+    std::string m_error;
+
+    // Current session
+    bool m_inSession = false;
+    int64_t m_ticksPerSecond = 1;
+    int64_t m_startTicks = 0;
+    int64_t m_startWallClockUs = 0;
+    std::vector<std::string_view> m_formats;    // Indexed by format ID
+    std::vector<BinaryLogArg> m_args;           // Scratch for the message being decoded
+};
+
@@ -1,9 +1,10 @@
 #include "character_effects.h"
-#include "logger.h"
 #include <algorithm>
 #include <cmath>
 
-CharacterEffects::CharacterEffects() {
+CharacterEffects::CharacterEffects(SimRandom& random)
+    : m_random(random),
+      m_effectPool(256, 256) {
 }
 
 CharacterEffects::~CharacterEffects() {
@@ -12,9 +13,6 @@ CharacterEffects::~CharacterEffects() {
 void CharacterEffects::Initialize(const MatrixSettings& settings) {
     m_settings = settings;
     RebuildCharacterPools();
-    
-    LOG_DEBUG("CharacterEffects initialized with variety: " + 
-             std::to_string(settings.enableCharacterVariety));
 }
 
 void CharacterEffects::Update(float deltaTime) {
@@ -28,7 +26,7 @@ void CharacterEffects::Update(float deltaTime) {
     // Randomly trigger system disruptions
     if (m_settings.enableSystemDisruptions && m_timeSinceLastDisruption > 30.0f) {
         float disruptionChance = deltaTime * 0.01f; // 1% chance per second after 30s
-        if (std::uniform_real_distribution<float>(0.0f, 1.0f)(g_rng) < disruptionChance) {
+        if (m_random.NextFloat() < disruptionChance) {
             TriggerSystemDisruption();
         }
     }
@@ -44,169 +42,211 @@ void CharacterEffects::SetSettings(const MatrixSettings& settings) {
     RebuildCharacterPools();
 }
 
-std::wstring CharacterEffects::SelectCharacter(float depth, bool allowVariety) const {
+GlyphId CharacterEffects::SelectCharacter(float depth, bool allowVariety) const {
     if (!allowVariety || !m_settings.enableCharacterVariety || m_availableChars.empty()) {
         // Use original character set
-        return KATAKANA_CHARS[std::uniform_int_distribution<int>(0, static_cast<int>(KATAKANA_CHARS.size()) - 1)(g_rng)];
+        return SelectFromPool(GlyphTable::Instance().GetKatakanaGlyphs());
     }
     
-    // Weighted character selection based on depth and probability settings
-    float roll = std::uniform_real_distribution<float>(0.0f, 1.0f)(g_rng);
-    
-    // Symbols are rarer in deeper areas (darker mask areas)
-    float adjustedSymbolProb = m_settings.symbolCharProbability * (1.0f - depth * 0.5f);
-    float adjustedLatinProb = m_settings.latinCharProbability;
-    
-    if (roll < adjustedSymbolProb && !SYMBOL_CHARS.empty()) {
-        return SYMBOL_CHARS[std::uniform_int_distribution<int>(0, static_cast<int>(SYMBOL_CHARS.size()) - 1)(g_rng)];
-    } else if (roll < adjustedSymbolProb + adjustedLatinProb && !LATIN_CHARS.empty()) {
-        return LATIN_CHARS[std::uniform_int_distribution<int>(0, static_cast<int>(LATIN_CHARS.size()) - 1)(g_rng)];
-    } else {
-        // Default to Japanese characters
-        return KATAKANA_CHARS[std::uniform_int_distribution<int>(0, static_cast<int>(KATAKANA_CHARS.size()) - 1)(g_rng)];
+    // Weighted by category and depth; see RebuildVarietySamplers
+    int bucket = std::clamp(static_cast<int>(depth * DEPTH_BUCKETS), 0, DEPTH_BUCKETS - 1);
+    const GlyphSampler& sampler = m_varietySamplers[bucket];
+    if (sampler.IsEmpty()) {
+        return SelectFromPool(GlyphTable::Instance().GetKatakanaGlyphs());
     }
+    return sampler.Sample(m_random.NextUInt());
 }
 
-std::wstring CharacterEffects::SelectMorphTarget(const std::wstring& current) const {
-    if (m_morphTargets.empty()) {
-        return SelectCharacter();
+GlyphId CharacterEffects::SelectMorphTarget(GlyphId current) const {
+    if (m_morphTargets.size() < 2) {
+        return m_morphTargets.empty() ? SelectCharacter() : m_morphTargets[0];
     }
     
-    // Select a different character for morphing
-    std::wstring target;
-    int attempts = 0;
-    do {
-        target = SelectFromPool(m_morphTargets);
-        attempts++;
-    } while (target == current && attempts < 10);
+    // Select a different character for morphing: draw over the other slots
+    // and step past the current glyph's
+    uint16_t slot = current < m_morphTargetSlots.size() ? m_morphTargetSlots[current] : 0;
+    if (slot == 0) {
+        return SelectFromPool(m_morphTargets);
+    }
     
-    return target;
+    int index = m_random.NextInt(0, static_cast<int>(m_morphTargets.size()) - 2);
+    if (index >= slot - 1) {
+        index++;
+    }
+    return m_morphTargets[index];
 }
 
 void CharacterEffects::StartMorphing(GridCell& cell, float probability) {
     if (!m_settings.enableCharacterMorphing) return;
     
-    float roll = std::uniform_real_distribution<float>(0.0f, 1.0f)(g_rng);
-    if (roll < probability && !cell.isMorphing) {
-        cell.morphTarget = SelectMorphTarget(cell.character);
-        cell.morphProgress = 0.0f;
-        cell.morphSpeed = m_settings.morphSpeed * std::uniform_real_distribution<float>(0.8f, 1.2f)(g_rng);
-        cell.morphTimer = 0.0f;
-        cell.isMorphing = true;
+    float roll = m_random.NextFloat();
+    if (roll < probability && !cell.IsMorphing()) {
+        CellEffectState* state = AcquireEffectState(cell);
+        if (!state) return;
+        
+        state->morphTarget = SelectMorphTarget(cell.glyph);
+        state->morphProgress = 0.0f;
+        state->morphSpeed = m_settings.morphSpeed * m_random.NextFloat(0.8f, 1.2f);
+        cell.SetFlag(CELL_MORPHING, true);
     }
 }
 
 void CharacterEffects::UpdateMorphing(GridCell& cell, float deltaTime) {
-    if (!cell.isMorphing) return;
+    if (!cell.IsMorphing()) return;
     
-    cell.morphTimer += deltaTime;
-    cell.morphProgress += deltaTime * cell.morphSpeed;
+    CellEffectState* state = GetEffectState(cell);
+    state->morphProgress += deltaTime * state->morphSpeed;
     
-    if (cell.morphProgress >= 1.0f) {
+    if (state->morphProgress >= 1.0f) {
         // Morphing complete
-        cell.character = cell.morphTarget;
-        cell.morphTarget = L"";
-        cell.morphProgress = 0.0f;
-        cell.isMorphing = false;
+        cell.glyph = state->morphTarget;
+        state->morphTarget = INVALID_GLYPH;
+        state->morphProgress = 0.0f;
+        cell.SetFlag(CELL_MORPHING, false);
         
         // Chance to start another morph
-        if (std::uniform_real_distribution<float>(0.0f, 1.0f)(g_rng) < 0.3f) {
+        if (m_random.NextFloat() < 0.3f) {
             StartMorphing(cell, 1.0f); // 100% chance for chain morphing
         }
+        
+        ReleaseEffectStateIfIdle(cell);
     }
 }
 
-std::wstring CharacterEffects::GetMorphedCharacter(const GridCell& cell) const {
-    if (!cell.isMorphing || cell.morphTarget.empty()) {
-        return cell.character;
+GlyphId CharacterEffects::GetMorphedCharacter(const GridCell& cell) const {
+    const CellEffectState* state = cell.IsMorphing() ? GetEffectState(cell) : nullptr;
+    if (!state || state->morphTarget == INVALID_GLYPH) {
+        return cell.glyph;
     }
     
     // Simple character switching based on progress
-    if (cell.morphProgress < 0.5f) {
-        return cell.character;
-    } else {
-        return cell.morphTarget;
-    }
+    return InterpolateCharacters(cell.glyph, state->morphTarget, state->morphProgress);
 }
 
 void CharacterEffects::StartGlitch(GridCell& cell, float probability) {
     if (!m_settings.enableGlitchEffects) return;
     
-    float roll = std::uniform_real_distribution<float>(0.0f, 1.0f)(g_rng);
-    if (roll < probability && !cell.isGlitching) {
-        cell.glitchIntensity = std::uniform_real_distribution<float>(0.5f, 1.0f)(g_rng);
-        cell.glitchTimer = 0.0f;
-        cell.isGlitching = true;
+    float roll = m_random.NextFloat();
+    if (roll < probability && !cell.IsGlitching()) {
+        CellEffectState* state = AcquireEffectState(cell);
+        if (!state) return;
+        
+        state->glitchIntensity = m_random.NextFloat(0.5f, 1.0f);
+        state->glitchTimer = 0.0f;
+        // Weighted by depth like any other glyph, one sampler draw each
+        for (GlyphId& glyph : state->glitchGlyphs) {
+            glyph = SelectCharacter(cell.GetDepth());
+        }
+        cell.SetFlag(CELL_GLITCHING, true);
     }
 }
 
 void CharacterEffects::UpdateGlitch(GridCell& cell, float deltaTime) {
-    if (!cell.isGlitching) return;
+    if (!cell.IsGlitching()) return;
     
-    cell.glitchTimer += deltaTime;
+    CellEffectState* state = GetEffectState(cell);
+    state->glitchTimer += deltaTime;
     
     // Glitch lasts 0.1 to 0.3 seconds
-    float glitchDuration = 0.1f + cell.glitchIntensity * 0.2f;
-    if (cell.glitchTimer >= glitchDuration) {
-        cell.isGlitching = false;
-        cell.glitchIntensity = 0.0f;
-        cell.glitchTimer = 0.0f;
+    float glitchDuration = 0.1f + state->glitchIntensity * 0.2f;
+    if (state->glitchTimer >= glitchDuration) {
+        state->glitchIntensity = 0.0f;
+        state->glitchTimer = 0.0f;
+        state->glitchGlyphs.fill(INVALID_GLYPH);
+        cell.SetFlag(CELL_GLITCHING, false);
+        ReleaseEffectStateIfIdle(cell);
     }
 }
 
-std::wstring CharacterEffects::GetGlitchedCharacter(const GridCell& cell) const {
-    if (!cell.isGlitching) {
+GlyphId CharacterEffects::GetGlitchedCharacter(const GridCell& cell) const {
+    if (!cell.IsGlitching()) {
         return GetMorphedCharacter(cell);
     }
     
-    // During glitch, rapidly switch between random characters
-    if (static_cast<int>(cell.glitchTimer * 20.0f) % 2 == 0) {
-        return SelectCharacter(cell.depth, m_settings.enableCharacterVariety);
-    } else {
-        return GetMorphedCharacter(cell);
+    // During glitch, rapidly switch between random-looking characters. The
+    // sequence was chosen when the glitch started, so what shows is a function
+    // of the glitch timer alone and reading it draws nothing.
+    const CellEffectState* state = GetEffectState(cell);
+    int step = static_cast<int>(state->glitchTimer * GLITCH_STEP_RATE);
+    if (step % 2 == 0) {
+        size_t flicker = std::min(static_cast<size_t>(step / 2), GLITCH_SEQUENCE_LENGTH - 1);
+        if (state->glitchGlyphs[flicker] != INVALID_GLYPH) {
+            return state->glitchGlyphs[flicker];
+        }
     }
+    return GetMorphedCharacter(cell);
 }
 
-void CharacterEffects::UpdateGlow(GridCell& cell, float deltaTime) {
+float CharacterEffects::GetGlowIntensity(const GridCell& cell) const {
     if (!m_settings.enablePhosphorGlow) {
-        cell.glowIntensity = 0.0f;
-        return;
+        return 0.0f;
     }
     
     // Vary glow intensity based on character activity and alpha
-    float targetGlow = cell.alpha * m_settings.glowIntensity;
+    float glow = cell.GetAlpha() * m_settings.glowIntensity;
     
     // Add some variation for more organic feel
-    targetGlow += std::sin(cell.lastUpdateTime * 3.0f) * 0.1f * m_settings.glowIntensity;
-    targetGlow = std::max(0.0f, targetGlow);
-    
-    // Smooth transition to target glow
-    cell.glowIntensity += (targetGlow - cell.glowIntensity) * deltaTime * 5.0f;
+    glow += std::sin(cell.GetAge() * 3.0f) * 0.1f * m_settings.glowIntensity;
+    return std::max(0.0f, glow);
+}
+
+Color CharacterEffects::GetGlowColor(const GridCell& cell) const {
+    return MakeGlowColor(cell.flags, GetGlowIntensity(cell));
+}
+
+Color CharacterEffects::MakeGlowColor(uint8_t cellFlags, float intensity) {
+    Color baseColor = Color(0.0f, 1.0f, 0.0f, intensity);
     
-    // Set glow color based on character properties
-    if (cell.glowIntensity > 0.0f) {
-        Color baseColor = Color(0.0f, 1.0f, 0.0f, cell.glowIntensity);
-        
-        // Modify color based on character type
-        if (cell.isGlitching) {
-            baseColor.r = 0.2f; // Slight red tint for glitches
-        } else if (cell.isMorphing) {
-            baseColor.b = 0.1f; // Slight blue tint for morphing
-        }
-        
-        cell.glowColor = baseColor;
+    // Modify color based on character type
+    if (cellFlags & CELL_GLITCHING) {
+        baseColor.r = 0.2f; // Slight red tint for glitches
+    } else if (cellFlags & CELL_MORPHING) {
+        baseColor.b = 0.1f; // Slight blue tint for morphing
     }
+    
+    return baseColor;
 }
 
-Color CharacterEffects::GetGlowColor(const GridCell& cell) const {
-    return cell.glowColor;
+void CharacterEffects::ReleaseEffectState(GridCell& cell) {
+    if (cell.effectSlot == NO_EFFECT_SLOT) return;
+    
+    m_effectPool.Release(m_effectPool.FromIndex(cell.effectSlot));
+    cell.effectSlot = NO_EFFECT_SLOT;
+    cell.SetFlag(CELL_MORPHING, false);
+    cell.SetFlag(CELL_GLITCHING, false);
+    m_activeEffectCount--;
+}
+
+CharacterEffects::SystemState CharacterEffects::GetSystemState() const {
+    SystemState state;
+    state.disruptionTimer = m_systemDisruptionTimer;
+    state.timeSinceLastDisruption = m_timeSinceLastDisruption;
+    state.rainIntensityPhase = m_rainIntensityPhase;
+    return state;
+}
+
+void CharacterEffects::SetSystemState(const SystemState& state) {
+    m_systemDisruptionTimer = state.disruptionTimer;
+    m_timeSinceLastDisruption = state.timeSinceLastDisruption;
+    m_rainIntensityPhase = state.rainIntensityPhase;
+}
+
+bool CharacterEffects::RestoreEffectState(GridCell& cell, const CellEffectState& state) {
+    CellEffectState* slot = AcquireEffectState(cell);
+    if (!slot) return false;
+    
+    *slot = state;
+    return true;
 }
 
 void CharacterEffects::TriggerSystemDisruption() {
     m_systemDisruptionTimer = m_systemDisruptionDuration;
     m_timeSinceLastDisruption = 0.0f;
-    
-    LOG_DEBUG("System disruption triggered");
+}
+
+uint64_t CharacterEffects::HashState(uint64_t hash) const {
+    const float timers[] = { m_systemDisruptionTimer, m_timeSinceLastDisruption, m_rainIntensityPhase };
+    return HashBytes(hash, reinterpret_cast<const unsigned char*>(timers), sizeof(timers));
 }
 
 float CharacterEffects::GetSystemDisruptionIntensity() const {
@@ -217,12 +257,14 @@ float CharacterEffects::GetSystemDisruptionIntensity() const {
     return std::exp(-progress * 3.0f); // Exponential fade
 }
 
-float CharacterEffects::GetRainIntensityMultiplier() const {
+float CharacterEffects::GetRainIntensityMultiplier(float timeAhead) const {
     if (!m_settings.enableRainVariations) return 1.0f;
     
     // Combine slow wave with some randomness
-    float slowWave = 0.8f + 0.4f * std::sin(m_rainIntensityPhase * 0.1f);
-    float fastVariation = 0.9f + 0.2f * std::sin(m_rainIntensityPhase * 0.5f);
+    // This scales column speed, so it uses SimSin to stay reproducible in replays
+    float phase = m_rainIntensityPhase + timeAhead;
+    float slowWave = 0.8f + 0.4f * SimSin(phase * 0.1f);
+    float fastVariation = 0.9f + 0.2f * SimSin(phase * 0.5f);
     
     return slowWave * fastVariation;
 }
@@ -232,48 +274,109 @@ void CharacterEffects::UpdateRainVariations(float deltaTime) {
 }
 
 void CharacterEffects::RebuildCharacterPools() {
-    m_availableChars.clear();
-    m_morphTargets.clear();
+    const GlyphTable& glyphs = GlyphTable::Instance();
     
     if (m_settings.enableCharacterVariety) {
         // Add all character types to pools
-        m_availableChars.insert(m_availableChars.end(), MATRIX_CHARS.begin(), MATRIX_CHARS.end());
-        m_morphTargets.insert(m_morphTargets.end(), MATRIX_CHARS.begin(), MATRIX_CHARS.end());
+        m_availableChars = glyphs.GetMatrixGlyphs();
     } else {
         // Use only basic katakana
-        m_availableChars.insert(m_availableChars.end(), KATAKANA_CHARS.begin(), KATAKANA_CHARS.end());
-        m_morphTargets.insert(m_morphTargets.end(), KATAKANA_CHARS.begin(), KATAKANA_CHARS.end());
+        m_availableChars = glyphs.GetKatakanaGlyphs();
+    }
+    
+    // Morph targets without repeats, so skipping the current glyph's slot
+    // always lands on a different glyph
+    m_morphTargets.clear();
+    m_morphTargetSlots.assign(glyphs.GetGlyphCount(), 0);
+    for (GlyphId glyph : m_availableChars) {
+        if (glyph != INVALID_GLYPH && m_morphTargetSlots[glyph] == 0) {
+            m_morphTargets.push_back(glyph);
+            m_morphTargetSlots[glyph] = static_cast<uint16_t>(m_morphTargets.size());
+        }
     }
+    
+    RebuildVarietySamplers();
 }
 
-std::wstring CharacterEffects::SelectFromPool(const std::vector<std::wstring>& pool) const {
-    if (pool.empty()) return L"ア";
+void CharacterEffects::RebuildVarietySamplers() {
+    const GlyphTable& glyphs = GlyphTable::Instance();
+    
+    std::vector<GlyphId> candidates = glyphs.GetKatakanaGlyphs();
+    candidates.insert(candidates.end(), glyphs.GetLatinGlyphs().begin(), glyphs.GetLatinGlyphs().end());
+    candidates.insert(candidates.end(), glyphs.GetSymbolGlyphs().begin(), glyphs.GetSymbolGlyphs().end());
     
-    int index = std::uniform_int_distribution<int>(0, static_cast<int>(pool.size()) - 1)(g_rng);
+    std::vector<GlyphSampler::WeightedGlyph> weighted(candidates.size());
+    for (int bucket = 0; bucket < DEPTH_BUCKETS; ++bucket) {
+        if (!m_settings.enableCharacterVariety) {
+            m_varietySamplers[bucket].Clear();
+            continue;
+        }
+        
+        // Each bucket is weighted for the depth at its middle
+        float depth = (static_cast<float>(bucket) + 0.5f) / DEPTH_BUCKETS;
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            weighted[i] = { candidates[i], GetCharacterWeight(candidates[i], depth) };
+        }
+        m_varietySamplers[bucket].Build(weighted);
+    }
+}
+
+GlyphId CharacterEffects::SelectFromPool(const std::vector<GlyphId>& pool) const {
+    if (pool.empty()) return GlyphTable::Instance().GetKatakanaGlyphs()[0];
+    
+    int index = m_random.NextInt(0, static_cast<int>(pool.size()) - 1);
     return pool[index];
 }
 
-float CharacterEffects::GetCharacterWeight(const std::wstring& character, float depth) const {
-    // Weight characters based on depth and type
-    // Symbols are rarer in deep areas, Latin chars are consistent
+float CharacterEffects::GetCharacterWeight(GlyphId character, float depth) const {
+    // The chance of the character's category, shared evenly within it.
+    // Symbols are rarer in deeper areas (darker mask areas), Latin chars are
+    // consistent, and katakana take what is left.
+    const GlyphTable& glyphs = GlyphTable::Instance();
+    float symbolShare = std::clamp(m_settings.symbolCharProbability * (1.0f - depth * 0.5f), 0.0f, 1.0f);
+    float latinShare = std::clamp(m_settings.latinCharProbability, 0.0f, 1.0f - symbolShare);
     
-    for (const auto& symbol : SYMBOL_CHARS) {
-        if (character == symbol) {
-            return 1.0f - depth * 0.7f; // Much rarer in deep areas
-        }
+    uint8_t categories = glyphs.GetCategories(character);
+    if (categories & GLYPH_SYMBOL) {
+        return symbolShare / static_cast<float>(glyphs.GetSymbolGlyphs().size());
     }
-    
-    for (const auto& latin : LATIN_CHARS) {
-        if (character == latin) {
-            return 0.8f; // Consistent weight
-        }
+    if (categories & GLYPH_LATIN) {
+        return latinShare / static_cast<float>(glyphs.GetLatinGlyphs().size());
+    }
+    if (categories & GLYPH_KATAKANA) {
+        return (1.0f - symbolShare - latinShare) / static_cast<float>(glyphs.GetKatakanaGlyphs().size());
+    }
+    return 0.0f;
+}
+
+CellEffectState* CharacterEffects::AcquireEffectState(GridCell& cell) {
+    if (cell.effectSlot != NO_EFFECT_SLOT) {
+        return GetEffectState(cell);
     }
     
-    // Default katakana weight
-    return 1.0f;
+    CellEffectState* state = m_effectPool.Acquire();
+    if (state) {
+        cell.effectSlot = m_effectPool.GetIndex(state);
+        m_activeEffectCount++;
+    }
+    return state;
+}
+
+CellEffectState* CharacterEffects::GetEffectState(const GridCell& cell) {
+    return m_effectPool.FromIndex(cell.effectSlot);
+}
+
+const CellEffectState* CharacterEffects::GetEffectState(const GridCell& cell) const {
+    return m_effectPool.FromIndex(cell.effectSlot);
+}
+
+void CharacterEffects::ReleaseEffectStateIfIdle(GridCell& cell) {
+    if (!cell.IsMorphing() && !cell.IsGlitching()) {
+        ReleaseEffectState(cell);
+    }
 }
 
-std::wstring CharacterEffects::InterpolateCharacters(const std::wstring& from, const std::wstring& to, float progress) const {
+GlyphId CharacterEffects::InterpolateCharacters(GlyphId from, GlyphId to, float progress) const {
     // Simple character switching - could be enhanced with visual morphing
     return progress < 0.5f ? from : to;
 }
\ No newline at end of file
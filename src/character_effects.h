@@ -1,33 +1,63 @@
 #pragma once
 
-#include "common.h"
+#include "sim_types.h"
+#include "sim_random.h"
+#include "glyph_sampler.h"
+#include "memory_pool.h"
+#include <array>
 
+// Per-cell morph/glitch effects and the system-wide disruption and rain
+// variation effects. Random choices come from the owning simulation's
+// SimRandom so they replay deterministically.
 class CharacterEffects {
 public:
-    CharacterEffects();
+    explicit CharacterEffects(SimRandom& random);
     ~CharacterEffects();
     
     void Initialize(const MatrixSettings& settings);
     void Update(float deltaTime);
     void SetSettings(const MatrixSettings& settings);
     
-    // Character selection with variety
-    std::wstring SelectCharacter(float depth = 0.5f, bool allowVariety = true) const;
-    std::wstring SelectMorphTarget(const std::wstring& current) const;
+    // Character selection with variety; each pick is one draw from SimRandom
+    GlyphId SelectCharacter(float depth = 0.5f, bool allowVariety = true) const;
+    GlyphId SelectMorphTarget(GlyphId current) const;
     
     // Morphing system
     void StartMorphing(GridCell& cell, float probability);
     void UpdateMorphing(GridCell& cell, float deltaTime);
-    std::wstring GetMorphedCharacter(const GridCell& cell) const;
+    GlyphId GetMorphedCharacter(const GridCell& cell) const;
     
     // Glitch effects
     void StartGlitch(GridCell& cell, float probability);
     void UpdateGlitch(GridCell& cell, float deltaTime);
-    std::wstring GetGlitchedCharacter(const GridCell& cell) const;
+    GlyphId GetGlitchedCharacter(const GridCell& cell) const;
     
-    // Phosphor glow effects
-    void UpdateGlow(GridCell& cell, float deltaTime);
+    // Phosphor glow effects (derived from alpha and age, no per-cell state)
+    float GetGlowIntensity(const GridCell& cell) const;
     Color GetGlowColor(const GridCell& cell) const;
+    static Color MakeGlowColor(uint8_t cellFlags, float intensity);
+    
+    // Return a cell's effect side-table entry, if it has one
+    void ReleaseEffectState(GridCell& cell);
+    size_t GetActiveEffectCount() const { return m_activeEffectCount; }
+    const CellEffectState* GetCellEffectState(const GridCell& cell) const {
+        return cell.effectSlot != NO_EFFECT_SLOT ? GetEffectState(cell) : nullptr;
+    }
+    
+    // Fold the system-wide effect timers into a simulation state hash
+    uint64_t HashState(uint64_t hash) const;
+    
+    // System-wide effect timers, saved and restored by a warm start
+    struct SystemState {
+        float disruptionTimer = 0.0f;
+        float timeSinceLastDisruption = 0.0f;
+        float rainIntensityPhase = 0.0f;
+    };
+    SystemState GetSystemState() const;
+    void SetSystemState(const SystemState& state);
+    
+    // Give a restored cell a side-table entry holding state; false if the pool is full
+    bool RestoreEffectState(GridCell& cell, const CellEffectState& state);
     
     // System-wide effects
     void TriggerSystemDisruption();
@@ -35,10 +65,12 @@ public:
     float GetSystemDisruptionIntensity() const;
     
     // Rain variation effects
-    float GetRainIntensityMultiplier() const;
+    // timeAhead looks further along the variation, for fast-forwarding
+    float GetRainIntensityMultiplier(float timeAhead = 0.0f) const;
     void UpdateRainVariations(float deltaTime);
 
 private:
+    SimRandom& m_random;
     MatrixSettings m_settings;
     
     // System disruption
@@ -51,14 +83,30 @@ private:
     float m_baseRainIntensity = 1.0f;
     
     // Character pools for efficiency
-    mutable std::vector<std::wstring> m_availableChars;
-    mutable std::vector<std::wstring> m_morphTargets;
+    std::vector<GlyphId> m_availableChars;
+    std::vector<GlyphId> m_morphTargets;            // Each glyph once
+    std::vector<uint16_t> m_morphTargetSlots;       // By GlyphId: index in m_morphTargets + 1, or 0
+    
+    // Variety picks by depth: the symbol share falls with depth, so each
+    // bucket has its own table, rebuilt when the settings change
+    static constexpr int DEPTH_BUCKETS = 8;
+    std::array<GlyphSampler, DEPTH_BUCKETS> m_varietySamplers;
+    
+    // Side table of morph/glitch state, referenced from GridCell::effectSlot
+    MemoryPool<CellEffectState> m_effectPool;
+    size_t m_activeEffectCount = 0;
     
     // Helper methods
     void RebuildCharacterPools();
-    std::wstring SelectFromPool(const std::vector<std::wstring>& pool) const;
-    float GetCharacterWeight(const std::wstring& character, float depth) const;
+    GlyphId SelectFromPool(const std::vector<GlyphId>& pool) const;
+    void RebuildVarietySamplers();
+    float GetCharacterWeight(GlyphId character, float depth) const;
+    
+    CellEffectState* AcquireEffectState(GridCell& cell);
+    CellEffectState* GetEffectState(const GridCell& cell);
+    const CellEffectState* GetEffectState(const GridCell& cell) const;
+    void ReleaseEffectStateIfIdle(GridCell& cell);
     
     // Morphing interpolation
-    std::wstring InterpolateCharacters(const std::wstring& from, const std::wstring& to, float progress) const;
+    GlyphId InterpolateCharacters(GlyphId from, GlyphId to, float progress) const;
 };
\ No newline at end of file
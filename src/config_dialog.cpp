@@ -1,7 +1,43 @@
 #include "config_dialog.h"
 #include "resource.h"
+#include "quality_presets.h"
 #include <commdlg.h>
 #include <commctrl.h>
+#include <cwchar>
+
+namespace {
+
+constexpr std::wstring_view AUTO_PRESET = L"auto";
+
+// The preset combo lists Custom, the presets in order, then auto
+constexpr int CUSTOM_PRESET_INDEX = 0;
+constexpr int AUTO_PRESET_INDEX = static_cast<int>(QUALITY_PRESET_COUNT) + 1;
+
+// Controls a preset sets; changing one by hand leaves the preset
+bool IsPresetControl(int id) {
+    switch (id) {
+    case IDC_DENSITY_SLIDER:
+    case IDC_FONTSIZE_SLIDER:
+    case IDC_TARGET_FPS_SLIDER:
+    case IDC_ENABLE_FRAME_LIMITING:
+    case IDC_ENABLE_MOTION_BLUR:
+    case IDC_ENABLE_PARTICLE_EFFECTS:
+    case IDC_ENABLE_HIGH_QUALITY_TEXT:
+    case IDC_ENABLE_ANTI_ALIASING:
+    case IDC_ENABLE_CHARACTER_MORPHING:
+    case IDC_ENABLE_PHOSPHOR_GLOW:
+    case IDC_ENABLE_GLITCH_EFFECTS:
+    case IDC_ENABLE_RAIN_VARIATIONS:
+    case IDC_ENABLE_SYSTEM_DISRUPTIONS:
+    case IDC_MORPH_FREQUENCY_SLIDER:
+    case IDC_GLITCH_FREQUENCY_SLIDER:
+    case IDC_GLOW_INTENSITY_SLIDER:
+        return true;
+    }
+    return false;
+}
+
+} // namespace
 
 ConfigDialog::ConfigDialog() {
     m_settingsManager = std::make_unique<SettingsManager>();
@@ -51,6 +87,15 @@ INT_PTR CALLBACK ConfigDialog::DialogProc(HWND hDlg, UINT message, WPARAM wParam
 }
 
 bool ConfigDialog::Initialize(HWND hDlg) {
+    HWND hPresetCombo = GetDlgItem(hDlg, IDC_PRESET_COMBO);
+    SendMessage(hPresetCombo, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(L"Custom"));
+    for (size_t i = 0; i < QUALITY_PRESET_COUNT; ++i) {
+        const QualityPresetInfo& info = GetQualityPresetInfo(static_cast<QualityPreset>(i));
+        SendMessage(hPresetCombo, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(info.displayName));
+    }
+    SendMessage(hPresetCombo, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(L"Best fit for this screen"));
+    m_presetCosts = m_settingsManager->LoadPresetCosts();
+
     LoadSettingsToDialog(hDlg);
     UpdatePreview(hDlg);
     return true;
@@ -91,6 +136,7 @@ void ConfigDialog::LoadSettingsToDialog(HWND hDlg) {
     
     // Set font combo
     HWND hFontCombo = GetDlgItem(hDlg, IDC_FONT_COMBO);
+    SendMessage(hFontCombo, CB_RESETCONTENT, 0, 0);
     SendMessage(hFontCombo, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(L"Consolas"));
     SendMessage(hFontCombo, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(L"Courier New"));
     SendMessage(hFontCombo, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(L"Lucida Console"));
@@ -129,7 +175,7 @@ void ConfigDialog::LoadSettingsToDialog(HWND hDlg) {
     CheckDlgButton(hDlg, IDC_ENABLE_DIRTY_RECTANGLES, m_settings.enableDirtyRectangles ? BST_CHECKED : BST_UNCHECKED);
     
     // Target FPS slider
-    SendDlgItemMessage(hDlg, IDC_TARGET_FPS_SLIDER, TBM_SETRANGE, 0, MAKELPARAM(30, 144));
+    SendDlgItemMessage(hDlg, IDC_TARGET_FPS_SLIDER, TBM_SETRANGE, 0, MAKELPARAM(24, 240));
     SendDlgItemMessage(hDlg, IDC_TARGET_FPS_SLIDER, TBM_SETPOS, TRUE, static_cast<LPARAM>(m_settings.targetFrameRate));
     
     // Advanced features (all OFF by default)
@@ -169,9 +215,20 @@ void ConfigDialog::LoadSettingsToDialog(HWND hDlg) {
     
     SendDlgItemMessage(hDlg, IDC_SYMBOL_CHAR_PROB_SLIDER, TBM_SETRANGE, 0, MAKELPARAM(0, 20));
     SendDlgItemMessage(hDlg, IDC_SYMBOL_CHAR_PROB_SLIDER, TBM_SETPOS, TRUE, static_cast<LPARAM>(m_settings.symbolCharProbability * 100));
+    
+    // Quality preset
+    int presetIndex = CUSTOM_PRESET_INDEX;
+    QualityPreset preset;
+    if (m_settings.qualityPreset == AUTO_PRESET) {
+        presetIndex = AUTO_PRESET_INDEX;
+    } else if (FindQualityPreset(m_settings.qualityPreset, preset)) {
+        presetIndex = static_cast<int>(preset) + 1;
+    }
+    SendDlgItemMessage(hDlg, IDC_PRESET_COMBO, CB_SETCURSEL, presetIndex, 0);
+    UpdatePresetCost(hDlg);
 }
 
-void ConfigDialog::SaveSettingsFromDialog(HWND hDlg) {
+void ConfigDialog::ReadSettingsFromDialog(HWND hDlg) {
     m_settings.speed = static_cast<float>(SendDlgItemMessage(hDlg, IDC_SPEED_SLIDER, TBM_GETPOS, 0, 0));
     m_settings.density = static_cast<float>(SendDlgItemMessage(hDlg, IDC_DENSITY_SLIDER, TBM_GETPOS, 0, 0)) / 100.0f;
     m_settings.fontSize = static_cast<float>(SendDlgItemMessage(hDlg, IDC_FONTSIZE_SLIDER, TBM_GETPOS, 0, 0));
@@ -243,9 +300,64 @@ void ConfigDialog::SaveSettingsFromDialog(HWND hDlg) {
     m_settings.latinCharProbability = static_cast<float>(SendDlgItemMessage(hDlg, IDC_LATIN_CHAR_PROB_SLIDER, TBM_GETPOS, 0, 0)) / 100.0f;
     m_settings.symbolCharProbability = static_cast<float>(SendDlgItemMessage(hDlg, IDC_SYMBOL_CHAR_PROB_SLIDER, TBM_GETPOS, 0, 0)) / 100.0f;
     
+    // Quality preset
+    int presetIndex = static_cast<int>(SendDlgItemMessage(hDlg, IDC_PRESET_COMBO, CB_GETCURSEL, 0, 0));
+    if (presetIndex == AUTO_PRESET_INDEX) {
+        m_settings.qualityPreset = AUTO_PRESET;
+    } else if (presetIndex > CUSTOM_PRESET_INDEX && presetIndex < AUTO_PRESET_INDEX) {
+        m_settings.qualityPreset = GetQualityPresetInfo(static_cast<QualityPreset>(presetIndex - 1)).name;
+    } else {
+        m_settings.qualityPreset.clear();
+    }
+}
+
+void ConfigDialog::SaveSettingsFromDialog(HWND hDlg) {
+    ReadSettingsFromDialog(hDlg);
     m_settingsManager->SaveSettings(m_settings);
 }
 
+// Keep what has been edited elsewhere in the dialog, apply the preset over
+// it, and show the result
+void ConfigDialog::OnPresetSelected(HWND hDlg) {
+    ReadSettingsFromDialog(hDlg);
+    if (!m_settings.qualityPreset.empty()) {
+        ResolveQualityPreset(m_settings, GetSystemMetrics(SM_CXVIRTUALSCREEN), GetSystemMetrics(SM_CYVIRTUALSCREEN),
+                             m_presetCosts);
+        LoadSettingsToDialog(hDlg);
+    }
+    UpdatePresetCost(hDlg);
+}
+
+void ConfigDialog::UpdatePresetCost(HWND hDlg) {
+    int width = GetSystemMetrics(SM_CXVIRTUALSCREEN);
+    int height = GetSystemMetrics(SM_CYVIRTUALSCREEN);
+    int presetIndex = static_cast<int>(SendDlgItemMessage(hDlg, IDC_PRESET_COMBO, CB_GETCURSEL, 0, 0));
+
+    wchar_t text[160] = {};
+    if (presetIndex == AUTO_PRESET_INDEX) {
+        float budgetMs = GetQualityFrameBudget(m_settings);
+        QualityPreset preset = ChooseQualityPreset(width, height, budgetMs, m_presetCosts);
+        const QualityPresetInfo& info = GetQualityPresetInfo(preset);
+        const PresetCost& cost = m_presetCosts[static_cast<size_t>(preset)];
+        if (cost.IsCalibrated()) {
+            std::swprintf(text, _countof(text), L"%ls: %.2f ms per frame predicted at %dx%d (budget %.2f ms)",
+                          info.displayName, cost.Predict(width, height), width, height, budgetMs);
+        } else {
+            std::swprintf(text, _countof(text), L"%ls: not yet measured on this machine, the governor adjusts it",
+                          info.displayName);
+        }
+    } else if (presetIndex > CUSTOM_PRESET_INDEX && presetIndex < AUTO_PRESET_INDEX) {
+        const PresetCost& cost = m_presetCosts[static_cast<size_t>(presetIndex - 1)];
+        if (cost.IsCalibrated()) {
+            std::swprintf(text, _countof(text), L"%.2f ms per frame predicted at %dx%d",
+                          cost.Predict(width, height), width, height);
+        } else {
+            std::swprintf(text, _countof(text), L"Not yet measured on this machine; running it once measures it");
+        }
+    }
+    SetDlgItemText(hDlg, IDC_PRESET_COST, text);
+}
+
 void ConfigDialog::OnCommand(HWND hDlg, WPARAM wParam, LPARAM lParam) {
     UNREFERENCED_PARAMETER(lParam);
     
@@ -268,8 +380,19 @@ void ConfigDialog::OnCommand(HWND hDlg, WPARAM wParam, LPARAM lParam) {
         UpdatePreview(hDlg);
         break;
         
+    case IDC_PRESET_COMBO:
+        if (HIWORD(wParam) == CBN_SELCHANGE) {
+            OnPresetSelected(hDlg);
+            UpdatePreview(hDlg);
+        }
+        break;
+        
     default:
         if (HIWORD(wParam) == CBN_SELCHANGE || HIWORD(wParam) == BN_CLICKED) {
+            if (IsPresetControl(LOWORD(wParam))) {
+                SendDlgItemMessage(hDlg, IDC_PRESET_COMBO, CB_SETCURSEL, CUSTOM_PRESET_INDEX, 0);
+                UpdatePresetCost(hDlg);
+            }
             UpdatePreview(hDlg);
         }
         break;
@@ -278,7 +401,10 @@ void ConfigDialog::OnCommand(HWND hDlg, WPARAM wParam, LPARAM lParam) {
 
 void ConfigDialog::OnHScroll(HWND hDlg, WPARAM wParam, LPARAM lParam) {
     UNREFERENCED_PARAMETER(wParam);
-    UNREFERENCED_PARAMETER(lParam);
+    if (lParam && IsPresetControl(GetDlgCtrlID(reinterpret_cast<HWND>(lParam)))) {
+        SendDlgItemMessage(hDlg, IDC_PRESET_COMBO, CB_SETCURSEL, CUSTOM_PRESET_INDEX, 0);
+        UpdatePresetCost(hDlg);
+    }
     UpdatePreview(hDlg);
 }
 
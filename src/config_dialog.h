@@ -15,7 +15,10 @@ private:
     
     bool Initialize(HWND hDlg);
     void LoadSettingsToDialog(HWND hDlg);
+    void ReadSettingsFromDialog(HWND hDlg);
     void SaveSettingsFromDialog(HWND hDlg);
+    void OnPresetSelected(HWND hDlg);
+    void UpdatePresetCost(HWND hDlg);
     void OnCommand(HWND hDlg, WPARAM wParam, LPARAM lParam);
     void OnHScroll(HWND hDlg, WPARAM wParam, LPARAM lParam);
     void UpdatePreview(HWND hDlg);
@@ -23,4 +26,5 @@ private:
     
     std::unique_ptr<SettingsManager> m_settingsManager;
     MatrixSettings m_settings;
+    PresetCosts m_presetCosts;      // Loaded once; predictions for the preset combo
 };
\ No newline at end of file
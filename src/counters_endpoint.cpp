@@ -0,0 +1,186 @@
+#include "counters_endpoint.h"
+#include "logger.h"
+#include <winsock2.h>
+#include <afunix.h>
+#include <cstring>
+#include <new>
+
+CountersEndpoint::~CountersEndpoint() {
+    Stop();
+}
+
+bool CountersEndpoint::Start(int instanceId, bool enableSocket) {
+    if (m_block) return true;
+
+    std::wstring name = L"Local\\MatrixScreensaverCounters" + std::to_wstring(instanceId);
+    m_mapping = CreateFileMapping(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                  0, sizeof(LiveCounterBlock), name.c_str());
+    if (!m_mapping) {
+        LOG_ERROR("Failed to create counters page (error {})", GetLastError());
+        return false;
+    }
+
+    void* view = MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(LiveCounterBlock));
+    if (!view) {
+        LOG_ERROR("Failed to map counters page (error {})", GetLastError());
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+        return false;
+    }
+
+    m_block = new (view) LiveCounterBlock();
+    m_block->processId = GetCurrentProcessId();
+    LOG_INFO("Counters page published as MatrixScreensaverCounters{}", instanceId);
+
+    if (enableSocket) {
+        StartSocket(instanceId);
+    }
+    return true;
+}
+
+void CountersEndpoint::Stop() {
+    StopSocket();
+
+    if (m_block) {
+        m_block->~LiveCounterBlock();
+        UnmapViewOfFile(m_block);
+        m_block = nullptr;
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+}
+
+void CountersEndpoint::Publish(const LiveCounters& counters) {
+    if (m_block) {
+        WriteLiveCounters(*m_block, counters);
+    }
+}
+
+bool CountersEndpoint::StartSocket(int instanceId) {
+    std::wstring directory = Logger::GetDataDirectory();
+    if (directory.empty()) return false;
+
+    m_socketPath = directory + L"\\counters" + std::to_wstring(instanceId) + L".sock";
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (m_socketPath.size() >= sizeof(address.sun_path)) {
+        LOG_WARNING("Counters socket path too long, socket disabled");
+        return false;
+    }
+    for (size_t i = 0; i < m_socketPath.size(); ++i) {
+        address.sun_path[i] = static_cast<char>(m_socketPath[i]); // ASCII paths, as for the log file
+    }
+
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        LOG_WARNING("WSAStartup failed, counters socket disabled");
+        return false;
+    }
+    m_winsockStarted = true;
+
+    SOCKET listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener == INVALID_SOCKET) {
+        LOG_WARNING("AF_UNIX sockets unavailable (error {}), counters socket disabled", WSAGetLastError());
+        StopSocket();
+        return false;
+    }
+
+    // A previous run may have left its socket file behind
+    DeleteFile(m_socketPath.c_str());
+
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == SOCKET_ERROR ||
+        listen(listener, 4) == SOCKET_ERROR) {
+        LOG_WARNING("Failed to bind counters socket (error {})", WSAGetLastError());
+        closesocket(listener);
+        StopSocket();
+        return false;
+    }
+
+    m_listenSocket = static_cast<uintptr_t>(listener);
+    m_serving.store(true, std::memory_order_release);
+    m_server = std::thread(&CountersEndpoint::ServeLoop, this);
+
+    LOG_INFO("Counters socket listening");
+    return true;
+}
+
+void CountersEndpoint::StopSocket() {
+    m_serving.store(false, std::memory_order_release);
+
+    // Closing the listener wakes the blocked accept()
+    if (m_listenSocket != ~uintptr_t(0)) {
+        closesocket(static_cast<SOCKET>(m_listenSocket));
+        m_listenSocket = ~uintptr_t(0);
+    }
+    if (m_server.joinable()) {
+        m_server.join();
+    }
+    if (!m_socketPath.empty()) {
+        DeleteFile(m_socketPath.c_str());
+        m_socketPath.clear();
+    }
+    if (m_winsockStarted) {
+        WSACleanup();
+        m_winsockStarted = false;
+    }
+}
+
+void CountersEndpoint::ServeLoop() {
+    SOCKET listener = static_cast<SOCKET>(m_listenSocket);
+
+    while (m_serving.load(std::memory_order_acquire)) {
+        SOCKET client = accept(listener, nullptr, nullptr);
+        if (client == INVALID_SOCKET) {
+            if (!m_serving.load(std::memory_order_acquire)) break;
+            Sleep(100); // Transient failure; don't spin
+            continue;
+        }
+
+        ServeClient(static_cast<uintptr_t>(client));
+        closesocket(client);
+    }
+}
+
+void CountersEndpoint::ServeClient(uintptr_t clientHandle) {
+    SOCKET client = static_cast<SOCKET>(clientHandle);
+
+    // A slow or silent client gets JSON after a short wait instead of holding the thread
+    DWORD timeoutMs = 200;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeoutMs), sizeof(timeoutMs));
+
+    char request[512];
+    int received = recv(client, request, sizeof(request) - 1, 0);
+    std::string_view requestText(request, received > 0 ? static_cast<size_t>(received) : 0);
+
+    bool http = requestText.starts_with("GET ");
+    bool prometheus = http ? requestText.starts_with("GET /metrics") : requestText.starts_with("prometheus");
+
+    LiveCounters counters;
+    std::string body;
+    if (!ReadLiveCounters(*m_block, counters)) {
+        body = "{\"error\":\"busy\"}\n";
+        prometheus = false;
+    } else {
+        body = prometheus ? FormatLiveCountersPrometheus(counters) : FormatLiveCountersJson(counters);
+    }
+
+    std::string response;
+    if (http) {
+        response = "HTTP/1.0 200 OK\r\nContent-Type: ";
+        response += prometheus ? "text/plain; version=0.0.4" : "application/json";
+        response += "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+    }
+    response += body;
+
+    const char* data = response.data();
+    int remaining = static_cast<int>(response.size());
+    while (remaining > 0) {
+        int sent = send(client, data, remaining, 0);
+        if (sent <= 0) break;
+        data += sent;
+        remaining -= sent;
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "common.h"
+#include "live_counters.h"
+#include <atomic>
+#include <thread>
+
+// Publishes LiveCounters for local monitoring agents.
+//
+// The snapshot lives in a named shared-memory page,
+// Local\MatrixScreensaverCounters<instance>, laid out as a LiveCounterBlock.
+// Optionally a UNIX-domain socket, counters<instance>.sock in the data
+// directory, serves the same data: an HTTP "GET /metrics" (or a bare
+// "prometheus" line) gets Prometheus text, anything else JSON.
+// The socket thread only reads the shared page, so the render loop never
+// waits on a client.
+class CountersEndpoint {
+public:
+    CountersEndpoint() = default;
+    ~CountersEndpoint();
+
+    CountersEndpoint(const CountersEndpoint&) = delete;
+    CountersEndpoint& operator=(const CountersEndpoint&) = delete;
+
+    bool Start(int instanceId, bool enableSocket);
+    void Stop();
+
+    bool IsRunning() const { return m_block != nullptr; }
+
+    // Render thread; cheap enough to call a few times a second
+    void Publish(const LiveCounters& counters);
+
+private:
+    bool StartSocket(int instanceId);
+    void StopSocket();
+    void ServeLoop();
+    void ServeClient(uintptr_t client);
+
+    HANDLE m_mapping = nullptr;
+    LiveCounterBlock* m_block = nullptr;
+
+    // Socket server; sockets are kept as integers so this header needs no winsock
+    uintptr_t m_listenSocket = ~uintptr_t(0);
+    bool m_winsockStarted = false;
+    std::wstring m_socketPath;
+    std::thread m_server;
+    std::atomic<bool> m_serving{false};
+};
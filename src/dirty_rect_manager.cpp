@@ -22,13 +22,11 @@ void DirtyRectManager::Initialize(int screenWidth, int screenHeight, int tileSiz
         row.resize(m_tilesX, false);
     }
     
-    // Reserve space for typical dirty region count
-    m_dirtyRegions.reserve(m_tilesX * m_tilesY / 4); // Estimate 25% dirty
-    m_dirtyTiles.reserve(m_tilesX * m_tilesY / 4);
+    // Reserve for every tile so marking and region building never allocate
+    m_dirtyRegions.reserve(m_tilesX * m_tilesY);
+    m_dirtyTiles.reserve(m_tilesX * m_tilesY);
     
-    LOG_DEBUG("DirtyRectManager initialized: " + 
-             std::to_string(m_tilesX) + "x" + std::to_string(m_tilesY) + 
-             " tiles (" + std::to_string(tileSize) + "px each)");
+    LOG_DEBUG("DirtyRectManager initialized: {}x{} tiles ({}px each)", m_tilesX, m_tilesY, tileSize);
 }
 
 void DirtyRectManager::Reset() {
@@ -49,7 +47,7 @@ void DirtyRectManager::MarkDirty(const D2D1_RECT_F& rect) {
         for (int x = leftTile; x <= rightTile; ++x) {
             if (!m_dirtyGrid[y][x]) {
                 m_dirtyGrid[y][x] = true;
-                m_dirtyTiles.insert(GetTileIndex(x, y));
+                m_dirtyTiles.push_back(GetTileIndex(x, y));
                 m_regionsNeedUpdate = true;
             }
         }
@@ -63,7 +61,7 @@ void DirtyRectManager::MarkDirty(int gridX, int gridY) {
     
     if (!m_dirtyGrid[gridY][gridX]) {
         m_dirtyGrid[gridY][gridX] = true;
-        m_dirtyTiles.insert(GetTileIndex(gridX, gridY));
+        m_dirtyTiles.push_back(GetTileIndex(gridX, gridY));
         m_regionsNeedUpdate = true;
     }
 }
@@ -81,7 +79,7 @@ void DirtyRectManager::MarkDirty(int gridX, int gridY, int width, int height) {
         for (int x = gridX; x < endX; ++x) {
             if (!m_dirtyGrid[y][x]) {
                 m_dirtyGrid[y][x] = true;
-                m_dirtyTiles.insert(GetTileIndex(x, y));
+                m_dirtyTiles.push_back(GetTileIndex(x, y));
             }
         }
     }
@@ -138,8 +136,10 @@ void DirtyRectManager::MarkFullScreenDirty() {
     // Mark all tiles as dirty
     for (int y = 0; y < m_tilesY; ++y) {
         for (int x = 0; x < m_tilesX; ++x) {
-            m_dirtyGrid[y][x] = true;
-            m_dirtyTiles.insert(GetTileIndex(x, y));
+            if (!m_dirtyGrid[y][x]) {
+                m_dirtyGrid[y][x] = true;
+                m_dirtyTiles.push_back(GetTileIndex(x, y));
+            }
         }
     }
     
@@ -190,9 +190,6 @@ void DirtyRectManager::OptimizeRegions() {
     
     if (m_dirtyRegions.size() < 2) return;
     
-    std::vector<DirtyRegion> optimized;
-    optimized.reserve(m_dirtyRegions.size());
-    
     // Sort by top, then left
     std::sort(m_dirtyRegions.begin(), m_dirtyRegions.end(),
         [](const DirtyRegion& a, const DirtyRegion& b) {
@@ -200,9 +197,11 @@ void DirtyRectManager::OptimizeRegions() {
             return a.rect.left < b.rect.left;
         });
     
-    DirtyRegion current = m_dirtyRegions[0];
+    // Merge in place so no scratch vector is allocated per frame
+    size_t writeIndex = 0;
     
     for (size_t i = 1; i < m_dirtyRegions.size(); ++i) {
+        DirtyRegion& current = m_dirtyRegions[writeIndex];
         const auto& next = m_dirtyRegions[i];
         
         // Check if we can merge horizontally
@@ -213,12 +212,10 @@ void DirtyRectManager::OptimizeRegions() {
             // Merge rectangles
             current.rect.right = next.rect.right;
         } else {
-            // Can't merge, save current and start new one
-            optimized.push_back(current);
-            current = next;
+            // Can't merge, keep current and start new one
+            m_dirtyRegions[++writeIndex] = next;
         }
     }
     
-    optimized.push_back(current);
-    m_dirtyRegions = std::move(optimized);
+    m_dirtyRegions.resize(writeIndex + 1);
 }
\ No newline at end of file
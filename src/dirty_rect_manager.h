@@ -2,7 +2,6 @@
 
 #include "common.h"
 #include <vector>
-#include <unordered_set>
 
 struct DirtyRegion {
     D2D1_RECT_F rect;
@@ -57,8 +56,9 @@ private:
     // Grid of dirty flags
     std::vector<std::vector<bool>> m_dirtyGrid;
     
-    // Set of dirty tile indices for fast lookup
-    std::unordered_set<int> m_dirtyTiles;
+    // Indices of dirty tiles; m_dirtyGrid keeps entries unique, and capacity
+    // covers every tile so marking never allocates
+    std::vector<int> m_dirtyTiles;
     
     // Cached dirty regions for rendering
     std::vector<DirtyRegion> m_dirtyRegions;
@@ -0,0 +1,540 @@
+#include "display_manager.h"
+#include "mask_loader.h"
+#include "logger.h"
+#include "quality_presets.h"
+#include "settings_schema.h"
+#include "sim_warm_start.h"
+
+namespace {
+
+// Since the process was created, so startup times include loading the
+// executable and everything before wWinMain
+float GetMsSinceLaunch() {
+    FILETIME creation, exitTime, kernelTime, userTime, now;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernelTime, &userTime)) return 0.0f;
+    GetSystemTimePreciseAsFileTime(&now);
+
+    auto ticks = [](const FILETIME& time) {
+        return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    };
+    uint64_t elapsed = ticks(now) > ticks(creation) ? ticks(now) - ticks(creation) : 0;
+    return static_cast<float>(elapsed / 10000.0);   // 100 ns units
+}
+
+std::filesystem::path GetWarmStartPath() {
+    std::wstring directory = Logger::GetDataDirectory();
+    return (directory.empty() ? L"" : directory + L"\\") + L"warm_start.mxws";
+}
+
+std::filesystem::path GetPresetTimingsPath() {
+    std::wstring directory = Logger::GetDataDirectory();
+    return (directory.empty() ? L"" : directory + L"\\") + PRESET_TIMINGS_FILE;
+}
+
+} // namespace
+
+DisplayManager::DisplayManager()
+    : m_simHost(std::make_unique<SimulationHost>()) {
+}
+
+DisplayManager::~DisplayManager() {
+    Shutdown();
+}
+
+bool DisplayManager::Initialize(const MatrixSettings& settings) {
+    m_settings = settings;
+
+    // None of these need a window, so they run while the windows are created
+    m_graphicsReady = std::async(std::launch::async, [this] {
+        bool available = m_graphics.Initialize();
+        m_startupTimes.deviceMs = GetMsSinceLaunch();
+        return available;
+    });
+    StartMaskLoad();
+    StartSimulationLayout();
+    return true;
+}
+
+bool DisplayManager::WaitForGraphics() {
+    if (m_graphicsReady.valid()) {
+        m_graphicsAvailable = m_graphicsReady.get();
+        if (!m_graphicsAvailable) {
+            LOG_ERROR("Failed to create the graphics device");
+        }
+    }
+    return m_graphicsAvailable;
+}
+
+void DisplayManager::Shutdown() {
+    // Startup work still in flight uses the members torn down below
+    if (m_graphicsReady.valid()) m_graphicsReady.wait();
+    if (m_simulationLayout.valid()) m_simulationLayout.wait();
+    if (m_maskLoad.valid()) m_maskLoad.wait();
+
+    RecordPresetTiming();
+    for (Output& output : m_outputs) {
+        output.renderer->Shutdown();
+    }
+    m_outputs.clear();
+
+    if (m_simHost) {
+        m_simHost->Stop();
+
+        // A capture's session starts cold, so it has nothing to save
+        if (m_simulationStarted && m_settings.enableWarmStart && !m_settings.enableSimCapture &&
+            !SaveWarmStart(GetWarmStartPath(), m_simHost->GetSimulation())) {
+            LOG_WARNING("Failed to save the warm start");
+        }
+
+        if (SimRecorder* recorder = m_simHost->GetRecorder()) {
+            LOG_INFO("Simulation capture closed after {} frames", recorder->GetFrameCount());
+            m_simHost->SetRecorder(nullptr);
+        }
+        m_simHost->GetSimulation().Clear();
+    }
+    m_simulationStarted = false;
+
+    m_graphics.Shutdown();
+}
+
+bool DisplayManager::AddOutput(HWND hwnd) {
+    if (!WaitForGraphics()) return false;
+
+    auto renderer = std::make_unique<MatrixRenderer>();
+    if (!renderer->Initialize(hwnd, m_settings, m_graphics)) {
+        renderer->Shutdown();
+        return false;
+    }
+    if (m_maskReady) {
+        renderer->SetMask(m_mask.get());
+    }
+    if (m_startupTimes.firstOutputMs == 0.0f) {
+        m_startupTimes.firstOutputMs = GetMsSinceLaunch();
+    }
+
+    Output output;
+    output.hwnd = hwnd;
+    GetWindowRect(hwnd, &output.rect);
+    output.renderer = std::move(renderer);
+    m_outputs.push_back(std::move(output));
+
+    LOG_INFO("Output {} added at ({}, {}) ({} total)", m_outputs.back().renderer->GetInstanceId(),
+             m_outputs.back().rect.left, m_outputs.back().rect.top, m_outputs.size());
+    UpdateLayout();
+    return true;
+}
+
+void DisplayManager::RemoveOutput(HWND hwnd) {
+    auto it = std::find_if(m_outputs.begin(), m_outputs.end(),
+                           [hwnd](const Output& output) { return output.hwnd == hwnd; });
+    if (it == m_outputs.end()) return;
+
+    it->renderer->Shutdown();
+    m_outputs.erase(it);
+    UpdateLayout();
+}
+
+void DisplayManager::Resize(HWND hwnd, int width, int height) {
+    for (Output& output : m_outputs) {
+        if (output.hwnd != hwnd) continue;
+
+        output.renderer->Resize(width, height);
+        GetWindowRect(hwnd, &output.rect);
+        UpdateLayout();
+        return;
+    }
+}
+
+void DisplayManager::UpdateSettings(const MatrixSettings& settings) {
+    SettingsInvalidation changes = ClassifySettingsChange(m_settings, settings);
+    m_settings = settings;
+    for (Output& output : m_outputs) {
+        output.renderer->UpdateSettings(settings);
+    }
+    StartPresetTiming();
+
+    // The new image is applied once decoded; the old one goes now
+    if (HasAny(changes, SettingsInvalidation::Mask)) {
+        StartMaskLoad();
+        if (settings.maskImagePath.empty() && m_simulationStarted) {
+            ApplyDensityMap({});
+        }
+    }
+
+    if (!m_simulationStarted) return;
+
+    // Palette, font and pacing changes never reach the simulation
+    if (HasAny(changes, SettingsInvalidation::Effects | SettingsInvalidation::Glyphs | SettingsInvalidation::Layout)) {
+        // Nothing here touches the simulation or the glyph table directly; the
+        // host applies the change between updates, interning the custom word
+        // on the simulation's thread
+        m_simHost->Post([settings](MatrixSimulation& simulation, SimRecorder* recorder) {
+            simulation.UpdateSettings(settings);
+            if (recorder) {
+                recorder->RecordSettings(settings);
+            }
+        });
+    }
+
+    if (HasAny(changes, SettingsInvalidation::Runtime)) {
+        // A capture can only start with the simulation, so turning it on takes effect next run
+        if (!settings.enableSimCapture) {
+            m_simHost->StopRecording();
+        }
+
+        if (settings.enableSimulationThread) {
+            m_simHost->Start();
+        } else {
+            m_simHost->Stop();
+        }
+    }
+}
+
+void DisplayManager::StartSimulationLayout() {
+    // The windows will cover the monitors, whose bounding box is the virtual
+    // screen; StartSimulation checks that guess against the real layout
+    int width = GetSystemMetrics(SM_CXVIRTUALSCREEN);
+    int height = GetSystemMetrics(SM_CYVIRTUALSCREEN);
+
+    // Seed from the clock; a capture records the seed so it can be replayed
+    uint32_t seed = static_cast<uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+
+    m_simulationLayout = std::async(std::launch::async, [this, settings = m_settings, width, height, seed] {
+        m_simHost->GetSimulation().Initialize(settings, width, height, seed);
+    });
+}
+
+void DisplayManager::StartSimulation() {
+    int width = m_desktop.right - m_desktop.left;
+    int height = m_desktop.bottom - m_desktop.top;
+
+    MatrixSimulation& simulation = m_simHost->GetSimulation();
+    if (m_simulationLayout.valid()) {
+        m_simulationLayout.get();
+    }
+
+    // Start over if the guess was wrong or the settings changed meanwhile,
+    // so a capture's Initialize record is exactly what ran
+    if (simulation.GetWidth() != width || simulation.GetHeight() != height ||
+        !DiffSettings(simulation.GetSettings(), m_settings).empty()) {
+        simulation.Initialize(m_settings, width, height, simulation.GetSeed());
+    }
+    m_simulationStarted = true;
+
+    // Pick up where the last session left off; a capture has to start from
+    // exactly what its Initialize record describes
+    bool warmStarted = false;
+    if (m_settings.enableWarmStart && !m_settings.enableSimCapture) {
+        warmStarted = LoadWarmStart(GetWarmStartPath(), simulation);
+        if (warmStarted) {
+            LOG_INFO("Warm start restored {} cells", simulation.GetActiveCells().size());
+        } else {
+            LOG_DEBUG("No usable warm start, starting cold");
+        }
+    }
+
+    if (m_settings.enableSimCapture) {
+        StartCapture();
+    }
+
+    // Otherwise skip the seconds of an empty screen filling up
+    if (!warmStarted && m_settings.startupFastForward > 0.0f) {
+        simulation.FastForward(m_settings.startupFastForward);
+        if (SimRecorder* recorder = m_simHost->GetRecorder()) {
+            recorder->RecordFastForward(m_settings.startupFastForward);
+        }
+        LOG_DEBUG("Fast-forwarded {:.1f} s to {} cells", m_settings.startupFastForward, simulation.GetActiveCells().size());
+    }
+
+    if (!m_settings.maskImagePath.empty() && m_maskReady) {
+        CreateDensityMap();
+    }
+
+    UpdateLayout();
+
+    if (m_settings.enableSimulationThread) {
+        m_simHost->Start();
+    }
+
+    m_startupTimes.simulationMs = GetMsSinceLaunch();
+    LOG_INFO("Simulation started over {}x{} for {} outputs", width, height, m_outputs.size());
+}
+
+void DisplayManager::StartCapture() {
+    std::wstring directory = Logger::GetDataDirectory();
+    std::wstring path = (directory.empty() ? L"" : directory + L"\\") +
+        L"sim_capture_" + std::to_wstring(GetCurrentProcessId()) + L".mxrp";
+
+    auto recorder = std::make_unique<SimRecorder>();
+    if (!recorder->Open(path)) {
+        LOG_WARNING("Failed to open simulation capture file");
+        return;
+    }
+
+    MatrixSimulation& simulation = m_simHost->GetSimulation();
+    recorder->RecordInitialize(m_settings, simulation.GetWidth(), simulation.GetHeight(), simulation.GetSeed());
+    m_simHost->SetRecorder(std::move(recorder));
+    LOG_INFO("Recording simulation capture (seed {})", simulation.GetSeed());
+}
+
+void DisplayManager::StartPresetTiming() {
+    // Only frames of a known preset at a known size say what that preset costs
+    PresetTiming timing;
+    bool timed = !m_settings.qualityPreset.empty() && !m_outputs.empty() &&
+                 MatchQualityPreset(m_settings, timing.preset);
+    if (timed) {
+        timing.width = m_desktop.right - m_desktop.left;
+        timing.height = m_desktop.bottom - m_desktop.top;
+    }
+    if (timed == m_presetTimed && (!timed || (timing.preset == m_presetTiming.preset &&
+        timing.width == m_presetTiming.width && timing.height == m_presetTiming.height))) {
+        return;
+    }
+
+    RecordPresetTiming();
+    m_presetTimed = timed;
+    m_presetTiming = timing;
+    m_presetSampler.Reset();
+}
+
+void DisplayManager::SamplePresetFrame() {
+    if (!m_presetTimed) return;
+
+    // The simulation's phases are folded into every output's frame; count them once
+    float frameMs = 0.0f;
+    bool fullQuality = true;
+    for (size_t i = 0; i < m_outputs.size(); ++i) {
+        FrameSample sample;
+        if (!m_outputs[i].renderer->GetLatestFrameSample(sample)) return;
+
+        float outputMs = sample.frameMs;
+        if (i > 0) {
+            for (ProfilePhase phase : { ProfilePhase::UpdateColumns, ProfilePhase::UpdateGrid, ProfilePhase::Effects }) {
+                outputMs -= sample.phaseMs[static_cast<size_t>(phase)];
+            }
+        }
+        frameMs += outputMs;
+        fullQuality = fullQuality && m_outputs[i].renderer->IsAtFullQuality();
+    }
+    m_presetSampler.AddFrame(frameMs, fullQuality);
+}
+
+void DisplayManager::RecordPresetTiming() {
+    if (!m_presetTimed) return;
+    m_presetTimed = false;
+
+    if (!m_presetSampler.GetMedian(m_presetTiming.frameMs)) return;
+    if (!AppendPresetTiming(GetPresetTimingsPath(), m_presetTiming)) {
+        LOG_WARNING("Failed to save the preset timing");
+        return;
+    }
+    LOG_INFO("Preset timing {:.2f} ms per frame at {}x{}", m_presetTiming.frameMs,
+             m_presetTiming.width, m_presetTiming.height);
+}
+
+void DisplayManager::UpdateLayout() {
+    if (m_outputs.empty()) return;
+
+    RECT desktop = m_outputs[0].rect;
+    for (const Output& output : m_outputs) {
+        UnionRect(&desktop, &desktop, &output.rect);
+    }
+
+    int width = desktop.right - desktop.left;
+    int height = desktop.bottom - desktop.top;
+    bool resized = width != m_desktop.right - m_desktop.left || height != m_desktop.bottom - m_desktop.top;
+    m_desktop = desktop;
+    StartPresetTiming();
+
+    if (!m_simulationStarted) return;
+
+    if (resized) {
+        m_simHost->Post([width, height](MatrixSimulation& simulation, SimRecorder* recorder) {
+            simulation.Resize(width, height);
+            if (recorder) {
+                recorder->RecordResize(width, height);
+            }
+        });
+        if (!m_settings.maskImagePath.empty() && m_maskReady) {
+            CreateDensityMap();
+        }
+    }
+
+    // Viewports are relative to the bounding box, which is the simulation's origin
+    std::vector<SimViewport> viewports;
+    viewports.reserve(m_outputs.size());
+    for (const Output& output : m_outputs) {
+        SimViewport viewport;
+        viewport.id = static_cast<uint32_t>(output.renderer->GetInstanceId());
+        viewport.left = output.rect.left - desktop.left;
+        viewport.top = output.rect.top - desktop.top;
+        viewport.right = output.rect.right - desktop.left;
+        viewport.bottom = output.rect.bottom - desktop.top;
+        viewports.push_back(viewport);
+    }
+    m_simHost->SetViewports(std::move(viewports));
+}
+
+void DisplayManager::StartMaskLoad() {
+    m_mask.reset();
+    m_maskReady = false;
+    if (m_settings.maskImagePath.empty()) {
+        m_maskLoad = {};
+        return;
+    }
+
+    m_maskLoad = std::async(std::launch::async, [path = m_settings.maskImagePath]() -> std::shared_ptr<const BitmapData> {
+        // WIC needs COM on this thread too
+        HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        std::shared_ptr<const BitmapData> mask;
+        {
+            MaskLoader loader;
+            if (loader.LoadFromFile(path)) {
+                mask = std::make_shared<const BitmapData>(loader.ReleaseBitmapData());
+            }
+        }
+        if (SUCCEEDED(hr)) {
+            CoUninitialize();
+        }
+        return mask;
+    });
+}
+
+void DisplayManager::UpdateMask() {
+    if (!m_maskLoad.valid() || m_maskLoad.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+
+    m_mask = m_maskLoad.get();
+    m_maskReady = true;
+    if (!m_mask) {
+        LOG_WARNING("Failed to load mask image");
+    }
+
+    for (Output& output : m_outputs) {
+        output.renderer->SetMask(m_mask.get());
+    }
+    if (m_simulationStarted) {
+        CreateDensityMap();
+    }
+}
+
+void DisplayManager::CreateDensityMap() {
+    int width = m_desktop.right - m_desktop.left;
+    int height = m_desktop.bottom - m_desktop.top;
+
+    // The mask is stretched over the whole desktop, as the outputs draw it
+    if (m_mask) {
+        ApplyDensityMap(MaskLoader::CreateDensityMap(*m_mask, width, height));
+        return;
+    }
+
+    // If loading failed, create uniform density
+    ApplyDensityMap(std::vector<std::vector<float>>(width, std::vector<float>(height, m_settings.density)));
+}
+
+void DisplayManager::ApplyDensityMap(const std::vector<std::vector<float>>& densityMap) {
+    // The simulation keeps depth as bytes, row-major; cells store depth as a
+    // byte anyway, and the compact map is what a capture records
+    int width = static_cast<int>(densityMap.size());
+    int height = width > 0 ? static_cast<int>(densityMap[0].size()) : 0;
+
+    std::vector<uint8_t> depthMap(static_cast<size_t>(width) * height);
+    for (int x = 0; x < width; ++x) {
+        for (int y = 0; y < height; ++y) {
+            depthMap[static_cast<size_t>(y) * width + x] =
+                static_cast<uint8_t>(std::clamp(densityMap[x][y], 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+    }
+
+    m_simHost->Post([width, height, depthMap = std::move(depthMap)](MatrixSimulation& simulation, SimRecorder* recorder) mutable {
+        if (recorder) {
+            recorder->RecordDepthMap(width, height, depthMap);
+        }
+        simulation.SetDepthMap(width, height, std::move(depthMap));
+    });
+}
+
+void DisplayManager::SetFrameLateness(float latenessMs) {
+    for (Output& output : m_outputs) {
+        output.renderer->SetFrameLateness(latenessMs);
+    }
+}
+
+float DisplayManager::GetTargetFrameRate() const {
+    float rate = 0.0f;
+    for (const Output& output : m_outputs) {
+        rate = std::max(rate, output.renderer->GetTargetFrameRate());
+    }
+    return rate > 0.0f ? rate : 60.0f;
+}
+
+void DisplayManager::Update(float deltaTime) {
+    if (m_outputs.empty()) return;
+
+    if (!m_simulationStarted) {
+        StartSimulation();
+    }
+    UpdateMask();
+
+    bool timing = false;
+    for (Output& output : m_outputs) {
+        output.renderer->Update(deltaTime);
+        timing = timing || output.renderer->WantsSimulationTiming();
+    }
+
+    // Inline this runs the update; threaded it releases the next one, which
+    // overlaps drawing the snapshot the previous update published
+    m_simHost->SetProfiling(timing);
+    m_simHost->Advance(deltaTime);
+}
+
+void DisplayManager::Render() {
+    if (m_outputs.empty()) return;
+
+    // One snapshot for every output; it stays put until the next acquire
+    m_simHost->AcquireSnapshot();
+    const FrameSnapshot& snapshot = m_simHost->GetSnapshot();
+
+    for (Output& output : m_outputs) {
+        output.renderer->Draw(snapshot);
+    }
+
+    // Present together once every output has its frame; a blocking present
+    // per output would cost one vblank each
+    for (size_t i = 0; i < m_outputs.size(); ++i) {
+        m_outputs[i].renderer->Present(i + 1 == m_outputs.size());
+    }
+    SamplePresetFrame();
+
+    if (m_startupTimes.firstFrameMs == 0.0f) {
+        m_startupTimes.firstFrameMs = GetMsSinceLaunch();
+        for (Output& output : m_outputs) {
+            output.renderer->SetTimeToFirstFrame(m_startupTimes.firstFrameMs);
+        }
+        LOG_INFO("First frame presented {:.1f} ms after launch (device {:.1f}, first output {:.1f}, simulation {:.1f})",
+                 m_startupTimes.firstFrameMs, m_startupTimes.deviceMs,
+                 m_startupTimes.firstOutputMs, m_startupTimes.simulationMs);
+    }
+
+    UpdateSimulationQuality();
+}
+
+void DisplayManager::UpdateSimulationQuality() {
+    // The simulation runs at the quality the most loaded output needs
+    SimQuality quality;
+    for (const Output& output : m_outputs) {
+        const SimQuality& wanted = output.renderer->GetSimQuality();
+        quality.columnFraction = std::min(quality.columnFraction, wanted.columnFraction);
+        quality.effectScale = std::min(quality.effectScale, wanted.effectScale);
+        quality.effectInterval = std::max(quality.effectInterval, wanted.effectInterval);
+    }
+
+    if (quality != m_simQuality) {
+        m_simQuality = quality;
+        m_simHost->Post([quality](MatrixSimulation& simulation, SimRecorder* recorder) {
+            simulation.SetQuality(quality);
+            if (recorder) {
+                recorder->RecordQuality(quality);
+            }
+        });
+    }
+}
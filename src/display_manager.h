@@ -0,0 +1,109 @@
+#pragma once
+
+#include "common.h"
+#include "graphics_device.h"
+#include "matrix_renderer.h"
+#include "quality_presets.h"
+#include "simulation_host.h"
+#include <future>
+
+// Milliseconds from process launch to each startup milestone, 0 until reached
+struct StartupTimes {
+    float deviceMs = 0.0f;          // Shared graphics device created
+    float firstOutputMs = 0.0f;     // First window ready to draw
+    float simulationMs = 0.0f;      // Simulation running
+    float firstFrameMs = 0.0f;      // First frame presented: time to first frame
+};
+
+// All screensaver windows of a session, one per monitor.
+//
+// Owns the GraphicsDevice every output draws with, one simulation covering
+// the bounding box of all windows in virtual-desktop coordinates, and one
+// MatrixRenderer per window. Rain runs on across monitor borders, and each
+// output's rectangle is a viewport of the simulation: snapshots are culled
+// and grouped by viewport, so an output only walks the cells it shows.
+//
+// Each frame the outputs draw one after another, then present back to back,
+// so the monitors show the same frame and only the last present waits for
+// vblank.
+//
+// Startup is a pipeline. Initialize starts creating the device, decoding the
+// mask and laying out the simulation's columns in the background, so they
+// overlap creating the windows. The first output waits only for the
+// device. The mask is applied to whichever frame follows its decode.
+class DisplayManager {
+public:
+    DisplayManager();
+    ~DisplayManager();
+
+    DisplayManager(const DisplayManager&) = delete;
+    DisplayManager& operator=(const DisplayManager&) = delete;
+
+    bool Initialize(const MatrixSettings& settings);
+    void Shutdown();
+
+    bool AddOutput(HWND hwnd);
+    void RemoveOutput(HWND hwnd);
+    bool HasOutputs() const { return !m_outputs.empty(); }
+
+    void Resize(HWND hwnd, int width, int height);
+    void UpdateSettings(const MatrixSettings& settings);
+
+    void SetFrameLateness(float latenessMs);
+    float GetTargetFrameRate() const;
+
+    void Update(float deltaTime);
+    void Render();
+
+    const StartupTimes& GetStartupTimes() const { return m_startupTimes; }
+
+private:
+    struct Output {
+        HWND hwnd = nullptr;
+        RECT rect = {};                         // Window in virtual-desktop coordinates
+        std::unique_ptr<MatrixRenderer> renderer;
+    };
+
+    bool WaitForGraphics();
+    void StartSimulationLayout();
+    void StartSimulation();
+    void StartCapture();
+    void StartMaskLoad();
+    void UpdateMask();
+    void UpdateLayout();
+    void CreateDensityMap();
+    void ApplyDensityMap(const std::vector<std::vector<float>>& densityMap);
+    void UpdateSimulationQuality();
+    void StartPresetTiming();
+    void SamplePresetFrame();
+    void RecordPresetTiming();
+
+    GraphicsDevice m_graphics;
+    std::future<bool> m_graphicsReady;          // Device creation, until the first output waits for it
+    bool m_graphicsAvailable = false;
+    std::vector<Output> m_outputs;
+
+    // The shared simulation, started with the first frame so every window
+    // created at startup is in its first layout
+    MatrixSettings m_settings;
+    std::unique_ptr<SimulationHost> m_simHost;
+    std::future<void> m_simulationLayout;       // Initialize over the virtual screen, in the background
+    bool m_simulationStarted = false;
+    RECT m_desktop = {};                        // Bounding box of the outputs
+    SimQuality m_simQuality;                    // Last quality posted to the simulation
+
+    // The mask image, decoded once in the background for the renderers and
+    // the simulation's depth map
+    std::future<std::shared_ptr<const BitmapData>> m_maskLoad;
+    std::shared_ptr<const BitmapData> m_mask;
+    bool m_maskReady = false;
+
+    StartupTimes m_startupTimes;
+
+    // Full frame times of the quality preset in use, appended to
+    // preset_timings.csv when the preset or the desktop size changes and at
+    // shutdown (see quality_presets.h)
+    PresetTimingSampler m_presetSampler;
+    PresetTiming m_presetTiming;                // Preset and size being timed
+    bool m_presetTimed = false;
+};
@@ -0,0 +1,65 @@
+#include "frame_arena.h"
+#include <algorithm>
+#include <cstdint>
+
+FrameArena::FrameArena(size_t initialCapacity) {
+    AddBlock(initialCapacity);
+}
+
+FrameArena::~FrameArena() {
+}
+
+void* FrameArena::Allocate(size_t bytes, size_t alignment) {
+    if (bytes == 0) bytes = 1;
+    
+    while (true) {
+        Block& block = m_blocks[m_currentBlock];
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+        uintptr_t aligned = (base + m_offset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+        size_t newOffset = static_cast<size_t>(aligned - base) + bytes;
+        
+        if (newOffset <= block.size) {
+            m_bytesUsed += newOffset - m_offset;
+            m_offset = newOffset;
+            return reinterpret_cast<void*>(aligned);
+        }
+        
+        // Move on to the next block, taking a new one from the heap if needed
+        if (m_currentBlock + 1 >= m_blocks.size()) {
+            AddBlock(std::max(bytes + alignment, block.size));
+            m_overflowCount++;
+        }
+        m_currentBlock++;
+        m_offset = 0;
+    }
+}
+
+void FrameArena::Reset() {
+    m_highWaterMark = std::max(m_highWaterMark, m_bytesUsed);
+    
+    // Fold overflow blocks into one so the next frame fits in a single block
+    if (m_blocks.size() > 1) {
+        size_t capacity = GetCapacity();
+        m_blocks.clear();
+        AddBlock(capacity);
+    }
+    
+    m_currentBlock = 0;
+    m_offset = 0;
+    m_bytesUsed = 0;
+}
+
+size_t FrameArena::GetCapacity() const {
+    size_t capacity = 0;
+    for (const auto& block : m_blocks) {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+void FrameArena::AddBlock(size_t minimumSize) {
+    Block block;
+    block.size = std::max<size_t>(minimumSize, 4096);
+    block.data = std::make_unique_for_overwrite<std::byte[]>(block.size);
+    m_blocks.push_back(std::move(block));
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Bump-pointer allocator for data that only lives for one frame.
+//
+// Allocation is a pointer increment; nothing is freed individually. Reset()
+// releases everything at once at the end of the frame. If a frame outgrows the
+// current block an overflow block is taken from the heap, and the next Reset()
+// folds all blocks into a single one sized for the high-water mark, so steady
+// state frames never touch the global heap.
+class FrameArena {
+public:
+    explicit FrameArena(size_t initialCapacity = 64 * 1024);
+    ~FrameArena();
+    
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+    
+    void* Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+    
+    // Invalidate every allocation made since the last reset
+    void Reset();
+    
+    size_t GetBytesUsed() const { return m_bytesUsed; }
+    size_t GetCapacity() const;
+    size_t GetHighWaterMark() const { return m_highWaterMark; }
+    size_t GetOverflowCount() const { return m_overflowCount; } // Heap blocks taken since startup
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size = 0;
+    };
+    
+    void AddBlock(size_t minimumSize);
+    
+    std::vector<Block> m_blocks;
+    size_t m_currentBlock = 0;
+    size_t m_offset = 0;
+    
+    size_t m_bytesUsed = 0;
+    size_t m_highWaterMark = 0;
+    size_t m_overflowCount = 0;
+};
+
+// Standard allocator adapter so containers can live in a FrameArena.
+// A null arena falls back to the global heap, which lets arena-aware
+// containers be default-constructed before an arena is attached.
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    
+    ArenaAllocator() noexcept = default;
+    explicit ArenaAllocator(FrameArena* arena) noexcept : m_arena(arena) {}
+    
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : m_arena(other.GetArena()) {}
+    
+    T* allocate(size_t count) {
+        if (m_arena) {
+            return static_cast<T*>(m_arena->Allocate(count * sizeof(T), alignof(T)));
+        }
+        return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+    
+    void deallocate(T* ptr, size_t count) noexcept {
+        // Arena memory is reclaimed wholesale by FrameArena::Reset()
+        if (!m_arena) {
+            ::operator delete(ptr, count * sizeof(T));
+        }
+    }
+    
+    FrameArena* GetArena() const noexcept { return m_arena; }
+    
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return m_arena == other.GetArena(); }
+
+private:
+    FrameArena* m_arena = nullptr;
+};
+
+template<typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+using FrameWString = std::basic_string<wchar_t, std::char_traits<wchar_t>, ArenaAllocator<wchar_t>>;
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include "frame_pacer.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+int64_t SteadyPacerClock::Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool SteadyPacerClock::Sleep(int64_t duration) {
+    std::this_thread::sleep_for(std::chrono::nanoseconds(duration));
+    return true;
+}
+
+void SteadyPacerClock::Relax() {
+    std::this_thread::yield();
+}
+
+FramePacer::FramePacer(PacerClock& clock, double targetRate)
+    : m_clock(clock) {
+    SetTargetRate(targetRate);
+}
+
+void FramePacer::SetTargetRate(double rate) {
+    rate = std::clamp(rate, MIN_RATE, MAX_RATE);
+    if (m_period != 0 && rate == m_rate) return;
+
+    m_rate = rate;
+    m_period = static_cast<int64_t>(1e9 / rate + 0.5);
+
+    // Keep the pending deadline and space the following ones at the new period
+    m_anchor = m_deadline;
+    m_frameInSchedule = 0;
+    m_spinWindow = std::min(m_spinWindow, m_period / 2);
+}
+
+void FramePacer::Reset() {
+    m_started = false;
+    m_frameInSchedule = 0;
+}
+
+bool FramePacer::Wait() {
+    if (!m_started) return true;
+
+    for (;;) {
+        int64_t now = m_clock.Now();
+        int64_t remaining = m_deadline - now;
+        if (remaining <= 0) return true;
+        if (remaining <= m_spinWindow) break;
+
+        // Sleep through most of the gap, leaving the spin window for the wakeup
+        int64_t request = remaining - m_spinWindow;
+        if (!m_clock.Sleep(request)) return false;
+        UpdateSpinWindow(m_clock.Now() - now - request);
+    }
+
+    while (m_clock.Now() < m_deadline) {
+        m_clock.Relax();
+    }
+    return true;
+}
+
+float FramePacer::BeginFrame() {
+    int64_t now = m_clock.Now();
+
+    if (!m_started) {
+        m_started = true;
+        m_lastFrameStart = now;
+        m_anchor = now;
+        m_frameInSchedule = 1;
+        m_deadline = m_anchor + m_period;
+        m_stats.frames++;
+        return static_cast<float>(m_period * 1e-9);
+    }
+
+    int64_t lateness = std::max<int64_t>(now - m_deadline, 0);
+    float latenessMs = static_cast<float>(lateness * 1e-6);
+    m_stats.frames++;
+    m_stats.lastLatenessMs = latenessMs;
+    m_stats.maxLatenessMs = std::max(m_stats.maxLatenessMs, latenessMs);
+    m_latenessSumMs += latenessMs;
+    m_stats.meanLatenessMs = static_cast<float>(m_latenessSumMs / (m_stats.frames - 1));
+
+    if (lateness >= m_period) {
+        // Too far behind to catch up smoothly; start a new schedule from here
+        m_stats.missedDeadlines++;
+        m_anchor = now;
+        m_frameInSchedule = 0;
+    }
+
+    m_frameInSchedule++;
+    m_deadline = m_anchor + static_cast<int64_t>(m_frameInSchedule) * m_period;
+
+    float deltaTime = static_cast<float>((now - m_lastFrameStart) * 1e-9);
+    m_lastFrameStart = now;
+    return deltaTime;
+}
+
+void FramePacer::UpdateSpinWindow(int64_t oversleep) {
+    int64_t needed = std::max<int64_t>(oversleep, 0) + SPIN_MARGIN;
+    if (needed > m_spinWindow) {
+        m_spinWindow = needed;                          // Widen at once after a late wakeup
+    } else {
+        m_spinWindow -= (m_spinWindow - needed) / 32;   // Narrow slowly
+    }
+
+    int64_t maxWindow = std::min(m_period / 2, MAX_SPIN_WINDOW);
+    m_spinWindow = std::clamp(m_spinWindow, MIN_SPIN_WINDOW, std::max(maxWindow, MIN_SPIN_WINDOW));
+    m_stats.spinWindowMs = static_cast<float>(m_spinWindow * 1e-6);
+}
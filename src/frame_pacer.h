@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+
+// Time source and sleeper for FramePacer; tests substitute a fake clock
+class PacerClock {
+public:
+    virtual ~PacerClock() = default;
+
+    // Monotonic time in nanoseconds
+    virtual int64_t Now() = 0;
+
+    // Sleep for about `duration` nanoseconds; may oversleep. Returns false if
+    // woken early by outside work (window messages), so the caller can
+    // handle it and resume waiting.
+    virtual bool Sleep(int64_t duration) = 0;
+
+    // Called between polls while spinning out the last stretch
+    virtual void Relax() {}
+};
+
+// std::chrono::steady_clock with std::this_thread::sleep_for
+class SteadyPacerClock : public PacerClock {
+public:
+    int64_t Now() override;
+    bool Sleep(int64_t duration) override;
+    void Relax() override;
+};
+
+struct FramePacerStats {
+    uint64_t frames = 0;
+    uint64_t missedDeadlines = 0;       // Frames that began a full period late; the schedule re-anchors
+    float lastLatenessMs = 0.0f;        // How far past its deadline the last frame began
+    float maxLatenessMs = 0.0f;
+    float meanLatenessMs = 0.0f;
+    float spinWindowMs = 0.0f;          // Current sleep/spin split, tracks measured oversleep
+};
+
+// Paces the frame loop against absolute deadlines.
+//
+// Deadline k is anchor + k * period, so rounding and late wakeups do not
+// accumulate into drift. Wait() sleeps coarsely until the deadline is within
+// the spin window, then polls the clock for the remainder. The spin window
+// follows how far the clock's sleeps have actually overshot: it grows at once
+// when a sleep runs long and shrinks slowly, so it stays just wide enough
+// to absorb timer jitter without burning CPU for the rest of the frame.
+// It never exceeds MAX_SPIN_WINDOW: on a clock whose sleeps overshoot by more
+// than that (a coarse system timer), frames start that much late rather
+// than spinning a core for a large share of every period.
+// A frame that starts a whole period late re-anchors the schedule instead of
+// running a burst of catch-up frames.
+class FramePacer {
+public:
+    static constexpr double MIN_RATE = 24.0;
+    static constexpr double MAX_RATE = 240.0;
+
+    explicit FramePacer(PacerClock& clock, double targetRate = 60.0);
+
+    // Clamped to [MIN_RATE, MAX_RATE]; takes effect from the next frame
+    void SetTargetRate(double rate);
+    double GetTargetRate() const { return m_rate; }
+
+    // Block until the next frame is due. Returns false if the clock was woken
+    // early; call again after handling whatever woke it.
+    bool Wait();
+
+    // Mark the start of a frame once Wait() returned true. Returns seconds
+    // since the previous frame began (one period for the first frame).
+    float BeginFrame();
+
+    // Forget the schedule, e.g. after the loop was suspended
+    void Reset();
+
+    const FramePacerStats& GetStats() const { return m_stats; }
+
+private:
+    static constexpr int64_t MIN_SPIN_WINDOW = 250'000;     // 0.25 ms
+    static constexpr int64_t MAX_SPIN_WINDOW = 1'500'000;   // 1.5 ms
+    static constexpr int64_t SPIN_MARGIN = 200'000;         // Added to the worst recent oversleep
+
+    void UpdateSpinWindow(int64_t oversleep);
+
+    PacerClock& m_clock;
+    double m_rate = 60.0;
+    int64_t m_period = 0;
+    int64_t m_anchor = 0;               // Deadline of frame zero in the current schedule
+    uint64_t m_frameInSchedule = 0;
+    int64_t m_deadline = 0;
+    int64_t m_lastFrameStart = 0;
+    bool m_started = false;
+    int64_t m_spinWindow = 1'000'000;   // Start at 1 ms until sleeps have been measured
+    double m_latenessSumMs = 0.0;
+    FramePacerStats m_stats;
+};
@@ -0,0 +1,112 @@
+#include "frame_profiler.h"
+#include <algorithm>
+#include <cmath>
+
+const wchar_t* GetProfilePhaseName(ProfilePhase phase) {
+    switch (phase) {
+        case ProfilePhase::UpdateColumns:  return L"Columns";
+        case ProfilePhase::UpdateGrid:     return L"Grid";
+        case ProfilePhase::Effects:        return L"Effects";
+        case ProfilePhase::BatchBuild:     return L"Batch";
+        case ProfilePhase::Draw:           return L"Draw";
+        case ProfilePhase::MetricsOverlay: return L"Overlay";
+        case ProfilePhase::Present:        return L"Present";
+        case ProfilePhase::Wait:           return L"Wait";
+        default:                           return L"?";
+    }
+}
+
+void FrameProfiler::AddPhaseTime(ProfilePhase phase, Clock::time_point start, Clock::time_point end) {
+    size_t index = static_cast<size_t>(phase);
+    if (index >= PROFILE_PHASE_COUNT) return;
+    
+    if (!m_currentStarted) {
+        m_currentStarted = true;
+        m_currentStart = start;
+        m_current.startUs = std::chrono::duration<double, std::micro>(start - m_epoch).count();
+    }
+    
+    if (!m_phaseStarted[index]) {
+        m_phaseStarted[index] = true;
+        m_current.phaseStartMs[index] = std::chrono::duration<float, std::milli>(start - m_currentStart).count();
+    }
+    
+    m_current.phaseMs[index] += std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+void FrameProfiler::EndFrame() {
+    uint64_t frameIndex = m_writeIndex.load(std::memory_order_relaxed);
+
+    m_current.frameIndex = frameIndex;
+    m_current.frameMs = 0.0f;
+    for (size_t i = 0; i < PROFILE_PHASE_COUNT; ++i) {
+        if (i != static_cast<size_t>(ProfilePhase::Wait)) {
+            m_current.frameMs += m_current.phaseMs[i];
+        }
+    }
+
+    m_samples[frameIndex % CAPACITY] = m_current;
+    m_writeIndex.store(frameIndex + 1, std::memory_order_release);
+
+    m_current = FrameSample();
+    m_currentStarted = false;
+    m_phaseStarted = {};
+}
+
+bool FrameProfiler::GetLatestSample(FrameSample& sample) const {
+    uint64_t count = m_writeIndex.load(std::memory_order_acquire);
+    if (count == 0) return false;
+
+    sample = m_samples[(count - 1) % CAPACITY];
+    return true;
+}
+
+ProfileSummary FrameProfiler::Summarize(size_t window) const {
+    ProfileSummary summary;
+
+    uint64_t count = m_writeIndex.load(std::memory_order_acquire);
+    size_t frames = static_cast<size_t>(std::min<uint64_t>(count, std::min(window, CAPACITY)));
+    summary.frameCount = frames;
+    if (frames == 0) return summary;
+
+    uint64_t first = count - frames;
+
+    for (size_t i = 0; i < frames; ++i) {
+        m_scratch[i] = m_samples[(first + i) % CAPACITY].frameMs;
+    }
+    summary.frame = SummarizeValues(frames);
+
+    for (size_t phase = 0; phase < PROFILE_PHASE_COUNT; ++phase) {
+        for (size_t i = 0; i < frames; ++i) {
+            m_scratch[i] = m_samples[(first + i) % CAPACITY].phaseMs[phase];
+        }
+        summary.phases[phase] = SummarizeValues(frames);
+    }
+
+    return summary;
+}
+
+PhaseSummary FrameProfiler::SummarizeValues(size_t count) const {
+    PhaseSummary result;
+    float* values = m_scratch.data();
+
+    // Nearest-rank percentiles; each nth_element narrows the range for the next
+    auto rank = [count](float percentile) {
+        size_t index = static_cast<size_t>(std::ceil(percentile * count));
+        return std::clamp<size_t>(index, 1, count) - 1;
+    };
+
+    size_t p50 = rank(0.50f);
+    size_t p95 = rank(0.95f);
+    size_t p99 = rank(0.99f);
+
+    std::nth_element(values, values + p50, values + count);
+    result.p50 = values[p50];
+    std::nth_element(values + p50, values + p95, values + count);
+    result.p95 = values[p95];
+    std::nth_element(values + p95, values + p99, values + count);
+    result.p99 = values[p99];
+    result.max = *std::max_element(values + p99, values + count);
+
+    return result;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Timed sections of a frame, in the order they normally run
+enum class ProfilePhase : uint8_t {
+    UpdateColumns,
+    UpdateGrid,
+    Effects,
+    BatchBuild,
+    Draw,
+    MetricsOverlay,
+    Present,
+    Wait,           // Frame pacer wait between frames
+    Count
+};
+
+constexpr size_t PROFILE_PHASE_COUNT = static_cast<size_t>(ProfilePhase::Count);
+
+const wchar_t* GetProfilePhaseName(ProfilePhase phase);
+
+// One completed frame
+struct FrameSample {
+    uint64_t frameIndex = 0;
+    double startUs = 0.0;                                // First timed phase, since profiler creation
+    float frameMs = 0.0f;                                // Frame time excluding Wait
+    std::array<float, PROFILE_PHASE_COUNT> phaseMs = {};
+    std::array<float, PROFILE_PHASE_COUNT> phaseStartMs = {}; // First start of each phase, from startUs
+};
+
+struct PhaseSummary {
+    float p50 = 0.0f;
+    float p95 = 0.0f;
+    float p99 = 0.0f;
+    float max = 0.0f;
+};
+
+struct ProfileSummary {
+    size_t frameCount = 0;                               // Frames the summary covers
+    PhaseSummary frame;
+    std::array<PhaseSummary, PROFILE_PHASE_COUNT> phases;
+};
+
+// Per-phase frame timing.
+//
+// The render thread accumulates phase times for the frame in progress and
+// commits them to a fixed ring buffer in EndFrame(). Publishing is a single
+// release store of the write index, so readers on other threads never block
+// the frame loop; a reader that falls a full ring behind can see a torn
+// sample, which only skews one statistic. Nothing here allocates after
+// construction.
+class FrameProfiler {
+public:
+    using Clock = std::chrono::high_resolution_clock;
+
+    static constexpr size_t CAPACITY = 1024; // Frames kept; summary windows are clamped to this
+
+    FrameProfiler() : m_epoch(Clock::now()) {}
+
+    FrameProfiler(const FrameProfiler&) = delete;
+    FrameProfiler& operator=(const FrameProfiler&) = delete;
+
+    // Add time to a phase of the frame in progress (phases may run repeatedly;
+    // their times add up and the first start is kept)
+    void AddPhaseTime(ProfilePhase phase, Clock::time_point start, Clock::time_point end);
+
+    // Commit the frame in progress and start the next one
+    void EndFrame();
+
+    uint64_t GetFrameCount() const { return m_writeIndex.load(std::memory_order_acquire); }
+
+    // Origin of FrameSample::startUs
+    Clock::time_point GetEpoch() const { return m_epoch; }
+
+    // Copy out the most recent sample; false if no frame has completed yet
+    bool GetLatestSample(FrameSample& sample) const;
+
+    // p50/p95/p99/max over the most recent `window` frames
+    ProfileSummary Summarize(size_t window) const;
+
+private:
+    std::array<FrameSample, CAPACITY> m_samples;
+    std::atomic<uint64_t> m_writeIndex{0};
+    FrameSample m_current;
+    Clock::time_point m_epoch;
+    Clock::time_point m_currentStart;
+    bool m_currentStarted = false;
+    std::array<bool, PROFILE_PHASE_COUNT> m_phaseStarted = {};
+
+    // Sort scratch for Summarize, kept as a member so summaries do not allocate
+    mutable std::array<float, CAPACITY> m_scratch;
+
+    PhaseSummary SummarizeValues(size_t count) const;
+};
+
+// Times its enclosing scope into a phase; a null profiler makes it a no-op
+class ScopedPhaseTimer {
+public:
+    ScopedPhaseTimer(FrameProfiler* profiler, ProfilePhase phase)
+        : m_profiler(profiler), m_phase(phase) {
+        if (m_profiler) {
+            m_start = FrameProfiler::Clock::now();
+        }
+    }
+
+    ~ScopedPhaseTimer() {
+        if (m_profiler) {
+            m_profiler->AddPhaseTime(m_phase, m_start, FrameProfiler::Clock::now());
+        }
+    }
+
+    ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+    ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+private:
+    FrameProfiler* m_profiler;
+    ProfilePhase m_phase;
+    FrameProfiler::Clock::time_point m_start;
+};
@@ -0,0 +1,113 @@
+#include "frame_trace.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <string>
+
+namespace {
+
+// Phase names are plain ASCII, so a narrowing copy is enough for JSON/CSV
+std::string PhaseName(size_t phase) {
+    std::string name;
+    for (const wchar_t* c = GetProfilePhaseName(static_cast<ProfilePhase>(phase)); *c; ++c) {
+        name.push_back(static_cast<char>(*c));
+    }
+    return name;
+}
+
+} // namespace
+
+FrameTrace::FrameTrace(size_t maxFrames)
+    : m_maxFrames(maxFrames) {
+    m_frames.reserve(maxFrames);
+}
+
+void FrameTrace::Record(const FrameSample& sample, const FrameCounters& counters) {
+    if (m_frames.size() >= m_maxFrames) {
+        m_droppedFrames++;
+        return;
+    }
+    m_frames.push_back({sample, counters});
+}
+
+bool FrameTrace::WriteChromeTrace(const std::filesystem::path& path) const {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Frame loop\"}}";
+
+    std::string phaseNames[PROFILE_PHASE_COUNT];
+    for (size_t phase = 0; phase < PROFILE_PHASE_COUNT; ++phase) {
+        phaseNames[phase] = PhaseName(phase);
+    }
+
+    for (const TraceFrame& frame : m_frames) {
+        const FrameSample& sample = frame.sample;
+        double frameEndUs = sample.startUs;
+        for (size_t phase = 0; phase < PROFILE_PHASE_COUNT; ++phase) {
+            if (sample.phaseMs[phase] <= 0.0f) continue;
+            frameEndUs = std::max(frameEndUs, sample.startUs + (sample.phaseStartMs[phase] + sample.phaseMs[phase]) * 1000.0);
+        }
+
+        // The frame span goes first on the phases' own track, so viewers
+        // nest the phases under it
+        file << ",\n{\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+             << ",\"ts\":" << sample.startUs << ",\"dur\":" << (frameEndUs - sample.startUs)
+             << ",\"args\":{\"frame\":" << sample.frameIndex << ",\"busy_ms\":" << sample.frameMs << "}}";
+
+        // One complete ("X") event per phase that ran, placed at its first start
+        for (size_t phase = 0; phase < PROFILE_PHASE_COUNT; ++phase) {
+            if (sample.phaseMs[phase] <= 0.0f) continue;
+
+            double startUs = sample.startUs + sample.phaseStartMs[phase] * 1000.0;
+            double durationUs = sample.phaseMs[phase] * 1000.0;
+            file << ",\n{\"name\":\"" << phaseNames[phase] << "\",\"cat\":\"phase\",\"ph\":\"X\""
+                 << ",\"pid\":1,\"tid\":1,\"ts\":" << startUs << ",\"dur\":" << durationUs
+                 << ",\"args\":{\"frame\":" << sample.frameIndex << "}}";
+        }
+
+        const FrameCounters& counters = frame.counters;
+        file << ",\n{\"name\":\"Counters\",\"ph\":\"C\",\"pid\":1,\"ts\":" << sample.startUs
+             << ",\"args\":{\"active_cells\":" << counters.activeCells
+             << ",\"spawns\":" << counters.spawns
+             << ",\"batches\":" << counters.batches
+             << ",\"draw_calls\":" << counters.drawCalls
+             << ",\"dirty_percent\":" << counters.dirtyPercent
+             << ",\"lateness_ms\":" << counters.latenessMs
+             << ",\"quality_columns\":" << counters.qualityColumns
+             << ",\"quality_effects\":" << counters.qualityEffects
+             << ",\"quality_glow\":" << counters.qualityGlow << "}}";
+    }
+
+    file << "\n]}\n";
+    return file.good();
+}
+
+bool FrameTrace::WriteCsv(const std::filesystem::path& path) const {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    file << "frame,start_us,frame_ms";
+    for (size_t phase = 0; phase < PROFILE_PHASE_COUNT; ++phase) {
+        file << ',' << PhaseName(phase) << "_ms";
+    }
+    file << ",active_cells,spawns,batches,draw_calls,dirty_percent,lateness_ms,quality_columns,quality_effects,quality_glow\n";
+
+    file << std::fixed << std::setprecision(3);
+    for (const TraceFrame& frame : m_frames) {
+        const FrameSample& sample = frame.sample;
+        const FrameCounters& counters = frame.counters;
+
+        file << sample.frameIndex << ',' << sample.startUs << ',' << sample.frameMs;
+        for (size_t phase = 0; phase < PROFILE_PHASE_COUNT; ++phase) {
+            file << ',' << sample.phaseMs[phase];
+        }
+        file << ',' << counters.activeCells << ',' << counters.spawns << ',' << counters.batches
+             << ',' << counters.drawCalls << ',' << counters.dirtyPercent << ',' << counters.latenessMs
+             << ',' << counters.qualityColumns << ',' << counters.qualityEffects << ',' << counters.qualityGlow << '\n';
+    }
+
+    return file.good();
+}
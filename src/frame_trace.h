@@ -0,0 +1,48 @@
+#pragma once
+
+#include "frame_profiler.h"
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Per-frame workload counters captured alongside phase timings
+struct FrameCounters {
+    uint32_t activeCells = 0;   // Grid cells alive at the end of the frame
+    uint32_t spawns = 0;        // Cells (re)started by column heads this frame
+    uint32_t batches = 0;       // Non-empty batches flushed
+    uint32_t drawCalls = 0;     // Text and glyph-run draw calls issued
+    float dirtyPercent = 0.0f;  // Share of dirty tiles, 0 when dirty rects are off
+    float latenessMs = 0.0f;    // How far past its paced deadline the frame began
+    float qualityColumns = 1.0f; // Quality governor levels in effect, 1 = full
+    float qualityEffects = 1.0f;
+    float qualityGlow = 1.0f;
+};
+
+// In-memory frame timeline for offline comparison between builds and machines.
+//
+// Frames are appended to storage reserved up front, so recording never
+// allocates; once the capture is full further frames are counted as dropped.
+// The capture is written out as Chrome about:tracing / Perfetto JSON and as a
+// flat CSV with one row per frame.
+class FrameTrace {
+public:
+    explicit FrameTrace(size_t maxFrames);
+
+    void Record(const FrameSample& sample, const FrameCounters& counters);
+
+    size_t GetFrameCount() const { return m_frames.size(); }
+    size_t GetDroppedCount() const { return m_droppedFrames; }
+
+    bool WriteChromeTrace(const std::filesystem::path& path) const;
+    bool WriteCsv(const std::filesystem::path& path) const;
+
+private:
+    struct TraceFrame {
+        FrameSample sample;
+        FrameCounters counters;
+    };
+
+    std::vector<TraceFrame> m_frames;
+    size_t m_maxFrames;
+    size_t m_droppedFrames = 0;
+};
@@ -0,0 +1,95 @@
+#include "glyph_run_builder.h"
+#include <array>
+
+void GlyphMetricsCache::Clear() {
+    m_metrics.clear();
+}
+
+void GlyphMetricsCache::SetFontMetrics(float ascent, float descent) {
+    m_ascent = ascent;
+    m_descent = descent;
+}
+
+void GlyphMetricsCache::Set(GlyphId glyph, const GlyphMetrics& metrics) {
+    if (glyph == INVALID_GLYPH) return;
+
+    if (glyph >= m_metrics.size()) {
+        m_metrics.resize(static_cast<size_t>(glyph) + 1);
+    }
+    m_metrics[glyph] = metrics;
+    m_metrics[glyph].resolved = true;
+}
+
+const GlyphMetrics* GlyphMetricsCache::Find(GlyphId glyph) const {
+    if (glyph >= m_metrics.size() || !m_metrics[glyph].resolved) {
+        return nullptr;
+    }
+    return &m_metrics[glyph];
+}
+
+bool GlyphMetricsCache::IsResolved(GlyphId glyph) const {
+    return Find(glyph) != nullptr;
+}
+
+void GlyphRunBuilder::Build(const GlyphId* glyphs,
+                            const GlyphCellRect* rects,
+                            size_t count,
+                            float fontSize,
+                            const GlyphMetricsCache& cache,
+                            GlyphRun& run) {
+    run.indices.clear();
+    run.advances.clear();
+    run.offsets.clear();
+    run.spans.clear();
+    run.fallback.clear();
+
+    // Count each face's glyphs first so the run can be laid out face by face
+    std::array<size_t, MAX_GLYPH_FONT_FACES> faceCounts{};
+    size_t drawable = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const GlyphMetrics* metrics = cache.Find(glyphs[i]);
+        if (!metrics || !metrics->drawable || metrics->fontFace >= MAX_GLYPH_FONT_FACES) {
+            run.fallback.push_back(i);
+            continue;
+        }
+        faceCounts[metrics->fontFace]++;
+        drawable++;
+    }
+
+    std::array<size_t, MAX_GLYPH_FONT_FACES> nextSlot{};
+    size_t first = 0;
+    for (size_t face = 0; face < MAX_GLYPH_FONT_FACES; ++face) {
+        if (faceCounts[face] == 0) continue;
+        run.spans.push_back({static_cast<uint8_t>(face), first, faceCounts[face]});
+        nextSlot[face] = first;
+        first += faceCounts[face];
+    }
+
+    run.indices.resize(drawable);
+    run.advances.assign(drawable, 0.0f);
+    run.offsets.resize(drawable);
+
+    // Line box height and baseline position within it
+    float ascent = cache.GetAscent() * fontSize;
+    float lineHeight = (cache.GetAscent() + cache.GetDescent()) * fontSize;
+
+    size_t nextFallback = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (nextFallback < run.fallback.size() && run.fallback[nextFallback] == i) {
+            nextFallback++;
+            continue;
+        }
+        const GlyphMetrics* metrics = cache.Find(glyphs[i]);
+
+        const GlyphCellRect& rect = rects[i];
+        float width = metrics->advance * fontSize;
+        float x = rect.left + (rect.right - rect.left - width) * 0.5f;
+        float baseline = rect.top + (rect.bottom - rect.top - lineHeight) * 0.5f + ascent;
+
+        // Zero advances keep every glyph relative to the run origin;
+        // ascender offsets point up, so screen y is negated
+        size_t slot = nextSlot[metrics->fontFace]++;
+        run.indices[slot] = metrics->fontGlyphIndex;
+        run.offsets[slot] = {x, -baseline};
+    }
+}
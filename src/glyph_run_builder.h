@@ -0,0 +1,100 @@
+#pragma once
+
+#include "glyph_table.h"
+#include "frame_arena.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Font faces a glyph run can be split across: the format's own font plus
+// the fallback fonts found for glyphs it lacks
+constexpr size_t MAX_GLYPH_FONT_FACES = 16;
+
+// Font-resolved metrics for one interned glyph, in em units so one entry
+// serves every font size
+struct GlyphMetrics {
+    uint16_t fontGlyphIndex = 0;   // Index into the font face
+    uint8_t fontFace = 0;          // Face that draws it: 0 is the format's font, then fallbacks
+    float advance = 0.0f;          // Advance width / em size, at the face's fallback scale
+    bool resolved = false;         // False until looked up in the font
+    bool drawable = false;         // Single code point present in a font face
+};
+
+// Per-font metrics cache indexed by GlyphId. Filled lazily by the renderer
+// from the font face; kept free of DirectWrite types so it can be reused
+// by headless tools.
+class GlyphMetricsCache {
+public:
+    void Clear();
+
+    // Vertical font metrics in em units, used to place baselines
+    void SetFontMetrics(float ascent, float descent);
+    float GetAscent() const { return m_ascent; }
+    float GetDescent() const { return m_descent; }
+
+    void Set(GlyphId glyph, const GlyphMetrics& metrics);
+    const GlyphMetrics* Find(GlyphId glyph) const;
+    bool IsResolved(GlyphId glyph) const;
+
+private:
+    std::vector<GlyphMetrics> m_metrics;  // Indexed by GlyphId
+    float m_ascent = 0.8f;
+    float m_descent = 0.2f;
+};
+
+// Layout-compatible with DWRITE_GLYPH_OFFSET
+struct GlyphRunOffset {
+    float advanceOffset;
+    float ascenderOffset;
+};
+
+// Cell rectangle a glyph is centered in (same layout as D2D1_RECT_F)
+struct GlyphCellRect {
+    float left;
+    float top;
+    float right;
+    float bottom;
+};
+
+// The glyphs of one font face: a contiguous range of a GlyphRun
+struct GlyphRunSpan {
+    uint8_t fontFace;
+    size_t first;
+    size_t count;
+};
+
+// Positioned glyph runs: every glyph has a zero advance and is placed by
+// its offset from the run origin (0, 0), so a whole batch of arbitrarily
+// placed cells becomes one draw call per font face it uses. Glyphs are
+// grouped by face, in face order, with a span for each face present.
+// Glyphs no face can draw as a single glyph index are collected separately
+// for text fallback.
+struct GlyphRun {
+    FrameVector<uint16_t> indices;
+    FrameVector<float> advances;
+    FrameVector<GlyphRunOffset> offsets;
+    FrameVector<GlyphRunSpan> spans;
+    FrameVector<size_t> fallback;   // Positions (in the input) left for DrawText
+
+    explicit GlyphRun(FrameArena* arena = nullptr)
+        : indices(ArenaAllocator<uint16_t>(arena)),
+          advances(ArenaAllocator<float>(arena)),
+          offsets(ArenaAllocator<GlyphRunOffset>(arena)),
+          spans(ArenaAllocator<GlyphRunSpan>(arena)),
+          fallback(ArenaAllocator<size_t>(arena)) {}
+
+    size_t GetGlyphCount() const { return indices.size(); }
+};
+
+class GlyphRunBuilder {
+public:
+    // Build a run for glyphs drawn at fontSize, each centered in its rect the
+    // way a center/center aligned text format would place it. Every glyph
+    // must already be resolved in the cache.
+    static void Build(const GlyphId* glyphs,
+                      const GlyphCellRect* rects,
+                      size_t count,
+                      float fontSize,
+                      const GlyphMetricsCache& cache,
+                      GlyphRun& run);
+};
@@ -0,0 +1,67 @@
+#include "glyph_sampler.h"
+#include <algorithm>
+
+void GlyphSampler::Build(const std::vector<WeightedGlyph>& glyphs) {
+    m_entries.clear();
+
+    std::vector<GlyphId> ids;
+    std::vector<double> shares;
+    double total = 0.0;
+    for (const WeightedGlyph& glyph : glyphs) {
+        if (glyph.weight > 0.0f) {
+            ids.push_back(glyph.glyph);
+            shares.push_back(glyph.weight);
+            total += glyph.weight;
+        }
+    }
+    if (ids.empty()) return;
+
+    // Scale so the mean slot holds 1.0, then pair each short slot with a
+    // long one that tops it up
+    size_t count = ids.size();
+    for (double& share : shares) {
+        share *= static_cast<double>(count) / total;
+    }
+
+    std::vector<size_t> small;
+    std::vector<size_t> large;
+    for (size_t i = 0; i < count; ++i) {
+        (shares[i] < 1.0 ? small : large).push_back(i);
+    }
+
+    m_entries.resize(count);
+    while (!small.empty() && !large.empty()) {
+        size_t shortSlot = small.back();
+        small.pop_back();
+        size_t longSlot = large.back();
+
+        double threshold = std::min(shares[shortSlot], 1.0) * 4294967296.0;
+        m_entries[shortSlot] = { static_cast<uint32_t>(std::min(threshold, 4294967295.0)), ids[shortSlot], ids[longSlot] };
+
+        shares[longSlot] -= 1.0 - shares[shortSlot];
+        if (shares[longSlot] < 1.0) {
+            large.pop_back();
+            small.push_back(longSlot);
+        }
+    }
+
+    // What is left is 1.0 up to rounding
+    for (size_t slot : large) {
+        m_entries[slot] = { UINT32_MAX, ids[slot], ids[slot] };
+    }
+    for (size_t slot : small) {
+        m_entries[slot] = { UINT32_MAX, ids[slot], ids[slot] };
+    }
+}
+
+double GlyphSampler::GetProbability(GlyphId glyph) const {
+    if (m_entries.empty()) return 0.0;
+
+    double share = 0.0;
+    for (const Entry& entry : m_entries) {
+        double kept = entry.glyph == entry.alias ? 1.0 : entry.threshold / 4294967296.0;
+        if (entry.glyph == glyph) share += kept;
+        if (entry.alias == glyph) share += 1.0 - kept;
+    }
+    return share / static_cast<double>(m_entries.size());
+}
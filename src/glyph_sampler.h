@@ -0,0 +1,44 @@
+#pragma once
+
+#include "glyph_table.h"
+#include <cstdint>
+#include <vector>
+
+// Weighted glyph choice in constant time from one 32-bit draw (Vose's alias
+// method). Built once from (glyph, weight) pairs; each entry then holds a
+// glyph, an alias and the share of its slot that keeps the glyph. The high
+// part of draw * size picks the slot and the low 32 bits decide between the
+// two, so a pick costs one multiply and one compare.
+class GlyphSampler {
+public:
+    struct WeightedGlyph {
+        GlyphId glyph;
+        float weight;
+    };
+
+    // Entries with no weight are dropped; an empty or weightless list leaves
+    // the sampler empty
+    void Build(const std::vector<WeightedGlyph>& glyphs);
+    void Clear() { m_entries.clear(); }
+
+    bool IsEmpty() const { return m_entries.empty(); }
+    size_t GetSize() const { return m_entries.size(); }
+
+    GlyphId Sample(uint32_t draw) const {
+        uint64_t scaled = static_cast<uint64_t>(draw) * m_entries.size();
+        const Entry& entry = m_entries[static_cast<size_t>(scaled >> 32)];
+        return static_cast<uint32_t>(scaled) < entry.threshold ? entry.glyph : entry.alias;
+    }
+
+    // Probability of drawing glyph, for checking a build against its weights
+    double GetProbability(GlyphId glyph) const;
+
+private:
+    struct Entry {
+        uint32_t threshold;     // Low draw bits below this keep glyph
+        GlyphId glyph;
+        GlyphId alias;          // Equal to glyph when the slot is all glyph
+    };
+
+    std::vector<Entry> m_entries;
+};
@@ -0,0 +1,93 @@
+#include "glyph_table.h"
+#include "sim_types.h"
+
+GlyphTable::GlyphTable() {
+    m_matrixGlyphs = InternAll(MATRIX_CHARS);
+    m_katakanaGlyphs = InternAll(KATAKANA_CHARS);
+    m_latinGlyphs = InternAll(LATIN_CHARS);
+    m_symbolGlyphs = InternAll(SYMBOL_CHARS);
+
+    SetCategory(m_katakanaGlyphs, GLYPH_KATAKANA);
+    SetCategory(m_latinGlyphs, GLYPH_LATIN);
+    SetCategory(m_symbolGlyphs, GLYPH_SYMBOL);
+}
+
+GlyphId GlyphTable::Intern(std::wstring_view glyph) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return InternLocked(glyph);
+}
+
+GlyphId GlyphTable::InternLocked(std::wstring_view glyph) {
+    std::wstring key(glyph);
+    auto it = m_lookup.find(key);
+    if (it != m_lookup.end()) {
+        return it->second;
+    }
+
+    size_t count = m_count.load(std::memory_order_relaxed);
+    if (count >= INVALID_GLYPH) {
+        return INVALID_GLYPH; // Table full
+    }
+
+    std::unique_ptr<Entry[]>& chunk = m_chunks[count / CHUNK_SIZE];
+    if (!chunk) {
+        chunk = std::make_unique<Entry[]>(CHUNK_SIZE);
+    }
+    chunk[count % CHUNK_SIZE].glyph = key;
+
+    GlyphId id = static_cast<GlyphId>(count);
+    m_lookup.emplace(std::move(key), id);
+    m_count.store(count + 1, std::memory_order_release);
+    return id;
+}
+
+GlyphId GlyphTable::Find(std::wstring_view glyph) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_lookup.find(std::wstring(glyph));
+    return it != m_lookup.end() ? it->second : INVALID_GLYPH;
+}
+
+const std::wstring& GlyphTable::GetGlyph(GlyphId id) const {
+    static const std::wstring s_empty;
+    return id < GetGlyphCount() ? GetEntry(id).glyph : s_empty;
+}
+
+std::vector<GlyphId> GlyphTable::InternWord(std::wstring_view word) {
+    std::vector<GlyphId> ids;
+    ids.reserve(word.size());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (size_t i = 0; i < word.size(); ++i) {
+        size_t length = 1;
+        if (word[i] >= 0xD800 && word[i] <= 0xDBFF && i + 1 < word.size()) {
+            length = 2; // High surrogate followed by its low surrogate
+        }
+
+        GlyphId id = InternLocked(word.substr(i, length));
+        if (id != INVALID_GLYPH) {
+            ids.push_back(id);
+        }
+        i += length - 1;
+    }
+
+    return ids;
+}
+
+std::vector<GlyphId> GlyphTable::InternAll(const std::vector<std::wstring>& glyphs) {
+    std::vector<GlyphId> ids;
+    ids.reserve(glyphs.size());
+    for (const auto& glyph : glyphs) {
+        ids.push_back(Intern(glyph));
+    }
+    return ids;
+}
+
+// Only called from the constructor, before any other thread can see the table
+void GlyphTable::SetCategory(const std::vector<GlyphId>& ids, GlyphCategory category) {
+    for (GlyphId id : ids) {
+        if (id != INVALID_GLYPH) {
+            m_chunks[id / CHUNK_SIZE][id % CHUNK_SIZE].categories |= category;
+        }
+    }
+}
\ No newline at end of file
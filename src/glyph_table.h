@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Compact glyph handle used by grid cells instead of per-cell strings
+using GlyphId = uint16_t;
+constexpr GlyphId INVALID_GLYPH = 0xFFFF;
+
+// Built-in character sets a glyph belongs to
+enum GlyphCategory : uint8_t {
+    GLYPH_KATAKANA = 1 << 0,
+    GLYPH_LATIN    = 1 << 1,
+    GLYPH_SYMBOL   = 1 << 2
+};
+
+// Interns every displayable glyph once and hands out small integer IDs.
+// The built-in character sets are interned at construction; custom words are
+// added on settings change. IDs are never recycled, and the strings they map
+// to have stable addresses for the lifetime of the process.
+//
+// Shared by the simulation, the renderer and the UI thread. Intern and Find
+// take a lock; GetGlyph and GetCategories do not, since entries live in
+// chunks that never move and are published by an atomic count after they
+// are written.
+class GlyphTable {
+public:
+    static GlyphTable& Instance() {
+        static GlyphTable instance;
+        return instance;
+    }
+
+    GlyphId Intern(std::wstring_view glyph);
+    GlyphId Find(std::wstring_view glyph) const;
+
+    const std::wstring& GetGlyph(GlyphId id) const;
+    size_t GetGlyphCount() const { return m_count.load(std::memory_order_acquire); }
+
+    // GlyphCategory bits, 0 for glyphs only in a custom word
+    uint8_t GetCategories(GlyphId id) const { return id < GetGlyphCount() ? GetEntry(id).categories : 0; }
+
+    // Built-in character sets, in the order of their source tables
+    const std::vector<GlyphId>& GetMatrixGlyphs() const { return m_matrixGlyphs; }
+    const std::vector<GlyphId>& GetKatakanaGlyphs() const { return m_katakanaGlyphs; }
+    const std::vector<GlyphId>& GetLatinGlyphs() const { return m_latinGlyphs; }
+    const std::vector<GlyphId>& GetSymbolGlyphs() const { return m_symbolGlyphs; }
+
+    // Intern each code point of a word (surrogate pairs stay together)
+    std::vector<GlyphId> InternWord(std::wstring_view word);
+
+private:
+    GlyphTable();
+
+    GlyphTable(const GlyphTable&) = delete;
+    GlyphTable& operator=(const GlyphTable&) = delete;
+
+    struct Entry {
+        std::wstring glyph;
+        uint8_t categories = 0;
+    };
+
+    static constexpr size_t CHUNK_SIZE = 256;
+    static constexpr size_t CHUNK_COUNT = (INVALID_GLYPH + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    const Entry& GetEntry(GlyphId id) const { return m_chunks[id / CHUNK_SIZE][id % CHUNK_SIZE]; }
+
+    GlyphId InternLocked(std::wstring_view glyph);
+    std::vector<GlyphId> InternAll(const std::vector<std::wstring>& glyphs);
+    void SetCategory(const std::vector<GlyphId>& ids, GlyphCategory category);
+
+    mutable std::mutex m_mutex;                           // Guards m_lookup and adding entries
+    std::unordered_map<std::wstring, GlyphId> m_lookup;
+    std::array<std::unique_ptr<Entry[]>, CHUNK_COUNT> m_chunks;
+    std::atomic<size_t> m_count{0};                       // Entries below this are complete
+
+    std::vector<GlyphId> m_matrixGlyphs;
+    std::vector<GlyphId> m_katakanaGlyphs;
+    std::vector<GlyphId> m_latinGlyphs;
+    std::vector<GlyphId> m_symbolGlyphs;
+};
\ No newline at end of file
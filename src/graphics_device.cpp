@@ -0,0 +1,103 @@
+#include "graphics_device.h"
+#include "logger.h"
+
+bool GraphicsDevice::Initialize() {
+    D3D_FEATURE_LEVEL featureLevel;
+    HRESULT hr = D3D11CreateDevice(
+        nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr,
+        D3D11_CREATE_DEVICE_BGRA_SUPPORT,
+        nullptr, 0, D3D11_SDK_VERSION,
+        &m_device, &featureLevel, &m_deviceContext);
+    if (FAILED(hr)) {
+        LOG_ERROR("Failed to create Direct3D device (0x{:08X})", static_cast<uint32_t>(hr));
+        return false;
+    }
+
+    // Swap chains must come from the factory that made the device's adapter
+    Microsoft::WRL::ComPtr<IDXGIDevice> dxgiDevice;
+    Microsoft::WRL::ComPtr<IDXGIAdapter> adapter;
+    hr = m_device.As(&dxgiDevice);
+    if (SUCCEEDED(hr)) hr = dxgiDevice->GetAdapter(&adapter);
+    if (SUCCEEDED(hr)) hr = adapter->GetParent(IID_PPV_ARGS(&m_dxgiFactory));
+    if (FAILED(hr)) return false;
+
+    hr = D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, m_d2dFactory.GetAddressOf());
+    if (FAILED(hr)) return false;
+
+    hr = DWriteCreateFactory(
+        DWRITE_FACTORY_TYPE_SHARED,
+        __uuidof(m_writeFactory),
+        reinterpret_cast<IUnknown**>(m_writeFactory.GetAddressOf()));
+    if (FAILED(hr)) return false;
+
+    LOG_INFO("Shared graphics device created (feature level {:X})", static_cast<uint32_t>(featureLevel));
+    return true;
+}
+
+void GraphicsDevice::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_formatMutex);
+        m_textFormats.clear();
+    }
+    m_writeFactory.Reset();
+    m_d2dFactory.Reset();
+    m_dxgiFactory.Reset();
+    m_deviceContext.Reset();
+    m_device.Reset();
+}
+
+HRESULT GraphicsDevice::CreateSwapChain(HWND hwnd, UINT width, UINT height, IDXGISwapChain** swapChain) {
+    if (!m_dxgiFactory) return E_FAIL;
+
+    DXGI_SWAP_CHAIN_DESC swapChainDesc = {};
+    swapChainDesc.BufferCount = 2;
+    swapChainDesc.BufferDesc.Width = width;
+    swapChainDesc.BufferDesc.Height = height;
+    swapChainDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    swapChainDesc.BufferDesc.RefreshRate.Numerator = 60;
+    swapChainDesc.BufferDesc.RefreshRate.Denominator = 1;
+    swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    swapChainDesc.OutputWindow = hwnd;
+    swapChainDesc.SampleDesc.Count = 1;
+    swapChainDesc.SampleDesc.Quality = 0;
+    swapChainDesc.Windowed = TRUE;
+    swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+
+    return m_dxgiFactory->CreateSwapChain(m_device.Get(), &swapChainDesc, swapChain);
+}
+
+IDWriteTextFormat* GraphicsDevice::GetTextFormat(const std::wstring& fontName, bool bold, float fontSize, bool centered) {
+    std::lock_guard<std::mutex> lock(m_formatMutex);
+
+    TextFormatKey key(fontName, bold, fontSize, centered);
+    auto it = m_textFormats.find(key);
+    if (it != m_textFormats.end()) {
+        return it->second.Get();
+    }
+
+    if (!m_writeFactory) return nullptr;
+
+    Microsoft::WRL::ComPtr<IDWriteTextFormat> format;
+    HRESULT hr = m_writeFactory->CreateTextFormat(
+        fontName.c_str(),
+        nullptr,
+        bold ? DWRITE_FONT_WEIGHT_BOLD : DWRITE_FONT_WEIGHT_NORMAL,
+        DWRITE_FONT_STYLE_NORMAL,
+        DWRITE_FONT_STRETCH_NORMAL,
+        fontSize,
+        L"",
+        &format);
+    if (FAILED(hr)) return nullptr;
+
+    if (centered) {
+        format->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
+        format->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
+    } else {
+        format->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_LEADING);
+        format->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR);
+    }
+
+    IDWriteTextFormat* result = format.Get();
+    m_textFormats.emplace(std::move(key), std::move(format));
+    return result;
+}
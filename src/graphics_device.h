@@ -0,0 +1,46 @@
+#pragma once
+
+#include "common.h"
+#include <map>
+#include <mutex>
+#include <tuple>
+
+// Graphics objects shared by every output window: one D3D11 device, one
+// Direct2D factory, one DirectWrite factory and the text formats built from
+// them. Each output only owns its swap chain and render target.
+//
+// Outputs draw one after another on the thread that owns the message loop,
+// so the Direct2D factory is single-threaded and skips the lock a
+// multithreaded one takes around every call. Drawing in parallel would gain
+// nothing: Direct2D serializes all use of one device anyway.
+class GraphicsDevice {
+public:
+    GraphicsDevice() = default;
+
+    GraphicsDevice(const GraphicsDevice&) = delete;
+    GraphicsDevice& operator=(const GraphicsDevice&) = delete;
+
+    bool Initialize();
+    void Shutdown();
+
+    ID3D11Device* GetDevice() const { return m_device.Get(); }
+    ID2D1Factory* GetD2DFactory() const { return m_d2dFactory.Get(); }
+    IDWriteFactory* GetWriteFactory() const { return m_writeFactory.Get(); }
+
+    // Swap chain for one output window on the shared device
+    HRESULT CreateSwapChain(HWND hwnd, UINT width, UINT height, IDXGISwapChain** swapChain);
+
+    // Text format for a font and size, created on first use and then shared
+    IDWriteTextFormat* GetTextFormat(const std::wstring& fontName, bool bold, float fontSize, bool centered);
+
+private:
+    Microsoft::WRL::ComPtr<ID3D11Device> m_device;
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext> m_deviceContext;
+    Microsoft::WRL::ComPtr<IDXGIFactory> m_dxgiFactory;
+    Microsoft::WRL::ComPtr<ID2D1Factory> m_d2dFactory;
+    Microsoft::WRL::ComPtr<IDWriteFactory> m_writeFactory;
+
+    using TextFormatKey = std::tuple<std::wstring, bool, float, bool>;
+    std::mutex m_formatMutex;
+    std::map<TextFormatKey, Microsoft::WRL::ComPtr<IDWriteTextFormat>> m_textFormats;
+};
@@ -0,0 +1,107 @@
+#include "live_counters.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+void WriteLiveCounters(LiveCounterBlock& block, const LiveCounters& counters) {
+    uint32_t words[LiveCounterBlock::WORD_COUNT];
+    std::memcpy(words, &counters, sizeof(counters));
+
+    uint32_t sequence = block.sequence.load(std::memory_order_relaxed);
+    block.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (size_t i = 0; i < LiveCounterBlock::WORD_COUNT; ++i) {
+        block.payload[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    block.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool ReadLiveCounters(const LiveCounterBlock& block, LiveCounters& counters) {
+    constexpr int MAX_ATTEMPTS = 64;
+    uint32_t words[LiveCounterBlock::WORD_COUNT];
+
+    for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+        uint32_t before = block.sequence.load(std::memory_order_acquire);
+        if (before & 1) continue;
+
+        for (size_t i = 0; i < LiveCounterBlock::WORD_COUNT; ++i) {
+            words[i] = block.payload[i].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (block.sequence.load(std::memory_order_relaxed) == before) {
+            std::memcpy(&counters, words, sizeof(counters));
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string FormatLiveCountersJson(const LiveCounters& c) {
+    char buffer[1024];
+    int length = std::snprintf(buffer, sizeof(buffer),
+        "{\"frame\":%" PRIu64 ",\"uptime_s\":%.3f,"
+        "\"fps\":%.2f,\"fps_avg\":%.2f,"
+        "\"frame_ms\":{\"p50\":%.3f,\"p95\":%.3f,\"p99\":%.3f,\"max\":%.3f},"
+        "\"active_cells\":%u,\"spawns_per_s\":%.1f,\"draw_calls\":%u,\"batches\":%u,"
+        "\"dirty_percent\":%.1f,\"working_set_bytes\":%" PRIu64 ",\"private_bytes\":%" PRIu64 ","
+        "\"allocs_per_frame\":%" PRIu64 ",\"alloc_bytes_per_frame\":%" PRIu64 ","
+        "\"time_to_first_frame_ms\":%.1f}\n",
+        c.frameIndex, c.uptimeSeconds,
+        c.fps, c.fpsAverage,
+        c.frameMsP50, c.frameMsP95, c.frameMsP99, c.frameMsMax,
+        c.activeCells, c.spawnsPerSecond, c.drawCalls, c.batches,
+        c.dirtyPercent, c.workingSetBytes, c.privateBytes,
+        c.allocationsPerFrame, c.bytesAllocatedPerFrame,
+        c.timeToFirstFrameMs);
+
+    return std::string(buffer, length > 0 ? std::min<size_t>(length, sizeof(buffer) - 1) : 0);
+}
+
+std::string FormatLiveCountersPrometheus(const LiveCounters& c) {
+    char buffer[2048];
+    int length = std::snprintf(buffer, sizeof(buffer),
+        "# TYPE matrix_frames_total counter\n"
+        "matrix_frames_total %" PRIu64 "\n"
+        "# TYPE matrix_uptime_seconds gauge\n"
+        "matrix_uptime_seconds %.3f\n"
+        "# TYPE matrix_fps gauge\n"
+        "matrix_fps %.2f\n"
+        "# TYPE matrix_fps_average gauge\n"
+        "matrix_fps_average %.2f\n"
+        "# TYPE matrix_frame_time_ms summary\n"
+        "matrix_frame_time_ms{quantile=\"0.5\"} %.3f\n"
+        "matrix_frame_time_ms{quantile=\"0.95\"} %.3f\n"
+        "matrix_frame_time_ms{quantile=\"0.99\"} %.3f\n"
+        "matrix_frame_time_ms{quantile=\"1\"} %.3f\n"
+        "# TYPE matrix_active_cells gauge\n"
+        "matrix_active_cells %u\n"
+        "# TYPE matrix_spawns_per_second gauge\n"
+        "matrix_spawns_per_second %.1f\n"
+        "# TYPE matrix_draw_calls gauge\n"
+        "matrix_draw_calls %u\n"
+        "# TYPE matrix_glyph_batches gauge\n"
+        "matrix_glyph_batches %u\n"
+        "# TYPE matrix_dirty_percent gauge\n"
+        "matrix_dirty_percent %.1f\n"
+        "# TYPE matrix_working_set_bytes gauge\n"
+        "matrix_working_set_bytes %" PRIu64 "\n"
+        "# TYPE matrix_private_bytes gauge\n"
+        "matrix_private_bytes %" PRIu64 "\n"
+        "# TYPE matrix_allocations_per_frame gauge\n"
+        "matrix_allocations_per_frame %" PRIu64 "\n"
+        "# TYPE matrix_allocated_bytes_per_frame gauge\n"
+        "matrix_allocated_bytes_per_frame %" PRIu64 "\n"
+        "# TYPE matrix_time_to_first_frame_ms gauge\n"
+        "matrix_time_to_first_frame_ms %.1f\n",
+        c.frameIndex, c.uptimeSeconds, c.fps, c.fpsAverage,
+        c.frameMsP50, c.frameMsP95, c.frameMsP99, c.frameMsMax,
+        c.activeCells, c.spawnsPerSecond, c.drawCalls, c.batches, c.dirtyPercent,
+        c.workingSetBytes, c.privateBytes, c.allocationsPerFrame, c.bytesAllocatedPerFrame,
+        c.timeToFirstFrameMs);
+
+    return std::string(buffer, length > 0 ? std::min<size_t>(length, sizeof(buffer) - 1) : 0);
+}
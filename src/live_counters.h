@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Snapshot of the renderer's health, published for external monitoring
+struct LiveCounters {
+    uint64_t frameIndex = 0;
+    double uptimeSeconds = 0.0;
+    float fps = 0.0f;
+    float fpsAverage = 0.0f;
+    float frameMsP50 = 0.0f;                // Frame times exclude the limiter wait
+    float frameMsP95 = 0.0f;
+    float frameMsP99 = 0.0f;
+    float frameMsMax = 0.0f;
+    uint32_t activeCells = 0;
+    float spawnsPerSecond = 0.0f;
+    uint32_t drawCalls = 0;                 // Last frame
+    uint32_t batches = 0;                   // Last frame
+    float dirtyPercent = 0.0f;
+    uint32_t reserved = 0;
+    uint64_t workingSetBytes = 0;
+    uint64_t privateBytes = 0;
+    uint64_t allocationsPerFrame = 0;       // Zero unless built with MATRIX_COUNT_ALLOCATIONS
+    uint64_t bytesAllocatedPerFrame = 0;
+    float timeToFirstFrameMs = 0.0f;        // Process launch to the first present
+    uint32_t reserved2 = 0;
+};
+
+static_assert(sizeof(LiveCounters) % sizeof(uint32_t) == 0, "LiveCounters is copied as 32-bit words");
+
+// Shared-memory layout of the counters page.
+//
+// The renderer is the only writer. Updates are a seqlock: `sequence` is odd
+// while the payload is being rewritten, so a reader copies the payload and
+// retries if the sequence changed or was odd. Readers never block the writer.
+// Consumers should check magic, version and size before trusting the payload;
+// fields are only ever appended, with `size` growing accordingly.
+struct LiveCounterBlock {
+    static constexpr uint32_t MAGIC = 0x5443584D;   // "MXCT"
+    static constexpr uint16_t VERSION = 1;
+    static constexpr size_t WORD_COUNT = sizeof(LiveCounters) / sizeof(uint32_t);
+
+    uint32_t magic = MAGIC;
+    uint16_t version = VERSION;
+    uint16_t size = static_cast<uint16_t>(sizeof(LiveCounters));
+    uint32_t processId = 0;
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<uint32_t> payload[WORD_COUNT] = {};    // A LiveCounters, word by word
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Counters page must be usable across processes");
+
+// Publish a snapshot (single writer)
+void WriteLiveCounters(LiveCounterBlock& block, const LiveCounters& counters);
+
+// Copy a consistent snapshot; false if the writer kept it busy for every attempt
+bool ReadLiveCounters(const LiveCounterBlock& block, LiveCounters& counters);
+
+// Text renderings served by the counters socket
+std::string FormatLiveCountersJson(const LiveCounters& counters);
+std::string FormatLiveCountersPrometheus(const LiveCounters& counters);
@@ -1,33 +1,58 @@
 #include "logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
 #include <windows.h>
 #include <shlobj.h>
+#endif
+
+namespace {
+
+template<typename T>
+void AppendValue(std::string& buffer, const T& value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+bool ToLocalTime(time_t time, struct tm& localTime) {
+#ifdef _WIN32
+    return localtime_s(&localTime, &time) == 0;
+#else
+    return localtime_r(&time, &localTime) != nullptr;
+#endif
+}
+
+} // namespace
 
 Logger::Logger() {
 }
 
 Logger::~Logger() {
-    if (m_logFile.is_open()) {
-        m_logFile.close();
-    }
+    Shutdown();
 }
 
-void Logger::Initialize(bool enabled, const std::wstring& logPath) {
+void Logger::Initialize(bool enabled, LogFileFormat format, const std::wstring& logPath) {
     std::lock_guard<std::mutex> lock(m_mutex);
     
-    m_enabled = enabled;
-    
     if (!enabled) {
-        if (m_logFile.is_open()) {
-            m_logFile.close();
-        }
+        StopWriter();
         return;
     }
     
+    // Already running (e.g. one screensaver window per monitor)
+    if (m_writerRunning.load(std::memory_order_acquire)) {
+        return;
+    }
+    
+    m_fileFormat = format;
+    m_binary.store(format == LogFileFormat::Binary, std::memory_order_relaxed);
+    
     // Determine log file path
     if (!logPath.empty()) {
         m_logPath = logPath;
     } else {
-        m_logPath = GetDefaultLogPath();
+        m_logPath = GetDefaultLogPath(format);
     }
     
     // Convert wide string to narrow string for file operations
@@ -38,69 +63,315 @@ void Logger::Initialize(bool enabled, const std::wstring& logPath) {
     }
     
     // Open log file in append mode
-    m_logFile.open(narrowPath, std::ios::app);
+    std::ios::openmode mode = std::ios::app;
+    if (format == LogFileFormat::Binary) {
+        mode |= std::ios::binary;
+    }
+    m_logFile.open(narrowPath, mode);
     
     if (m_logFile.is_open()) {
+        // Anchor the tick counter to wall-clock time for this session
+        m_sessionTicks = GetTicks();
+        m_sessionTime = std::chrono::system_clock::now();
+        m_formatIds.clear();
+        
         // Write startup message
-        m_logFile << "\n===== Matrix Screensaver Started =====" << std::endl;
-        m_logFile << GetTimestamp() << " [INFO] Logging initialized" << std::endl;
+        m_writeBuffer.clear();
+        if (format == LogFileFormat::Binary) {
+            AppendBinarySession();
+            AppendBinaryPlain(LogLevel::Info, m_sessionTicks, "Logging initialized");
+        } else {
+            m_writeBuffer += "\n===== Matrix Screensaver Started =====\n";
+            AppendText(LogLevel::Info, m_sessionTicks, "Logging initialized");
+        }
+        WriteBuffer();
+        m_logFile.flush();
+        
+        StartWriter();
     }
 }
 
 void Logger::SetEnabled(bool enabled) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    if (enabled == IsEnabled()) return;
     
-    if (m_enabled == enabled) return;
+    if (enabled) {
+        Initialize(true, m_fileFormat, m_logPath);
+    } else {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        StopWriter();
+    }
+}
+
+void Logger::Log(LogLevel level, std::string_view message) {
+    if (!IsEnabled()) return;
     
-    m_enabled = enabled;
+    uint64_t pos;
+    LogRecord* record = ClaimRecord(pos);
+    if (!record) return;
     
-    if (!enabled && m_logFile.is_open()) {
-        m_logFile << GetTimestamp() << " [INFO] Logging disabled" << std::endl;
-        m_logFile.close();
-    } else if (enabled && !m_logFile.is_open()) {
-        Initialize(true, m_logPath);
+    // Copy the message only; timestamps are formatted on the writer thread
+    size_t length = std::min(message.size(), MAX_MESSAGE_LENGTH);
+    std::memcpy(record->text, message.data(), length);
+    record->format = {};
+    record->length = static_cast<uint32_t>(length);
+    PublishRecord(record, pos, level);
+}
+
+Logger::LogRecord* Logger::ClaimRecord(uint64_t& pos) {
+    // Bounded MPMC queue after Vyukov; only one consumer here
+    pos = m_enqueuePos.load(std::memory_order_relaxed);
+    while (true) {
+        LogRecord* record = &m_ring[pos & (RING_CAPACITY - 1)];
+        uint64_t sequence = record->sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+        
+        if (diff == 0) {
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                return record;
+            }
+        } else if (diff < 0) {
+            // Ring full: never wait on the writer
+            m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        } else {
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
     }
 }
 
-void Logger::Log(LogLevel level, const std::string& message) {
-    if (!m_enabled) return;
+void Logger::PublishRecord(LogRecord* record, uint64_t pos, LogLevel level) {
+    record->level = level;
+    record->ticks = GetTicks();
+    record->sequence.store(pos + 1, std::memory_order_release);
+}
+
+void Logger::Flush() {
+    if (!m_writerRunning.load(std::memory_order_acquire)) return;
     
+    // Wait for the writer to pass everything enqueued so far (bounded, so a
+    // stalled disk cannot hang the caller)
+    uint64_t target = m_enqueuePos.load(std::memory_order_acquire);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (m_dequeuePos.load(std::memory_order_acquire) < target &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void Logger::Shutdown() {
     std::lock_guard<std::mutex> lock(m_mutex);
+    StopWriter();
+}
+
+void Logger::StartWriter() {
+    // The ring outlives a stop/start cycle, so a producer racing a shutdown
+    // never touches freed memory
+    if (!m_ring) {
+        m_ring = std::make_unique<LogRecord[]>(RING_CAPACITY);
+    }
+    for (size_t i = 0; i < RING_CAPACITY; ++i) {
+        m_ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    m_enqueuePos.store(0, std::memory_order_relaxed);
+    m_dequeuePos.store(0, std::memory_order_relaxed);
+    m_reportedDrops = m_droppedCount.load(std::memory_order_relaxed);
+    
+    m_writerRunning.store(true, std::memory_order_release);
+    m_writer = std::thread(&Logger::WriterLoop, this);
+    s_enabled.store(true, std::memory_order_release);
+}
+
+void Logger::StopWriter() {
+    s_enabled.store(false, std::memory_order_release);
+    
+    if (m_writer.joinable()) {
+        // The writer drains whatever producers already claimed before exiting
+        m_writerRunning.store(false, std::memory_order_release);
+        m_writer.join();
+    }
+    m_writerRunning.store(false, std::memory_order_release);
     
     if (m_logFile.is_open()) {
-        m_logFile << GetTimestamp() << " " << GetLevelString(level) << " " << message << std::endl;
+        m_writeBuffer.clear();
+        if (m_fileFormat == LogFileFormat::Binary) {
+            AppendBinaryPlain(LogLevel::Info, GetTicks(), "Logging stopped");
+        } else {
+            AppendText(LogLevel::Info, GetTicks(), "Logging stopped");
+        }
+        WriteBuffer();
+        m_logFile.close();
+    }
+}
+
+void Logger::WriterLoop() {
+    while (true) {
+        bool running = m_writerRunning.load(std::memory_order_acquire);
+        if (running && m_writerHeld.load(std::memory_order_acquire)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
         
-        // Auto-flush for errors and warnings
-        if (level >= LogLevel::Warning) {
+        size_t written = DrainRing();
+        if (written > 0) {
             m_logFile.flush();
         }
+        
+        // One last drain after the stop request, then exit
+        if (!running) {
+            // A producer that claimed a slot just before shutdown may still be
+            // copying; give it a moment rather than losing the message
+            if (m_dequeuePos.load(std::memory_order_relaxed) != m_enqueuePos.load(std::memory_order_acquire)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                if (DrainRing() > 0) {
+                    m_logFile.flush();
+                }
+            }
+            break;
+        }
+        
+        if (written == 0) {
+            std::this_thread::sleep_for(WRITER_IDLE_INTERVAL);
+        }
     }
 }
 
-void Logger::Flush() {
-    std::lock_guard<std::mutex> lock(m_mutex);
+size_t Logger::DrainRing() {
+    m_writeBuffer.clear();
+    size_t count = 0;
+    uint64_t pos = m_dequeuePos.load(std::memory_order_relaxed);
     
-    if (m_logFile.is_open()) {
-        m_logFile.flush();
+    while (true) {
+        LogRecord& record = m_ring[pos & (RING_CAPACITY - 1)];
+        if (record.sequence.load(std::memory_order_acquire) != pos + 1) {
+            break; // Empty, or the producer is still copying
+        }
+        
+        std::string_view text(record.text, record.length);
+        if (!record.format.empty()) {
+            AppendBinary(record);
+        } else if (m_fileFormat == LogFileFormat::Binary) {
+            AppendBinaryPlain(record.level, record.ticks, text);
+        } else {
+            AppendText(record.level, record.ticks, text);
+        }
+        
+        // Hand the slot back to producers for the next lap
+        record.sequence.store(pos + RING_CAPACITY, std::memory_order_release);
+        pos++;
+        count++;
+    }
+    m_dequeuePos.store(pos, std::memory_order_release);
+    
+    uint64_t dropped = m_droppedCount.load(std::memory_order_relaxed);
+    if (dropped != m_reportedDrops) {
+        AppendDropped(GetTicks(), dropped - m_reportedDrops);
+        m_reportedDrops = dropped;
+        count++;
     }
+    
+    WriteBuffer();
+    return count;
 }
 
-std::string Logger::GetTimestamp() const {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
+void Logger::AppendText(LogLevel level, int64_t ticks, std::string_view text) {
+    m_writeBuffer += GetTimestamp(ticks);
+    m_writeBuffer += ' ';
+    m_writeBuffer += GetLevelString(level);
+    m_writeBuffer += ' ';
+    m_writeBuffer += text;
+    m_writeBuffer += '\n';
+}
+
+void Logger::AppendBinary(const LogRecord& record) {
+    uint16_t formatId;
+    auto it = m_formatIds.find(record.format.data());
+    if (it != m_formatIds.end()) {
+        formatId = it->second;
+    } else {
+        // First use this session: define it ahead of the message (ID 0 is plain text)
+        formatId = static_cast<uint16_t>(m_formatIds.size() + 1);
+        m_formatIds.emplace(record.format.data(), formatId);
+        
+        uint16_t length = static_cast<uint16_t>(std::min<size_t>(record.format.size(), UINT16_MAX));
+        AppendValue(m_writeBuffer, BinaryLogRecordKind::Format);
+        AppendValue(m_writeBuffer, formatId);
+        AppendValue(m_writeBuffer, length);
+        m_writeBuffer.append(record.format.data(), length);
+    }
     
-    struct tm localTime;
-    if (localtime_s(&localTime, &time_t) != 0) {
-        return "[TIMESTAMP_ERROR]";
+    AppendValue(m_writeBuffer, BinaryLogRecordKind::Message);
+    AppendValue(m_writeBuffer, static_cast<uint8_t>(record.level));
+    AppendValue(m_writeBuffer, formatId);
+    AppendValue(m_writeBuffer, record.ticks);
+    AppendValue(m_writeBuffer, static_cast<uint16_t>(record.length));
+    m_writeBuffer.append(record.text, record.length);
+}
+
+void Logger::AppendBinaryPlain(LogLevel level, int64_t ticks, std::string_view text) {
+    uint16_t length = static_cast<uint16_t>(std::min<size_t>(text.size(), UINT16_MAX));
+    
+    AppendValue(m_writeBuffer, BinaryLogRecordKind::Message);
+    AppendValue(m_writeBuffer, static_cast<uint8_t>(level));
+    AppendValue(m_writeBuffer, BINARY_LOG_PLAIN_FORMAT);
+    AppendValue(m_writeBuffer, ticks);
+    AppendValue(m_writeBuffer, length);
+    m_writeBuffer.append(text.data(), length);
+}
+
+void Logger::AppendBinarySession() {
+    using Ticks = std::chrono::steady_clock::period;
+    int64_t ticksPerSecond = static_cast<int64_t>(Ticks::den / Ticks::num);
+    int64_t wallClockUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        m_sessionTime.time_since_epoch()).count();
+    
+    AppendValue(m_writeBuffer, BinaryLogRecordKind::Session);
+    m_writeBuffer.append(BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC));
+    AppendValue(m_writeBuffer, BINARY_LOG_VERSION);
+    AppendValue(m_writeBuffer, ticksPerSecond);
+    AppendValue(m_writeBuffer, m_sessionTicks);
+    AppendValue(m_writeBuffer, wallClockUs);
+}
+
+void Logger::AppendDropped(int64_t ticks, uint64_t count) {
+    if (m_fileFormat == LogFileFormat::Binary) {
+        AppendValue(m_writeBuffer, BinaryLogRecordKind::Dropped);
+        AppendValue(m_writeBuffer, ticks);
+        AppendValue(m_writeBuffer, count);
+    } else {
+        AppendText(LogLevel::Warning, ticks, "Log queue full, dropped " + std::to_string(count) + " messages");
+    }
+}
+
+void Logger::WriteBuffer() {
+    if (!m_writeBuffer.empty() && m_logFile.is_open()) {
+        m_logFile.write(m_writeBuffer.data(), static_cast<std::streamsize>(m_writeBuffer.size()));
     }
+    m_writeBuffer.clear();
+}
+
+std::string Logger::GetTimestamp(int64_t ticks) {
+    auto time = m_sessionTime + std::chrono::duration_cast<std::chrono::system_clock::duration>(
+        std::chrono::steady_clock::duration(ticks - m_sessionTicks));
+    auto time_t = std::chrono::system_clock::to_time_t(time);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        time.time_since_epoch()) % 1000;
     
-    std::stringstream ss;
-    ss << std::put_time(&localTime, "%Y-%m-%d %H:%M:%S");
-    ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
+    // The date/time part only changes once a second, so format it once per second
+    if (time_t != m_cachedSecond || m_cachedTimestamp.empty()) {
+        struct tm localTime;
+        if (!ToLocalTime(time_t, localTime)) {
+            return "[TIMESTAMP_ERROR]";
+        }
+        
+        std::stringstream ss;
+        ss << std::put_time(&localTime, "%Y-%m-%d %H:%M:%S");
+        m_cachedTimestamp = ss.str();
+        m_cachedSecond = time_t;
+    }
     
-    return ss.str();
+    char millis[8];
+    std::snprintf(millis, sizeof(millis), ".%03d", static_cast<int>(ms.count()));
+    return m_cachedTimestamp + millis;
 }
 
 std::string Logger::GetLevelString(LogLevel level) const {
@@ -113,34 +384,46 @@ std::string Logger::GetLevelString(LogLevel level) const {
     }
 }
 
-std::wstring Logger::GetDefaultLogPath() const {
+std::wstring Logger::GetDataDirectory() {
+#ifdef _WIN32
     wchar_t path[MAX_PATH];
     
     // Get AppData\Local folder
     if (SUCCEEDED(SHGetFolderPath(nullptr, CSIDL_LOCAL_APPDATA, nullptr, 0, path))) {
-        std::wstring logPath = path;
-        logPath += L"\\MatrixScreensaver";
+        std::wstring directory = path;
+        directory += L"\\MatrixScreensaver";
         
         // Create directory if it doesn't exist
-        CreateDirectory(logPath.c_str(), nullptr);
-        
+        CreateDirectory(directory.c_str(), nullptr);
+        return directory;
+    }
+#endif
+    
+    return L"";
+}
+
+std::wstring Logger::GetDefaultLogPath(LogFileFormat format) const {
+    const wchar_t* extension = (format == LogFileFormat::Binary) ? L".mlog" : L".log";
+    std::wstring logPath = GetDataDirectory();
+    
+    if (!logPath.empty()) {
         // Add log file name with timestamp
         auto now = std::chrono::system_clock::now();
         auto time_t = std::chrono::system_clock::to_time_t(now);
         
         struct tm localTime;
-        if (localtime_s(&localTime, &time_t) == 0) {
+        if (ToLocalTime(time_t, localTime)) {
             std::wstringstream ss;
             ss << logPath << L"\\matrix_" 
                << std::put_time(&localTime, L"%Y%m%d")
-               << L".log";
+               << extension;
             return ss.str();
         }
         
-        // Fallback if localtime_s fails
-        return logPath + L"\\matrix_screensaver.log";
+        // Fallback if the local time is unavailable
+        return logPath + L"\\matrix_screensaver" + extension;
     }
     
     // Fallback to current directory
-    return L"matrix_screensaver.log";
+    return std::wstring(L"matrix_screensaver") + extension;
 }
\ No newline at end of file
@@ -1,11 +1,18 @@
 #pragma once
 
+#include "binary_log.h"
 #include <string>
+#include <string_view>
+#include <format>
 #include <fstream>
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <unordered_map>
 
 enum class LogLevel {
     Debug,
@@ -14,44 +21,187 @@ enum class LogLevel {
     Error
 };
 
+// Log file layout: readable text, or the compact binary format of
+// binary_log.h (decoded offline with matrix_logdump)
+enum class LogFileFormat {
+    Text,
+    Binary
+};
+
+// Lowest level compiled in: 0 = Debug, 1 = Info, 2 = Warning, 3 = Error.
+// LOG_* calls below it are removed entirely, arguments included.
+#ifndef MATRIX_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define MATRIX_LOG_MIN_LEVEL 1
+#else
+#define MATRIX_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+// Asynchronous file logger.
+//
+// Callers only copy their message into a fixed-size slot of a bounded
+// multi-producer ring; a background thread formats timestamps, writes whole
+// batches and flushes. Producers never block or touch the file: when the
+// ring is full the message is dropped and counted, and the writer reports
+// the drop count in the log. Shutdown() drains everything still queued.
+//
+// In binary mode producers skip formatting altogether: they pack the raw
+// arguments and a pointer to the format string, and the writer emits each
+// distinct format string once per session.
 class Logger {
 public:
     static Logger& Instance() {
         static Logger instance;
         return instance;
     }
-    
-    void Initialize(bool enabled, const std::wstring& logPath = L"");
+
+    void Initialize(bool enabled, LogFileFormat format = LogFileFormat::Text, const std::wstring& logPath = L"");
     void SetEnabled(bool enabled);
-    bool IsEnabled() const { return m_enabled; }
-    
-    void Log(LogLevel level, const std::string& message);
-    void Debug(const std::string& message) { Log(LogLevel::Debug, message); }
-    void Info(const std::string& message) { Log(LogLevel::Info, message); }
-    void Warning(const std::string& message) { Log(LogLevel::Warning, message); }
-    void Error(const std::string& message) { Log(LogLevel::Error, message); }
-    
+    static bool IsEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    void Log(LogLevel level, std::string_view message);
+
+    // std::format-style logging; the message is formatted straight into its
+    // queue slot (truncated, never allocated), or in binary mode its arguments
+    // are packed there. Use through the LOG_* macros so arguments are not
+    // even evaluated while logging is off.
+    template<typename... Args>
+    void LogFormat(LogLevel level, std::format_string<Args...> format, Args&&... args) {
+        uint64_t pos;
+        LogRecord* record = ClaimRecord(pos);
+        if (!record) return;
+
+        if (m_binary.load(std::memory_order_relaxed)) {
+            // Format strings are literals, so the writer can read them later
+            BinaryArgWriter writer(record->text, MAX_MESSAGE_LENGTH);
+            (writer.Add(args), ...);
+            record->format = format.get();
+            record->length = static_cast<uint32_t>(writer.GetLength());
+        } else {
+            auto result = std::format_to_n(record->text, MAX_MESSAGE_LENGTH, format, std::forward<Args>(args)...);
+            record->format = {};
+            record->length = static_cast<uint32_t>(result.out - record->text);
+        }
+        PublishRecord(record, pos, level);
+    }
+
+    void Debug(std::string_view message) { Log(LogLevel::Debug, message); }
+    void Info(std::string_view message) { Log(LogLevel::Info, message); }
+    void Warning(std::string_view message) { Log(LogLevel::Warning, message); }
+    void Error(std::string_view message) { Log(LogLevel::Error, message); }
+
+    // Wait (briefly) until everything logged so far has reached the file
     void Flush();
-    
+
+    // Stop the writer thread after draining the queue; call before exit
+    void Shutdown();
+
+    uint64_t GetDroppedCount() const { return m_droppedCount.load(std::memory_order_relaxed); }
+
+    // %LOCALAPPDATA%\MatrixScreensaver (created on demand), or empty if unavailable
+    static std::wstring GetDataDirectory();
+
 private:
     Logger();
     ~Logger();
-    
+
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
-    
-    std::string GetTimestamp() const;
+
+    static constexpr size_t RING_CAPACITY = 1024;           // Must be a power of two
+    static constexpr size_t MAX_MESSAGE_LENGTH = 240;       // Longer messages are truncated
+    static constexpr std::chrono::milliseconds WRITER_IDLE_INTERVAL{10};
+
+    struct LogRecord {
+        std::atomic<uint64_t> sequence{0};
+        LogLevel level = LogLevel::Info;
+        uint32_t length = 0;
+        int64_t ticks = 0;                  // steady_clock counter, converted by the writer
+        std::string_view format;            // Binary mode only; empty for plain text
+        char text[MAX_MESSAGE_LENGTH];      // Message text, or packed arguments
+    };
+
+    LogRecord* ClaimRecord(uint64_t& pos);
+    void PublishRecord(LogRecord* record, uint64_t pos, LogLevel level);
+
+    void StartWriter();
+    void StopWriter();
+    void WriterLoop();
+    size_t DrainRing();
+
+    // Append one entry to m_writeBuffer in the file's format
+    void AppendText(LogLevel level, int64_t ticks, std::string_view text);
+    void AppendBinary(const LogRecord& record);
+    void AppendBinaryPlain(LogLevel level, int64_t ticks, std::string_view text);
+    void AppendBinarySession();
+    void AppendDropped(int64_t ticks, uint64_t count);
+    void WriteBuffer();
+
+    static int64_t GetTicks() { return std::chrono::steady_clock::now().time_since_epoch().count(); }
+
+    std::string GetTimestamp(int64_t ticks);
     std::string GetLevelString(LogLevel level) const;
-    std::wstring GetDefaultLogPath() const;
-    
-    bool m_enabled = false;
-    std::ofstream m_logFile;
-    std::mutex m_mutex;
+    std::wstring GetDefaultLogPath(LogFileFormat format) const;
+
+    static inline std::atomic<bool> s_enabled{false};      // Static so the macros skip Instance()
+    std::atomic<bool> m_binary{false};
+    std::mutex m_mutex;                                     // Guards Initialize/SetEnabled/Shutdown only
     std::wstring m_logPath;
+    LogFileFormat m_fileFormat = LogFileFormat::Text;
+
+    // Producer side
+    std::unique_ptr<LogRecord[]> m_ring;
+    alignas(64) std::atomic<uint64_t> m_enqueuePos{0};
+    alignas(64) std::atomic<uint64_t> m_dequeuePos{0};      // Written by the writer thread only
+    std::atomic<uint64_t> m_droppedCount{0};
+
+    // Writer side
+    std::thread m_writer;
+    std::atomic<bool> m_writerRunning{false};
+    std::ofstream m_logFile;
+    std::string m_writeBuffer;
+    uint64_t m_reportedDrops = 0;
+    time_t m_cachedSecond = 0;
+    std::string m_cachedTimestamp;
+
+    // Session clock anchor: ticks at start and the matching wall-clock time
+    int64_t m_sessionTicks = 0;
+    std::chrono::system_clock::time_point m_sessionTime;
+
+    // Binary mode: format string address -> ID written this session
+    std::unordered_map<const char*, uint16_t> m_formatIds;
+
+    // Tests hold the writer off to fill the ring; Shutdown() still drains it
+    std::atomic<bool> m_writerHeld{false};
+    friend struct LoggerTestAccess;     // tests/logger_test.cpp
 };
 
-// Convenience macros
-#define LOG_DEBUG(msg) Logger::Instance().Debug(msg)
-#define LOG_INFO(msg) Logger::Instance().Info(msg)
-#define LOG_WARNING(msg) Logger::Instance().Warning(msg)
-#define LOG_ERROR(msg) Logger::Instance().Error(msg)
\ No newline at end of file
+// Convenience macros: LOG_INFO("Loaded {} glyphs", count). Disabled logging
+// costs one branch; levels below MATRIX_LOG_MIN_LEVEL cost nothing.
+#define MATRIX_LOG(level, ...) \
+    do { \
+        if (Logger::IsEnabled()) { \
+            Logger::Instance().LogFormat(level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#if MATRIX_LOG_MIN_LEVEL <= 0
+#define LOG_DEBUG(...) MATRIX_LOG(LogLevel::Debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#if MATRIX_LOG_MIN_LEVEL <= 1
+#define LOG_INFO(...) MATRIX_LOG(LogLevel::Info, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if MATRIX_LOG_MIN_LEVEL <= 2
+#define LOG_WARNING(...) MATRIX_LOG(LogLevel::Warning, __VA_ARGS__)
+#else
+#define LOG_WARNING(...) ((void)0)
+#endif
+
+#define LOG_ERROR(...) MATRIX_LOG(LogLevel::Error, __VA_ARGS__)
@@ -2,14 +2,17 @@
 #include "matrix_screensaver.h"
 #include "config_dialog.h"
 #include "logger.h"
+#include "frame_pacer.h"
+#include "message_loop_clock.h"
 #include <windowsx.h>
-
-std::mt19937 g_rng(static_cast<unsigned int>(std::chrono::steady_clock::now().time_since_epoch().count()));
+#include <filesystem>
+#include <fstream>
 
 // Global variables
 std::unique_ptr<MatrixScreensaver> g_screensaver;
 
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+void AppendStartupBenchmark(const StartupTimes& times);
 
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, 
                    PWSTR pCmdLine, int nCmdShow) {
@@ -35,7 +38,10 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
         return 0;
     }
     
-    // Screensaver mode (default)
+    // Screensaver mode (default). /b exits after the first frame and appends
+    // the startup times to startup_benchmark.csv, for timing cold starts
+    bool benchmark = cmdLine.find(L"/b") != std::wstring::npos;
+    
     WNDCLASSEX wc = {};
     wc.cbSize = sizeof(WNDCLASSEX);
     wc.style = CS_HREDRAW | CS_VREDRAW;
@@ -47,6 +53,15 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
     
     RegisterClassEx(&wc);
     
+    // One screensaver for all monitors; each window becomes an output of it
+    g_screensaver = std::make_unique<MatrixScreensaver>();
+    if (!g_screensaver->Initialize()) {
+        g_screensaver.reset();
+        Logger::Instance().Shutdown();
+        CoUninitialize();
+        return 1;
+    }
+    
     // Create screensaver windows for each monitor
     struct MonitorData {
         HINSTANCE hInstance;
@@ -98,13 +113,57 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
         }
     }
     
-    // Message loop
+    // Windows that could not get an output were never created
+    if (monitorData.windows.empty()) {
+        g_screensaver.reset();
+        Logger::Instance().Shutdown();
+        CoUninitialize();
+        return 1;
+    }
+    
+    // Message loop: drain messages, then wait for the next frame deadline.
+    // The pacer's sleep wakes on input, so messages are never held behind a frame.
+    MessageLoopClock clock;
+    FramePacer pacer(clock);
     MSG msg = {};
-    while (GetMessage(&msg, nullptr, 0, 0)) {
-        TranslateMessage(&msg);
-        DispatchMessage(&msg);
+    for (;;) {
+        bool quit = false;
+        while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+            if (msg.message == WM_QUIT) {
+                quit = true;
+                break;
+            }
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        }
+        if (quit) break;
+        
+        if (!g_screensaver->HasOutputs()) {
+            pacer.Reset();
+            WaitMessage();
+            continue;
+        }
+        
+        pacer.SetTargetRate(g_screensaver->GetTargetFrameRate());
+        if (!pacer.Wait()) continue;
+        
+        float deltaTime = pacer.BeginFrame();
+        g_screensaver->SetFrameLateness(pacer.GetStats().lastLatenessMs);
+        g_screensaver->Update(deltaTime);
+        g_screensaver->Render();
+        
+        if (benchmark && g_screensaver->GetStartupTimes().firstFrameMs > 0.0f) {
+            AppendStartupBenchmark(g_screensaver->GetStartupTimes());
+            msg.wParam = 0;
+            break;
+        }
     }
     
+    // Tear down before statics are destroyed so shutdown logging still works,
+    // then let the logger drain its queue
+    g_screensaver.reset();
+    Logger::Instance().Shutdown();
+    
     CoUninitialize();
     return static_cast<int>(msg.wParam);
 }
@@ -119,49 +178,31 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         {
             s_startTime = std::chrono::steady_clock::now();
             
-            g_screensaver = std::make_unique<MatrixScreensaver>();
-            if (!g_screensaver->Initialize(hwnd)) {
+            if (!g_screensaver || !g_screensaver->AddOutput(hwnd)) {
                 LOG_ERROR("Failed to initialize screensaver");
                 return -1;
             }
             
             LOG_INFO("Screensaver initialized successfully");
             
-            // Set up timer for animation
-            SetTimer(hwnd, 1, 16, nullptr); // ~60 FPS
-            
             // Hide cursor
             ShowCursor(FALSE);
         }
         break;
         
     case WM_DESTROY:
-        KillTimer(hwnd, 1);
         if (g_screensaver) {
-            g_screensaver->Shutdown();
-            g_screensaver.reset();
+            g_screensaver->RemoveOutput(hwnd);
         }
         ShowCursor(TRUE);
         PostQuitMessage(0);
         break;
         
-    case WM_TIMER:
-        if (g_screensaver) {
-            static auto lastFrame = std::chrono::high_resolution_clock::now();
-            auto now = std::chrono::high_resolution_clock::now();
-            auto deltaTime = std::chrono::duration<float>(now - lastFrame).count();
-            lastFrame = now;
-            
-            g_screensaver->Update(deltaTime);
-            g_screensaver->Render();
-        }
-        break;
-        
     case WM_SIZE:
         if (g_screensaver) {
             int width = LOWORD(lParam);
             int height = HIWORD(lParam);
-            g_screensaver->Resize(width, height);
+            g_screensaver->Resize(hwnd, width, height);
         }
         break;
         
@@ -206,6 +247,24 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
     return 0;
 }
 
+void AppendStartupBenchmark(const StartupTimes& times) {
+    std::wstring directory = Logger::GetDataDirectory();
+    std::wstring path = (directory.empty() ? L"" : directory + L"\\") + L"startup_benchmark.csv";
+    
+    // One line per run, all in milliseconds since the process was created
+    bool exists = GetFileAttributes(path.c_str()) != INVALID_FILE_ATTRIBUTES;
+    std::ofstream file(std::filesystem::path(path), std::ios::app);
+    if (!file.is_open()) {
+        LOG_WARNING("Failed to write the startup benchmark");
+        return;
+    }
+    if (!exists) {
+        file << "first_frame_ms,device_ms,first_output_ms,simulation_ms\n";
+    }
+    file << std::format("{:.1f},{:.1f},{:.1f},{:.1f}\n",
+                        times.firstFrameMs, times.deviceMs, times.firstOutputMs, times.simulationMs);
+}
+
 // Utility function implementations
 std::wstring GetExecutablePath() {
     wchar_t path[MAX_PATH];
@@ -84,30 +84,34 @@ bool MaskLoader::LoadFromFile(const std::wstring& filePath) {
 }
 
 std::vector<std::vector<float>> MaskLoader::CreateDensityMap(int targetWidth, int targetHeight) const {
+    return CreateDensityMap(m_bitmapData, targetWidth, targetHeight);
+}
+
+std::vector<std::vector<float>> MaskLoader::CreateDensityMap(const BitmapData& bitmap, int targetWidth, int targetHeight) {
     std::vector<std::vector<float>> densityMap(targetWidth, std::vector<float>(targetHeight, 0.5f));
     
-    if (m_bitmapData.pixels.empty() || m_bitmapData.width == 0 || m_bitmapData.height == 0) {
+    if (bitmap.pixels.empty() || bitmap.width == 0 || bitmap.height == 0) {
         return densityMap;
     }
     
     for (int y = 0; y < targetHeight; ++y) {
         for (int x = 0; x < targetWidth; ++x) {
             // Map target coordinates to source coordinates
-            int srcX = static_cast<int>((static_cast<float>(x) / targetWidth) * m_bitmapData.width);
-            int srcY = static_cast<int>((static_cast<float>(y) / targetHeight) * m_bitmapData.height);
+            int srcX = static_cast<int>((static_cast<float>(x) / targetWidth) * bitmap.width);
+            int srcY = static_cast<int>((static_cast<float>(y) / targetHeight) * bitmap.height);
             
             // Clamp to valid range
-            srcX = std::clamp(srcX, 0, m_bitmapData.width - 1);
-            srcY = std::clamp(srcY, 0, m_bitmapData.height - 1);
+            srcX = std::clamp(srcX, 0, bitmap.width - 1);
+            srcY = std::clamp(srcY, 0, bitmap.height - 1);
             
             // Get pixel from source image
-            int pixelIndex = (srcY * m_bitmapData.width + srcX) * 4;
+            int pixelIndex = (srcY * bitmap.width + srcX) * 4;
             
-            if (pixelIndex + 3 < static_cast<int>(m_bitmapData.pixels.size())) {
-                uint8_t r = m_bitmapData.pixels[pixelIndex + 0];
-                uint8_t g = m_bitmapData.pixels[pixelIndex + 1];
-                uint8_t b = m_bitmapData.pixels[pixelIndex + 2];
-                uint8_t a = m_bitmapData.pixels[pixelIndex + 3];
+            if (pixelIndex + 3 < static_cast<int>(bitmap.pixels.size())) {
+                uint8_t r = bitmap.pixels[pixelIndex + 0];
+                uint8_t g = bitmap.pixels[pixelIndex + 1];
+                uint8_t b = bitmap.pixels[pixelIndex + 2];
+                uint8_t a = bitmap.pixels[pixelIndex + 3];
                 
                 // Calculate luminance (brightness)
                 float luminance = (0.299f * r + 0.587f * g + 0.114f * b) / 255.0f;
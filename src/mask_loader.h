@@ -16,9 +16,11 @@ public:
 
     bool LoadFromFile(const std::wstring& filePath);
     const BitmapData& GetBitmapData() const { return m_bitmapData; }
+    BitmapData ReleaseBitmapData() { return std::move(m_bitmapData); }
     
     // Convert to density map (0.0 = transparent/black, 1.0 = opaque/white)
     std::vector<std::vector<float>> CreateDensityMap(int targetWidth, int targetHeight) const;
+    static std::vector<std::vector<float>> CreateDensityMap(const BitmapData& bitmap, int targetWidth, int targetHeight);
 
 private:
     bool InitializeWIC();
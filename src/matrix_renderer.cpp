@@ -1,34 +1,52 @@
 #include "matrix_renderer.h"
 #include "mask_loader.h"
+#include "glyph_table.h"
+#include "character_effects.h"
 #include "logger.h"
-#include <thread>
+#include "settings_schema.h"
 #include <cmath>
+#include <atomic>
+
+namespace {
+
+// Distinguishes the renderers of a multi-monitor session in trace file names
+std::atomic<int> g_rendererInstanceCount{0};
+
+} // namespace
 
 MatrixRenderer::MatrixRenderer() 
     : m_lastUpdate(std::chrono::high_resolution_clock::now()),
-      m_lastFrameTime(std::chrono::high_resolution_clock::now()),
       m_performanceMetrics(std::make_unique<PerformanceMetrics>()),
       m_batchRenderer(std::make_unique<BatchRenderer>()),
-      m_gridCellPool(std::make_unique<MemoryPool<GridCell>>(2000, 1000)), // Large pool for grid cells
       m_dirtyRectManager(std::make_unique<DirtyRectManager>()),
-      m_characterEffects(std::make_unique<CharacterEffects>()) {
+      m_frameArena(std::make_unique<FrameArena>(256 * 1024)),
+      m_instanceId(g_rendererInstanceCount.fetch_add(1)) {
 }
 
 MatrixRenderer::~MatrixRenderer() {
     Shutdown();
 }
 
-bool MatrixRenderer::Initialize(HWND hwnd, const MatrixSettings& settings) {
+bool MatrixRenderer::Initialize(HWND hwnd, const MatrixSettings& settings, GraphicsDevice& graphics) {
     m_settings = settings;
+    m_graphics = &graphics;
     
     // Configure performance metrics
     if (m_performanceMetrics) {
         m_performanceMetrics->SetEnabled(settings.showPerformanceMetrics);
+        m_performanceMetrics->SetProfileWindow(static_cast<size_t>(std::max(settings.profileWindowFrames, 1)));
+        if (settings.enableFrameTrace) {
+            m_performanceMetrics->StartTrace(static_cast<size_t>(std::max(settings.frameTraceMaxFrames, 1)));
+        }
+        if (settings.enableCountersEndpoint) {
+            m_performanceMetrics->StartCountersEndpoint(m_instanceId, settings.enableCountersSocket);
+        }
     }
     
     // Configure performance optimizations
     if (m_batchRenderer) {
         m_batchRenderer->SetEnabled(settings.enableBatchRendering);
+        m_batchRenderer->SetFrameArena(m_frameArena.get());
         m_batchRenderer->Initialize(1000);
     }
     
@@ -37,35 +55,28 @@ bool MatrixRenderer::Initialize(HWND hwnd, const MatrixSettings& settings) {
         m_dirtyRectManager->Initialize(m_screenWidth, m_screenHeight, 64);
     }
     
-    // Configure character effects
-    if (m_characterEffects) {
-        m_characterEffects->Initialize(settings);
-    }
-    
-    // Set up frame rate limiting
-    if (settings.enableFrameRateLimiting && settings.targetFrameRate > 0) {
-        m_targetFrameDuration = std::chrono::duration<float, std::milli>(1000.0f / settings.targetFrameRate);
-    }
-    
     if (!InitializeDirect3D(hwnd)) return false;
     if (!InitializeDirect2D()) return false;
     if (!InitializeDirectWrite()) return false;
     
-    InitializeColumns();
-    
-    if (!settings.maskImagePath.empty()) {
-        LoadMask(settings.maskImagePath);
-    }
+    ConfigureQualityGovernor();
     
+    // The mask arrives through SetMask once DisplayManager has decoded it
     return true;
 }
 
 void MatrixRenderer::Shutdown() {
-    m_columns.clear();
-    m_densityMap.clear();
-    m_sparseGrid.clear();
-    m_activeCells.clear();
-    m_activeCellSet.clear();
+    // Write out the frame timeline captured this session, if any
+    if (m_performanceMetrics && m_performanceMetrics->IsTracing()) {
+        std::wstring directory = Logger::GetDataDirectory();
+        std::wstring basePath = (directory.empty() ? L"" : directory + L"\\") +
+            L"frame_trace_" + std::to_wstring(GetCurrentProcessId()) + L"_" + std::to_wstring(m_instanceId);
+        m_performanceMetrics->StopTrace(basePath);
+    }
+    
+    if (m_performanceMetrics) {
+        m_performanceMetrics->StopCountersEndpoint();
+    }
 }
 
 bool MatrixRenderer::InitializeDirect3D(HWND hwnd) {
@@ -74,58 +85,19 @@ bool MatrixRenderer::InitializeDirect3D(HWND hwnd) {
     m_screenWidth = clientRect.right - clientRect.left;
     m_screenHeight = clientRect.bottom - clientRect.top;
     
-    DXGI_SWAP_CHAIN_DESC swapChainDesc = {};
-    swapChainDesc.BufferCount = 2;
-    swapChainDesc.BufferDesc.Width = m_screenWidth;
-    swapChainDesc.BufferDesc.Height = m_screenHeight;
-    swapChainDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    swapChainDesc.BufferDesc.RefreshRate.Numerator = 60;
-    swapChainDesc.BufferDesc.RefreshRate.Denominator = 1;
-    swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-    swapChainDesc.OutputWindow = hwnd;
-    swapChainDesc.SampleDesc.Count = 1;
-    swapChainDesc.SampleDesc.Quality = 0;
-    swapChainDesc.Windowed = TRUE;
-    swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
-    
-    D3D_FEATURE_LEVEL featureLevel;
-    HRESULT hr = D3D11CreateDeviceAndSwapChain(
-        nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr,
-        D3D11_CREATE_DEVICE_BGRA_SUPPORT,
-        nullptr, 0, D3D11_SDK_VERSION,
-        &swapChainDesc, &m_swapChain,
-        &m_device, &featureLevel, &m_deviceContext);
-    
-    if (FAILED(hr)) return false;
-    
-    // Create render target view
-    Microsoft::WRL::ComPtr<ID3D11Texture2D> backBuffer;
-    hr = m_swapChain->GetBuffer(0, IID_PPV_ARGS(&backBuffer));
-    if (FAILED(hr)) return false;
-    
-    hr = m_device->CreateRenderTargetView(backBuffer.Get(), nullptr, &m_renderTargetView);
-    if (FAILED(hr)) return false;
-    
-    m_deviceContext->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), nullptr);
-    
-    D3D11_VIEWPORT viewport = {};
-    viewport.Width = static_cast<float>(m_screenWidth);
-    viewport.Height = static_cast<float>(m_screenHeight);
-    viewport.MinDepth = 0.0f;
-    viewport.MaxDepth = 1.0f;
-    viewport.TopLeftX = 0;
-    viewport.TopLeftY = 0;
-    m_deviceContext->RSSetViewports(1, &viewport);
+    // The device is shared with the other outputs; only the swap chain is ours
+    HRESULT hr = m_graphics->CreateSwapChain(
+        hwnd, static_cast<UINT>(m_screenWidth), static_cast<UINT>(m_screenHeight), &m_swapChain);
     
-    return true;
+    return SUCCEEDED(hr);
 }
 
 bool MatrixRenderer::InitializeDirect2D() {
-    HRESULT hr = D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, m_d2dFactory.GetAddressOf());
-    if (FAILED(hr)) return false;
+    m_d2dFactory = m_graphics->GetD2DFactory();
+    if (!m_d2dFactory) return false;
     
     Microsoft::WRL::ComPtr<IDXGISurface> dxgiBackBuffer;
-    hr = m_swapChain->GetBuffer(0, IID_PPV_ARGS(&dxgiBackBuffer));
+    HRESULT hr = m_swapChain->GetBuffer(0, IID_PPV_ARGS(&dxgiBackBuffer));
     if (FAILED(hr)) return false;
     
     D2D1_RENDER_TARGET_PROPERTIES props = D2D1::RenderTargetProperties(
@@ -139,7 +111,7 @@ bool MatrixRenderer::InitializeDirect2D() {
     // Create brushes
     Color matrixColor = GetMatrixColor();
     hr = m_d2dRenderTarget->CreateSolidColorBrush(
-        matrixColor.ToD2D1(), &m_greenBrush);
+        ToD2D1(matrixColor), &m_greenBrush);
     if (FAILED(hr)) return false;
     
     hr = m_d2dRenderTarget->CreateSolidColorBrush(
@@ -154,25 +126,12 @@ bool MatrixRenderer::InitializeDirect2D() {
 }
 
 bool MatrixRenderer::InitializeDirectWrite() {
-    HRESULT hr = DWriteCreateFactory(
-        DWRITE_FACTORY_TYPE_SHARED,
-        __uuidof(m_writeFactory),
-        reinterpret_cast<IUnknown**>(m_writeFactory.GetAddressOf()));
-    if (FAILED(hr)) return false;
-    
-    hr = m_writeFactory->CreateTextFormat(
-        m_settings.fontName.c_str(),
-        nullptr,
-        m_settings.boldFont ? DWRITE_FONT_WEIGHT_BOLD : DWRITE_FONT_WEIGHT_NORMAL,
-        DWRITE_FONT_STYLE_NORMAL,
-        DWRITE_FONT_STRETCH_NORMAL,
-        m_settings.fontSize,
-        L"",
-        &m_textFormat);
-    if (FAILED(hr)) return false;
+    m_writeFactory = m_graphics->GetWriteFactory();
+    if (!m_writeFactory) return false;
     
-    m_textFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_LEADING);
-    m_textFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR);
+    // Text formats come from the shared cache, so every output reuses them
+    m_textFormat = m_graphics->GetTextFormat(m_settings.fontName, m_settings.boldFont, m_settings.fontSize, false);
+    if (!m_textFormat) return false;
     
     // Initialize font cache for performance
     InitializeFontCache();
@@ -180,104 +139,31 @@ bool MatrixRenderer::InitializeDirectWrite() {
     return true;
 }
 
-void MatrixRenderer::InitializeColumns() {
-    m_columns.clear();
-    
-    std::uniform_real_distribution<float> speedDist(m_settings.minSpeed, m_settings.maxSpeed);
-    std::uniform_real_distribution<float> yDist(-200.0f, -50.0f);
-    
-    // Create columns based on density setting
-    int columnWidth = static_cast<int>(m_settings.fontSize * 0.8f);
-    int baseColumnCount = std::max(1, m_screenWidth / columnWidth);
-    
-    // Use density to control how many columns we create (0.1 to 3.0 = 10% to 300%)
-    int columnCount = static_cast<int>(baseColumnCount * m_settings.density);
-    
-    for (int i = 0; i < columnCount; ++i) {
-        MatrixColumn column;
-        // Distribute columns across the screen, allowing overlap when density > 1
-        column.x = static_cast<float>((i * m_screenWidth) / columnCount);
-        column.y = yDist(g_rng);
-        column.baseSpeed = speedDist(g_rng);
-        column.currentSpeed = column.baseSpeed;
-        column.baseFontSize = m_settings.fontSize;
-        column.layer = 0;
-        column.isActive = true;
-        
-        // Initialize with random starting position in character sequence
-        if (!m_settings.useCustomWord && m_settings.sequentialCharacters) {
-            column.customWordIndex = std::uniform_int_distribution<int>(0, static_cast<int>(MATRIX_CHARS.size()) - 1)(g_rng);
-        } else {
-            column.customWordIndex = 0;
-        }
-        
-        m_columns.push_back(std::move(column));
-    }
+void MatrixRenderer::SetMask(const BitmapData* mask) {
+    m_maskBitmap.Reset();
+    if (!mask || mask->pixels.empty() || !m_d2dRenderTarget) return;
     
-    // Initialize the grid
-    InitializeGrid();
-}
-
-void MatrixRenderer::InitializeGrid() {
-    // Create grid based on font size
-    int cellWidth = static_cast<int>(m_settings.fontSize * 0.8f);
-    int cellHeight = static_cast<int>(m_settings.fontSize * 0.9f);
+    // Create Direct2D bitmap
+    D2D1_BITMAP_PROPERTIES bitmapProps = D2D1::BitmapProperties(
+        D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_IGNORE));
     
-    m_gridWidth = std::max(1, m_screenWidth / cellWidth);
-    m_gridHeight = std::max(1, m_screenHeight / cellHeight);
+    D2D1_SIZE_U size = D2D1::SizeU(
+        static_cast<UINT32>(mask->width),
+        static_cast<UINT32>(mask->height));
     
-    // Clear optimized sparse storage
-    m_sparseGrid.clear();
-    m_activeCells.clear();
-    m_activeCellSet.clear();
+    HRESULT hr = m_d2dRenderTarget->CreateBitmap(
+        size, mask->pixels.data(),
+        static_cast<UINT32>(mask->width * 4),
+        &bitmapProps, &m_maskBitmap);
     
-    // Reserve space for typical active cell count (about 10% of full grid)
-    size_t estimatedActiveCells = (m_gridWidth * m_gridHeight) / 10;
-    m_activeCells.reserve(estimatedActiveCells);
-    m_sparseGrid.reserve(estimatedActiveCells);
-}
-
-void MatrixRenderer::LoadMask(const std::wstring& imagePath) {
-    MaskLoader loader;
-    if (loader.LoadFromFile(imagePath)) {
-        auto maskData = loader.GetBitmapData();
-        
-        // Create density map from actual bitmap pixels
-        m_densityMap = loader.CreateDensityMap(m_screenWidth, m_screenHeight);
-        
-        // Create Direct2D bitmap
-        D2D1_BITMAP_PROPERTIES bitmapProps = D2D1::BitmapProperties(
-            D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_IGNORE));
-        
-        D2D1_SIZE_U size = D2D1::SizeU(
-            static_cast<UINT32>(maskData.width),
-            static_cast<UINT32>(maskData.height));
-        
-        HRESULT hr = m_d2dRenderTarget->CreateBitmap(
-            size, maskData.pixels.data(),
-            static_cast<UINT32>(maskData.width * 4),
-            &bitmapProps, &m_maskBitmap);
-        
-        if (SUCCEEDED(hr)) {
-            CreateDensityMap();
-        }
+    if (FAILED(hr)) {
+        LOG_WARNING("Failed to create mask bitmap");
     }
 }
 
-void MatrixRenderer::CreateDensityMap() {
-    // Use the MaskLoader to create a proper density map from the actual bitmap
-    MaskLoader loader;
-    
-    if (!m_settings.maskImagePath.empty() && loader.LoadFromFile(m_settings.maskImagePath)) {
-        // Use the loaded bitmap data to create density map
-        m_densityMap = loader.CreateDensityMap(m_screenWidth, m_screenHeight);
-        return;
-    }
-    
-    // If no mask or loading failed, create uniform density
-    m_densityMap.resize(m_screenWidth);
-    for (auto& row : m_densityMap) {
-        row.resize(m_screenHeight, m_settings.density);
+void MatrixRenderer::SetTimeToFirstFrame(float ms) {
+    if (m_performanceMetrics) {
+        m_performanceMetrics->SetTimeToFirstFrame(ms);
     }
 }
 
@@ -286,32 +172,6 @@ Color MatrixRenderer::GetMatrixColor() const {
     return Color::FromHSV(m_settings.hue, 0.8f, 0.9f, 1.0f);
 }
 
-float MatrixRenderer::GetMaskBrightness(int x, int y) const {
-    // Use the existing density map which already samples the mask
-    if (m_densityMap.empty()) return 0.1f; // Low brightness if no mask
-    
-    // Clamp coordinates
-    int clampedX = std::max(0, std::min(x, static_cast<int>(m_densityMap.size()) - 1));
-    int clampedY = 0;
-    if (clampedX < static_cast<int>(m_densityMap.size()) && !m_densityMap[clampedX].empty()) {
-        clampedY = std::max(0, std::min(y, static_cast<int>(m_densityMap[clampedX].size()) - 1));
-    }
-    
-    // Get brightness from density map (assumes density correlates with brightness)
-    if (clampedX < static_cast<int>(m_densityMap.size()) && 
-        clampedY < static_cast<int>(m_densityMap[clampedX].size())) {
-        
-        // Convert density to brightness - invert because mask is typically white=bright
-        float density = m_densityMap[clampedX][clampedY];
-        
-        // For now, assume density IS brightness
-        // This should work if the mask setup is correct
-        return density;
-    }
-    
-    return 0.1f; // Default low brightness
-}
-
 Color MatrixRenderer::GetDepthColor(float depth, float alpha) const {
     // Create color based on depth (3D effect) and alpha using configurable hue
     Color baseColor = GetMatrixColor();
@@ -336,307 +196,289 @@ Color MatrixRenderer::GetDepthColor(float depth, float alpha) const {
     return baseColor;
 }
 
-float MatrixRenderer::GetDensityAt(int x, int y) const {
-    if (m_densityMap.empty() || x < 0 || y < 0 || 
-        x >= static_cast<int>(m_densityMap.size()) || 
-        y >= static_cast<int>(m_densityMap[0].size())) {
-        return m_settings.density;
-    }
-    
-    return m_densityMap[x][y];
-}
-
 void MatrixRenderer::Update(float deltaTime) {
-    // Update character effects system
-    if (m_characterEffects) {
-        m_characterEffects->Update(deltaTime);
+    FrameProfiler* profiler = GetProfiler();
+    
+    // The frame loop paces between frames; charge that gap to the Wait phase
+    if (profiler) {
+        profiler->AddPhaseTime(ProfilePhase::Wait, m_lastRenderEnd, FrameProfiler::Clock::now());
     }
     
-    UpdateColumns(deltaTime);
+    m_lastDeltaTime = deltaTime;
+    
+    if (m_qualityGovernor) {
+        const QualityLevels& levels = m_qualityGovernor->GetLevels();
+        m_frameCounters.qualityColumns = levels.Get(QualityKnob::Columns);
+        m_frameCounters.qualityEffects = levels.Get(QualityKnob::Effects);
+        m_frameCounters.qualityGlow = levels.Get(QualityKnob::Glow);
+    }
 }
 
-void MatrixRenderer::UpdateColumns(float deltaTime) {
-    std::uniform_int_distribution<int> charDist(0, static_cast<int>(MATRIX_CHARS.size()) - 1);
+void MatrixRenderer::Draw(const FrameSnapshot& snapshot) {
+    FrameProfiler* profiler = GetProfiler();
     
-    // Get rain intensity multiplier for dynamic rain effects
-    float rainIntensity = 1.0f;
-    if (m_characterEffects) {
-        rainIntensity = m_characterEffects->GetRainIntensityMultiplier();
+    // Start performance tracking; the pacing wait was already charged in Update
+    if (m_performanceMetrics) {
+        m_performanceMetrics->StartFrame();
     }
     
-    for (auto& column : m_columns) {
-        // Apply rain intensity variation to speed (reduced motion consideration)
-        float speedMultiplier = rainIntensity;
-        if (m_settings.enableMotionReduction) {
-            speedMultiplier *= 0.7f; // Slower movement for reduced motion
-        }
-        
-        // Move column head down
-        column.y += column.currentSpeed * speedMultiplier * deltaTime * 60.0f;
+    if (snapshot.frame != m_consumedFrame) {
+        ConsumeSnapshot(snapshot, profiler);
+    }
+    m_frameCounters.activeCells = snapshot.activeCells;
+    
+    // A new output has no viewport until the simulation publishes with it
+    SnapshotViewport noViewport;
+    const SnapshotViewport* found = snapshot.FindViewport(static_cast<uint32_t>(m_instanceId));
+    const SnapshotViewport& viewport = found ? *found : noViewport;
+    
+    {
+        ScopedPhaseTimer timer(profiler, ProfilePhase::Draw);
         
-        // Calculate grid position
-        int gridX = static_cast<int>(column.x / (m_settings.fontSize * 0.8f));
-        int gridY = static_cast<int>(column.y / (m_settings.fontSize * 0.9f));
+        // Direct2D clears the back buffer, so the D3D clear is not needed
+        m_d2dRenderTarget->BeginDraw();
+        m_d2dRenderTarget->Clear(D2D1::ColorF(D2D1::ColorF::Black));
         
-        // Check if head is in valid grid bounds
-        if (gridX >= 0 && gridX < m_gridWidth && gridY >= 0 && gridY < m_gridHeight) {
-            GridCell& cell = GetCell(gridX, gridY);
-            
-            // Only create new character if cell is empty or very faded
-            if (!cell.isActive || cell.alpha < 0.1f) {
-                // Get depth for 3D effects
-                float depth = 0.5f;
-                if (m_settings.useMask && m_settings.enable3DEffect) {
-                    depth = GetMaskBrightness(static_cast<int>(column.x), static_cast<int>(column.y));
-                }
-                
-                // Always place character - trails should appear everywhere
-                // Select character based on settings
-                if (m_settings.useCustomWord && !m_settings.customWord.empty()) {
-                    // Use custom word logic
-                    if (m_settings.sequentialCharacters) {
-                        cell.character = m_settings.customWord.substr(column.customWordIndex % static_cast<int>(m_settings.customWord.length()), 1);
-                        column.customWordIndex = (column.customWordIndex + 1) % static_cast<int>(m_settings.customWord.length());
-                    } else {
-                        // Random character from custom word
-                        int charIndex = std::uniform_int_distribution<int>(0, static_cast<int>(m_settings.customWord.length()) - 1)(g_rng);
-                        cell.character = m_settings.customWord.substr(charIndex, 1);
-                    }
-                } else if (m_characterEffects) {
-                    // Use enhanced character selection with variety and depth-based weighting
-                    cell.character = m_characterEffects->SelectCharacter(depth, m_settings.enableCharacterVariety);
-                } else {
-                    // Fallback to basic character selection
-                    cell.character = MATRIX_CHARS[charDist(g_rng)];
-                }
-                
-                cell.alpha = 1.0f; // Start bright
-                cell.fontSize = m_settings.fontSize * (0.7f + depth * 0.6f); // Depth-based size
-                cell.depth = depth;
-                cell.isActive = true;
-                
-                // Add to active tracking
-                SetCellActive(gridX, gridY, cell);
-            }
+        // Render mask as lighter background if available and enabled
+        if (m_maskBitmap && m_settings.useMask && m_settings.showMaskBackground) {
+            RenderMaskBackground(snapshot, viewport);
         }
+    }
+    
+    // Use optimized rendering if enabled (it times its own batch and draw phases)
+    if (m_settings.enableBatchRendering || m_settings.enableDirtyRectangles) {
+        RenderOptimized(snapshot, viewport);
+    } else {
+        // Standard rendering
+        ScopedPhaseTimer timer(profiler, ProfilePhase::Draw);
+        RenderGrid(snapshot, viewport);
+        RenderColumns(snapshot, viewport);
+    }
+    
+    // Render performance metrics overlay
+    if (m_performanceMetrics && m_settings.showPerformanceMetrics) {
+        ScopedPhaseTimer timer(profiler, ProfilePhase::MetricsOverlay);
+        m_performanceMetrics->Render(m_d2dRenderTarget.Get(), m_writeFactory.Get());
+    }
+    
+    {
+        // EndDraw submits the queued Direct2D work, so it counts toward present
+        ScopedPhaseTimer timer(profiler, ProfilePhase::Present);
         
-        // Reset column when off screen
-        if (column.y > m_screenHeight + 100) {
-            column.y = std::uniform_real_distribution<float>(-200.0f, -50.0f)(g_rng);
-            
-            // Reset to random starting character for Japanese sequential mode
-            if (!m_settings.useCustomWord && m_settings.sequentialCharacters) {
-                column.customWordIndex = std::uniform_int_distribution<int>(0, static_cast<int>(MATRIX_CHARS.size()) - 1)(g_rng);
-            }
+        HRESULT hr = m_d2dRenderTarget->EndDraw();
+        if (hr == D2DERR_RECREATE_TARGET) {
+            // Handle device lost scenario
+            InitializeDirect2D();
         }
     }
-    
-    // Update grid cells
-    UpdateGrid(deltaTime);
 }
 
-void MatrixRenderer::UpdateGrid(float deltaTime) {
-    // Only update active cells for massive performance gain
-    auto it = m_activeCells.begin();
-    while (it != m_activeCells.end()) {
-        auto [x, y] = *it;
-        uint64_t key = PackCoords(x, y);
-        
-        auto cellIt = m_sparseGrid.find(key);
-        if (cellIt == m_sparseGrid.end()) {
-            // Cell no longer exists, remove from active list
-            m_activeCellSet.erase(key);
-            it = m_activeCells.erase(it);
-            continue;
-        }
-        
-        GridCell& cell = cellIt->second;
+void MatrixRenderer::Present(bool waitForVBlank) {
+    FrameProfiler* profiler = GetProfiler();
+    
+    {
+        ScopedPhaseTimer timer(profiler, ProfilePhase::Present);
         
-        // Update character effects
-        if (m_characterEffects) {
-            // Start morphing occasionally
-            m_characterEffects->StartMorphing(cell, m_settings.morphFrequency * deltaTime);
-            m_characterEffects->UpdateMorphing(cell, deltaTime);
-            
-            // Start glitches occasionally
-            m_characterEffects->StartGlitch(cell, m_settings.glitchFrequency * deltaTime);
-            m_characterEffects->UpdateGlitch(cell, deltaTime);
-            
-            // Update phosphor glow
-            m_characterEffects->UpdateGlow(cell, deltaTime);
+        // Use adaptive VSync if enabled
+        UINT syncInterval = waitForVBlank ? 1 : 0;
+        if (m_settings.enableAdaptiveVSync) {
+            // Adaptive VSync - tear if running behind
+            syncInterval = 0;
         }
         
-        // Update last update time for effects
-        cell.lastUpdateTime += deltaTime;
-        
-        // Fade the character over time (adjusted by motion reduction setting)
-        float fadeRate = m_settings.fadeRate;
-        if (m_settings.enableMotionReduction) {
-            fadeRate *= 0.5f; // Slower fading for reduced motion
+        m_swapChain->Present(syncInterval, 0);
+    }
+    
+    // Release this frame's transient data; nothing may hold arena memory past here
+    if (m_batchRenderer) {
+        m_batchRenderer->Reset();
+    }
+    m_frameArena->Reset();
+    
+    // End performance tracking
+    if (m_performanceMetrics) {
+        if (m_performanceMetrics->IsCollectingCounters()) {
+            if (m_batchRenderer && m_settings.enableBatchRendering) {
+                m_frameCounters.batches = static_cast<uint32_t>(m_batchRenderer->GetFlushedBatchCount());
+                m_frameCounters.drawCalls += static_cast<uint32_t>(m_batchRenderer->GetDrawCallCount());
+            }
+            m_performanceMetrics->SetFrameCounters(m_frameCounters);
         }
-        cell.alpha -= fadeRate * deltaTime;
-        
-        // Deactivate when fully faded
-        if (cell.alpha <= 0.0f) {
-            cell.alpha = 0.0f;
-            cell.isActive = false;
-            cell.character = L"";
-            
-            // Remove from active tracking
-            m_activeCellSet.erase(key);
-            it = m_activeCells.erase(it);
+        m_performanceMetrics->EndFrame();
+    }
+    UpdateQualityGovernor();
+    m_frameCounters = FrameCounters();
+    m_lastRenderEnd = FrameProfiler::Clock::now();
+}
+
+void MatrixRenderer::ConsumeSnapshot(const FrameSnapshot& snapshot, FrameProfiler* profiler) {
+    m_consumedFrame = snapshot.frame;
+    
+    // Spawns are cumulative, so updates whose snapshots were never drawn still count
+    m_frameCounters.spawns += static_cast<uint32_t>(snapshot.totalSpawns - m_consumedSpawns);
+    m_consumedSpawns = snapshot.totalSpawns;
+    
+    // Fold the simulation phases into this frame at the times they actually ran
+    if (profiler && snapshot.hasTiming) {
+        auto origin = snapshot.timingEpoch + std::chrono::duration_cast<FrameProfiler::Clock::duration>(
+            std::chrono::duration<double, std::micro>(snapshot.timing.startUs));
+        for (size_t i = 0; i < PROFILE_PHASE_COUNT; ++i) {
+            if (snapshot.timing.phaseMs[i] <= 0.0f) continue;
             
-            // Remove from sparse grid to save memory
-            m_sparseGrid.erase(cellIt);
-        } else {
-            ++it;
+            auto start = origin + std::chrono::duration_cast<FrameProfiler::Clock::duration>(
+                std::chrono::duration<float, std::milli>(snapshot.timing.phaseStartMs[i]));
+            auto end = start + std::chrono::duration_cast<FrameProfiler::Clock::duration>(
+                std::chrono::duration<float, std::milli>(snapshot.timing.phaseMs[i]));
+            profiler->AddPhaseTime(static_cast<ProfilePhase>(i), start, end);
         }
     }
 }
 
+void MatrixRenderer::SetFrameLateness(float latenessMs) {
+    m_frameCounters.latenessMs = latenessMs;
+}
 
-void MatrixRenderer::Render() {
-    // Start performance tracking
-    if (m_performanceMetrics) {
-        m_performanceMetrics->StartFrame();
-    }
-    
-    // Frame rate limiting
-    if (m_settings.enableFrameRateLimiting && m_settings.targetFrameRate > 0) {
-        auto now = std::chrono::high_resolution_clock::now();
-        auto timeSinceLastFrame = std::chrono::duration<float, std::milli>(now - m_lastFrameTime);
-        
-        if (timeSinceLastFrame < m_targetFrameDuration) {
-            // Sleep to maintain target frame rate
-            auto sleepTime = m_targetFrameDuration - timeSinceLastFrame;
-            std::this_thread::sleep_for(sleepTime);
+void MatrixRenderer::ConfigureQualityGovernor() {
+    if (!m_settings.enableQualityGovernor) {
+        m_qualityGovernor.reset();
+        ApplyQuality(QualityLevels());
+    } else {
+        if (!m_qualityGovernor) {
+            m_qualityGovernor = std::make_unique<QualityGovernor>();
+            LOG_INFO("Quality governor enabled ({:.1f} FPS target)", GetTargetFrameRate());
         }
+        m_qualityGovernor->SetTargetRate(GetTargetFrameRate());
         
-        m_lastFrameTime = std::chrono::high_resolution_clock::now();
+        // Glow is only drawn by the unbatched optimized path
+        bool glowDrawn = m_settings.enablePhosphorGlow && m_settings.enableDirtyRectangles && !m_settings.enableBatchRendering;
+        m_qualityGovernor->SetKnobAvailable(QualityKnob::Glow, glowDrawn);
+        m_qualityGovernor->SetKnobAvailable(QualityKnob::Effects,
+            m_settings.enableCharacterMorphing || m_settings.enableGlitchEffects);
     }
     
-    // Clear background
-    float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
-    m_deviceContext->ClearRenderTargetView(m_renderTargetView.Get(), clearColor);
-    
-    m_d2dRenderTarget->BeginDraw();
-    m_d2dRenderTarget->Clear(D2D1::ColorF(D2D1::ColorF::Black));
-    
-    // Render mask as lighter background if available and enabled
-    if (m_maskBitmap && m_settings.useMask && m_settings.showMaskBackground) {
-        RenderMaskBackground();
+    // The governor and preset timing need phase times even with the overlay off
+    if (m_performanceMetrics) {
+        m_performanceMetrics->SetProfilingRequired(m_qualityGovernor != nullptr || !m_settings.qualityPreset.empty());
+        m_performanceMetrics->SetQualityStatus(m_qualityGovernor ? &m_qualityGovernor->GetStatus() : nullptr);
     }
+}
+
+void MatrixRenderer::UpdateQualityGovernor() {
+    if (!m_qualityGovernor || !m_performanceMetrics) return;
     
-    // Use optimized rendering if enabled
-    if (m_settings.enableBatchRendering || m_settings.enableDirtyRectangles) {
-        RenderOptimized();
-    } else {
-        // Standard rendering
-        RenderGrid();
-        RenderColumns();
-    }
+    FrameSample sample;
+    if (!m_performanceMetrics->GetFrameProfiler().GetLatestSample(sample)) return;
     
-    // Render performance metrics overlay
-    if (m_performanceMetrics && m_settings.showPerformanceMetrics) {
-        m_performanceMetrics->Render(m_d2dRenderTarget.Get(), m_writeFactory.Get());
+    if (m_qualityGovernor->Observe(sample, m_frameCounters.latenessMs, m_lastDeltaTime)) {
+        const QualityGovernorStatus& status = m_qualityGovernor->GetStatus();
+        QualityKnob knob = status.lastKnob;
+        LOG_INFO("Quality governor {} {} to {:.0f}% (p90 {:.2f} ms, late {:.2f} ms, budget {:.2f} ms)",
+                 status.lastDirection < 0 ? "lowered" : "raised", GetQualityKnobName(knob),
+                 status.target.Get(knob) * 100.0f, status.loadMs, status.latenessMs, status.budgetMs);
     }
     
-    HRESULT hr = m_d2dRenderTarget->EndDraw();
-    if (hr == D2DERR_RECREATE_TARGET) {
-        // Handle device lost scenario
-        InitializeDirect2D();
-    }
+    ApplyQuality(m_qualityGovernor->GetLevels());
+}
+
+bool MatrixRenderer::GetLatestFrameSample(FrameSample& sample) const {
+    if (!GetProfiler()) return false;
+    return m_performanceMetrics->GetFrameProfiler().GetLatestSample(sample);
+}
+
+bool MatrixRenderer::IsAtFullQuality() const {
+    if (!m_qualityGovernor) return true;
     
-    // Use adaptive VSync if enabled
-    UINT syncInterval = 1;
-    if (m_settings.enableAdaptiveVSync) {
-        // Adaptive VSync - tear if running behind
-        syncInterval = 0;
-    }
+    const QualityLevels& levels = m_qualityGovernor->GetLevels();
+    return std::all_of(levels.values.begin(), levels.values.end(), [](float value) { return value >= 1.0f; });
+}
+
+void MatrixRenderer::ApplyQuality(const QualityLevels& levels) {
+    m_glowScale = levels.Get(QualityKnob::Glow);
     
-    m_swapChain->Present(syncInterval, 0);
+    // Quantize so a ramp changes the simulation (and the capture) in a few steps
+    auto quantize = [](float value) { return std::round(value * 20.0f) / 20.0f; };
+    float effects = levels.Get(QualityKnob::Effects);
     
-    // End performance tracking
-    if (m_performanceMetrics) {
-        m_performanceMetrics->EndFrame();
+    SimQuality quality;
+    quality.columnFraction = quantize(levels.Get(QualityKnob::Columns));
+    quality.effectScale = quantize(effects);
+    quality.effectInterval = effects >= 0.75f ? 1 : (effects >= 0.4f ? 2 : 3);
+    
+    // DisplayManager combines the outputs' requests for the shared simulation
+    m_simQuality = quality;
+}
+
+float MatrixRenderer::GetTargetFrameRate() const {
+    // Without the limiter, keep the 60 Hz cadence the old 16 ms timer gave
+    if (m_settings.enableFrameRateLimiting && m_settings.targetFrameRate > 0) {
+        return static_cast<float>(m_settings.targetFrameRate);
     }
+    return 60.0f;
 }
 
-void MatrixRenderer::RenderGrid() {
-    // Only render active cells - massive performance improvement!
-    for (const auto& [x, y] : m_activeCells) {
-        uint64_t key = PackCoords(x, y);
-        auto it = m_sparseGrid.find(key);
-        if (it == m_sparseGrid.end()) continue;
-        
-        const GridCell& cell = it->second;
-        
-        if (!cell.isActive || cell.alpha < 0.05f || cell.character.empty()) {
-            continue; // Skip inactive or transparent cells
-        }
-        
-        // Calculate screen position
-        float screenX = static_cast<float>(x) * m_settings.fontSize * 0.8f;
-        float screenY = static_cast<float>(y) * m_settings.fontSize * 0.9f;
+void MatrixRenderer::RenderGrid(const FrameSnapshot& snapshot, const SnapshotViewport& viewport) {
+    const GlyphTable& glyphs = GlyphTable::Instance();
+    float originX = static_cast<float>(viewport.rect.left);
+    float originY = static_cast<float>(viewport.rect.top);
+    
+    // Only this viewport's visible active cells - massive performance improvement!
+    for (const SnapshotCell& cell : snapshot.GetCells(viewport)) {
+        float alpha = cell.alpha;
         
-        if (screenX < -50 || screenX > m_screenWidth + 50 || 
-            screenY < -50 || screenY > m_screenHeight + 50) {
-            continue; // Skip off-screen cells
-        }
+        // Calculate screen position; the snapshot already dropped off-screen cells
+        float screenX = static_cast<float>(cell.x) * m_settings.fontSize * 0.8f - originX;
+        float screenY = static_cast<float>(cell.y) * m_settings.fontSize * 0.9f - originY;
         
         // Get color based on depth and alpha
-        Color color = GetDepthColor(cell.depth, cell.alpha);
-        m_fadeBrush->SetColor(color.ToD2D1());
+        Color color = GetDepthColor(cell.GetDepth(), alpha);
+        m_fadeBrush->SetColor(ToD2D1(color));
         
         // Create layout rect
+        float fontSize = GetCellFontSize(cell);
         D2D1_RECT_F layoutRect = D2D1::RectF(
-            screenX - cell.fontSize * 0.5f, screenY,
-            screenX + cell.fontSize * 0.5f, screenY + cell.fontSize);
+            screenX - fontSize * 0.5f, screenY,
+            screenX + fontSize * 0.5f, screenY + fontSize);
         
         // Use cached font format for performance
-        IDWriteTextFormat* format = GetCachedFormat(cell.fontSize);
+        const std::wstring& character = glyphs.GetGlyph(cell.glyph);
+        IDWriteTextFormat* format = GetCachedFormat(fontSize);
         if (format) {
             m_d2dRenderTarget->DrawText(
-                cell.character.c_str(),
-                static_cast<UINT32>(cell.character.length()),
+                character.c_str(),
+                static_cast<UINT32>(character.length()),
                 format,
                 layoutRect,
                 m_fadeBrush.Get());
+            m_frameCounters.drawCalls++;
         } else {
             // Fallback to default format if cache miss
             m_d2dRenderTarget->DrawText(
-                cell.character.c_str(),
-                static_cast<UINT32>(cell.character.length()),
+                character.c_str(),
+                static_cast<UINT32>(character.length()),
                 m_textFormat.Get(),
                 layoutRect,
                 m_fadeBrush.Get());
+            m_frameCounters.drawCalls++;
         }
     }
 }
 
-void MatrixRenderer::RenderColumns() {
-    // Render column heads as bright white characters
-    std::uniform_int_distribution<int> charDist(0, static_cast<int>(MATRIX_CHARS.size()) - 1);
+void MatrixRenderer::RenderColumns(const FrameSnapshot& snapshot, const SnapshotViewport& viewport) {
+    const GlyphTable& glyphs = GlyphTable::Instance();
+    float originX = static_cast<float>(viewport.rect.left);
+    float originY = static_cast<float>(viewport.rect.top);
     
-    for (const auto& column : m_columns) {
-        // Skip if off screen
-        if (column.y < -50 || column.y > m_screenHeight + 50) {
+    // Render column heads as bright white characters
+    for (const SnapshotColumn& column : snapshot.GetColumns(viewport)) {
+        // Skip heads above the top (the simulation leaves those without a head glyph)
+        if (column.headGlyph == INVALID_GLYPH) {
             continue;
         }
+        float x = column.x - originX;
+        float y = column.y - originY;
         
-        // Get character for head (always random when not using custom word)
-        std::wstring headChar;
-        if (m_settings.useCustomWord && !m_settings.customWord.empty()) {
-            if (m_settings.sequentialCharacters) {
-                headChar = m_settings.customWord.substr(column.customWordIndex % static_cast<int>(m_settings.customWord.length()), 1);
-            } else {
-                int charIndex = std::uniform_int_distribution<int>(0, static_cast<int>(m_settings.customWord.length()) - 1)(g_rng);
-                headChar = m_settings.customWord.substr(charIndex, 1);
-            }
-        } else {
-            // Always random Japanese character for heads
-            headChar = MATRIX_CHARS[charDist(g_rng)];
-        }
+        // Heads change every frame; the simulation picks the glyph so drawing stays deterministic
+        const std::wstring& headChar = glyphs.GetGlyph(column.headGlyph);
         
         // Set color for head based on settings
         if (m_settings.whiteHeadCharacters) {
@@ -648,20 +490,26 @@ void MatrixRenderer::RenderColumns() {
         
         // Create layout rect
         D2D1_RECT_F layoutRect = D2D1::RectF(
-            column.x - column.baseFontSize * 0.5f, column.y,
-            column.x + column.baseFontSize * 0.5f, column.y + column.baseFontSize);
+            x - column.baseFontSize * 0.5f, y,
+            x + column.baseFontSize * 0.5f, y + column.baseFontSize);
         
         // Render the head character
         m_d2dRenderTarget->DrawText(
-            headChar.c_str(),
+            headChar.data(),
             static_cast<UINT32>(headChar.length()),
             m_textFormat.Get(),
             layoutRect,
             m_whiteBrush.Get());
+        m_frameCounters.drawCalls++;
     }
 }
 
-void MatrixRenderer::RenderOptimized() {
+void MatrixRenderer::RenderOptimized(const FrameSnapshot& snapshot, const SnapshotViewport& viewport) {
+    FrameProfiler* profiler = GetProfiler();
+    float originX = static_cast<float>(viewport.rect.left);
+    float originY = static_cast<float>(viewport.rect.top);
+    std::optional<ScopedPhaseTimer> batchTimer(std::in_place, profiler, ProfilePhase::BatchBuild);
+    
     // Reset batch renderer for new frame
     if (m_batchRenderer && m_settings.enableBatchRendering) {
         m_batchRenderer->Reset();
@@ -670,44 +518,34 @@ void MatrixRenderer::RenderOptimized() {
     // Update dirty rectangles if needed
     if (m_dirtyRectManager && m_settings.enableDirtyRectangles) {
         // Mark areas where columns are as dirty
-        for (const auto& column : m_columns) {
-            if (column.y >= -50 && column.y <= m_screenHeight + 50) {
-                D2D1_RECT_F columnRect = D2D1::RectF(
-                    column.x - column.baseFontSize,
-                    column.y - column.baseFontSize,
-                    column.x + column.baseFontSize,
-                    column.y + column.baseFontSize);
-                m_dirtyRectManager->MarkDirty(columnRect);
-            }
+        for (const SnapshotColumn& column : snapshot.GetColumns(viewport)) {
+            float x = column.x - originX;
+            float y = column.y - originY;
+            D2D1_RECT_F columnRect = D2D1::RectF(
+                x - column.baseFontSize,
+                y - column.baseFontSize,
+                x + column.baseFontSize,
+                y + column.baseFontSize);
+            m_dirtyRectManager->MarkDirty(columnRect);
         }
     }
     
+    const GlyphTable& glyphs = GlyphTable::Instance();
+    
     // Render grid cells (using batch renderer if enabled)
     size_t cellsRendered = 0;
-    for (const auto& [x, y] : m_activeCells) {
-        uint64_t key = PackCoords(x, y);
-        auto it = m_sparseGrid.find(key);
-        if (it == m_sparseGrid.end()) continue;
-        
-        const GridCell& cell = it->second;
-        
-        if (!cell.isActive || cell.alpha < 0.05f || cell.character.empty()) {
-            continue;
-        }
-        
-        // Calculate screen position
-        float screenX = static_cast<float>(x) * m_settings.fontSize * 0.8f;
-        float screenY = static_cast<float>(y) * m_settings.fontSize * 0.9f;
+    for (const SnapshotCell& cell : snapshot.GetCells(viewport)) {
+        float alpha = cell.alpha;
         
-        if (screenX < -50 || screenX > m_screenWidth + 50 || 
-            screenY < -50 || screenY > m_screenHeight + 50) {
-            continue;
-        }
+        // Calculate screen position; the snapshot already dropped off-screen cells
+        float screenX = static_cast<float>(cell.x) * m_settings.fontSize * 0.8f - originX;
+        float screenY = static_cast<float>(cell.y) * m_settings.fontSize * 0.9f - originY;
         
         // Check if this cell is in a dirty region (if dirty rect optimization is enabled)
+        float fontSize = GetCellFontSize(cell);
         D2D1_RECT_F cellRect = D2D1::RectF(
-            screenX - cell.fontSize * 0.5f, screenY,
-            screenX + cell.fontSize * 0.5f, screenY + cell.fontSize);
+            screenX - fontSize * 0.5f, screenY,
+            screenX + fontSize * 0.5f, screenY + fontSize);
             
         if (m_dirtyRectManager && m_settings.enableDirtyRectangles) {
             if (!m_dirtyRectManager->IsRectDirty(cellRect)) {
@@ -715,20 +553,17 @@ void MatrixRenderer::RenderOptimized() {
             }
         }
         
-        // Get the final character to display (considering morphing and glitching)
-        std::wstring displayChar = cell.character;
-        if (m_characterEffects) {
-            displayChar = m_characterEffects->GetGlitchedCharacter(cell);
-        }
+        // The snapshot carries the final character (considering morphing and glitching)
+        GlyphId displayGlyph = cell.displayGlyph;
         
         // Get color based on depth and alpha
-        Color color = GetDepthColor(cell.depth, cell.alpha);
+        Color color = GetDepthColor(cell.GetDepth(), alpha);
         
         // Add system disruption effects
-        if (m_characterEffects && m_characterEffects->IsSystemDisrupted()) {
-            float disruptionIntensity = m_characterEffects->GetSystemDisruptionIntensity();
+        if (snapshot.systemDisrupted) {
+            float disruptionIntensity = snapshot.disruptionIntensity;
             // Flicker effect during system disruption
-            if (static_cast<int>(cell.lastUpdateTime * 30.0f * disruptionIntensity) % 3 == 0) {
+            if (static_cast<int>(cell.age * 30.0f * disruptionIntensity) % 3 == 0) {
                 color.a *= 0.3f; // Make characters flicker
             }
             // Add slight red tint during disruption
@@ -737,20 +572,24 @@ void MatrixRenderer::RenderOptimized() {
         
         if (m_batchRenderer && m_settings.enableBatchRendering) {
             // Add to batch renderer
-            m_batchRenderer->AddCharacter(displayChar, cellRect, color.ToD2D1(), cell.fontSize);
+            m_batchRenderer->AddCharacter(displayGlyph, cellRect, ToD2D1(color), fontSize);
         } else {
+            // This is a reference into the glyph table, not a copy
+            const std::wstring& displayChar = glyphs.GetGlyph(displayGlyph);
+            
             // Immediate rendering with glow effect
-            if (m_settings.enablePhosphorGlow && cell.glowIntensity > 0.0f) {
+            Color glowColor = CharacterEffects::MakeGlowColor(cell.flags, cell.glow);
+            glowColor.a *= m_glowScale;
+            if (m_settings.enablePhosphorGlow && glowColor.a > 0.0f) {
                 // Render glow first (slightly larger and more transparent)
-                Color glowColor = m_characterEffects ? m_characterEffects->GetGlowColor(cell) : Color(0.0f, 1.0f, 0.0f, cell.glowIntensity * 0.5f);
                 glowColor.a *= 0.5f;
                 
                 D2D1_RECT_F glowRect = D2D1::RectF(
                     cellRect.left - 2, cellRect.top - 2,
                     cellRect.right + 2, cellRect.bottom + 2);
                     
-                m_fadeBrush->SetColor(glowColor.ToD2D1());
-                IDWriteTextFormat* format = GetCachedFormat(cell.fontSize * 1.1f);
+                m_fadeBrush->SetColor(ToD2D1(glowColor));
+                IDWriteTextFormat* format = GetCachedFormat(fontSize * 1.1f);
                 if (format) {
                     m_d2dRenderTarget->DrawText(
                         displayChar.c_str(),
@@ -758,12 +597,13 @@ void MatrixRenderer::RenderOptimized() {
                         format,
                         glowRect,
                         m_fadeBrush.Get());
+                    m_frameCounters.drawCalls++;
                 }
             }
             
             // Render main character
-            m_fadeBrush->SetColor(color.ToD2D1());
-            IDWriteTextFormat* format = GetCachedFormat(cell.fontSize);
+            m_fadeBrush->SetColor(ToD2D1(color));
+            IDWriteTextFormat* format = GetCachedFormat(fontSize);
             if (format) {
                 m_d2dRenderTarget->DrawText(
                     displayChar.c_str(),
@@ -771,42 +611,39 @@ void MatrixRenderer::RenderOptimized() {
                     format,
                     cellRect,
                     m_fadeBrush.Get());
+                m_frameCounters.drawCalls++;
             }
         }
         
         cellsRendered++;
     }
     
+    batchTimer.reset();
+    ScopedPhaseTimer drawTimer(profiler, ProfilePhase::Draw);
+    
     // Flush batch renderer
     if (m_batchRenderer && m_settings.enableBatchRendering) {
         m_batchRenderer->Flush(m_d2dRenderTarget.Get(), m_writeFactory.Get(), m_textFormat.Get());
     }
     
     // Render columns (always immediate rendering for heads)
-    RenderColumns();
+    RenderColumns(snapshot, viewport);
     
     // Clear dirty flags for next frame
     if (m_dirtyRectManager && m_settings.enableDirtyRectangles) {
+        m_frameCounters.dirtyPercent = m_dirtyRectManager->GetDirtyPercentage();
         m_dirtyRectManager->ClearDirtyFlags();
     }
     
     // Log performance info (optional)
-    if (m_settings.enableLogging && cellsRendered > 0) {
-        Logger::Instance().Debug("Rendered " + std::to_string(cellsRendered) + " cells using optimized path");
+    if (cellsRendered > 0) {
+        LOG_DEBUG("Rendered {} cells using optimized path", cellsRendered);
     }
 }
 
-void MatrixRenderer::RenderMaskBackground() {
+void MatrixRenderer::RenderMaskBackground(const FrameSnapshot& snapshot, const SnapshotViewport& viewport) {
     if (!m_maskBitmap) return;
     
-    // Create a lighter black brush for the mask background
-    Microsoft::WRL::ComPtr<ID2D1SolidColorBrush> maskBrush;
-    HRESULT hr = m_d2dRenderTarget->CreateSolidColorBrush(
-        D2D1::ColorF(0.1f, 0.1f, 0.1f, 0.8f), // Dark gray with transparency
-        &maskBrush);
-    
-    if (FAILED(hr)) return;
-    
     // Get mask bitmap size
     D2D1_SIZE_F maskSize = m_maskBitmap->GetSize();
     
@@ -815,6 +652,17 @@ void MatrixRenderer::RenderMaskBackground() {
         static_cast<float>(m_screenWidth), 
         static_cast<float>(m_screenHeight));
     
+    // The mask is stretched over the whole simulation, as the density map is;
+    // show the part under this output
+    D2D1_RECT_F sourceRect = D2D1::RectF(0, 0, maskSize.width, maskSize.height);
+    if (snapshot.width > 0 && snapshot.height > 0 && viewport.rect.GetWidth() > 0) {
+        float scaleX = maskSize.width / snapshot.width;
+        float scaleY = maskSize.height / snapshot.height;
+        sourceRect = D2D1::RectF(
+            viewport.rect.left * scaleX, viewport.rect.top * scaleY,
+            viewport.rect.right * scaleX, viewport.rect.bottom * scaleY);
+    }
+    
     // Draw the mask bitmap with configurable opacity
     m_d2dRenderTarget->SetTransform(D2D1::Matrix3x2F::Identity());
     m_d2dRenderTarget->DrawBitmap(
@@ -822,7 +670,7 @@ void MatrixRenderer::RenderMaskBackground() {
         &destRect,
         m_settings.maskBackgroundOpacity, // Configurable opacity
         D2D1_BITMAP_INTERPOLATION_MODE_LINEAR,
-        nullptr);
+        &sourceRect);
 }
 
 void MatrixRenderer::Resize(int width, int height) {
@@ -831,144 +679,80 @@ void MatrixRenderer::Resize(int width, int height) {
         m_screenHeight = height;
         
         m_d2dRenderTarget.Reset();
-        m_renderTargetView.Reset();
         
         HRESULT hr = m_swapChain->ResizeBuffers(0, width, height, DXGI_FORMAT_UNKNOWN, 0);
+        // The shared simulation follows the desktop layout (see DisplayManager)
         if (SUCCEEDED(hr)) {
             InitializeDirect2D();
-            InitializeColumns();
-            if (m_maskBitmap) {
-                CreateDensityMap();
-            }
         }
     }
 }
 
 void MatrixRenderer::UpdateSettings(const MatrixSettings& settings) {
+    // Rebuild only what the change touches; the scene itself lives in the
+    // simulation, so nothing here clears the rain
+    SettingsInvalidation changes = ClassifySettingsChange(m_settings, settings);
     m_settings = settings;
     
-    // Update performance metrics
-    if (m_performanceMetrics) {
-        m_performanceMetrics->SetEnabled(settings.showPerformanceMetrics);
-    }
-    
-    // Update frame rate limiting
-    if (settings.enableFrameRateLimiting && settings.targetFrameRate > 0) {
-        m_targetFrameDuration = std::chrono::duration<float, std::milli>(1000.0f / settings.targetFrameRate);
+    if (HasAny(changes, SettingsInvalidation::Runtime)) {
+        if (m_performanceMetrics) {
+            m_performanceMetrics->SetEnabled(settings.showPerformanceMetrics);
+            m_performanceMetrics->SetProfileWindow(static_cast<size_t>(std::max(settings.profileWindowFrames, 1)));
+            if (settings.enableFrameTrace) {
+                m_performanceMetrics->StartTrace(static_cast<size_t>(std::max(settings.frameTraceMaxFrames, 1)));
+            }
+            if (settings.enableCountersEndpoint) {
+                m_performanceMetrics->StartCountersEndpoint(m_instanceId, settings.enableCountersSocket);
+            } else {
+                m_performanceMetrics->StopCountersEndpoint();
+            }
+        }
+        if (m_batchRenderer) {
+            m_batchRenderer->SetEnabled(settings.enableBatchRendering);
+        }
+        if (m_dirtyRectManager) {
+            m_dirtyRectManager->SetEnabled(settings.enableDirtyRectangles);
+        }
     }
     
-    // Recreate text format if font changed
-    if (m_textFormat) {
-        m_textFormat.Reset();
+    // Formats come from the shared cache, so only a new face or size creates any
+    if (HasAny(changes, SettingsInvalidation::Font) && m_textFormat) {
         InitializeDirectWrite();
     }
     
-    // Update brush colors
-    if (m_greenBrush) {
+    if (HasAny(changes, SettingsInvalidation::Palette) && m_greenBrush) {
         Color matrixColor = GetMatrixColor();
-        m_greenBrush->SetColor(matrixColor.ToD2D1());
+        m_greenBrush->SetColor(ToD2D1(matrixColor));
     }
     
-    // Update character effects settings
-    if (m_characterEffects) {
-        m_characterEffects->SetSettings(settings);
+    // DisplayManager decodes the new image and hands it to SetMask
+    if (HasAny(changes, SettingsInvalidation::Mask)) {
+        m_maskBitmap.Reset();
     }
     
-    InitializeColumns();
+    // The governor's knobs depend on which effects are drawn
+    if (HasAny(changes, SettingsInvalidation::Runtime | SettingsInvalidation::Effects)) {
+        ConfigureQualityGovernor();
+    }
 }
 
 // Optimization helper implementations
 void MatrixRenderer::InitializeFontCache() {
-    // Pre-create font formats for common sizes
-    for (size_t i = 0; i < FONT_CACHE_SIZE; ++i) {
-        HRESULT hr = m_writeFactory->CreateTextFormat(
-            m_settings.fontName.c_str(),
-            nullptr,
-            m_settings.boldFont ? DWRITE_FONT_WEIGHT_BOLD : DWRITE_FONT_WEIGHT_NORMAL,
-            DWRITE_FONT_STYLE_NORMAL,
-            DWRITE_FONT_STRETCH_NORMAL,
-            m_formatSizes[i],
-            L"",
-            &m_cachedFormats[i]);
-        
-        if (SUCCEEDED(hr)) {
-            m_cachedFormats[i]->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
-            m_cachedFormats[i]->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
-        }
+    // Filled on first use; a session only draws a few of the sizes, and none
+    // of them are needed before the first frame
+    for (auto& format : m_cachedFormats) {
+        format.Reset();
     }
 }
 
 IDWriteTextFormat* MatrixRenderer::GetCachedFormat(float fontSize) {
-    // Find the closest cached format
+    // The first cached size at least as large, or the largest
     auto it = std::lower_bound(m_formatSizes.begin(), m_formatSizes.end(), fontSize);
+    size_t index = std::min<size_t>(std::distance(m_formatSizes.begin(), it), FONT_CACHE_SIZE - 1);
     
-    // If exact match or very close, use it
-    if (it != m_formatSizes.end()) {
-        size_t index = std::distance(m_formatSizes.begin(), it);
-        if (index < FONT_CACHE_SIZE && m_cachedFormats[index]) {
-            return m_cachedFormats[index].Get();
-        }
-    }
-    
-    // If fontSize is larger than all cached sizes, use the largest
-    if (fontSize > m_formatSizes.back() && m_cachedFormats[FONT_CACHE_SIZE - 1]) {
-        return m_cachedFormats[FONT_CACHE_SIZE - 1].Get();
-    }
-    
-    // If fontSize is smaller than all cached sizes, use the smallest
-    if (fontSize < m_formatSizes[0] && m_cachedFormats[0]) {
-        return m_cachedFormats[0].Get();
-    }
-    
-    // Find closest match
-    size_t closestIndex = 0;
-    float minDiff = std::abs(fontSize - m_formatSizes[0]);
-    for (size_t i = 1; i < FONT_CACHE_SIZE; ++i) {
-        float diff = std::abs(fontSize - m_formatSizes[i]);
-        if (diff < minDiff) {
-            minDiff = diff;
-            closestIndex = i;
-        }
+    // Only the first use of a size takes the shared cache's lock
+    if (!m_cachedFormats[index]) {
+        m_cachedFormats[index] = m_graphics->GetTextFormat(m_settings.fontName, m_settings.boldFont, m_formatSizes[index], true);
     }
-    
-    return m_cachedFormats[closestIndex] ? m_cachedFormats[closestIndex].Get() : nullptr;
-}
-
-GridCell& MatrixRenderer::GetCell(int x, int y) {
-    uint64_t key = PackCoords(x, y);
-    return m_sparseGrid[key];
+    return m_cachedFormats[index].Get();
 }
-
-bool MatrixRenderer::HasActiveCell(int x, int y) const {
-    uint64_t key = PackCoords(x, y);
-    auto it = m_sparseGrid.find(key);
-    return it != m_sparseGrid.end() && it->second.isActive;
-}
-
-void MatrixRenderer::SetCellActive(int x, int y, const GridCell& cell) {
-    uint64_t key = PackCoords(x, y);
-    m_sparseGrid[key] = cell;
-    
-    // Add to active tracking if not already present
-    if (m_activeCellSet.find(key) == m_activeCellSet.end()) {
-        m_activeCellSet.insert(key);
-        m_activeCells.push_back({x, y});
-    }
-}
-
-void MatrixRenderer::DeactivateCell(int x, int y) {
-    uint64_t key = PackCoords(x, y);
-    
-    // Remove from active tracking
-    m_activeCellSet.erase(key);
-    
-    // Remove from active cells list
-    auto it = std::find(m_activeCells.begin(), m_activeCells.end(), std::make_pair(x, y));
-    if (it != m_activeCells.end()) {
-        m_activeCells.erase(it);
-    }
-    
-    // Remove from sparse grid
-    m_sparseGrid.erase(key);
-}
-
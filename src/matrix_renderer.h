@@ -3,11 +3,12 @@
 #include "common.h"
 #include "performance_metrics.h"
 #include "batch_renderer.h"
-#include "memory_pool.h"
 #include "dirty_rect_manager.h"
-#include "character_effects.h"
-#include <unordered_map>
-#include <unordered_set>
+#include "sim_snapshot.h"
+#include "frame_arena.h"
+#include "quality_governor.h"
+#include "graphics_device.h"
+#include "mask_loader.h"
 #include <array>
 #include <algorithm>
 
@@ -16,20 +17,43 @@ public:
     MatrixRenderer();
     ~MatrixRenderer();
 
-    bool Initialize(HWND hwnd, const MatrixSettings& settings);
+    bool Initialize(HWND hwnd, const MatrixSettings& settings, GraphicsDevice& graphics);
     void Shutdown();
     void Update(float deltaTime);
-    void Render();
+    
+    // A frame in two halves for several outputs: Draw() records and submits
+    // this output's viewport of the snapshot, Present() shows it and closes
+    // the frame. Only one present per vblank should wait, or each output
+    // would block for its own.
+    void Draw(const FrameSnapshot& snapshot);
+    void Present(bool waitForVBlank);
     void Resize(int width, int height);
     void UpdateSettings(const MatrixSettings& settings);
-    void LoadMask(const std::wstring& imagePath);
+    
+    // Decoded once by DisplayManager for every output; null removes the mask
+    void SetMask(const BitmapData* mask);
+    void SetTimeToFirstFrame(float ms);
+    
+    // Frame pacing: the loop reports how late this frame started and asks
+    // which rate to schedule at
+    void SetFrameLateness(float latenessMs);
+    float GetTargetFrameRate() const;
+    
+    // The simulation is shared (see DisplayManager). Each output names its
+    // viewport by instance id and reports what it wants from the simulation.
+    int GetInstanceId() const { return m_instanceId; }
+    bool WantsSimulationTiming() const { return GetProfiler() != nullptr; }
+    const SimQuality& GetSimQuality() const { return m_simQuality; }
+    
+    // Preset timing (see quality_presets.h): the last closed frame while
+    // profiling, and whether the governor has anything cut
+    bool GetLatestFrameSample(FrameSample& sample) const;
+    bool IsAtFullQuality() const;
 
 private:
-    // DirectX resources
-    Microsoft::WRL::ComPtr<ID3D11Device> m_device;
-    Microsoft::WRL::ComPtr<ID3D11DeviceContext> m_deviceContext;
+    // DirectX resources; the device and factories are shared by all outputs
+    GraphicsDevice* m_graphics = nullptr;
     Microsoft::WRL::ComPtr<IDXGISwapChain> m_swapChain;
-    Microsoft::WRL::ComPtr<ID3D11RenderTargetView> m_renderTargetView;
     
     // Direct2D resources
     Microsoft::WRL::ComPtr<ID2D1Factory> m_d2dFactory;
@@ -49,18 +73,12 @@ private:
     
     // Mask resources
     Microsoft::WRL::ComPtr<ID2D1Bitmap> m_maskBitmap;
-    std::vector<std::vector<float>> m_densityMap;
-    
-    // Animation data
-    std::vector<MatrixColumn> m_columns;
     
-    // Optimized sparse grid storage
-    std::unordered_map<uint64_t, GridCell> m_sparseGrid;  // Sparse grid for memory efficiency
-    std::vector<std::pair<int, int>> m_activeCells;       // List of active cells to render
-    std::unordered_set<uint64_t> m_activeCellSet;         // Fast lookup for active cells
+    // Snapshot bookkeeping; the simulation itself is shared by all outputs
+    uint64_t m_consumedFrame = 0;                         // FrameSnapshot::frame last drawn
+    uint64_t m_consumedSpawns = 0;                        // FrameSnapshot::totalSpawns last drawn
+    SimQuality m_simQuality;                              // What this output's governor asks of the simulation
     
-    int m_gridWidth = 0;
-    int m_gridHeight = 0;
     MatrixSettings m_settings;
     int m_screenWidth = 0;
     int m_screenHeight = 0;
@@ -73,45 +91,41 @@ private:
     
     // Performance optimizations
     std::unique_ptr<BatchRenderer> m_batchRenderer;
-    std::unique_ptr<MemoryPool<GridCell>> m_gridCellPool;
     std::unique_ptr<DirtyRectManager> m_dirtyRectManager;
+    std::unique_ptr<FrameArena> m_frameArena;             // Transient render data, reset every frame
     
-    // Visual effects
-    std::unique_ptr<CharacterEffects> m_characterEffects;
+    // Per-frame workload counters for trace capture
+    FrameCounters m_frameCounters;
+    int m_instanceId = 0;
     
-    // Frame rate limiting
-    std::chrono::high_resolution_clock::time_point m_lastFrameTime;
-    std::chrono::duration<float, std::milli> m_targetFrameDuration;
+    // Quality governor, only allocated while enabled
+    std::unique_ptr<QualityGovernor> m_qualityGovernor;
+    float m_glowScale = 1.0f;
+    float m_lastDeltaTime = 0.0f;
+    
+    // End of the previous Render; the gap until the next Update is pacing wait
+    FrameProfiler::Clock::time_point m_lastRenderEnd = FrameProfiler::Clock::now();
     
     // Private methods
     bool InitializeDirect3D(HWND hwnd);
     bool InitializeDirect2D();
     bool InitializeDirectWrite();
-    void InitializeColumns();
-    void InitializeGrid();
-    void CreateDensityMap();
-    void UpdateColumns(float deltaTime);
-    void UpdateGrid(float deltaTime);
-    float GetDensityAt(int x, int y) const;
-    float GetMaskBrightness(int x, int y) const; // Get brightness from mask for 3D depth
-    void RenderGrid();
-    void RenderColumns();
-    void RenderOptimized(); // Optimized rendering with batching and dirty rectangles
-    void RenderMaskBackground();
+    void ConfigureQualityGovernor();
+    void UpdateQualityGovernor();
+    void ApplyQuality(const QualityLevels& levels);
+    FrameProfiler* GetProfiler() const { return m_performanceMetrics ? m_performanceMetrics->GetProfiler() : nullptr; }
+    void ConsumeSnapshot(const FrameSnapshot& snapshot, FrameProfiler* profiler);
+    void RenderGrid(const FrameSnapshot& snapshot, const SnapshotViewport& viewport);
+    void RenderColumns(const FrameSnapshot& snapshot, const SnapshotViewport& viewport);
+    void RenderOptimized(const FrameSnapshot& snapshot, const SnapshotViewport& viewport); // Optimized rendering with batching and dirty rectangles
+    void RenderMaskBackground(const FrameSnapshot& snapshot, const SnapshotViewport& viewport);
     Color GetMatrixColor() const;
     Color GetDepthColor(float depth, float alpha) const; // Color based on depth
     
     // Optimization helpers
-    inline uint64_t PackCoords(int x, int y) const { 
-        return (static_cast<uint64_t>(x) << 32) | static_cast<uint64_t>(y); 
-    }
-    inline std::pair<int, int> UnpackCoords(uint64_t packed) const {
-        return { static_cast<int>(packed >> 32), static_cast<int>(packed & 0xFFFFFFFF) };
+    float GetCellFontSize(const SnapshotCell& cell) const {
+        return m_settings.fontSize * (0.7f + cell.GetDepth() * 0.6f); // Depth-based size
     }
-    GridCell& GetCell(int x, int y);
-    bool HasActiveCell(int x, int y) const;
-    void SetCellActive(int x, int y, const GridCell& cell);
-    void DeactivateCell(int x, int y);
     IDWriteTextFormat* GetCachedFormat(float fontSize);
     void InitializeFontCache();
 };
\ No newline at end of file
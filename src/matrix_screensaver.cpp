@@ -1,8 +1,9 @@
 #include "matrix_screensaver.h"
 #include "logger.h"
+#include "settings_schema.h"
 
 MatrixScreensaver::MatrixScreensaver() {
-    m_renderer = std::make_unique<MatrixRenderer>();
+    m_displayManager = std::make_unique<DisplayManager>();
     m_settingsManager = std::make_unique<SettingsManager>();
 }
 
@@ -10,48 +11,109 @@ MatrixScreensaver::~MatrixScreensaver() {
     Shutdown();
 }
 
-bool MatrixScreensaver::Initialize(HWND hwnd) {
-    m_hwnd = hwnd;
-    
+bool MatrixScreensaver::Initialize() {
     // Load settings
     m_settings = m_settingsManager->LoadSettings();
     
     // Initialize logger if enabled
-    Logger::Instance().Initialize(m_settings.enableLogging);
+    Logger::Instance().Initialize(m_settings.enableLogging,
+                                  m_settings.binaryLogging ? LogFileFormat::Binary : LogFileFormat::Text);
     LOG_INFO("MatrixScreensaver initializing");
     
-    // Initialize renderer
-    bool result = m_renderer->Initialize(hwnd, m_settings);
+    // Create the graphics device the outputs share
+    bool result = m_displayManager->Initialize(m_settings);
     
     if (result) {
-        LOG_INFO("Renderer initialized successfully");
+        LOG_INFO("Display manager initialized successfully");
     } else {
-        LOG_ERROR("Failed to initialize renderer");
+        LOG_ERROR("Failed to initialize display manager");
+    }
+    
+    // A settings file is applied live, so fleets can be retuned without a restart
+    if (result && m_settingsManager->IsUsingSettingsFile()) {
+        m_settingsWatcher = std::make_unique<SettingsWatcher>(m_settingsManager->GetSettingsFilePath());
+        if (!m_settingsWatcher->Start()) {
+            LOG_WARNING("Failed to watch the settings file");
+            m_settingsWatcher.reset();
+        }
     }
     
     return result;
 }
 
 void MatrixScreensaver::Shutdown() {
-    if (m_renderer) {
-        m_renderer->Shutdown();
+    m_settingsWatcher.reset();
+    if (m_displayManager) {
+        m_displayManager->Shutdown();
+    }
+}
+
+bool MatrixScreensaver::AddOutput(HWND hwnd) {
+    return m_displayManager && m_displayManager->AddOutput(hwnd);
+}
+
+void MatrixScreensaver::RemoveOutput(HWND hwnd) {
+    if (m_displayManager) {
+        m_displayManager->RemoveOutput(hwnd);
     }
 }
 
+bool MatrixScreensaver::HasOutputs() const {
+    return m_displayManager && m_displayManager->HasOutputs();
+}
+
 void MatrixScreensaver::Update(float deltaTime) {
-    if (m_renderer) {
-        m_renderer->Update(deltaTime);
+    if (m_settingsWatcher && m_settingsWatcher->ConsumeChange()) {
+        ReloadSettings();
+    }
+    if (m_displayManager) {
+        m_displayManager->Update(deltaTime);
+    }
+}
+
+void MatrixScreensaver::ReloadSettings() {
+    MatrixSettings settings = m_settingsManager->LoadSettings();
+    std::vector<const char*> changed = DiffSettings(m_settings, settings);
+    if (changed.empty()) return;
+
+    std::string names;
+    for (const char* name : changed) {
+        if (!names.empty()) names += ", ";
+        names += name;
+    }
+    LOG_INFO("Settings file changed: {}", names);
+
+    // Logging, and starting a simulation capture, only take effect on the next
+    // run. The simulation's part of the change, the custom word included, is
+    // posted to its host and applied on the simulation's own thread.
+    m_settings = settings;
+    if (m_displayManager) {
+        m_displayManager->UpdateSettings(m_settings);
     }
 }
 
 void MatrixScreensaver::Render() {
-    if (m_renderer) {
-        m_renderer->Render();
+    if (m_displayManager) {
+        m_displayManager->Render();
+    }
+}
+
+void MatrixScreensaver::Resize(HWND hwnd, int width, int height) {
+    if (m_displayManager) {
+        m_displayManager->Resize(hwnd, width, height);
     }
 }
 
-void MatrixScreensaver::Resize(int width, int height) {
-    if (m_renderer) {
-        m_renderer->Resize(width, height);
+void MatrixScreensaver::SetFrameLateness(float latenessMs) {
+    if (m_displayManager) {
+        m_displayManager->SetFrameLateness(latenessMs);
     }
+}
+
+float MatrixScreensaver::GetTargetFrameRate() const {
+    return m_displayManager ? m_displayManager->GetTargetFrameRate() : 60.0f;
+}
+
+StartupTimes MatrixScreensaver::GetStartupTimes() const {
+    return m_displayManager ? m_displayManager->GetStartupTimes() : StartupTimes{};
 }
\ No newline at end of file
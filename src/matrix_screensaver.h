@@ -1,23 +1,35 @@
 #pragma once
 
 #include "common.h"
-#include "matrix_renderer.h"
+#include "display_manager.h"
 #include "settings_manager.h"
+#include "settings_watcher.h"
 
 class MatrixScreensaver {
 public:
     MatrixScreensaver();
     ~MatrixScreensaver();
 
-    bool Initialize(HWND hwnd);
+    bool Initialize();
     void Shutdown();
+    
+    // One output per screensaver window, all showing one simulation
+    bool AddOutput(HWND hwnd);
+    void RemoveOutput(HWND hwnd);
+    bool HasOutputs() const;
+    
     void Update(float deltaTime);
     void Render();
-    void Resize(int width, int height);
+    void Resize(HWND hwnd, int width, int height);
+    void SetFrameLateness(float latenessMs);
+    float GetTargetFrameRate() const;
+    StartupTimes GetStartupTimes() const;
 
 private:
-    std::unique_ptr<MatrixRenderer> m_renderer;
+    void ReloadSettings();
+
+    std::unique_ptr<DisplayManager> m_displayManager;
     std::unique_ptr<SettingsManager> m_settingsManager;
+    std::unique_ptr<SettingsWatcher> m_settingsWatcher;    // Only with a settings file
     MatrixSettings m_settings;
-    HWND m_hwnd = nullptr;
 };
\ No newline at end of file
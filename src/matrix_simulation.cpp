@@ -0,0 +1,932 @@
+#include "matrix_simulation.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+template<typename T>
+uint64_t HashValue(uint64_t hash, const T& value) {
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    return HashBytes(hash, bytes, sizeof(T));
+}
+
+template<typename T>
+void AppendValue(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Bounds-checked reads; once one fails, every later one does too
+class StateReader {
+public:
+    explicit StateReader(std::string_view data) : m_data(data) {}
+
+    template<typename T>
+    bool Read(T& value) {
+        if (m_failed || m_data.size() - m_offset < sizeof(T)) {
+            m_failed = true;
+            return false;
+        }
+        std::memcpy(&value, m_data.data() + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return true;
+    }
+
+    bool Failed() const { return m_failed; }
+    bool AtEnd() const { return m_offset == m_data.size(); }
+
+private:
+    std::string_view m_data;
+    size_t m_offset = 0;
+    bool m_failed = false;
+};
+
+// Glyphs go out as UTF-16, so a state saved on one platform loads on another
+void AppendGlyph(std::string& out, const std::wstring& glyph) {
+    std::u16string units;
+    for (wchar_t c : glyph) {
+        uint32_t codePoint = static_cast<uint32_t>(c);
+        if (codePoint >= 0x10000) {
+            codePoint -= 0x10000;
+            units.push_back(static_cast<char16_t>(0xD800 + (codePoint >> 10)));
+            units.push_back(static_cast<char16_t>(0xDC00 + (codePoint & 0x3FF)));
+        } else {
+            units.push_back(static_cast<char16_t>(codePoint));
+        }
+    }
+    AppendValue(out, static_cast<uint8_t>(std::min<size_t>(units.size(), 0xFF)));
+    out.append(reinterpret_cast<const char*>(units.data()), std::min<size_t>(units.size(), 0xFF) * sizeof(char16_t));
+}
+
+bool ReadGlyph(StateReader& reader, std::wstring& glyph) {
+    uint8_t count = 0;
+    reader.Read(count);
+    glyph.clear();
+    for (uint8_t i = 0; i < count; ++i) {
+        char16_t unit = 0;
+        if (!reader.Read(unit)) return false;
+        if constexpr (sizeof(wchar_t) == 2) {
+            glyph.push_back(static_cast<wchar_t>(unit));
+        } else if (unit >= 0xDC00 && unit <= 0xDFFF && !glyph.empty() &&
+                   glyph.back() >= 0xD800 && glyph.back() <= 0xDBFF) {
+            uint32_t high = static_cast<uint32_t>(glyph.back()) - 0xD800;
+            glyph.back() = static_cast<wchar_t>(0x10000 + (high << 10) + (unit - 0xDC00));
+        } else {
+            glyph.push_back(static_cast<wchar_t>(unit));
+        }
+    }
+    return !reader.Failed() && !glyph.empty();
+}
+
+} // namespace
+
+MatrixSimulation::MatrixSimulation()
+    : m_characterEffects(std::make_unique<CharacterEffects>(m_random)) {
+}
+
+MatrixSimulation::~MatrixSimulation() {
+    Clear();
+}
+
+void MatrixSimulation::Initialize(const MatrixSettings& settings, int width, int height, uint32_t seed) {
+    m_settings = settings;
+    m_screenWidth = width;
+    m_screenHeight = height;
+    m_random.Seed(seed);
+
+    m_characterEffects->Initialize(settings);
+    InitializeColumns();
+}
+
+void MatrixSimulation::Resize(int width, int height) {
+    m_screenWidth = width;
+    m_screenHeight = height;
+    InitializeColumns();
+}
+
+void MatrixSimulation::UpdateSettings(const MatrixSettings& settings, SettingsInvalidation rebuild) {
+    // Only density and font size are Layout, and captures record both, so a
+    // replay makes the same choice as the session it came from
+    SettingsInvalidation changes = ClassifySettingsChange(m_settings, settings) | rebuild;
+    m_settings = settings;
+    m_characterEffects->SetSettings(settings);
+
+    if (HasAny(changes, SettingsInvalidation::Layout)) {
+        InitializeColumns();
+    } else if (HasAny(changes, SettingsInvalidation::Glyphs)) {
+        m_customWordGlyphs = GlyphTable::Instance().InternWord(m_settings.customWord);
+    }
+}
+
+void MatrixSimulation::SetDepthMap(int width, int height, std::vector<uint8_t> depthMap) {
+    if (depthMap.size() != static_cast<size_t>(std::max(width, 0)) * std::max(height, 0)) {
+        depthMap.clear();
+    }
+    m_depthMap = std::move(depthMap);
+    m_depthMapWidth = m_depthMap.empty() ? 0 : width;
+    m_depthMapHeight = m_depthMap.empty() ? 0 : height;
+}
+
+void MatrixSimulation::SetQuality(const SimQuality& quality) {
+    m_quality = quality;
+    m_quality.columnFraction = std::clamp(quality.columnFraction, 0.0f, 1.0f);
+    m_quality.effectScale = std::clamp(quality.effectScale, 0.0f, 1.0f);
+    m_quality.effectInterval = std::max(quality.effectInterval, 1);
+
+    size_t columnCount = m_columns.size();
+    m_wantedColumns = static_cast<uint32_t>(std::lround(columnCount * m_quality.columnFraction));
+    if (columnCount > 0) {
+        m_wantedColumns = std::max<uint32_t>(m_wantedColumns, 1);
+    }
+}
+
+void MatrixSimulation::Clear() {
+    for (auto& cell : m_activeCells) {
+        m_characterEffects->ReleaseEffectState(cell);
+    }
+
+    m_activeCells.clear();
+    std::fill(m_cellLookup.begin(), m_cellLookup.end(), NO_CELL);
+}
+
+void MatrixSimulation::InitializeColumns() {
+    m_columns.clear();
+
+    // Create columns based on density setting
+    int columnWidth = std::max(1, static_cast<int>(m_settings.fontSize * 0.8f));
+    int baseColumnCount = std::max(1, m_screenWidth / columnWidth);
+
+    // Use density to control how many columns we create (0.1 to 3.0 = 10% to 300%)
+    int columnCount = static_cast<int>(baseColumnCount * m_settings.density);
+
+    for (int i = 0; i < columnCount; ++i) {
+        MatrixColumn column;
+        // Distribute columns across the screen, allowing overlap when density > 1
+        column.x = static_cast<float>((i * m_screenWidth) / columnCount);
+        column.y = m_random.NextFloat(-200.0f, -50.0f);
+        column.baseSpeed = m_random.NextFloat(m_settings.minSpeed, m_settings.maxSpeed);
+        column.currentSpeed = column.baseSpeed;
+        column.baseFontSize = m_settings.fontSize;
+        column.layer = 0;
+        column.isActive = true;
+
+        // Initialize with random starting position in character sequence
+        if (!m_settings.useCustomWord && m_settings.sequentialCharacters) {
+            column.customWordIndex = m_random.NextInt(0, static_cast<int>(MATRIX_CHARS.size()) - 1);
+        } else {
+            column.customWordIndex = 0;
+        }
+
+        m_columns.push_back(std::move(column));
+    }
+
+    RankColumns();
+    SetQuality(m_quality);
+
+    // Initialize the grid
+    InitializeGrid();
+}
+
+void MatrixSimulation::RankColumns() {
+    // Golden-ratio order: any prefix of the ranking is spread evenly across
+    // the screen, so dropping the highest ranks thins the rain uniformly
+    size_t count = m_columns.size();
+    std::vector<uint32_t> order(count);
+    for (size_t i = 0; i < count; ++i) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+    auto key = [](uint32_t i) { return std::fmod(i * 0.6180339887, 1.0); };
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return key(a) < key(b); });
+
+    m_columnRank.assign(count, 0);
+    for (size_t rank = 0; rank < count; ++rank) {
+        m_columnRank[order[rank]] = static_cast<uint32_t>(rank);
+    }
+}
+
+void MatrixSimulation::InitializeGrid() {
+    // Create grid based on font size
+    int cellWidth = std::max(1, static_cast<int>(m_settings.fontSize * 0.8f));
+    int cellHeight = std::max(1, static_cast<int>(m_settings.fontSize * 0.9f));
+
+    m_gridWidth = std::clamp(m_screenWidth / cellWidth, 1, 0xFFFF);
+    m_gridHeight = std::clamp(m_screenHeight / cellHeight, 1, 0xFFFF);
+
+    // Clear optimized dense storage
+    Clear();
+    m_cellLookup.assign(static_cast<size_t>(m_gridWidth) * m_gridHeight, NO_CELL);
+
+    // Reserve space for typical active cell count (about 25% of full grid)
+    // so the active list does not reallocate in steady state
+    size_t estimatedActiveCells = (static_cast<size_t>(m_gridWidth) * m_gridHeight) / 4;
+    m_activeCells.reserve(estimatedActiveCells);
+
+    // Intern the custom word so cells can refer to its characters by glyph ID
+    m_customWordGlyphs = GlyphTable::Instance().InternWord(m_settings.customWord);
+}
+
+float MatrixSimulation::GetMaskBrightness(int x, int y) const {
+    if (m_depthMap.empty()) return 0.1f; // Low brightness if no mask
+
+    int clampedX = std::clamp(x, 0, m_depthMapWidth - 1);
+    int clampedY = std::clamp(y, 0, m_depthMapHeight - 1);
+    return m_depthMap[static_cast<size_t>(clampedY) * m_depthMapWidth + clampedX] * (1.0f / 255.0f);
+}
+
+void MatrixSimulation::Update(float deltaTime, FrameProfiler* profiler) {
+    m_frameSpawns = 0;
+
+    // Update character effects system
+    {
+        ScopedPhaseTimer timer(profiler, ProfilePhase::Effects);
+        m_characterEffects->Update(deltaTime);
+    }
+
+    {
+        ScopedPhaseTimer timer(profiler, ProfilePhase::UpdateColumns);
+        UpdateColumns(deltaTime);
+    }
+
+    // Fade and run per-cell effects (UpdateGrid times its own phases)
+    UpdateGrid(deltaTime, profiler);
+}
+
+void MatrixSimulation::UpdateColumns(float deltaTime) {
+    // Get rain intensity multiplier for dynamic rain effects
+    float rainIntensity = m_characterEffects->GetRainIntensityMultiplier();
+
+    for (size_t columnIndex = 0; columnIndex < m_columns.size(); ++columnIndex) {
+        MatrixColumn& column = m_columns[columnIndex];
+
+        // A column the quality level no longer wants finishes its drop first;
+        // one it wants back starts a fresh drop from above the screen
+        if (!column.isActive) {
+            if (!IsColumnWanted(columnIndex)) continue;
+            column.isActive = true;
+            column.y = m_random.NextFloat(-200.0f, -50.0f);
+        }
+
+        // Apply rain intensity variation to speed (reduced motion consideration)
+        float speedMultiplier = rainIntensity;
+        if (m_settings.enableMotionReduction) {
+            speedMultiplier *= 0.7f; // Slower movement for reduced motion
+        }
+
+        // Move column head down
+        column.y += column.currentSpeed * speedMultiplier * deltaTime * 60.0f;
+
+        // Calculate grid position
+        int gridX = static_cast<int>(column.x / (m_settings.fontSize * 0.8f));
+        int gridY = static_cast<int>(column.y / (m_settings.fontSize * 0.9f));
+
+        // Check if head is in valid grid bounds
+        if (gridX >= 0 && gridX < m_gridWidth && gridY >= 0 && gridY < m_gridHeight) {
+            GridCell* cellPtr = FindCell(gridX, gridY);
+
+            // Only create new character if cell is empty or very faded
+            if (!cellPtr || cellPtr->GetAlpha() < 0.1f) {
+                if (!cellPtr) {
+                    cellPtr = ActivateCell(gridX, gridY);
+                }
+                GridCell& cell = *cellPtr;
+
+                // Get depth for 3D effects
+                float depth = 0.5f;
+                if (m_settings.useMask && m_settings.enable3DEffect) {
+                    depth = GetMaskBrightness(static_cast<int>(column.x), static_cast<int>(column.y));
+                }
+
+                // Always place character - trails should appear everywhere
+                cell.glyph = SelectSpawnGlyph(column, depth);
+
+                cell.SetAlpha(1.0f); // Start bright
+                cell.SetDepth(depth);
+                cell.SetFlag(CELL_ACTIVE, true);
+                m_frameSpawns++;
+            }
+        }
+
+        // Reset column when off screen
+        if (column.y > m_screenHeight + 100 && !IsColumnWanted(columnIndex)) {
+            column.isActive = false;
+            column.headGlyph = INVALID_GLYPH;
+            continue;
+        }
+        if (column.y > m_screenHeight + 100) {
+            column.y = m_random.NextFloat(-200.0f, -50.0f);
+
+            // Reset to random starting character for Japanese sequential mode
+            if (!m_settings.useCustomWord && m_settings.sequentialCharacters) {
+                column.customWordIndex = m_random.NextInt(0, static_cast<int>(MATRIX_CHARS.size()) - 1);
+            }
+        }
+
+        // Heads change every frame; only visible ones need a glyph
+        column.headGlyph = (column.y >= -50 && column.y <= m_screenHeight + 50)
+            ? SelectHeadGlyph(column)
+            : INVALID_GLYPH;
+    }
+}
+
+GlyphId MatrixSimulation::SelectSpawnGlyph(MatrixColumn& column, float depth) {
+    // Select character based on settings
+    if (m_settings.useCustomWord && !m_customWordGlyphs.empty()) {
+        // Use custom word logic
+        int wordLength = static_cast<int>(m_customWordGlyphs.size());
+        if (m_settings.sequentialCharacters) {
+            GlyphId glyph = m_customWordGlyphs[column.customWordIndex % wordLength];
+            column.customWordIndex = (column.customWordIndex + 1) % wordLength;
+            return glyph;
+        }
+        // Random character from custom word
+        return m_customWordGlyphs[m_random.NextInt(0, wordLength - 1)];
+    }
+
+    // Use enhanced character selection with variety and depth-based weighting
+    return m_characterEffects->SelectCharacter(depth, m_settings.enableCharacterVariety);
+}
+
+GlyphId MatrixSimulation::SelectHeadGlyph(const MatrixColumn& column) {
+    if (m_settings.useCustomWord && !m_customWordGlyphs.empty()) {
+        int wordLength = static_cast<int>(m_customWordGlyphs.size());
+        if (m_settings.sequentialCharacters) {
+            return m_customWordGlyphs[column.customWordIndex % wordLength];
+        }
+        return m_customWordGlyphs[m_random.NextInt(0, wordLength - 1)];
+    }
+
+    // Always random Japanese character for heads
+    const auto& matrixGlyphs = GlyphTable::Instance().GetMatrixGlyphs();
+    return matrixGlyphs[m_random.NextInt(0, static_cast<int>(matrixGlyphs.size()) - 1)];
+}
+
+void MatrixSimulation::FastForward(float seconds) {
+    if (seconds <= 0.0f || m_columns.empty()) return;
+
+    float fadeRate = m_settings.fadeRate * (m_settings.enableMotionReduction ? 0.5f : 1.0f);
+    float motion = m_settings.enableMotionReduction ? 0.7f : 1.0f;
+    float cellWidth = m_settings.fontSize * 0.8f;
+    float cellHeight = m_settings.fontSize * 0.9f;
+    float exitY = static_cast<float>(m_screenHeight + 100);
+
+    // A cell lives 1 / fadeRate seconds, so only spawns in that final window
+    // can still be on screen; earlier ones matter only for word positions
+    float windowStart = fadeRate > 0.0f ? std::max(0.0f, seconds - 1.0f / fadeRate) : 0.0f;
+
+    // What was already on screen fades as it would have
+    size_t index = 0;
+    while (index < m_activeCells.size()) {
+        GridCell& cell = m_activeCells[index];
+        float alpha = cell.GetAlpha() - fadeRate * seconds;
+        if (alpha <= 0.0f) {
+            DeactivateCell(index);
+        } else {
+            cell.SetAlpha(alpha);
+            cell.SetAge(cell.GetAge() + seconds);
+            ++index;
+        }
+    }
+
+    struct Spawn {
+        float time;
+        uint32_t column;
+        int row;
+    };
+    std::vector<Spawn> spawns;
+
+    // Heads move at a constant speed within a drop (rain variations are
+    // taken at the drop's start), so each drop is one closed-form step
+    for (size_t columnIndex = 0; columnIndex < m_columns.size(); ++columnIndex) {
+        MatrixColumn& column = m_columns[columnIndex];
+        if (!column.isActive) {
+            if (!IsColumnWanted(columnIndex)) continue;
+            column.isActive = true;
+            column.y = m_random.NextFloat(-200.0f, -50.0f);
+        }
+
+        int gridX = static_cast<int>(column.x / cellWidth);
+        bool onGrid = gridX >= 0 && gridX < m_gridWidth;
+        float time = 0.0f;
+        while (true) {
+            float velocity = column.currentSpeed * m_characterEffects->GetRainIntensityMultiplier(time) * motion * 60.0f;
+            if (velocity <= 0.0f) break;
+
+            float exitTime = time + std::max(0.0f, exitY - column.y) / velocity;
+            float endTime = std::min(exitTime, seconds);
+            float endY = column.y + velocity * (endTime - time);
+
+            // The head is in row r from y = r * cellHeight on (row 0 from just
+            // above the screen, as the grid position truncates toward zero)
+            if (onGrid && endTime > windowStart) {
+                int firstRow = std::max(0, static_cast<int>(column.y / cellHeight));
+                int lastRow = std::min(m_gridHeight - 1, static_cast<int>(endY / cellHeight));
+                for (int row = firstRow; row <= lastRow; ++row) {
+                    float rowY = row == 0 ? -cellHeight : row * cellHeight;
+                    float spawnTime = time + std::max(0.0f, rowY - column.y) / velocity;
+                    if (spawnTime >= windowStart) {
+                        spawns.push_back({ spawnTime, static_cast<uint32_t>(columnIndex), row });
+                    } else if (m_settings.useCustomWord && m_settings.sequentialCharacters && !m_customWordGlyphs.empty()) {
+                        column.customWordIndex = (column.customWordIndex + 1) % static_cast<int>(m_customWordGlyphs.size());
+                    }
+                }
+            }
+
+            if (exitTime >= seconds) {
+                column.y = endY;
+                break;
+            }
+
+            time = exitTime;
+            if (!IsColumnWanted(columnIndex)) {
+                column.isActive = false;
+                column.headGlyph = INVALID_GLYPH;
+                break;
+            }
+            column.y = m_random.NextFloat(-200.0f, -50.0f);
+            if (!m_settings.useCustomWord && m_settings.sequentialCharacters) {
+                column.customWordIndex = m_random.NextInt(0, static_cast<int>(MATRIX_CHARS.size()) - 1);
+            }
+        }
+    }
+
+    // Replay the spawns in time order: a head only rewrites a cell that has
+    // faded below 0.1, and a cell's final alpha gives its alpha at any earlier time
+    std::stable_sort(spawns.begin(), spawns.end(), [](const Spawn& a, const Spawn& b) { return a.time < b.time; });
+    for (const Spawn& spawn : spawns) {
+        MatrixColumn& column = m_columns[spawn.column];
+        int gridX = static_cast<int>(column.x / cellWidth);
+        float remaining = seconds - spawn.time;
+
+        GridCell* cellPtr = FindCell(gridX, spawn.row);
+        if (cellPtr && cellPtr->GetAlpha() + fadeRate * remaining >= 0.1f) continue;
+
+        float alpha = 1.0f - fadeRate * remaining;
+        if (alpha <= 0.0f) continue;
+        if (!cellPtr) {
+            cellPtr = ActivateCell(gridX, spawn.row);
+        }
+        GridCell& cell = *cellPtr;
+
+        float depth = 0.5f;
+        if (m_settings.useMask && m_settings.enable3DEffect) {
+            depth = GetMaskBrightness(static_cast<int>(column.x), static_cast<int>(spawn.row * cellHeight));
+        }
+        cell.glyph = SelectSpawnGlyph(column, depth);
+        cell.SetAlpha(alpha);
+        cell.SetAge(remaining);
+        cell.SetDepth(depth);
+        cell.SetFlag(CELL_ACTIVE, true);
+    }
+
+    for (MatrixColumn& column : m_columns) {
+        column.headGlyph = (column.isActive && column.y >= -50 && column.y <= m_screenHeight + 50)
+            ? SelectHeadGlyph(column)
+            : INVALID_GLYPH;
+    }
+
+    // System-wide timers advance in one step
+    m_characterEffects->Update(seconds);
+    m_frameSpawns = 0;
+}
+
+void MatrixSimulation::UpdateGrid(float deltaTime, FrameProfiler* profiler) {
+    // Fade the character over time (adjusted by motion reduction setting)
+    float fadeRate = m_settings.fadeRate;
+    if (m_settings.enableMotionReduction) {
+        fadeRate *= 0.5f; // Slower fading for reduced motion
+    }
+
+    // Update character effects in their own pass so they can be timed separately.
+    // At reduced quality the pass runs every few updates over the summed time.
+    m_effectTime += deltaTime;
+    if (++m_effectFrames >= m_quality.effectInterval) {
+        ScopedPhaseTimer timer(profiler, ProfilePhase::Effects);
+
+        float effectTime = m_effectTime;
+        float morphProbability = m_settings.morphFrequency * m_quality.effectScale * effectTime;
+        float glitchProbability = m_settings.glitchFrequency * m_quality.effectScale * effectTime;
+        m_effectFrames = 0;
+        m_effectTime = 0.0f;
+
+        for (GridCell& cell : m_activeCells) {
+            // Start morphing occasionally
+            m_characterEffects->StartMorphing(cell, morphProbability);
+            m_characterEffects->UpdateMorphing(cell, effectTime);
+
+            // Start glitches occasionally
+            m_characterEffects->StartGlitch(cell, glitchProbability);
+            m_characterEffects->UpdateGlitch(cell, effectTime);
+        }
+    }
+
+    ScopedPhaseTimer timer(profiler, ProfilePhase::UpdateGrid);
+
+    // Only update active cells for massive performance gain; they are contiguous,
+    // and removal swaps the last cell into the freed slot
+    size_t index = 0;
+    while (index < m_activeCells.size()) {
+        GridCell& cell = m_activeCells[index];
+
+        // Update age for time-based effects
+        cell.SetAge(cell.GetAge() + deltaTime);
+
+        float alpha = cell.GetAlpha() - fadeRate * deltaTime;
+
+        // Deactivate when fully faded
+        if (alpha <= 0.0f) {
+            DeactivateCell(index);
+        } else {
+            cell.SetAlpha(alpha);
+            ++index;
+        }
+    }
+}
+
+GridCell* MatrixSimulation::FindCell(int x, int y) {
+    uint32_t index = m_cellLookup[LookupIndex(x, y)];
+    return index != NO_CELL ? &m_activeCells[index] : nullptr;
+}
+
+GridCell* MatrixSimulation::ActivateCell(int x, int y) {
+    // Add to the end of the dense active list and record its index
+    m_cellLookup[LookupIndex(x, y)] = static_cast<uint32_t>(m_activeCells.size());
+
+    GridCell& cell = m_activeCells.emplace_back();
+    cell.x = static_cast<uint16_t>(x);
+    cell.y = static_cast<uint16_t>(y);
+    return &cell;
+}
+
+void MatrixSimulation::DeactivateCell(size_t index) {
+    GridCell& cell = m_activeCells[index];
+
+    // Return any effect side-table entry before the cell goes away
+    m_characterEffects->ReleaseEffectState(cell);
+    m_cellLookup[LookupIndex(cell.x, cell.y)] = NO_CELL;
+
+    // Swap the last cell into this slot so the list stays dense
+    if (index + 1 != m_activeCells.size()) {
+        cell = m_activeCells.back();
+        m_cellLookup[LookupIndex(cell.x, cell.y)] = static_cast<uint32_t>(index);
+    }
+    m_activeCells.pop_back();
+}
+
+void MatrixSimulation::BuildSnapshot(FrameSnapshot& snapshot, std::span<const SimViewport> viewports) const {
+    snapshot.width = m_screenWidth;
+    snapshot.height = m_screenHeight;
+    snapshot.activeCells = static_cast<uint32_t>(m_activeCells.size());
+    snapshot.systemDisrupted = m_characterEffects->IsSystemDisrupted();
+    snapshot.disruptionIntensity = snapshot.systemDisrupted ? m_characterEffects->GetSystemDisruptionIntensity() : 0.0f;
+
+    SimViewport screen = { 0, 0, 0, m_screenWidth, m_screenHeight };
+    if (viewports.empty()) {
+        viewports = std::span<const SimViewport>(&screen, 1);
+    }
+
+    snapshot.viewports.resize(viewports.size());
+    for (size_t i = 0; i < viewports.size(); ++i) {
+        snapshot.viewports[i] = SnapshotViewport();
+        snapshot.viewports[i].rect = viewports[i];
+    }
+
+    // Cells sit where the renderer draws them; the margin matches its old off-screen test
+    float cellWidth = m_settings.fontSize * 0.8f;
+    float cellHeight = m_settings.fontSize * 0.9f;
+    auto overlapsX = [](const SimViewport& viewport, float x) {
+        return x >= viewport.left - VIEWPORT_MARGIN && x <= viewport.right + VIEWPORT_MARGIN;
+    };
+    auto overlapsY = [](const SimViewport& viewport, float y) {
+        return y >= viewport.top - VIEWPORT_MARGIN && y <= viewport.bottom + VIEWPORT_MARGIN;
+    };
+    auto contains = [&](const SimViewport& viewport, float x, float y) {
+        return overlapsX(viewport, x) && overlapsY(viewport, y);
+    };
+    auto isDrawn = [](const GridCell& cell) {
+        return cell.IsActive() && cell.GetAlpha() >= 0.05f && cell.glyph != INVALID_GLYPH;
+    };
+
+    // The viewports each grid column falls in, so a cell only tests those
+    // few for its row. Laid out like the cell groups: one run per column.
+    m_viewportBucketStart.resize(static_cast<size_t>(m_gridWidth) + 1);
+    m_viewportBuckets.clear();
+    for (int column = 0; column < m_gridWidth; ++column) {
+        m_viewportBucketStart[column] = static_cast<uint32_t>(m_viewportBuckets.size());
+        float x = column * cellWidth;
+        for (uint32_t i = 0; i < snapshot.viewports.size(); ++i) {
+            if (overlapsX(snapshot.viewports[i].rect, x)) m_viewportBuckets.push_back(i);
+        }
+    }
+    m_viewportBucketStart[m_gridWidth] = static_cast<uint32_t>(m_viewportBuckets.size());
+    auto bucket = [&](const GridCell& cell) {
+        return std::span<const uint32_t>(m_viewportBuckets.data() + m_viewportBucketStart[cell.x],
+                                         m_viewportBucketStart[cell.x + 1] - m_viewportBucketStart[cell.x]);
+    };
+
+    // Count per viewport first, so the groups fill one reused vector in place
+    for (const GridCell& cell : m_activeCells) {
+        if (!isDrawn(cell)) continue;
+
+        float y = cell.y * cellHeight;
+        for (uint32_t i : bucket(cell)) {
+            SnapshotViewport& viewport = snapshot.viewports[i];
+            if (overlapsY(viewport.rect, y)) viewport.cellCount++;
+        }
+    }
+
+    uint32_t cellTotal = 0;
+    for (SnapshotViewport& viewport : snapshot.viewports) {
+        viewport.firstCell = cellTotal;
+        cellTotal += viewport.cellCount;
+        viewport.cellCount = 0;
+    }
+    snapshot.cells.resize(cellTotal);
+
+    // Effects are resolved once per cell however many viewports show it
+    for (const GridCell& cell : m_activeCells) {
+        if (!isDrawn(cell)) continue;
+
+        float y = cell.y * cellHeight;
+        bool built = false;
+        SnapshotCell out;
+        for (uint32_t i : bucket(cell)) {
+            SnapshotViewport& viewport = snapshot.viewports[i];
+            if (!overlapsY(viewport.rect, y)) continue;
+
+            if (!built) {
+                out.x = cell.x;
+                out.y = cell.y;
+                out.glyph = cell.glyph;
+                out.displayGlyph = m_characterEffects->GetGlitchedCharacter(cell);
+                out.depth = cell.depth;
+                out.flags = cell.flags;
+                out.alpha = cell.GetAlpha();
+                out.age = cell.GetAge();
+                out.glow = m_characterEffects->GetGlowIntensity(cell);
+                built = true;
+            }
+            snapshot.cells[viewport.firstCell + viewport.cellCount++] = out;
+        }
+    }
+
+    // Few heads, so group them by scanning once per viewport
+    snapshot.columns.clear();
+    for (SnapshotViewport& viewport : snapshot.viewports) {
+        viewport.firstColumn = static_cast<uint32_t>(snapshot.columns.size());
+        for (const MatrixColumn& column : m_columns) {
+            if (!column.isActive || !contains(viewport.rect, column.x, column.y)) continue;
+            snapshot.columns.push_back({ column.x, column.y, column.baseFontSize, column.headGlyph });
+        }
+        viewport.columnCount = static_cast<uint32_t>(snapshot.columns.size()) - viewport.firstColumn;
+    }
+}
+
+uint64_t MatrixSimulation::ComputeStateHash() const {
+    uint64_t hash = FNV_OFFSET_BASIS;
+
+    hash = HashValue(hash, m_screenWidth);
+    hash = HashValue(hash, m_screenHeight);
+    hash = HashValue(hash, m_random.Peek());
+
+    for (const MatrixColumn& column : m_columns) {
+        hash = HashValue(hash, column.x);
+        hash = HashValue(hash, column.y);
+        hash = HashValue(hash, column.currentSpeed);
+        hash = HashValue(hash, column.customWordIndex);
+        hash = HashValue(hash, column.headGlyph);
+
+        // Columns only go inactive under the quality governor; hashing the
+        // flag just for them keeps the hashes of full-quality runs unchanged
+        if (!column.isActive) {
+            hash = HashValue(hash, column.isActive);
+        }
+    }
+
+    // Cell order is part of the state: swap-removal makes it history-dependent.
+    // Effect slots are pool indices, so the effect contents are hashed instead.
+    for (const GridCell& cell : m_activeCells) {
+        hash = HashValue(hash, cell.x);
+        hash = HashValue(hash, cell.y);
+        hash = HashValue(hash, cell.glyph);
+        hash = HashValue(hash, cell.alpha);
+        hash = HashValue(hash, cell.age);
+        hash = HashValue(hash, cell.depth);
+        hash = HashValue(hash, cell.flags);
+
+        if (const CellEffectState* state = m_characterEffects->GetCellEffectState(cell)) {
+            hash = HashValue(hash, state->morphTarget);
+            hash = HashValue(hash, state->morphProgress);
+            hash = HashValue(hash, state->morphSpeed);
+            hash = HashValue(hash, state->glitchIntensity);
+            hash = HashValue(hash, state->glitchTimer);
+            for (GlyphId glyph : state->glitchGlyphs) {
+                hash = HashValue(hash, glyph);
+            }
+        }
+    }
+
+    if (m_quality != SimQuality()) {
+        hash = HashValue(hash, m_quality.columnFraction);
+        hash = HashValue(hash, m_quality.effectScale);
+        hash = HashValue(hash, m_quality.effectInterval);
+        hash = HashValue(hash, m_effectFrames);
+        hash = HashValue(hash, m_effectTime);
+    }
+
+    return m_characterEffects->HashState(hash);
+}
+
+void MatrixSimulation::SaveWarmState(std::string& out) const {
+    // Glyph IDs depend on what was interned in this process, so the state
+    // carries its own glyph list and refers to glyphs by their place in it
+    const GlyphTable& glyphs = GlyphTable::Instance();
+    std::vector<uint16_t> localIds(glyphs.GetGlyphCount(), INVALID_GLYPH);
+    std::vector<GlyphId> usedGlyphs;
+    auto local = [&](GlyphId glyph) -> uint16_t {
+        if (glyph >= localIds.size()) return INVALID_GLYPH;
+        if (localIds[glyph] == INVALID_GLYPH) {
+            localIds[glyph] = static_cast<uint16_t>(usedGlyphs.size());
+            usedGlyphs.push_back(glyph);
+        }
+        return localIds[glyph];
+    };
+
+    std::string body;
+    AppendValue(body, static_cast<uint32_t>(m_columns.size()));
+    for (const MatrixColumn& column : m_columns) {
+        AppendValue(body, column.y);
+        AppendValue(body, column.baseSpeed);
+        AppendValue(body, column.currentSpeed);
+        AppendValue(body, static_cast<int32_t>(column.customWordIndex));
+        AppendValue(body, local(column.headGlyph));
+        AppendValue(body, column.alpha);
+        AppendValue(body, static_cast<uint8_t>(column.isActive ? 1 : 0));
+    }
+
+    AppendValue(body, static_cast<uint32_t>(m_activeCells.size()));
+    for (const GridCell& cell : m_activeCells) {
+        const CellEffectState* state = m_characterEffects->GetCellEffectState(cell);
+        uint8_t flags = state ? cell.flags : static_cast<uint8_t>(cell.flags & ~(CELL_MORPHING | CELL_GLITCHING));
+
+        AppendValue(body, cell.x);
+        AppendValue(body, cell.y);
+        AppendValue(body, local(cell.glyph));
+        AppendValue(body, cell.alpha);
+        AppendValue(body, cell.age);
+        AppendValue(body, cell.depth);
+        AppendValue(body, flags);
+        if (state) {
+            AppendValue(body, local(state->morphTarget));
+            AppendValue(body, state->morphProgress);
+            AppendValue(body, state->morphSpeed);
+            AppendValue(body, state->glitchIntensity);
+            AppendValue(body, state->glitchTimer);
+            for (GlyphId glyph : state->glitchGlyphs) {
+                AppendValue(body, local(glyph));
+            }
+        }
+    }
+
+    CharacterEffects::SystemState system = m_characterEffects->GetSystemState();
+    AppendValue(body, system.disruptionTimer);
+    AppendValue(body, system.timeSinceLastDisruption);
+    AppendValue(body, system.rainIntensityPhase);
+    AppendValue(body, static_cast<int32_t>(m_effectFrames));
+    AppendValue(body, m_effectTime);
+
+    AppendValue(out, static_cast<uint16_t>(usedGlyphs.size()));
+    for (GlyphId glyph : usedGlyphs) {
+        AppendGlyph(out, glyphs.GetGlyph(glyph));
+    }
+    out += body;
+}
+
+bool MatrixSimulation::RestoreWarmState(std::string_view data) {
+    StateReader reader(data);
+
+    // Glyphs stay as indices into the file's own list until the whole state
+    // has been checked, so a file that does not fit interns nothing
+    uint16_t glyphCount = 0;
+    reader.Read(glyphCount);
+    std::vector<std::wstring> glyphTexts(glyphCount);
+    for (std::wstring& text : glyphTexts) {
+        if (!ReadGlyph(reader, text)) return false;
+    }
+    auto local = [&](uint16_t stored, GlyphId& glyph) {
+        glyph = stored;
+        return stored == INVALID_GLYPH || stored < glyphTexts.size();
+    };
+
+    // Column positions come from the layout, so a saved scene only fits a
+    // simulation laid out the same way
+    uint32_t columnCount = 0;
+    reader.Read(columnCount);
+    if (columnCount != m_columns.size()) return false;
+
+    std::vector<MatrixColumn> columns = m_columns;
+    for (MatrixColumn& column : columns) {
+        int32_t customWordIndex = 0;
+        uint16_t headGlyph = INVALID_GLYPH;
+        uint8_t isActive = 0;
+        reader.Read(column.y);
+        reader.Read(column.baseSpeed);
+        reader.Read(column.currentSpeed);
+        reader.Read(customWordIndex);
+        reader.Read(headGlyph);
+        reader.Read(column.alpha);
+        reader.Read(isActive);
+        if (reader.Failed() || !local(headGlyph, column.headGlyph) || customWordIndex < 0) return false;
+        column.customWordIndex = customWordIndex;
+        column.isActive = isActive != 0;
+    }
+
+    struct SavedCell {
+        GridCell cell;
+        CellEffectState state;
+    };
+    uint32_t cellCount = 0;
+    reader.Read(cellCount);
+    if (cellCount > m_cellLookup.size()) return false;
+
+    std::vector<SavedCell> cells(cellCount);
+    std::vector<bool> occupied(m_cellLookup.size(), false);
+    for (SavedCell& saved : cells) {
+        GridCell& cell = saved.cell;
+        uint16_t glyph = INVALID_GLYPH;
+        reader.Read(cell.x);
+        reader.Read(cell.y);
+        reader.Read(glyph);
+        reader.Read(cell.alpha);
+        reader.Read(cell.age);
+        reader.Read(cell.depth);
+        reader.Read(cell.flags);
+        if (reader.Failed() || !local(glyph, cell.glyph) || cell.x >= static_cast<uint32_t>(m_gridWidth) || cell.y >= static_cast<uint32_t>(m_gridHeight)) return false;
+
+        size_t position = LookupIndex(cell.x, cell.y);
+        if (occupied[position]) return false;
+        occupied[position] = true;
+
+        if (cell.IsMorphing() || cell.IsGlitching()) {
+            uint16_t morphTarget = INVALID_GLYPH;
+            reader.Read(morphTarget);
+            reader.Read(saved.state.morphProgress);
+            reader.Read(saved.state.morphSpeed);
+            reader.Read(saved.state.glitchIntensity);
+            reader.Read(saved.state.glitchTimer);
+            if (reader.Failed() || !local(morphTarget, saved.state.morphTarget)) return false;
+            for (GlyphId& glitchGlyph : saved.state.glitchGlyphs) {
+                uint16_t stored = INVALID_GLYPH;
+                reader.Read(stored);
+                if (reader.Failed() || !local(stored, glitchGlyph)) return false;
+            }
+        }
+    }
+
+    CharacterEffects::SystemState system;
+    int32_t effectFrames = 0;
+    float effectTime = 0.0f;
+    reader.Read(system.disruptionTimer);
+    reader.Read(system.timeSinceLastDisruption);
+    reader.Read(system.rainIntensityPhase);
+    reader.Read(effectFrames);
+    reader.Read(effectTime);
+    if (reader.Failed() || !reader.AtEnd()) return false;
+
+    // Everything checked; nothing above touched the running scene or the glyph table
+    std::vector<GlyphId> glyphs(glyphTexts.size());
+    for (size_t i = 0; i < glyphs.size(); ++i) {
+        glyphs[i] = GlyphTable::Instance().Intern(glyphTexts[i]);
+    }
+    auto global = [&](GlyphId& glyph) {
+        if (glyph != INVALID_GLYPH) glyph = glyphs[glyph];
+    };
+
+    for (MatrixColumn& column : columns) {
+        global(column.headGlyph);
+    }
+    m_columns = std::move(columns);
+    Clear();
+    for (SavedCell& saved : cells) {
+        global(saved.cell.glyph);
+        if (saved.cell.IsMorphing() || saved.cell.IsGlitching()) {
+            global(saved.state.morphTarget);
+            for (GlyphId& glitchGlyph : saved.state.glitchGlyphs) {
+                global(glitchGlyph);
+            }
+        }
+
+        GridCell& cell = *ActivateCell(saved.cell.x, saved.cell.y);
+        cell = saved.cell;
+        cell.effectSlot = NO_EFFECT_SLOT;
+        if ((cell.IsMorphing() || cell.IsGlitching()) &&
+            !m_characterEffects->RestoreEffectState(cell, saved.state)) {
+            cell.SetFlag(CELL_MORPHING, false);
+            cell.SetFlag(CELL_GLITCHING, false);
+        }
+    }
+    m_characterEffects->SetSystemState(system);
+    m_effectFrames = effectFrames;
+    m_effectTime = effectTime;
+    return true;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "sim_types.h"
+#include "sim_random.h"
+#include "character_effects.h"
+#include "frame_profiler.h"
+#include "sim_snapshot.h"
+#include "settings_schema.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The falling-rain simulation: columns, the persistent cell grid and the
+// character effects, with no dependency on the renderer or on Windows.
+//
+// Everything that changes its state arrives through Initialize, Resize,
+// UpdateSettings, SetDepthMap and Update, and all randomness comes from the
+// seeded SimRandom, so feeding the same calls in the same order reproduces
+// the same state. SimRecorder captures exactly those calls.
+class MatrixSimulation {
+public:
+    MatrixSimulation();
+    ~MatrixSimulation();
+
+    MatrixSimulation(const MatrixSimulation&) = delete;
+    MatrixSimulation& operator=(const MatrixSimulation&) = delete;
+
+    void Initialize(const MatrixSettings& settings, int width, int height, uint32_t seed);
+    void Resize(int width, int height);
+    // Keeps the rain running unless the change invalidates the layout;
+    // rebuild forces classes regardless (replays of older captures use All)
+    void UpdateSettings(const MatrixSettings& settings, SettingsInvalidation rebuild = SettingsInvalidation::None);
+    void Update(float deltaTime, FrameProfiler* profiler = nullptr);
+
+    // Jump ahead in one analytic step instead of many Updates, for a full
+    // first frame without a warm start. Heads advance in closed form and cells
+    // are only created for spawns recent enough to still show, with their
+    // fade computed from the spawn time. Morph and glitch effects are not
+    // started; they pick up over the next second of normal updates.
+    // Statistically like stepping, not identical to it.
+    void FastForward(float seconds);
+    void Clear();
+
+    // Mask brightness sampled per pixel, 0-255, row-major width * height.
+    // An empty map means no mask.
+    void SetDepthMap(int width, int height, std::vector<uint8_t> depthMap);
+
+    // Scale the workload down; columns leave and rejoin only off screen
+    void SetQuality(const SimQuality& quality);
+    const SimQuality& GetQuality() const { return m_quality; }
+
+    const MatrixSettings& GetSettings() const { return m_settings; }
+    const std::vector<MatrixColumn>& GetColumns() const { return m_columns; }
+    const std::vector<GridCell>& GetActiveCells() const { return m_activeCells; }
+    const CharacterEffects& GetCharacterEffects() const { return *m_characterEffects; }
+    int GetWidth() const { return m_screenWidth; }
+    int GetHeight() const { return m_screenHeight; }
+    uint32_t GetSeed() const { return m_random.GetSeed(); }
+
+    // Cells (re)started by column heads during the last Update
+    uint32_t GetFrameSpawns() const { return m_frameSpawns; }
+
+    // Fill a render snapshot of the current state, reusing its storage. Cells
+    // and heads are culled to the viewports and grouped by them, so each
+    // output walks only what it shows; no viewports means the whole screen.
+    void BuildSnapshot(FrameSnapshot& snapshot, std::span<const SimViewport> viewports = {}) const;
+
+    // Slack around a viewport for glyphs that overhang its edge
+    static constexpr float VIEWPORT_MARGIN = 50.0f;
+
+    // FNV-1a over columns, cells, effect state and the random stream; equal
+    // hashes mean a replay is still in lockstep with the capture
+    uint64_t ComputeStateHash() const;
+
+    // Warm start (see sim_warm_start.h): the scene without the random stream.
+    // Restore goes over a freshly initialized simulation with the same layout
+    // and leaves it untouched if the state does not fit. Restoring interns
+    // glyphs, so it runs on the thread that owns the glyph table.
+    void SaveWarmState(std::string& out) const;
+    bool RestoreWarmState(std::string_view data);
+
+private:
+    void InitializeColumns();
+    void InitializeGrid();
+    void UpdateColumns(float deltaTime);
+    void UpdateGrid(float deltaTime, FrameProfiler* profiler);
+    float GetMaskBrightness(int x, int y) const; // Get brightness from mask for 3D depth
+    GlyphId SelectSpawnGlyph(MatrixColumn& column, float depth);
+    GlyphId SelectHeadGlyph(const MatrixColumn& column);
+    void RankColumns();
+    bool IsColumnWanted(size_t index) const { return m_columnRank[index] < m_wantedColumns; }
+
+    inline size_t LookupIndex(int x, int y) const {
+        return static_cast<size_t>(y) * m_gridWidth + x;
+    }
+    GridCell* FindCell(int x, int y);
+    GridCell* ActivateCell(int x, int y);
+    void DeactivateCell(size_t index);
+
+    MatrixSettings m_settings;
+    int m_screenWidth = 0;
+    int m_screenHeight = 0;
+
+    SimRandom m_random;
+    std::unique_ptr<CharacterEffects> m_characterEffects;
+
+    // Animation data
+    std::vector<MatrixColumn> m_columns;
+
+    // Active cells are stored densely (16 bytes each); m_cellLookup maps a grid
+    // position to its index in m_activeCells, or NO_CELL
+    static constexpr uint32_t NO_CELL = 0xFFFFFFFF;
+    std::vector<GridCell> m_activeCells;
+    std::vector<uint32_t> m_cellLookup;
+    std::vector<GlyphId> m_customWordGlyphs;              // Interned custom word
+    int m_gridWidth = 0;
+    int m_gridHeight = 0;
+
+    std::vector<uint8_t> m_depthMap;
+    int m_depthMapWidth = 0;
+    int m_depthMapHeight = 0;
+
+    uint32_t m_frameSpawns = 0;
+
+    // Quality scaling
+    SimQuality m_quality;
+    std::vector<uint32_t> m_columnRank;                   // Order in which columns drop out, evenly spread
+    uint32_t m_wantedColumns = 0;
+    int m_effectFrames = 0;                               // Updates since the per-cell effects last ran
+    float m_effectTime = 0.0f;                            // Time those updates covered
+
+    // BuildSnapshot scratch: per grid column, the viewports it falls in
+    mutable std::vector<uint32_t> m_viewportBucketStart;
+    mutable std::vector<uint32_t> m_viewportBuckets;
+};
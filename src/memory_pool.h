@@ -1,72 +1,296 @@
 #pragma once
 
-#include <vector>
-#include <stack>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
 
+// Chunked object pool with a lock-free free list and per-thread caches.
+//
+// Objects live in fixed-size chunks that are never moved or freed while the
+// pool is alive, so pointers handed out by Acquire() stay valid when the pool
+// grows. Growth is the only operation that takes a lock.
 template<typename T>
 class MemoryPool {
 public:
     explicit MemoryPool(size_t initialSize = 1000, size_t growthSize = 500)
-        : m_growthSize(growthSize) {
-        ExpandPool(initialSize);
+        : m_chunkSize(growthSize > 0 ? growthSize : 1),
+          m_poolId(NextPoolId()) {
+        size_t chunks = (initialSize + m_chunkSize - 1) / m_chunkSize;
+        std::lock_guard<std::mutex> lock(m_growMutex);
+        for (size_t i = 0; i < chunks; ++i) {
+            AddChunk();
+        }
     }
     
     ~MemoryPool() {
-        // All objects should be returned before destruction
+        // Destroy anything that was never returned so owned resources are freed
+        size_t chunkCount = m_chunkCount.load(std::memory_order_acquire);
+        for (size_t c = 0; c < chunkCount; ++c) {
+            Slot* chunk = m_chunks[c].load(std::memory_order_relaxed);
+            for (size_t i = 0; i < m_chunkSize; ++i) {
+                if (chunk[i].inUse) {
+                    std::destroy_at(chunk[i].Object());
+                }
+            }
+        }
     }
     
-    // Get an object from the pool
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
+    
+    // Get a default-constructed object from the pool, or nullptr if the pool
+    // has reached MAX_CHUNKS and cannot grow any further
     T* Acquire() {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        ThreadCache* cache = GetThreadCache();
         
-        if (m_available.empty()) {
-            ExpandPool(m_growthSize);
+        if (cache->count.load(std::memory_order_relaxed) == 0 && !RefillCache(*cache)) {
+            return nullptr;
         }
         
-        T* obj = m_available.top();
-        m_available.pop();
+        size_t count = cache->count.load(std::memory_order_relaxed) - 1;
+        cache->count.store(count, std::memory_order_relaxed);
+        Slot& slot = GetSlot(cache->indices[count]);
+        slot.inUse = true;
         
-        // Reset object to default state
-        *obj = T{};
-        
-        return obj;
+        return ::new (static_cast<void*>(slot.storage)) T{};
     }
     
-    // Return an object to the pool
+    // Return an object to the pool; it is destroyed immediately
     void Release(T* obj) {
         if (!obj) return;
         
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_available.push(obj);
+        Slot* slot = Slot::FromObject(obj);
+        std::destroy_at(obj);
+        slot->inUse = false;
+        
+        ThreadCache* cache = GetThreadCache();
+        size_t count = cache->count.load(std::memory_order_relaxed);
+        if (count == THREAD_CACHE_SIZE) {
+            // Hand the older half back to the shared free list in one push
+            size_t spill = THREAD_CACHE_SIZE / 2;
+            PushChain(cache->indices.data(), spill);
+            std::move(cache->indices.begin() + spill, cache->indices.end(), cache->indices.begin());
+            count -= spill;
+        }
+        
+        cache->indices[count] = slot->index;
+        cache->count.store(count + 1, std::memory_order_relaxed);
     }
     
+    // Approximate while other threads are acquiring or releasing
     size_t GetAvailableCount() const {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_available.size();
+        size_t available = m_freeCount.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        for (const auto& [owner, cache] : m_threadCaches) {
+            available += cache->count.load(std::memory_order_relaxed);
+        }
+        return available;
     }
     
     size_t GetTotalCount() const {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_storage.size();
+        return m_chunkCount.load(std::memory_order_acquire) * m_chunkSize;
     }
+    
+    // Stable slot index of an acquired object, for callers that keep compact
+    // 32-bit handles instead of pointers
+    uint32_t GetIndex(const T* obj) const { return Slot::FromObject(obj)->index; }
+    T* FromIndex(uint32_t index) { return GetSlot(index).Object(); }
+    const T* FromIndex(uint32_t index) const { return GetSlot(index).Object(); }
 
 private:
-    void ExpandPool(size_t count) {
-        size_t currentSize = m_storage.size();
-        m_storage.resize(currentSize + count);
+    static constexpr size_t MAX_CHUNKS = 4096;
+    static constexpr size_t THREAD_CACHE_SIZE = 64;
+    static constexpr size_t CACHE_REFILL_COUNT = THREAD_CACHE_SIZE / 4;
+    static constexpr size_t THREAD_CACHE_ENTRIES = 4;
+    static constexpr uint32_t END_OF_LIST = 0;
+    
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+        std::atomic<uint32_t> next{END_OF_LIST}; // Free-list link (slot index + 1)
+        uint32_t index = 0;
+        bool inUse = false;
+        
+        T* Object() { return std::launder(reinterpret_cast<T*>(storage)); }
+        const T* Object() const { return std::launder(reinterpret_cast<const T*>(storage)); }
         
-        // Add new objects to available stack
-        for (size_t i = currentSize; i < m_storage.size(); ++i) {
-            m_available.push(&m_storage[i]);
+        // storage is the first member, so the object address is the slot address
+        static Slot* FromObject(T* obj) {
+            return reinterpret_cast<Slot*>(reinterpret_cast<unsigned char*>(obj));
         }
+        static const Slot* FromObject(const T* obj) {
+            return reinterpret_cast<const Slot*>(reinterpret_cast<const unsigned char*>(obj));
+        }
+    };
+    
+    // Small stack of free slot indices owned by a single thread; count is
+    // atomic only so GetAvailableCount() can read it from other threads
+    struct ThreadCache {
+        std::array<uint32_t, THREAD_CACHE_SIZE> indices{};
+        std::atomic<size_t> count{0};
+    };
+    
+    // Free list head packs an ABA tag in the high 32 bits and (index + 1) in the low 32 bits
+    static uint64_t PackHead(uint32_t tag, uint32_t link) {
+        return (static_cast<uint64_t>(tag) << 32) | link;
+    }
+    
+    static uint64_t NextPoolId() {
+        static std::atomic<uint64_t> s_nextId{1};
+        return s_nextId.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    Slot& GetSlot(uint32_t index) {
+        Slot* chunk = m_chunks[index / m_chunkSize].load(std::memory_order_acquire);
+        return chunk[index % m_chunkSize];
+    }
+    
+    const Slot& GetSlot(uint32_t index) const {
+        const Slot* chunk = m_chunks[index / m_chunkSize].load(std::memory_order_acquire);
+        return chunk[index % m_chunkSize];
     }
     
-    mutable std::mutex m_mutex;
-    std::vector<T> m_storage;           // Actual object storage
-    std::stack<T*> m_available;        // Available objects
-    size_t m_growthSize;               // How much to grow when pool is empty
+    ThreadCache* GetThreadCache() {
+        // Remember the caches of the last few pools this thread touched so the
+        // common path is a thread-local lookup with no synchronisation
+        struct Entry {
+            uint64_t poolId = 0;
+            ThreadCache* cache = nullptr;
+        };
+        static thread_local std::array<Entry, THREAD_CACHE_ENTRIES> t_entries{};
+        static thread_local size_t t_nextEntry = 0;
+        
+        for (const auto& entry : t_entries) {
+            if (entry.poolId == m_poolId) {
+                return entry.cache;
+            }
+        }
+        
+        ThreadCache* cache = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_cacheMutex);
+            std::thread::id self = std::this_thread::get_id();
+            for (auto& [owner, existing] : m_threadCaches) {
+                if (owner == self) {
+                    cache = existing.get();
+                    break;
+                }
+            }
+            if (!cache) {
+                m_threadCaches.emplace_back(self, std::make_unique<ThreadCache>());
+                cache = m_threadCaches.back().second.get();
+            }
+        }
+        
+        t_entries[t_nextEntry] = { m_poolId, cache };
+        t_nextEntry = (t_nextEntry + 1) % THREAD_CACHE_ENTRIES;
+        return cache;
+    }
+    
+    bool RefillCache(ThreadCache& cache) {
+        while (true) {
+            size_t count = 0;
+            while (count < CACHE_REFILL_COUNT) {
+                uint32_t index;
+                if (!Pop(index)) break;
+                cache.indices[count++] = index;
+            }
+            cache.count.store(count, std::memory_order_relaxed);
+            
+            if (count > 0) return true;
+            if (!ExpandPool()) return false;
+        }
+    }
+    
+    bool Pop(uint32_t& index) {
+        uint64_t head = m_freeHead.load(std::memory_order_acquire);
+        while (true) {
+            uint32_t link = static_cast<uint32_t>(head);
+            if (link == END_OF_LIST) return false;
+            
+            // A stale read of next is harmless: the tag makes the CAS fail
+            uint32_t next = GetSlot(link - 1).next.load(std::memory_order_relaxed);
+            uint64_t newHead = PackHead(static_cast<uint32_t>(head >> 32) + 1, next);
+            if (m_freeHead.compare_exchange_weak(head, newHead,
+                    std::memory_order_acq_rel, std::memory_order_acquire)) {
+                index = link - 1;
+                m_freeCount.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+    
+    // Link the given slots together and push them onto the free list with a single CAS
+    void PushChain(const uint32_t* indices, size_t count) {
+        if (count == 0) return;
+        
+        for (size_t i = 0; i + 1 < count; ++i) {
+            GetSlot(indices[i]).next.store(indices[i + 1] + 1, std::memory_order_relaxed);
+        }
+        
+        Slot& tail = GetSlot(indices[count - 1]);
+        uint64_t head = m_freeHead.load(std::memory_order_relaxed);
+        do {
+            tail.next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        } while (!m_freeHead.compare_exchange_weak(head,
+                    PackHead(static_cast<uint32_t>(head >> 32) + 1, indices[0] + 1),
+                    std::memory_order_release, std::memory_order_relaxed));
+        
+        m_freeCount.fetch_add(count, std::memory_order_relaxed);
+    }
+    
+    bool ExpandPool() {
+        std::lock_guard<std::mutex> lock(m_growMutex);
+        
+        // Another thread may have grown the pool while we waited for the lock
+        if (static_cast<uint32_t>(m_freeHead.load(std::memory_order_acquire)) != END_OF_LIST) {
+            return true;
+        }
+        
+        return AddChunk();
+    }
+    
+    // Caller must hold m_growMutex
+    bool AddChunk() {
+        size_t chunkIndex = m_chunkCount.load(std::memory_order_relaxed);
+        if (chunkIndex >= MAX_CHUNKS) return false;
+        
+        auto chunk = std::make_unique<Slot[]>(m_chunkSize);
+        std::vector<uint32_t> indices(m_chunkSize);
+        for (size_t i = 0; i < m_chunkSize; ++i) {
+            chunk[i].index = static_cast<uint32_t>(chunkIndex * m_chunkSize + i);
+            indices[i] = chunk[i].index;
+        }
+        
+        m_chunks[chunkIndex].store(chunk.get(), std::memory_order_release);
+        m_ownedChunks.push_back(std::move(chunk));
+        m_chunkCount.store(chunkIndex + 1, std::memory_order_release);
+        
+        PushChain(indices.data(), indices.size());
+        return true;
+    }
+    
+    const size_t m_chunkSize;           // Objects per chunk (the growth step)
+    const uint64_t m_poolId;            // Unique id used to key thread-local caches
+    
+    std::array<std::atomic<Slot*>, MAX_CHUNKS> m_chunks{};
+    std::atomic<size_t> m_chunkCount{0};
+    std::atomic<uint64_t> m_freeHead{PackHead(0, END_OF_LIST)};
+    std::atomic<size_t> m_freeCount{0};     // Slots on the shared free list
+    
+    std::mutex m_growMutex;
+    std::vector<std::unique_ptr<Slot[]>> m_ownedChunks;
+    
+    // Caches of threads that have used this pool; indices held by a thread
+    // that has exited stay parked here until the pool is destroyed
+    mutable std::mutex m_cacheMutex;
+    std::vector<std::pair<std::thread::id, std::unique_ptr<ThreadCache>>> m_threadCaches;
 };
 
 // RAII wrapper for automatic memory pool management
@@ -85,7 +309,7 @@ public:
     PooledObject(const PooledObject&) = delete;
     PooledObject& operator=(const PooledObject&) = delete;
     
-    PooledObject(PooledObject&& other) noexcept 
+    PooledObject(PooledObject&& other) noexcept
         : m_pool(other.m_pool), m_object(other.m_object) {
         other.m_pool = nullptr;
         other.m_object = nullptr;
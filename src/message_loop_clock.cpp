@@ -0,0 +1,66 @@
+#include "message_loop_clock.h"
+#include <timeapi.h>
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+MessageLoopClock::MessageLoopClock() {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    m_frequency = frequency.QuadPart;
+
+    m_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!m_timer) {
+        // Older systems: a regular timer wakes on system ticks (15.6 ms by
+        // default), too coarse for the pacer's capped spin window
+        m_timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+        m_raisedTimerResolution = timeBeginPeriod(1) == TIMERR_NOERROR;
+    }
+}
+
+MessageLoopClock::~MessageLoopClock() {
+    if (m_timer) {
+        CloseHandle(m_timer);
+    }
+    if (m_raisedTimerResolution) {
+        timeEndPeriod(1);
+    }
+}
+
+int64_t MessageLoopClock::Now() {
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+
+    // Split to avoid overflowing the multiplication after long uptimes
+    int64_t seconds = counter.QuadPart / m_frequency;
+    int64_t remainder = counter.QuadPart % m_frequency;
+    return seconds * 1'000'000'000 + remainder * 1'000'000'000 / m_frequency;
+}
+
+bool MessageLoopClock::Sleep(int64_t duration) {
+    if (!m_timer) {
+        ::Sleep(static_cast<DWORD>(duration / 1'000'000));
+        return true;
+    }
+
+    // Relative due time, in 100 ns units
+    LARGE_INTEGER dueTime;
+    dueTime.QuadPart = -std::max<int64_t>(duration / 100, 1);
+    if (!SetWaitableTimer(m_timer, &dueTime, 0, nullptr, nullptr, FALSE)) {
+        return true;
+    }
+
+    DWORD result = MsgWaitForMultipleObjectsEx(1, &m_timer, INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+    if (result == WAIT_OBJECT_0) {
+        return true;
+    }
+
+    // Woken by a message (or failed); don't leave the timer armed
+    CancelWaitableTimer(m_timer);
+    return false;
+}
+
+void MessageLoopClock::Relax() {
+    YieldProcessor();
+}
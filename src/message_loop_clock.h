@@ -0,0 +1,30 @@
+#pragma once
+
+#include "common.h"
+#include "frame_pacer.h"
+
+// PacerClock for the UI thread's frame loop.
+//
+// Time comes from QueryPerformanceCounter. Sleeps wait on a high-resolution
+// waitable timer (Windows 10 1803+, falling back to a regular one) through
+// MsgWaitForMultipleObjectsEx, so window messages end the sleep early and
+// input is never held up by frame pacing. Without the high-resolution timer
+// the system timer is raised to 1 ms for the clock's lifetime, so sleeps
+// overshoot by less than the pacer's spin window can absorb.
+class MessageLoopClock : public PacerClock {
+public:
+    MessageLoopClock();
+    ~MessageLoopClock() override;
+
+    MessageLoopClock(const MessageLoopClock&) = delete;
+    MessageLoopClock& operator=(const MessageLoopClock&) = delete;
+
+    int64_t Now() override;
+    bool Sleep(int64_t duration) override;
+    void Relax() override;
+
+private:
+    HANDLE m_timer = nullptr;
+    int64_t m_frequency = 1;
+    bool m_raisedTimerResolution = false;
+};
@@ -1,21 +1,30 @@
 #include "performance_metrics.h"
-#include <sstream>
-#include <iomanip>
+#include "logger.h"
+#include <psapi.h>
+#include <cwchar>
 
 PerformanceMetrics::PerformanceMetrics() 
-    : m_lastFrameTime(std::chrono::high_resolution_clock::now()) {
+    : m_lastFrameTime(std::chrono::high_resolution_clock::now()),
+      m_startTime(m_lastFrameTime) {
 }
 
 PerformanceMetrics::~PerformanceMetrics() {
 }
 
 void PerformanceMetrics::StartFrame() {
-    if (!m_enabled) return;
+    if (!IsProfiling()) return;
     m_frameStartTime = std::chrono::high_resolution_clock::now();
 }
 
 void PerformanceMetrics::EndFrame() {
-    if (!m_enabled) return;
+    if (!IsProfiling()) return;
+    
+    // Measured end to end so simulation updates between frames are included
+    AllocationStats allocations = GetAllocationStats();
+    m_frameAllocations = allocations.allocations - m_lastFrameAllocations.allocations;
+    m_frameAllocatedBytes = allocations.bytes - m_lastFrameAllocations.bytes;
+    m_peakFrameAllocations = std::max(m_peakFrameAllocations, m_frameAllocations);
+    m_lastFrameAllocations = allocations;
     
     auto now = std::chrono::high_resolution_clock::now();
     auto frameDuration = std::chrono::duration<float, std::milli>(now - m_frameStartTime);
@@ -26,34 +35,125 @@ void PerformanceMetrics::EndFrame() {
     if (deltaTime.count() > 0) {
         m_currentFPS = 1.0f / deltaTime.count();
         
-        // Add to history
-        m_fpsHistory.push_back(m_currentFPS);
-        if (m_fpsHistory.size() > FPS_HISTORY_SIZE) {
-            m_fpsHistory.pop_front();
-        }
+        // Add to history, overwriting the oldest sample
+        m_fpsHistory[m_fpsHistoryNext] = m_currentFPS;
+        m_fpsHistoryNext = (m_fpsHistoryNext + 1) % FPS_HISTORY_SIZE;
+        m_fpsHistoryCount = std::min(m_fpsHistoryCount + 1, FPS_HISTORY_SIZE);
         
         // Calculate average
-        if (!m_fpsHistory.empty()) {
-            float sum = 0;
-            for (float fps : m_fpsHistory) {
-                sum += fps;
-            }
-            m_averageFPS = sum / m_fpsHistory.size();
+        float sum = 0;
+        for (size_t i = 0; i < m_fpsHistoryCount; ++i) {
+            sum += m_fpsHistory[i];
         }
+        m_averageFPS = sum / m_fpsHistoryCount;
     }
     
     m_lastFrameTime = now;
+    
+    m_profiler.EndFrame();
+    
+    if (m_trace) {
+        FrameSample sample;
+        if (m_profiler.GetLatestSample(sample)) {
+            m_trace->Record(sample, m_frameCounters);
+        }
+    }
+    
+    if (m_countersEndpoint) {
+        m_spawnsSincePublish += m_frameCounters.spawns;
+        if (++m_publishCounter >= PUBLISH_INTERVAL) {
+            m_publishCounter = 0;
+            PublishCounters(now);
+        }
+    }
+}
+
+bool PerformanceMetrics::StartCountersEndpoint(int instanceId, bool enableSocket) {
+    if (m_countersEndpoint) return true;
+    
+    auto endpoint = std::make_unique<CountersEndpoint>();
+    if (!endpoint->Start(instanceId, enableSocket)) return false;
+    
+    m_countersEndpoint = std::move(endpoint);
+    m_publishCounter = 0;
+    m_spawnsSincePublish = 0;
+    m_lastPublishTime = std::chrono::high_resolution_clock::now();
+    return true;
+}
+
+void PerformanceMetrics::StopCountersEndpoint() {
+    m_countersEndpoint.reset();
+}
+
+void PerformanceMetrics::PublishCounters(std::chrono::high_resolution_clock::time_point now) {
+    LiveCounters counters;
+    counters.frameIndex = m_profiler.GetFrameCount();
+    counters.uptimeSeconds = std::chrono::duration<double>(now - m_startTime).count();
+    counters.fps = m_currentFPS;
+    counters.fpsAverage = m_averageFPS;
+    
+    ProfileSummary summary = m_profiler.Summarize(m_profileWindow);
+    counters.frameMsP50 = summary.frame.p50;
+    counters.frameMsP95 = summary.frame.p95;
+    counters.frameMsP99 = summary.frame.p99;
+    counters.frameMsMax = summary.frame.max;
+    
+    float interval = std::chrono::duration<float>(now - m_lastPublishTime).count();
+    counters.activeCells = m_frameCounters.activeCells;
+    counters.spawnsPerSecond = interval > 0.0f ? m_spawnsSincePublish / interval : 0.0f;
+    counters.drawCalls = m_frameCounters.drawCalls;
+    counters.batches = m_frameCounters.batches;
+    counters.dirtyPercent = m_frameCounters.dirtyPercent;
+    
+    PROCESS_MEMORY_COUNTERS_EX memory = {};
+    memory.cb = sizeof(memory);
+    if (GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&memory), sizeof(memory))) {
+        counters.workingSetBytes = memory.WorkingSetSize;
+        counters.privateBytes = memory.PrivateUsage;
+    }
+    
+    counters.allocationsPerFrame = m_frameAllocations;
+    counters.bytesAllocatedPerFrame = m_frameAllocatedBytes;
+    counters.timeToFirstFrameMs = m_timeToFirstFrameMs;
+    
+    m_countersEndpoint->Publish(counters);
+    m_spawnsSincePublish = 0;
+    m_lastPublishTime = now;
+}
+
+void PerformanceMetrics::StartTrace(size_t maxFrames) {
+    if (m_trace) return;
+    
+    m_trace = std::make_unique<FrameTrace>(maxFrames);
+    LOG_INFO("Frame trace capture started ({} frames max)", maxFrames);
+}
+
+bool PerformanceMetrics::StopTrace(const std::wstring& basePath) {
+    if (!m_trace) return false;
+    
+    std::unique_ptr<FrameTrace> trace = std::move(m_trace);
+    if (trace->GetFrameCount() == 0) return false;
+    
+    bool written = trace->WriteChromeTrace(basePath + L".json") &&
+                   trace->WriteCsv(basePath + L".csv");
+    
+    if (written) {
+        LOG_INFO("Frame trace written: {} frames, {} dropped", trace->GetFrameCount(), trace->GetDroppedCount());
+    } else {
+        LOG_ERROR("Failed to write frame trace");
+    }
+    return written;
 }
 
 void PerformanceMetrics::Render(ID2D1RenderTarget* renderTarget, IDWriteFactory* writeFactory) {
     if (!m_enabled || !renderTarget || !writeFactory) return;
     
-    // Only update display every N frames to reduce flicker
-    m_updateCounter++;
-    if (m_updateCounter < UPDATE_FREQUENCY) {
-        return;
+    // Only rebuild the text every N frames to reduce flicker
+    if (m_overlayLength == 0 || ++m_updateCounter >= UPDATE_FREQUENCY) {
+        m_updateCounter = 0;
+        UpdateOverlayText();
     }
-    m_updateCounter = 0;
+    if (m_overlayLength == 0) return;
     
     // Create resources if needed
     if (!m_textBrush) {
@@ -85,24 +185,93 @@ void PerformanceMetrics::Render(ID2D1RenderTarget* renderTarget, IDWriteFactory*
         }
     }
     
-    // Format the display text
-    std::wstringstream ss;
-    ss << L"FPS: " << std::fixed << std::setprecision(1) << m_currentFPS;
-    ss << L" (Avg: " << std::fixed << std::setprecision(1) << m_averageFPS << L")\n";
-    ss << L"Frame Time: " << std::fixed << std::setprecision(2) << m_frameTime << L" ms";
-    
-    std::wstring text = ss.str();
+    float panelHeight = 15.0f + m_overlayLines * 14.0f;
     
     // Draw background
-    D2D1_RECT_F bgRect = D2D1::RectF(5, 5, 200, 45);
+    D2D1_RECT_F bgRect = D2D1::RectF(5, 5, 400, panelHeight);
     renderTarget->FillRectangle(&bgRect, m_backgroundBrush.Get());
     
     // Draw text
-    D2D1_RECT_F textRect = D2D1::RectF(10, 10, 195, 40);
+    D2D1_RECT_F textRect = D2D1::RectF(10, 10, 395, panelHeight - 5);
     renderTarget->DrawText(
-        text.c_str(),
-        static_cast<UINT32>(text.length()),
+        m_overlayText.data(),
+        m_overlayLength,
         m_textFormat.Get(),
         textRect,
         m_textBrush.Get());
-}
\ No newline at end of file
+}
+
+void PerformanceMetrics::UpdateOverlayText() {
+    // Format into a fixed buffer to avoid per-frame allocations
+    wchar_t* text = m_overlayText.data();
+    size_t capacity = m_overlayText.size();
+    size_t length = 0;
+    int lines = 0;
+    
+    auto append = [&](int written) {
+        if (written > 0) {
+            length = std::min(length + static_cast<size_t>(written), capacity - 1);
+            lines++;
+        }
+    };
+    
+    ProfileSummary summary = m_profiler.Summarize(m_profileWindow);
+    
+    append(std::swprintf(text + length, capacity - length,
+        L"FPS: %.1f (Avg: %.1f)  Frame: %.2f ms\n",
+        m_currentFPS, m_averageFPS, m_frameTime));
+    
+    if (m_timeToFirstFrameMs > 0.0f) {
+        append(std::swprintf(text + length, capacity - length,
+            L"First frame: %.0f ms after launch\n", m_timeToFirstFrameMs));
+    }
+    
+    if (IsAllocationCountingEnabled()) {
+        append(std::swprintf(text + length, capacity - length,
+            L"Allocs/Frame: %llu (%llu B, peak %llu)\n",
+            static_cast<unsigned long long>(m_frameAllocations),
+            static_cast<unsigned long long>(m_frameAllocatedBytes),
+            static_cast<unsigned long long>(m_peakFrameAllocations)));
+    }
+    
+    if (m_qualityStatus) {
+        const QualityGovernorStatus& quality = *m_qualityStatus;
+        
+        // Knob names are ASCII; widen the last decision for the wide overlay
+        wchar_t decision[16] = L"-";
+        if (quality.lastDirection != 0) {
+            const char* name = GetQualityKnobName(quality.lastKnob);
+            size_t i = 0;
+            decision[i++] = quality.lastDirection < 0 ? L'-' : L'+';
+            for (; *name && i + 1 < std::size(decision); ++name) {
+                decision[i++] = static_cast<wchar_t>(*name);
+            }
+            decision[i] = L'\0';
+        }
+        
+        append(std::swprintf(text + length, capacity - length,
+            L"Quality: cols %.0f%% fx %.0f%% glow %.0f%%  p90 %.1f/%.1f ms  last %ls\n",
+            quality.current.Get(QualityKnob::Columns) * 100.0f,
+            quality.current.Get(QualityKnob::Effects) * 100.0f,
+            quality.current.Get(QualityKnob::Glow) * 100.0f,
+            quality.loadMs, quality.budgetMs, decision));
+    }
+    
+    append(std::swprintf(text + length, capacity - length,
+        L"%-8ls %6ls %6ls %6ls %6ls  (ms, %zu frames)\n",
+        L"Phase", L"p50", L"p95", L"p99", L"max", summary.frameCount));
+    
+    auto appendRow = [&](const wchar_t* name, const PhaseSummary& phase) {
+        append(std::swprintf(text + length, capacity - length,
+            L"%-8ls %6.2f %6.2f %6.2f %6.2f\n",
+            name, phase.p50, phase.p95, phase.p99, phase.max));
+    };
+    
+    appendRow(L"Frame", summary.frame);
+    for (size_t i = 0; i < PROFILE_PHASE_COUNT; ++i) {
+        appendRow(GetProfilePhaseName(static_cast<ProfilePhase>(i)), summary.phases[i]);
+    }
+    
+    m_overlayLength = static_cast<UINT32>(length);
+    m_overlayLines = lines;
+}
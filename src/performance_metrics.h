@@ -1,7 +1,12 @@
 #pragma once
 
 #include "common.h"
-#include <deque>
+#include "alloc_counter.h"
+#include "frame_profiler.h"
+#include "frame_trace.h"
+#include "counters_endpoint.h"
+#include "quality_governor.h"
+#include <array>
 
 class PerformanceMetrics {
 public:
@@ -16,11 +21,56 @@ public:
     float GetAverageFPS() const { return m_averageFPS; }
     float GetFrameTime() const { return m_frameTime; }
     
+    // Heap activity from the previous EndFrame to the last one; always zero
+    // unless built with MATRIX_COUNT_ALLOCATIONS
+    uint64_t GetAllocationsPerFrame() const { return m_frameAllocations; }
+    uint64_t GetBytesAllocatedPerFrame() const { return m_frameAllocatedBytes; }
+    uint64_t GetPeakAllocationsPerFrame() const { return m_peakFrameAllocations; }
+    
     void SetEnabled(bool enabled) { m_enabled = enabled; }
     bool IsEnabled() const { return m_enabled; }
+    
+    // Per-phase timing; null unless metrics or tracing are on, so scoped timers cost nothing
+    FrameProfiler* GetProfiler() { return IsProfiling() ? &m_profiler : nullptr; }
+    const FrameProfiler& GetFrameProfiler() const { return m_profiler; }
+    
+    // Number of recent frames the overlay percentiles cover
+    void SetProfileWindow(size_t frames) { m_profileWindow = std::clamp<size_t>(frames, 1, FrameProfiler::CAPACITY); }
+    size_t GetProfileWindow() const { return m_profileWindow; }
+    
+    // Frame timeline capture. Counters are reported by the renderer before
+    // EndFrame and recorded with that frame's phase timings.
+    void StartTrace(size_t maxFrames);
+    bool IsTracing() const { return m_trace != nullptr; }
+    void SetFrameCounters(const FrameCounters& counters) { m_frameCounters = counters; }
+    
+    // Whether the renderer should report FrameCounters (tracing or publishing)
+    bool IsCollectingCounters() const { return m_trace || m_countersEndpoint; }
+    
+    // Live counters for external monitoring, refreshed every PUBLISH_INTERVAL frames
+    bool StartCountersEndpoint(int instanceId, bool enableSocket);
+    void StopCountersEndpoint();
+    bool IsPublishingCounters() const { return m_countersEndpoint != nullptr; }
+    
+    // End the capture and write it as <basePath>.json (Chrome trace) and <basePath>.csv
+    bool StopTrace(const std::wstring& basePath);
+    
+    // Keep the profiler running for a consumer other than the overlay (the quality governor)
+    void SetProfilingRequired(bool required) { m_profilingRequired = required; }
+    
+    // Governor state shown in the overlay; the owner keeps it alive, null hides the line
+    void SetQualityStatus(const QualityGovernorStatus* status) { m_qualityStatus = status; }
+    
+    // Launch to first present, reported in the overlay and the live counters
+    void SetTimeToFirstFrame(float ms) { m_timeToFirstFrameMs = ms; }
 
 private:
     bool m_enabled = false;
+    bool m_profilingRequired = false;
+    const QualityGovernorStatus* m_qualityStatus = nullptr;
+    float m_timeToFirstFrameMs = 0.0f;
+    
+    bool IsProfiling() const { return m_enabled || m_profilingRequired || m_trace || m_countersEndpoint; }
     
     // Timing data
     std::chrono::high_resolution_clock::time_point m_frameStartTime;
@@ -31,9 +81,42 @@ private:
     float m_averageFPS = 0.0f;
     float m_frameTime = 0.0f;
     
-    // History for averaging
-    std::deque<float> m_fpsHistory;
+    // Ring buffer of recent FPS samples for averaging
     static constexpr size_t FPS_HISTORY_SIZE = 60;
+    std::array<float, FPS_HISTORY_SIZE> m_fpsHistory = {};
+    size_t m_fpsHistoryNext = 0;
+    size_t m_fpsHistoryCount = 0;
+    
+    // Allocation counters
+    AllocationStats m_lastFrameAllocations;
+    uint64_t m_frameAllocations = 0;
+    uint64_t m_frameAllocatedBytes = 0;
+    uint64_t m_peakFrameAllocations = 0;
+    
+    // Phase timing
+    FrameProfiler m_profiler;
+    size_t m_profileWindow = 120;
+    
+    // Timeline capture, only allocated while tracing
+    std::unique_ptr<FrameTrace> m_trace;
+    FrameCounters m_frameCounters;
+    
+    // Live counters, only allocated while publishing
+    static constexpr int PUBLISH_INTERVAL = 15;
+    std::unique_ptr<CountersEndpoint> m_countersEndpoint;
+    int m_publishCounter = 0;
+    uint64_t m_spawnsSincePublish = 0;
+    std::chrono::high_resolution_clock::time_point m_startTime;
+    std::chrono::high_resolution_clock::time_point m_lastPublishTime;
+    
+    void PublishCounters(std::chrono::high_resolution_clock::time_point now);
+    
+    // Overlay text, rebuilt every UPDATE_FREQUENCY frames and drawn every frame
+    std::array<wchar_t, 1024> m_overlayText = {};
+    UINT32 m_overlayLength = 0;
+    int m_overlayLines = 0;
+    
+    void UpdateOverlayText();
     
     // Rendering resources
     Microsoft::WRL::ComPtr<ID2D1SolidColorBrush> m_textBrush;
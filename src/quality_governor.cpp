@@ -0,0 +1,155 @@
+#include "quality_governor.h"
+#include <algorithm>
+
+namespace {
+
+float PhaseMs(const std::array<double, PROFILE_PHASE_COUNT>& sums, ProfilePhase phase) {
+    return static_cast<float>(sums[static_cast<size_t>(phase)]);
+}
+
+} // namespace
+
+const char* GetQualityKnobName(QualityKnob knob) {
+    switch (knob) {
+        case QualityKnob::Glow:     return "glow";
+        case QualityKnob::Effects:  return "effects";
+        case QualityKnob::Columns:  return "columns";
+        default:                    return "?";
+    }
+}
+
+QualityGovernor::QualityGovernor() {
+    SetTargetRate(60.0);
+}
+
+void QualityGovernor::SetTargetRate(double rate) {
+    m_status.budgetMs = static_cast<float>(1000.0 / std::max(rate, 1.0));
+}
+
+void QualityGovernor::SetKnobAvailable(QualityKnob knob, bool available) {
+    size_t index = static_cast<size_t>(knob);
+    m_available[index] = available;
+    if (!available) {
+        m_status.target.values[index] = 1.0f;
+        m_status.current.values[index] = 1.0f;
+    }
+}
+
+void QualityGovernor::Reset() {
+    m_status.current = QualityLevels();
+    m_status.target = QualityLevels();
+    m_status.lastDirection = 0;
+    m_windowFrames = 0;
+    m_phaseSumMs.fill(0.0);
+    m_latenessSumMs = 0.0;
+    m_quietWindows = 0;
+    m_secondsSinceLower = RAISE_COOLDOWN_SECONDS;
+    m_settling = false;
+}
+
+bool QualityGovernor::Observe(const FrameSample& sample, float latenessMs, float deltaTime) {
+    Ramp(deltaTime);
+    m_secondsSinceLower += deltaTime;
+
+    float busyMs = 0.0f;
+    for (size_t i = 0; i < PROFILE_PHASE_COUNT; ++i) {
+        m_phaseSumMs[i] += sample.phaseMs[i];
+        if (i != static_cast<size_t>(ProfilePhase::Wait) && i != static_cast<size_t>(ProfilePhase::Present)) {
+            busyMs += sample.phaseMs[i];
+        }
+    }
+    m_busyMs[m_windowFrames++] = busyMs;
+    m_latenessSumMs += latenessMs;
+
+    if (m_windowFrames < WINDOW_FRAMES) return false;
+
+    bool changed = Evaluate();
+    m_windowFrames = 0;
+    m_phaseSumMs.fill(0.0);
+    m_latenessSumMs = 0.0;
+    return changed;
+}
+
+bool QualityGovernor::Evaluate() {
+    std::array<float, WINDOW_FRAMES> sorted = m_busyMs;
+    size_t p90 = (WINDOW_FRAMES * 9) / 10;
+    std::nth_element(sorted.begin(), sorted.begin() + p90, sorted.end());
+    m_status.loadMs = sorted[p90];
+    m_status.latenessMs = static_cast<float>(m_latenessSumMs / WINDOW_FRAMES);
+
+    if (m_settling) {
+        m_settling = false;
+        return false;
+    }
+
+    float budget = m_status.budgetMs;
+    bool late = m_status.latenessMs > budget * LATE_FRACTION;
+    if (m_status.loadMs > budget * HIGH_WATER || late) {
+        m_quietWindows = 0;
+        return Lower();
+    }
+
+    if (m_status.loadMs < budget * LOW_WATER && m_status.latenessMs < budget * 0.05f) {
+        if (++m_quietWindows >= RAISE_WINDOWS && m_secondsSinceLower >= RAISE_COOLDOWN_SECONDS) {
+            m_quietWindows = 0;
+            return Raise();
+        }
+    } else {
+        m_quietWindows = 0;
+    }
+    return false;
+}
+
+bool QualityGovernor::Lower() {
+    // Attribute the window's cost to the knob that drives it
+    float drawMs = PhaseMs(m_phaseSumMs, ProfilePhase::BatchBuild) + PhaseMs(m_phaseSumMs, ProfilePhase::Draw);
+    std::array<float, QUALITY_KNOB_COUNT> cost = {
+        drawMs,
+        PhaseMs(m_phaseSumMs, ProfilePhase::Effects),
+        PhaseMs(m_phaseSumMs, ProfilePhase::UpdateColumns) + PhaseMs(m_phaseSumMs, ProfilePhase::UpdateGrid),
+    };
+
+    // Highest cost wins; on ties the earlier (less visible) knob goes first
+    size_t chosen = QUALITY_KNOB_COUNT;
+    for (size_t i = 0; i < QUALITY_KNOB_COUNT; ++i) {
+        if (!m_available[i] || m_status.target.values[i] <= FLOOR[i]) continue;
+        if (chosen == QUALITY_KNOB_COUNT || cost[i] > cost[chosen]) {
+            chosen = i;
+        }
+    }
+    if (chosen == QUALITY_KNOB_COUNT) return false;
+
+    float& target = m_status.target.values[chosen];
+    target = std::max(target - STEP[chosen], FLOOR[chosen]);
+
+    m_status.lastDirection = -1;
+    m_status.lastKnob = static_cast<QualityKnob>(chosen);
+    m_status.decisions++;
+    m_secondsSinceLower = 0.0f;
+    m_settling = true;
+    return true;
+}
+
+bool QualityGovernor::Raise() {
+    // Most visible first: columns, then effects, then glow
+    for (size_t i = QUALITY_KNOB_COUNT; i-- > 0;) {
+        float& target = m_status.target.values[i];
+        if (!m_available[i] || target >= 1.0f) continue;
+
+        target = std::min(target + STEP[i], 1.0f);
+        m_status.lastDirection = 1;
+        m_status.lastKnob = static_cast<QualityKnob>(i);
+        m_status.decisions++;
+        return true;
+    }
+    return false;
+}
+
+void QualityGovernor::Ramp(float deltaTime) {
+    float step = RAMP_PER_SECOND * std::clamp(deltaTime, 0.0f, 0.1f);
+    for (size_t i = 0; i < QUALITY_KNOB_COUNT; ++i) {
+        float& current = m_status.current.values[i];
+        float target = m_status.target.values[i];
+        current = current < target ? std::min(current + step, target) : std::max(current - step, target);
+    }
+}
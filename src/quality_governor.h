@@ -0,0 +1,99 @@
+#pragma once
+
+#include "frame_profiler.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// What the governor can turn down, in the order it prefers to give them up
+enum class QualityKnob : uint8_t {
+    Glow,           // Phosphor glow pass
+    Effects,        // Morph/glitch probabilities and per-cell effect update rate
+    Columns,        // Share of columns dropping rain
+    Count
+};
+
+constexpr size_t QUALITY_KNOB_COUNT = static_cast<size_t>(QualityKnob::Count);
+
+const char* GetQualityKnobName(QualityKnob knob);
+
+// One value per knob, 1 = full quality
+struct QualityLevels {
+    std::array<float, QUALITY_KNOB_COUNT> values = { 1.0f, 1.0f, 1.0f };
+
+    float Get(QualityKnob knob) const { return values[static_cast<size_t>(knob)]; }
+    float& Get(QualityKnob knob) { return values[static_cast<size_t>(knob)]; }
+};
+
+struct QualityGovernorStatus {
+    QualityLevels current;              // Ramped values in use this frame
+    QualityLevels target;               // Where the ramp is heading
+    float budgetMs = 0.0f;              // One frame at the target rate
+    float loadMs = 0.0f;                // p90 busy time over the last window
+    float latenessMs = 0.0f;            // Mean pacer lateness over the last window
+    int lastDirection = 0;              // -1 lowered, +1 raised, 0 no decision yet
+    QualityKnob lastKnob = QualityKnob::Glow;
+    uint64_t decisions = 0;
+};
+
+// Feedback controller that trades visual quality for frame time.
+//
+// Every completed frame is fed in with its per-phase times and the pacer's
+// lateness. Once per window the governor compares the p90 busy time (all
+// phases except Wait and Present, which block on the display) with the frame
+// budget. Above HIGH_WATER of the budget, or with frames starting late, it
+// lowers one knob by a step, choosing the one tied to the most expensive
+// phases: glow for drawing, effects for the Effects phase, columns for the
+// column and grid updates. Quality comes back one step at a time, most
+// visible knob first, only after several consecutive windows below
+// LOW_WATER and a cooldown since the last cut, so the two thresholds and the
+// cooldown keep it from oscillating. Knob values ramp towards their targets
+// rather than jumping, which keeps changes from being noticeable.
+class QualityGovernor {
+public:
+    static constexpr size_t WINDOW_FRAMES = 30;
+    static constexpr float HIGH_WATER = 0.85f;
+    static constexpr float LOW_WATER = 0.60f;
+    static constexpr float LATE_FRACTION = 0.25f;       // Mean lateness, as a share of the budget, that counts as overload
+    static constexpr int RAISE_WINDOWS = 4;             // Quiet windows needed before raising
+    static constexpr float RAISE_COOLDOWN_SECONDS = 5.0f;
+    static constexpr float RAMP_PER_SECOND = 0.5f;
+
+    QualityGovernor();
+
+    void SetTargetRate(double rate);
+
+    // Knobs whose feature is switched off are never chosen and stay at full
+    void SetKnobAvailable(QualityKnob knob, bool available);
+
+    // Feed one completed frame; true when a knob target changed
+    bool Observe(const FrameSample& sample, float latenessMs, float deltaTime);
+
+    // Back to full quality, e.g. after settings change
+    void Reset();
+
+    const QualityLevels& GetLevels() const { return m_status.current; }
+    const QualityGovernorStatus& GetStatus() const { return m_status; }
+
+private:
+    static constexpr std::array<float, QUALITY_KNOB_COUNT> STEP = { 0.25f, 0.25f, 0.1f };
+    static constexpr std::array<float, QUALITY_KNOB_COUNT> FLOOR = { 0.0f, 0.0f, 0.4f };
+
+    bool Evaluate();
+    bool Lower();
+    bool Raise();
+    void Ramp(float deltaTime);
+
+    QualityGovernorStatus m_status;
+    std::array<bool, QUALITY_KNOB_COUNT> m_available = { true, true, true };
+
+    // Current window
+    std::array<float, WINDOW_FRAMES> m_busyMs = {};
+    std::array<double, PROFILE_PHASE_COUNT> m_phaseSumMs = {};
+    double m_latenessSumMs = 0.0;
+    size_t m_windowFrames = 0;
+
+    int m_quietWindows = 0;
+    float m_secondsSinceLower = RAISE_COOLDOWN_SECONDS;
+    bool m_settling = false;            // Skip one window after a cut while the ramp lands
+};
@@ -0,0 +1,322 @@
+#include "quality_presets.h"
+#include "settings_schema.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+constexpr QualityPresetInfo PRESETS[QUALITY_PRESET_COUNT] = {
+    { QualityPreset::LowPower,   L"low-power",   L"Low power" },
+    { QualityPreset::Balanced,   L"balanced",    L"Balanced" },
+    { QualityPreset::FourKWall,  L"4k-wall",     L"4K wall" },
+    { QualityPreset::MaxEffects, L"max-effects", L"Max effects" },
+};
+
+constexpr std::wstring_view AUTO_PRESET = L"auto";
+constexpr float DEFAULT_FRAME_BUDGET_MS = 1000.0f / 60.0f;
+
+// Older sessions stop counting once a preset has this many newer ones, so
+// driver and hardware changes wash out
+constexpr size_t MAX_TIMINGS_PER_PRESET = 32;
+
+constexpr std::string_view TIMINGS_HEADER = "preset,width,height,frame_ms\n";
+
+// Preset names are ASCII
+std::string Narrow(std::wstring_view text) {
+    std::string out;
+    for (wchar_t c : text) {
+        out.push_back(static_cast<char>(c));
+    }
+    return out;
+}
+
+bool ParseField(std::string_view& line, std::string_view& field) {
+    if (line.empty()) return false;
+    size_t comma = line.find(',');
+    field = line.substr(0, comma);
+    line = comma == std::string_view::npos ? std::string_view() : line.substr(comma + 1);
+    return !field.empty();
+}
+
+template <typename T>
+bool ParseNumber(std::string_view field, T& value) {
+    auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+    return result.ec == std::errc() && result.ptr == field.data() + field.size();
+}
+
+PresetCost FitLine(const std::vector<const PresetTiming*>& timings) {
+    PresetCost cost;
+    if (timings.empty()) return cost;
+
+    double count = static_cast<double>(timings.size());
+    double meanX = 0.0;
+    double meanY = 0.0;
+    for (const PresetTiming* timing : timings) {
+        meanX += timing->width * static_cast<double>(timing->height) / 1.0e6 / count;
+        meanY += timing->frameMs / count;
+    }
+    double covariance = 0.0;
+    double variance = 0.0;
+    double sumXY = 0.0;
+    double sumXX = 0.0;
+    for (const PresetTiming* timing : timings) {
+        double x = timing->width * static_cast<double>(timing->height) / 1.0e6;
+        covariance += (x - meanX) * (timing->frameMs - meanY);
+        variance += (x - meanX) * (x - meanX);
+        sumXY += x * timing->frameMs;
+        sumXX += x * x;
+    }
+
+    // One screen size, or a line that would start below zero: through the origin
+    double fixed = 0.0;
+    double slope = sumXX > 0.0 ? sumXY / sumXX : 0.0;
+    if (variance > 1e-9 && meanY - covariance / variance * meanX >= 0.0) {
+        slope = covariance / variance;
+        fixed = meanY - slope * meanX;
+    }
+
+    cost.fixedMs = static_cast<float>(fixed);
+    cost.msPerMegapixel = static_cast<float>(std::max(0.0, slope));
+    cost.samples = static_cast<uint32_t>(timings.size());
+    return cost;
+}
+
+} // namespace
+
+const QualityPresetInfo& GetQualityPresetInfo(QualityPreset preset) {
+    return PRESETS[static_cast<size_t>(preset)];
+}
+
+bool FindQualityPreset(std::wstring_view name, QualityPreset& preset) {
+    for (const QualityPresetInfo& info : PRESETS) {
+        if (name == info.name) {
+            preset = info.preset;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ApplyQualityPreset(QualityPreset preset, MatrixSettings& settings) {
+    // Start from the lean end and add to it, so each preset lists what it changes
+    settings.density = 0.5f;
+    settings.fontSize = 18.0f;
+    settings.enableFrameRateLimiting = true;
+    settings.targetFrameRate = 30;
+    settings.enableQualityGovernor = true;
+    settings.enableCharacterMorphing = false;
+    settings.enablePhosphorGlow = false;
+    settings.enableGlitchEffects = false;
+    settings.enableRainVariations = false;
+    settings.enableSystemDisruptions = false;
+    settings.enableMotionBlur = false;
+    settings.enableParticleEffects = false;
+    settings.enableHighQualityText = false;
+    settings.enableAntiAliasing = false;
+
+    switch (preset) {
+        case QualityPreset::LowPower:
+            break;
+
+        case QualityPreset::Balanced:
+            settings.density = 0.8f;
+            settings.fontSize = 14.0f;
+            settings.targetFrameRate = 60;
+            settings.enablePhosphorGlow = true;
+            settings.glowIntensity = 0.3f;
+            settings.enableRainVariations = true;
+            break;
+
+        // Large text keeps the cell count of a wall of screens in check
+        case QualityPreset::FourKWall:
+            settings.density = 1.0f;
+            settings.fontSize = 20.0f;
+            settings.targetFrameRate = 60;
+            settings.enablePhosphorGlow = true;
+            settings.glowIntensity = 0.3f;
+            settings.enableCharacterMorphing = true;
+            settings.morphFrequency = 0.1f;
+            settings.enableRainVariations = true;
+            settings.enableHighQualityText = true;
+            settings.enableAntiAliasing = true;
+            break;
+
+        case QualityPreset::MaxEffects:
+            settings.density = 2.0f;
+            settings.fontSize = 12.0f;
+            settings.enableFrameRateLimiting = false;
+            settings.targetFrameRate = 60;
+            settings.enableQualityGovernor = false;
+            settings.enablePhosphorGlow = true;
+            settings.glowIntensity = 0.5f;
+            settings.enableCharacterMorphing = true;
+            settings.morphFrequency = 0.2f;
+            settings.enableGlitchEffects = true;
+            settings.glitchFrequency = 0.05f;
+            settings.enableRainVariations = true;
+            settings.enableSystemDisruptions = true;
+            settings.enableHighQualityText = true;
+            settings.enableAntiAliasing = true;
+            break;
+    }
+}
+
+bool MatchQualityPreset(const MatrixSettings& settings, QualityPreset& preset) {
+    for (const QualityPresetInfo& info : PRESETS) {
+        MatrixSettings applied = settings;
+        ApplyQualityPreset(info.preset, applied);
+        if (DiffSettings(settings, applied).empty()) {
+            preset = info.preset;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IsAutoQualityPreset(QualityPreset preset) {
+    MatrixSettings settings;
+    ApplyQualityPreset(preset, settings);
+    return settings.enableFrameRateLimiting && settings.enableQualityGovernor;
+}
+
+std::string FormatPresetTiming(const PresetTiming& timing) {
+    char ms[32];
+    std::snprintf(ms, sizeof(ms), "%.3f", timing.frameMs);
+    return Narrow(GetQualityPresetInfo(timing.preset).name) + "," + std::to_string(timing.width) + "," +
+           std::to_string(timing.height) + "," + ms + "\n";
+}
+
+bool ParsePresetTiming(std::string_view line, PresetTiming& timing) {
+    while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) {
+        line.remove_suffix(1);
+    }
+
+    std::string_view name, width, height, ms;
+    if (!ParseField(line, name) || !ParseField(line, width) || !ParseField(line, height) ||
+        !ParseField(line, ms) || !line.empty()) {
+        return false;
+    }
+
+    PresetTiming parsed;
+    bool found = false;
+    for (const QualityPresetInfo& info : PRESETS) {
+        if (name == Narrow(info.name)) {
+            parsed.preset = info.preset;
+            found = true;
+        }
+    }
+    if (!found || !ParseNumber(width, parsed.width) || !ParseNumber(height, parsed.height) ||
+        !ParseNumber(ms, parsed.frameMs)) {
+        return false;
+    }
+    if (parsed.width <= 0 || parsed.height <= 0 || !(parsed.frameMs > 0.0f)) return false;
+
+    timing = parsed;
+    return true;
+}
+
+std::vector<PresetTiming> LoadPresetTimings(const std::filesystem::path& path) {
+    std::vector<PresetTiming> timings;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        PresetTiming timing;
+        if (ParsePresetTiming(line, timing)) {
+            timings.push_back(timing);
+        }
+    }
+    return timings;
+}
+
+bool AppendPresetTiming(const std::filesystem::path& path, const PresetTiming& timing) {
+    std::error_code error;
+    bool exists = std::filesystem::exists(path, error);
+
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    if (!file) return false;
+    if (!exists) {
+        file << TIMINGS_HEADER;
+    }
+    file << FormatPresetTiming(timing);
+    return static_cast<bool>(file);
+}
+
+PresetCosts FitPresetCosts(const std::vector<PresetTiming>& timings) {
+    PresetCosts costs;
+    for (const QualityPresetInfo& info : PRESETS) {
+        std::vector<const PresetTiming*> recent;
+        for (auto it = timings.rbegin(); it != timings.rend() && recent.size() < MAX_TIMINGS_PER_PRESET; ++it) {
+            if (it->preset == info.preset) {
+                recent.push_back(&*it);
+            }
+        }
+        costs[static_cast<size_t>(info.preset)] = FitLine(recent);
+    }
+    return costs;
+}
+
+QualityPreset ChooseQualityPreset(int width, int height, float budgetMs, const PresetCosts& costs) {
+    QualityPreset chosen = QualityPreset::LowPower;
+    bool overBudget = false;
+    for (const QualityPresetInfo& info : PRESETS) {
+        if (!IsAutoQualityPreset(info.preset)) continue;
+
+        const PresetCost& cost = costs[static_cast<size_t>(info.preset)];
+        if (!cost.IsCalibrated()) {
+            // Try it only when everything measured below it fits
+            if (!overBudget) {
+                chosen = info.preset;
+            }
+            break;
+        }
+        if (cost.Predict(width, height) <= budgetMs) {
+            chosen = info.preset;
+        } else {
+            overBudget = true;
+        }
+    }
+    return chosen;
+}
+
+float GetQualityFrameBudget(const MatrixSettings& settings) {
+    if (settings.frameBudgetMs > 0.0f) return settings.frameBudgetMs;
+    return DEFAULT_FRAME_BUDGET_MS;
+}
+
+bool ResolveQualityPreset(MatrixSettings& settings, int width, int height, const PresetCosts& costs) {
+    QualityPreset preset;
+    if (settings.qualityPreset == AUTO_PRESET) {
+        preset = ChooseQualityPreset(width, height, GetQualityFrameBudget(settings), costs);
+    } else if (!FindQualityPreset(settings.qualityPreset, preset)) {
+        return false;
+    }
+
+    ApplyQualityPreset(preset, settings);
+    return true;
+}
+
+void PresetTimingSampler::Reset() {
+    m_seen = 0;
+    m_count = 0;
+    m_next = 0;
+}
+
+void PresetTimingSampler::AddFrame(float frameMs, bool fullQuality) {
+    if (++m_seen <= WARMUP_FRAMES || !fullQuality || !(frameMs > 0.0f)) return;
+
+    m_frames[m_next] = frameMs;
+    m_next = (m_next + 1) % CAPACITY;
+    m_count = std::min(m_count + 1, CAPACITY);
+}
+
+bool PresetTimingSampler::GetMedian(float& frameMs) const {
+    if (m_count < MIN_FRAMES) return false;
+
+    std::vector<float> frames(m_frames.begin(), m_frames.begin() + m_count);
+    auto middle = frames.begin() + frames.size() / 2;
+    std::nth_element(frames.begin(), middle, frames.end());
+    frameMs = *middle;
+    return true;
+}
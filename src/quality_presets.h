@@ -0,0 +1,119 @@
+#pragma once
+
+#include "sim_types.h"
+#include <array>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Named bundles of the settings that decide what a frame costs (density,
+// font size, effects, frame rate), so a machine can be configured by
+// choosing one instead of combining toggles. A preset only touches those
+// settings; colors, fonts, words and masks are left alone.
+//
+// Costs are measured on the machine itself. A session running a preset
+// records its median full frame time (simulation, draw and present on every
+// output, without the pacer wait) to preset_timings.csv in the data
+// directory, and each preset's cost model, fixedMs + msPerMegapixel * screen
+// megapixels, is fitted from its rows. A preset with no rows is uncalibrated
+// and has no prediction.
+//
+// Presets are in order of richness. "auto" only picks presets that keep the
+// frame rate limiter and the quality governor on: the richest calibrated one
+// whose predicted cost fits the frame budget, or the next one up when it has
+// not been measured yet, so the governor guards the session that calibrates
+// it. With nothing calibrated that is LowPower.
+enum class QualityPreset : uint8_t {
+    LowPower,
+    Balanced,
+    FourKWall,
+    MaxEffects
+};
+
+constexpr size_t QUALITY_PRESET_COUNT = 4;
+
+constexpr const wchar_t* PRESET_TIMINGS_FILE = L"preset_timings.csv";
+
+struct PresetCost {
+    float fixedMs = 0.0f;
+    float msPerMegapixel = 0.0f;
+    uint32_t samples = 0;           // Timings the fit came from
+
+    bool IsCalibrated() const { return samples > 0; }
+
+    float Predict(int width, int height) const {
+        return fixedMs + msPerMegapixel * (static_cast<float>(width) * static_cast<float>(height) / 1.0e6f);
+    }
+};
+
+using PresetCosts = std::array<PresetCost, QUALITY_PRESET_COUNT>;
+
+struct QualityPresetInfo {
+    QualityPreset preset;
+    const wchar_t* name;            // As written in the QualityPreset setting
+    const wchar_t* displayName;
+};
+
+// One session's median frame time, a row of the timings file
+struct PresetTiming {
+    QualityPreset preset = QualityPreset::LowPower;
+    int width = 0;
+    int height = 0;
+    float frameMs = 0.0f;
+};
+
+const QualityPresetInfo& GetQualityPresetInfo(QualityPreset preset);
+bool FindQualityPreset(std::wstring_view name, QualityPreset& preset);
+void ApplyQualityPreset(QualityPreset preset, MatrixSettings& settings);
+
+// The preset whose values settings hold, if any
+bool MatchQualityPreset(const MatrixSettings& settings, QualityPreset& preset);
+
+// Presets that keep the frame rate limiter and the quality governor on; the
+// only ones "auto" considers
+bool IsAutoQualityPreset(QualityPreset preset);
+
+// "balanced,1920,1080,7.250"; lines that do not parse (the header, a torn
+// final write) are skipped on load
+std::string FormatPresetTiming(const PresetTiming& timing);
+bool ParsePresetTiming(std::string_view line, PresetTiming& timing);
+std::vector<PresetTiming> LoadPresetTimings(const std::filesystem::path& path);
+bool AppendPresetTiming(const std::filesystem::path& path, const PresetTiming& timing);
+
+// Least squares over each preset's most recent timings. Timings at a single
+// screen size give a line through the origin.
+PresetCosts FitPresetCosts(const std::vector<PresetTiming>& timings);
+
+// The preset "auto" picks for a screen and budget, as described above
+QualityPreset ChooseQualityPreset(int width, int height, float budgetMs, const PresetCosts& costs);
+
+// The budget "auto" uses: FrameBudgetMs, or a 60 Hz frame when it is 0. Not
+// the target frame rate, which the chosen preset sets.
+float GetQualityFrameBudget(const MatrixSettings& settings);
+
+// Apply settings.qualityPreset (a name or "auto") over settings; false if it
+// is empty or unknown, leaving settings as they are
+bool ResolveQualityPreset(MatrixSettings& settings, int width, int height, const PresetCosts& costs);
+
+// Frame times of one session at one preset and screen size. Frames are only
+// kept while the governor has nothing cut, so they cost what the preset does.
+class PresetTimingSampler {
+public:
+    static constexpr size_t CAPACITY = 1024;        // Most recent frames kept
+    static constexpr size_t WARMUP_FRAMES = 120;    // Skipped while caches and the first layout settle
+    static constexpr size_t MIN_FRAMES = 60;        // Fewer is not worth recording
+
+    void Reset();
+    void AddFrame(float frameMs, bool fullQuality);
+
+    // Median of the kept frames; false until there are MIN_FRAMES
+    bool GetMedian(float& frameMs) const;
+
+private:
+    std::array<float, CAPACITY> m_frames = {};
+    size_t m_seen = 0;
+    size_t m_count = 0;
+    size_t m_next = 0;
+};
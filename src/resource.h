@@ -62,3 +62,7 @@
 #define IDC_ADVANCED_GROUP            1051
 #define IDC_QUALITY_GROUP             1052
 #define IDC_VISUAL_ENHANCEMENT_GROUP  1053
+
+// Quality preset controls
+#define IDC_PRESET_COMBO              1054
+#define IDC_PRESET_COST               1055
@@ -1,7 +1,13 @@
 #pragma once
 
 #include "common.h"
+#include "settings_store.h"
+#include "quality_presets.h"
 
+// Loads and saves MatrixSettings. The registry is the default store; when a
+// settings file exists (MATRIX_SETTINGS_FILE, else settings.ini in the data
+// directory) it is read instead, and saving writes both. A QualityPreset
+// setting is applied over the loaded values (see quality_presets.h).
 class SettingsManager {
 public:
     SettingsManager();
@@ -10,16 +16,19 @@ public:
     MatrixSettings LoadSettings();
     void SaveSettings(const MatrixSettings& settings);
 
+    bool IsUsingSettingsFile() const { return m_store != nullptr; }
+    const std::filesystem::path& GetSettingsFilePath() const { return m_filePath; }
+
+    // Preset costs fitted from this machine's preset_timings.csv
+    PresetCosts LoadPresetCosts() const;
+
 private:
     static constexpr const wchar_t* REGISTRY_KEY = L"SOFTWARE\\MatrixScreensaver";
-    
-    std::wstring ReadString(HKEY hKey, const wchar_t* valueName, const wchar_t* defaultValue);
-    DWORD ReadDword(HKEY hKey, const wchar_t* valueName, DWORD defaultValue);
-    float ReadFloat(HKEY hKey, const wchar_t* valueName, float defaultValue);
-    bool ReadBool(HKEY hKey, const wchar_t* valueName, bool defaultValue);
-    
-    void WriteString(HKEY hKey, const wchar_t* valueName, const std::wstring& value);
-    void WriteDword(HKEY hKey, const wchar_t* valueName, DWORD value);
-    void WriteFloat(HKEY hKey, const wchar_t* valueName, float value);
-    void WriteBool(HKEY hKey, const wchar_t* valueName, bool value);
-};
\ No newline at end of file
+
+    MatrixSettings LoadFromRegistry();
+    void ResolvePreset(MatrixSettings& settings);   // Applies settings.qualityPreset, if any
+    void SaveToRegistry(const MatrixSettings& settings);
+
+    std::filesystem::path m_filePath;
+    std::unique_ptr<SettingsStore> m_store;     // Set when the settings file exists
+};
@@ -0,0 +1,80 @@
+#include "settings_schema.h"
+#include <cstring>
+#include <type_traits>
+
+namespace {
+
+class SettingsDiff {
+public:
+    explicit SettingsDiff(std::vector<const char*>* changed) : m_changed(changed) {}
+
+    template<typename D, typename T>
+    void Field(const char* name, const D&, SettingsInvalidation invalidation, const T& before, const T& after) {
+        if (!(before == after)) {
+            if (m_changed) m_changed->push_back(name);
+            m_classes = m_classes | invalidation;
+        }
+    }
+
+    SettingsInvalidation GetClasses() const { return m_classes; }
+
+private:
+    std::vector<const char*>* m_changed;
+    SettingsInvalidation m_classes = SettingsInvalidation::None;
+};
+
+class SchemaHasher {
+public:
+    template<typename D, typename T>
+    void Field(const char* name, const D&, SettingsInvalidation, const T&) {
+        Mix(name, std::strlen(name));
+        uint8_t type = TypeCode<T>();
+        Mix(&type, 1);
+    }
+
+    uint64_t GetHash() const { return m_hash; }
+
+private:
+    template<typename T>
+    static uint8_t TypeCode() {
+        if constexpr (std::is_same_v<T, bool>) return 1;
+        else if constexpr (std::is_same_v<T, int>) return 2;
+        else if constexpr (std::is_same_v<T, float>) return 3;
+        else if constexpr (std::is_same_v<T, std::wstring>) return 4;
+        else return 5;
+    }
+
+    void Mix(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            m_hash = (m_hash ^ bytes[i]) * 0x100000001B3ull;
+        }
+    }
+
+    uint64_t m_hash = 0xCBF29CE484222325ull;
+};
+
+} // namespace
+
+std::vector<const char*> DiffSettings(const MatrixSettings& before, const MatrixSettings& after) {
+    std::vector<const char*> changed;
+    SettingsDiff diff(&changed);
+    VisitStoredSettings(diff, before, after);
+    return changed;
+}
+
+SettingsInvalidation ClassifySettingsChange(const MatrixSettings& before, const MatrixSettings& after) {
+    SettingsDiff diff(nullptr);
+    VisitStoredSettings(diff, before, after);
+    return diff.GetClasses();
+}
+
+uint64_t GetSettingsSchemaHash() {
+    static const uint64_t hash = [] {
+        MatrixSettings settings;
+        SchemaHasher hasher;
+        VisitStoredSettings(hasher, settings);
+        return hasher.GetHash();
+    }();
+    return hash;
+}
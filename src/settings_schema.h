@@ -0,0 +1,126 @@
+#pragma once
+
+#include "sim_types.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// What a change to a setting invalidates. Whoever applies new settings
+// rebuilds only the classes ClassifySettingsChange reports, so changing the
+// hue recolors the rain instead of restarting it.
+enum class SettingsInvalidation : uint32_t {
+    None    = 0,
+    Palette = 1 << 0,   // Colors and opacities, read when drawing
+    Effects = 1 << 1,   // Effect switches and rates, read every update
+    Glyphs  = 1 << 2,   // Character pools and the custom word
+    Layout  = 1 << 3,   // Column spacing and grid cells; the rain restarts
+    Font    = 1 << 4,   // Text formats
+    Mask    = 1 << 5,   // Mask image, its bitmap and the depth map
+    Runtime = 1 << 6,   // Pacing, pipeline and diagnostics switches
+    All     = (1 << 7) - 1
+};
+
+constexpr SettingsInvalidation operator|(SettingsInvalidation a, SettingsInvalidation b) {
+    return static_cast<SettingsInvalidation>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+}
+
+constexpr bool HasAny(SettingsInvalidation changes, SettingsInvalidation classes) {
+    return (static_cast<uint32_t>(changes) & static_cast<uint32_t>(classes)) != 0;
+}
+
+// Every persisted setting: the name it is stored under, the value a store
+// that lacks it falls back to, what changing it invalidates, and the
+// MatrixSettings field. The registry, the text and binary settings files
+// and the settings diffs all walk this one list, so a new setting is added
+// here once.
+//
+// The visitor gets Field(name, defaultValue, invalidation, field...) with
+// one field per settings object passed in (one to load or save, two to
+// compare). Append
+// new settings at the end; the binary snapshot is rebuilt when the list
+// changes (see GetSettingsSchemaHash).
+template<typename Visitor, typename... Settings>
+void VisitStoredSettings(Visitor& visitor, Settings&... s) {
+    visitor.Field("Speed", 5.0f, SettingsInvalidation::Effects, s.speed...);
+    visitor.Field("Density", 0.6f, SettingsInvalidation::Layout, s.density...);
+    visitor.Field("MessageSpeed", 3.0f, SettingsInvalidation::Effects, s.messageSpeed...);
+    visitor.Field("FontSize", 14.0f, SettingsInvalidation::Layout | SettingsInvalidation::Font, s.fontSize...);
+    visitor.Field("Hue", 120.0f, SettingsInvalidation::Palette, s.hue...);
+    visitor.Field("RandomizeMessages", true, SettingsInvalidation::Effects, s.randomizeMessages...);
+    visitor.Field("BoldFont", true, SettingsInvalidation::Font, s.boldFont...);
+    visitor.Field("FontName", L"Consolas", SettingsInvalidation::Font, s.fontName...);
+    visitor.Field("CustomWord", L"MATRIX", SettingsInvalidation::Glyphs, s.customWord...);
+    visitor.Field("UseCustomWord", false, SettingsInvalidation::Glyphs, s.useCustomWord...);
+    visitor.Field("SequentialCharacters", true, SettingsInvalidation::Glyphs, s.sequentialCharacters...);
+    visitor.Field("ShowMaskBackground", false, SettingsInvalidation::Palette, s.showMaskBackground...);
+    visitor.Field("WhiteHeadCharacters", true, SettingsInvalidation::Palette, s.whiteHeadCharacters...);
+    visitor.Field("Enable3DEffect", true, SettingsInvalidation::Effects, s.enable3DEffect...);
+    visitor.Field("VariableFontSize", true, SettingsInvalidation::Effects, s.variableFontSize...);
+    visitor.Field("MaskBackgroundOpacity", 0.3f, SettingsInvalidation::Palette, s.maskBackgroundOpacity...);
+    visitor.Field("DepthRange", 5.0f, SettingsInvalidation::Effects, s.depthRange...);
+    visitor.Field("FadeRate", 2.0f, SettingsInvalidation::Effects, s.fadeRate...);
+    visitor.Field("MaskImagePath", L"", SettingsInvalidation::Mask, s.maskImagePath...);
+    visitor.Field("UseMask", false, SettingsInvalidation::Effects, s.useMask...);
+
+    // Performance optimization features (default OFF)
+    visitor.Field("EnableBatchRendering", false, SettingsInvalidation::Runtime, s.enableBatchRendering...);
+    visitor.Field("EnableFrameRateLimiting", false, SettingsInvalidation::Runtime, s.enableFrameRateLimiting...);
+    visitor.Field("TargetFrameRate", 60, SettingsInvalidation::Runtime, s.targetFrameRate...);
+    visitor.Field("EnableAdaptiveVSync", false, SettingsInvalidation::Runtime, s.enableAdaptiveVSync...);
+    visitor.Field("ShowPerformanceMetrics", false, SettingsInvalidation::Runtime, s.showPerformanceMetrics...);
+    visitor.Field("ProfileWindowFrames", 120, SettingsInvalidation::Runtime, s.profileWindowFrames...);
+    visitor.Field("EnableFrameTrace", false, SettingsInvalidation::Runtime, s.enableFrameTrace...);
+    visitor.Field("FrameTraceMaxFrames", 36000, SettingsInvalidation::Runtime, s.frameTraceMaxFrames...);
+    visitor.Field("EnableCountersEndpoint", false, SettingsInvalidation::Runtime, s.enableCountersEndpoint...);
+    visitor.Field("EnableCountersSocket", false, SettingsInvalidation::Runtime, s.enableCountersSocket...);
+    visitor.Field("EnableSimCapture", false, SettingsInvalidation::Runtime, s.enableSimCapture...);
+    visitor.Field("EnableQualityGovernor", false, SettingsInvalidation::Runtime, s.enableQualityGovernor...);
+    visitor.Field("EnableSimulationThread", true, SettingsInvalidation::Runtime, s.enableSimulationThread...);
+    visitor.Field("EnableDirtyRectangles", false, SettingsInvalidation::Runtime, s.enableDirtyRectangles...);
+    visitor.Field("EnableWarmStart", true, SettingsInvalidation::Runtime, s.enableWarmStart...);
+    visitor.Field("StartupFastForward", 3.0f, SettingsInvalidation::Runtime, s.startupFastForward...);
+
+    // The fields a preset sets carry their own classes; the preset itself
+    // only decides whether frames are timed for it
+    visitor.Field("QualityPreset", L"", SettingsInvalidation::Runtime, s.qualityPreset...);
+    visitor.Field("FrameBudgetMs", 0.0f, SettingsInvalidation::None, s.frameBudgetMs...);
+
+    // Advanced features (default OFF)
+    visitor.Field("EnableLogging", false, SettingsInvalidation::Runtime, s.enableLogging...);
+    visitor.Field("BinaryLogging", false, SettingsInvalidation::Runtime, s.binaryLogging...);
+    visitor.Field("EnableMotionBlur", false, SettingsInvalidation::Effects, s.enableMotionBlur...);
+    visitor.Field("EnableParticleEffects", false, SettingsInvalidation::Effects, s.enableParticleEffects...);
+    visitor.Field("EnableAudioVisualization", false, SettingsInvalidation::Effects, s.enableAudioVisualization...);
+
+    // Quality settings (default OFF)
+    visitor.Field("EnableHighQualityText", false, SettingsInvalidation::Font, s.enableHighQualityText...);
+    visitor.Field("EnableAntiAliasing", false, SettingsInvalidation::Font, s.enableAntiAliasing...);
+
+    // Visual enhancement features
+    visitor.Field("EnableCharacterMorphing", true, SettingsInvalidation::Effects, s.enableCharacterMorphing...);
+    visitor.Field("EnablePhosphorGlow", true, SettingsInvalidation::Effects, s.enablePhosphorGlow...);
+    visitor.Field("EnableGlitchEffects", false, SettingsInvalidation::Effects, s.enableGlitchEffects...);
+    visitor.Field("EnableRainVariations", true, SettingsInvalidation::Effects, s.enableRainVariations...);
+    visitor.Field("EnableSystemDisruptions", false, SettingsInvalidation::Effects, s.enableSystemDisruptions...);
+    visitor.Field("EnableMotionReduction", false, SettingsInvalidation::Effects, s.enableMotionReduction...);
+
+    // Enhancement parameters
+    visitor.Field("MorphFrequency", 0.1f, SettingsInvalidation::Effects, s.morphFrequency...);
+    visitor.Field("MorphSpeed", 2.0f, SettingsInvalidation::Effects, s.morphSpeed...);
+    visitor.Field("GlitchFrequency", 0.05f, SettingsInvalidation::Effects, s.glitchFrequency...);
+    visitor.Field("GlowIntensity", 0.3f, SettingsInvalidation::Effects, s.glowIntensity...);
+    visitor.Field("LatinCharProbability", 0.15f, SettingsInvalidation::Glyphs, s.latinCharProbability...);
+    visitor.Field("SymbolCharProbability", 0.05f, SettingsInvalidation::Glyphs, s.symbolCharProbability...);
+    visitor.Field("EnableCharacterVariety", true, SettingsInvalidation::Glyphs, s.enableCharacterVariety...);
+
+    visitor.Field("CustomMessages", std::vector<std::wstring>(), SettingsInvalidation::Effects, s.customMessages...);
+}
+
+// Names of the stored settings that differ between two settings objects
+std::vector<const char*> DiffSettings(const MatrixSettings& before, const MatrixSettings& after);
+
+// Union of the invalidation classes of the settings that differ
+SettingsInvalidation ClassifySettingsChange(const MatrixSettings& before, const MatrixSettings& after);
+
+// FNV-1a over the names and types in VisitStoredSettings
+uint64_t GetSettingsSchemaHash();
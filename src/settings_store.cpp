@@ -0,0 +1,530 @@
+#include "settings_store.h"
+#include "settings_schema.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+namespace {
+
+std::string ToUtf8(const std::wstring& value) {
+    std::string out;
+    out.reserve(value.size());
+    for (size_t i = 0; i < value.size(); ++i) {
+        uint32_t c = static_cast<uint32_t>(value[i]);
+        if constexpr (sizeof(wchar_t) == 2) {
+            if (c >= 0xD800 && c <= 0xDBFF && i + 1 < value.size()) {
+                uint32_t low = static_cast<uint32_t>(value[i + 1]);
+                if (low >= 0xDC00 && low <= 0xDFFF) {
+                    c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                    ++i;
+                }
+            }
+        }
+
+        if (c < 0x80) {
+            out.push_back(static_cast<char>(c));
+        } else if (c < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (c >> 6)));
+            out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+        } else if (c < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (c >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (c >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+        }
+    }
+    return out;
+}
+
+// Invalid sequences become U+FFFD rather than failing the whole value
+std::wstring FromUtf8(std::string_view value) {
+    std::wstring out;
+    out.reserve(value.size());
+    size_t i = 0;
+    while (i < value.size()) {
+        uint8_t lead = static_cast<uint8_t>(value[i]);
+        int length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+        uint32_t c = length == 1 ? lead : length == 2 ? (lead & 0x1F) : length == 3 ? (lead & 0x0F) : (lead & 0x07);
+
+        bool valid = length > 0 && i + length <= value.size();
+        for (int k = 1; valid && k < length; ++k) {
+            uint8_t next = static_cast<uint8_t>(value[i + k]);
+            valid = (next & 0xC0) == 0x80;
+            c = (c << 6) | (next & 0x3F);
+        }
+        if (!valid) {
+            out.push_back(static_cast<wchar_t>(0xFFFD));
+            ++i;
+            continue;
+        }
+        i += length;
+
+        if (sizeof(wchar_t) == 2 && c >= 0x10000) {
+            c -= 0x10000;
+            out.push_back(static_cast<wchar_t>(0xD800 + (c >> 10)));
+            out.push_back(static_cast<wchar_t>(0xDC00 + (c & 0x3FF)));
+        } else {
+            out.push_back(static_cast<wchar_t>(c));
+        }
+    }
+    return out;
+}
+
+std::string_view Trim(std::string_view text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) return {};
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+bool ParseValue(std::string_view text, bool& value) {
+    std::string lower(text);
+    for (char& c : lower) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    if (lower == "true" || lower == "1" || lower == "yes" || lower == "on") {
+        value = true;
+        return true;
+    }
+    if (lower == "false" || lower == "0" || lower == "no" || lower == "off") {
+        value = false;
+        return true;
+    }
+    return false;
+}
+
+template<typename T>
+bool ParseNumber(std::string_view text, T& value) {
+    T parsed{};
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), parsed);
+    if (error != std::errc() || end != text.data() + text.size()) return false;
+    value = parsed;
+    return true;
+}
+
+bool ParseValue(std::string_view text, int& value) { return ParseNumber(text, value); }
+bool ParseValue(std::string_view text, float& value) { return ParseNumber(text, value); }
+
+bool ParseValue(std::string_view text, std::wstring& value) {
+    if (text.empty() || text.front() != '"') {
+        value = FromUtf8(text);
+        return true;
+    }
+
+    std::string unescaped;
+    for (size_t i = 1; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '"') {
+            if (i + 1 != text.size()) return false;
+            value = FromUtf8(unescaped);
+            return true;
+        }
+        if (c == '\\' && i + 1 < text.size()) {
+            c = text[++i];
+        }
+        unescaped.push_back(c);
+    }
+    return false;   // Unterminated
+}
+
+std::string FormatValue(bool value) { return value ? "true" : "false"; }
+std::string FormatValue(int value) { return std::to_string(value); }
+
+std::string FormatValue(float value) {
+    char buffer[32];
+    auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return std::string(buffer, error == std::errc() ? end : buffer);
+}
+
+std::string FormatValue(const std::wstring& value) {
+    std::string out = "\"";
+    for (char c : ToUtf8(value)) {
+        if (c == '"' || c == '\\') out.push_back('\\');
+        out.push_back(c);
+    }
+    out.push_back('"');
+    return out;
+}
+
+struct TextEntry {
+    std::string_view value;
+    size_t line = 0;
+    bool used = false;
+};
+
+class TextReader {
+public:
+    explicit TextReader(std::unordered_map<std::string_view, std::vector<TextEntry>>& entries)
+        : m_entries(entries) {}
+
+    template<typename D, typename T>
+    void Field(const char* name, const D& defaultValue, SettingsInvalidation, T& value) {
+        value = T(defaultValue);
+
+        auto it = m_entries.find(name);
+        if (it == m_entries.end()) return;
+
+        // Last one wins, as when a setting is overridden further down
+        TextEntry& entry = it->second.back();
+        for (TextEntry& other : it->second) {
+            other.used = true;
+        }
+        if (!ParseValue(entry.value, value)) {
+            value = T(defaultValue);
+            Reject(entry.line, "invalid value for " + std::string(name));
+        }
+    }
+
+    template<typename D>
+    void Field(const char* name, const D& defaultValue, SettingsInvalidation, std::vector<std::wstring>& value) {
+        value = defaultValue;
+
+        auto it = m_entries.find(name);
+        if (it == m_entries.end()) return;
+
+        for (TextEntry& entry : it->second) {
+            entry.used = true;
+            std::wstring item;
+            if (!ParseValue(entry.value, item)) {
+                Reject(entry.line, "invalid value for " + std::string(name));
+            } else if (!item.empty()) {
+                value.push_back(std::move(item));
+            }
+        }
+    }
+
+    void Reject(size_t line, std::string message) {
+        m_rejected.emplace_back(line, std::move(message));
+    }
+
+    // In line order, whichever pass found them
+    bool Finish(std::vector<std::string>* errors) {
+        std::stable_sort(m_rejected.begin(), m_rejected.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        if (errors) {
+            for (const auto& [line, message] : m_rejected) {
+                errors->push_back("line " + std::to_string(line) + ": " + message);
+            }
+        }
+        return m_rejected.empty();
+    }
+
+private:
+    std::unordered_map<std::string_view, std::vector<TextEntry>>& m_entries;
+    std::vector<std::pair<size_t, std::string>> m_rejected;
+};
+
+class TextWriter {
+public:
+    explicit TextWriter(std::string& out) : m_out(out) {}
+
+    template<typename D, typename T>
+    void Field(const char* name, const D&, SettingsInvalidation, const T& value) {
+        m_out += name;
+        m_out += " = ";
+        m_out += FormatValue(value);
+        m_out += '\n';
+    }
+
+    template<typename D>
+    void Field(const char* name, const D&, SettingsInvalidation invalidation, const std::vector<std::wstring>& value) {
+        if (value.empty()) {
+            m_out += "# ";
+            m_out += name;
+            m_out += " = \"...\"    (one line per message)\n";
+        }
+        for (const std::wstring& item : value) {
+            Field(name, item, invalidation, item);
+        }
+    }
+
+private:
+    std::string& m_out;
+};
+
+// Field order is VisitStoredSettings; a new schema changes the hash in the
+// header, so old snapshots are recompiled rather than misread
+class SnapshotCodec {
+public:
+    explicit SnapshotCodec(std::string& out) : m_out(&out) {}
+    explicit SnapshotCodec(std::string_view in, size_t offset) : m_in(in), m_offset(offset) {}
+
+    template<typename D, typename T>
+    void Field(const char*, const D&, SettingsInvalidation, T& value) {
+        Value(value);
+    }
+
+    template<typename T>
+    void Value(T& value) {
+        if (m_out) {
+            m_out->append(reinterpret_cast<const char*>(&value), sizeof(T));
+        } else if (m_offset + sizeof(T) <= m_in.size()) {
+            std::memcpy(&value, m_in.data() + m_offset, sizeof(T));
+            m_offset += sizeof(T);
+        } else {
+            m_failed = true;
+        }
+    }
+
+    void Value(bool& value) {
+        uint8_t byte = value ? 1 : 0;
+        Value(byte);
+        value = byte != 0;
+    }
+
+    // UTF-16 as in simulation captures, so snapshots move between platforms
+    void Value(std::wstring& value) {
+        if (m_out) {
+            std::u16string units;
+            for (wchar_t c : value) {
+                uint32_t codePoint = static_cast<uint32_t>(c);
+                if (codePoint >= 0x10000) {
+                    codePoint -= 0x10000;
+                    units.push_back(static_cast<char16_t>(0xD800 + (codePoint >> 10)));
+                    units.push_back(static_cast<char16_t>(0xDC00 + (codePoint & 0x3FF)));
+                } else {
+                    units.push_back(static_cast<char16_t>(codePoint));
+                }
+            }
+            uint16_t count = static_cast<uint16_t>(std::min<size_t>(units.size(), 0xFFFF));
+            Value(count);
+            m_out->append(reinterpret_cast<const char*>(units.data()), count * sizeof(char16_t));
+            return;
+        }
+
+        uint16_t count = 0;
+        Value(count);
+        value.clear();
+        for (uint16_t i = 0; i < count && !m_failed; ++i) {
+            char16_t unit = 0;
+            Value(unit);
+            if constexpr (sizeof(wchar_t) == 2) {
+                value.push_back(static_cast<wchar_t>(unit));
+            } else if (unit >= 0xDC00 && unit <= 0xDFFF && !value.empty() &&
+                       value.back() >= 0xD800 && value.back() <= 0xDBFF) {
+                uint32_t high = static_cast<uint32_t>(value.back()) - 0xD800;
+                value.back() = static_cast<wchar_t>(0x10000 + (high << 10) + (unit - 0xDC00));
+            } else {
+                value.push_back(static_cast<wchar_t>(unit));
+            }
+        }
+    }
+
+    void Value(std::vector<std::wstring>& value) {
+        uint16_t count = static_cast<uint16_t>(std::min<size_t>(value.size(), 0xFFFF));
+        Value(count);
+        value.resize(count);
+        for (uint16_t i = 0; i < count && !m_failed; ++i) {
+            Value(value[i]);
+        }
+    }
+
+    bool Failed() const { return m_failed; }
+    size_t GetOffset() const { return m_offset; }
+
+private:
+    std::string* m_out = nullptr;
+    std::string_view m_in;
+    size_t m_offset = 0;
+    bool m_failed = false;
+};
+
+constexpr size_t SNAPSHOT_HEADER_SIZE = 4 + 2 + 2 + 8 + 8;
+
+bool ReadFile(const std::filesystem::path& path, std::string& data) {
+    std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return false;
+
+    std::streamoff size = file.tellg();
+    if (size < 0) return false;
+    data.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    file.read(data.data(), size);
+    return !file.fail();
+}
+
+// Written beside the target and renamed over it, so a reader (or the
+// watcher of another instance) never sees half a file
+bool WriteFileAtomic(const std::filesystem::path& path, std::string_view data) {
+    std::filesystem::path temp = path;
+    temp += ".tmp";
+    {
+        std::ofstream file(temp, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!file.good()) return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp, path, error);
+    if (error) {
+        std::filesystem::remove(temp, error);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool ParseSettingsText(std::string_view text, MatrixSettings& settings, std::vector<std::string>* errors) {
+    if (text.substr(0, 3) == "\xEF\xBB\xBF") {
+        text.remove_prefix(3);
+    }
+
+    std::unordered_map<std::string_view, std::vector<TextEntry>> entries;
+    std::vector<std::pair<size_t, std::string_view>> malformed;
+    size_t lineNumber = 0;
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        std::string_view line = Trim(text.substr(0, end));
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+        ++lineNumber;
+
+        if (line.empty() || line.front() == '#') continue;
+
+        size_t equals = line.find('=');
+        if (equals == std::string_view::npos) {
+            malformed.emplace_back(lineNumber, line);
+            continue;
+        }
+        entries[Trim(line.substr(0, equals))].push_back({ Trim(line.substr(equals + 1)), lineNumber });
+    }
+
+    TextReader reader(entries);
+    VisitStoredSettings(reader, settings);
+
+    for (const auto& [line, content] : malformed) {
+        reader.Reject(line, "expected Name = value");
+    }
+    for (const auto& [name, list] : entries) {
+        for (const TextEntry& entry : list) {
+            if (!entry.used) {
+                reader.Reject(entry.line, "unknown setting " + std::string(name));
+            }
+        }
+    }
+    return reader.Finish(errors);
+}
+
+std::string FormatSettingsText(const MatrixSettings& settings) {
+    std::string out = "# Matrix screensaver settings (see settings_store.h)\n";
+    TextWriter writer(out);
+    VisitStoredSettings(writer, settings);
+    return out;
+}
+
+void EncodeSettingsSnapshot(const MatrixSettings& settings, uint64_t sourceStamp, std::string& out) {
+    out.clear();
+    out.append(SETTINGS_SNAPSHOT_MAGIC, sizeof(SETTINGS_SNAPSHOT_MAGIC));
+
+    MatrixSettings copy = settings;
+    SnapshotCodec codec(out);
+    uint16_t version = SETTINGS_SNAPSHOT_VERSION;
+    uint16_t reserved = 0;
+    uint64_t schemaHash = GetSettingsSchemaHash();
+    codec.Value(version);
+    codec.Value(reserved);
+    codec.Value(schemaHash);
+    codec.Value(sourceStamp);
+    VisitStoredSettings(codec, copy);
+}
+
+bool DecodeSettingsSnapshot(std::string_view data, MatrixSettings& settings, uint64_t& sourceStamp) {
+    if (data.size() < SNAPSHOT_HEADER_SIZE ||
+        std::memcmp(data.data(), SETTINGS_SNAPSHOT_MAGIC, sizeof(SETTINGS_SNAPSHOT_MAGIC)) != 0) {
+        return false;
+    }
+
+    SnapshotCodec codec(data, sizeof(SETTINGS_SNAPSHOT_MAGIC));
+    uint16_t version = 0;
+    uint16_t reserved = 0;
+    uint64_t schemaHash = 0;
+    codec.Value(version);
+    codec.Value(reserved);
+    codec.Value(schemaHash);
+    codec.Value(sourceStamp);
+    if (version != SETTINGS_SNAPSHOT_VERSION || schemaHash != GetSettingsSchemaHash()) {
+        return false;
+    }
+
+    // Decode into a copy so a truncated snapshot leaves settings alone
+    MatrixSettings decoded = settings;
+    VisitStoredSettings(codec, decoded);
+    if (codec.Failed() || codec.GetOffset() != data.size()) {
+        return false;
+    }
+    settings = std::move(decoded);
+    return true;
+}
+
+uint64_t GetSettingsFileStamp(const std::filesystem::path& path) {
+    std::error_code error;
+    uint64_t size = std::filesystem::file_size(path, error);
+    if (error) return 0;
+    auto written = std::filesystem::last_write_time(path, error);
+    if (error) return 0;
+
+    uint64_t ticks = static_cast<uint64_t>(written.time_since_epoch().count());
+    uint64_t stamp = 0xCBF29CE484222325ull;
+    for (uint64_t part : { size, ticks }) {
+        for (int i = 0; i < 8; ++i) {
+            stamp = (stamp ^ ((part >> (i * 8)) & 0xFF)) * 0x100000001B3ull;
+        }
+    }
+    return stamp != 0 ? stamp : 1;
+}
+
+SettingsStore::SettingsStore(std::filesystem::path textPath)
+    : m_textPath(std::move(textPath)) {
+    m_snapshotPath = m_textPath;
+    m_snapshotPath += ".bin";
+}
+
+bool SettingsStore::Exists() const {
+    std::error_code error;
+    return std::filesystem::is_regular_file(m_textPath, error);
+}
+
+bool SettingsStore::Load(MatrixSettings& settings) {
+    m_loadedFromSnapshot = false;
+    m_errors.clear();
+
+    // Stamp before reading: if the text changes in between, the snapshot
+    // carries the older stamp and is simply recompiled next time
+    uint64_t stamp = GetSettingsFileStamp(m_textPath);
+    if (stamp == 0) return false;
+
+    std::string data;
+    uint64_t snapshotStamp = 0;
+    if (ReadFile(m_snapshotPath, data) &&
+        DecodeSettingsSnapshot(data, settings, snapshotStamp) && snapshotStamp == stamp) {
+        m_loadedFromSnapshot = true;
+        return true;
+    }
+
+    if (!ReadFile(m_textPath, data)) return false;
+
+    // Text with rejected lines stays uncompiled, so every load reports them.
+    // A read-only location just means parsing on every load.
+    if (ParseSettingsText(data, settings, &m_errors)) {
+        EncodeSettingsSnapshot(settings, stamp, data);
+        WriteFileAtomic(m_snapshotPath, data);
+    }
+    return true;
+}
+
+bool SettingsStore::Save(const MatrixSettings& settings) {
+    if (!WriteFileAtomic(m_textPath, FormatSettingsText(settings))) return false;
+
+    std::string data;
+    EncodeSettingsSnapshot(settings, GetSettingsFileStamp(m_textPath), data);
+    WriteFileAtomic(m_snapshotPath, data);
+    return true;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "sim_types.h"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// File-based settings, for machines that are configured by copying a file
+// rather than through the registry (and for running anywhere but Windows).
+//
+// The text file is what gets edited: UTF-8, one "Name = value" per line with
+// the names from VisitStoredSettings, '#' starts a comment. Strings may be
+// double-quoted, with \" and \\ escapes; CustomMessages is repeated once per
+// message. Missing names take their default, unknown names are reported and
+// skipped.
+//
+// Next to it, "<file>.bin" is the compiled snapshot, read in one go instead
+// of parsing. It is stamped with the size and write time of the text it came
+// from and with the schema hash, and recompiled when either no longer matches.
+//
+// Snapshot layout, little-endian:
+//   header: "MXST" magic, u16 version, u16 reserved, u64 schema hash, u64 source stamp
+//   fields: in VisitStoredSettings order; bool u8, int i32, float f32,
+//           string u16 count + UTF-16 units, list u16 count + strings
+constexpr char SETTINGS_SNAPSHOT_MAGIC[4] = { 'M', 'X', 'S', 'T' };
+constexpr uint16_t SETTINGS_SNAPSHOT_VERSION = 1;
+
+// Parses settings text over the stored fields of settings; returns false if
+// any line was rejected, with one message per line in errors
+bool ParseSettingsText(std::string_view text, MatrixSettings& settings, std::vector<std::string>* errors = nullptr);
+std::string FormatSettingsText(const MatrixSettings& settings);
+
+void EncodeSettingsSnapshot(const MatrixSettings& settings, uint64_t sourceStamp, std::string& out);
+bool DecodeSettingsSnapshot(std::string_view data, MatrixSettings& settings, uint64_t& sourceStamp);
+
+// Size and last write time of a file folded into one value; 0 if it is missing
+uint64_t GetSettingsFileStamp(const std::filesystem::path& path);
+
+class SettingsStore {
+public:
+    explicit SettingsStore(std::filesystem::path textPath);
+
+    const std::filesystem::path& GetTextPath() const { return m_textPath; }
+    const std::filesystem::path& GetSnapshotPath() const { return m_snapshotPath; }
+    bool Exists() const;
+
+    // Loads the snapshot if it is current, else parses the text and
+    // recompiles the snapshot. False if the text file cannot be read.
+    bool Load(MatrixSettings& settings);
+    bool Save(const MatrixSettings& settings);
+
+    bool LoadedFromSnapshot() const { return m_loadedFromSnapshot; }
+    const std::vector<std::string>& GetErrors() const { return m_errors; }
+
+private:
+    std::filesystem::path m_textPath;
+    std::filesystem::path m_snapshotPath;
+    bool m_loadedFromSnapshot = false;
+    std::vector<std::string> m_errors;      // Rejected lines from the last parse
+};
@@ -0,0 +1,138 @@
+#include "settings_watcher.h"
+#include "settings_store.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+int64_t Now() {
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+} // namespace
+
+SettingsWatcher::SettingsWatcher(std::filesystem::path path)
+    : m_path(std::move(path)) {
+}
+
+SettingsWatcher::~SettingsWatcher() {
+    Stop();
+}
+
+bool SettingsWatcher::Start() {
+    if (IsRunning()) return true;
+
+    std::filesystem::path directory = m_path.parent_path();
+    if (directory.empty()) directory = ".";
+    m_stamp = GetSettingsFileStamp(m_path);
+    m_stopping = false;
+
+#ifdef _WIN32
+    m_notification = FindFirstChangeNotificationW(directory.c_str(), FALSE,
+        FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE);
+    if (m_notification == INVALID_HANDLE_VALUE) {
+        m_notification = nullptr;
+        return false;
+    }
+    m_stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!m_stopEvent) {
+        FindCloseChangeNotification(m_notification);
+        m_notification = nullptr;
+        return false;
+    }
+#elif defined(__linux__)
+    // Saves land as a write, or as a new file renamed over the old one
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify < 0) return false;
+    if (inotify_add_watch(m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE) < 0 ||
+        pipe(m_wakePipe) != 0) {
+        close(m_inotify);
+        m_inotify = -1;
+        return false;
+    }
+#endif
+
+    m_thread = std::thread(&SettingsWatcher::ThreadMain, this);
+    return true;
+}
+
+void SettingsWatcher::Stop() {
+    if (!IsRunning()) return;
+
+    m_stopping = true;
+#ifdef _WIN32
+    SetEvent(m_stopEvent);
+#elif defined(__linux__)
+    char wake = 0;
+    (void)!write(m_wakePipe[1], &wake, 1);
+#endif
+    m_thread.join();
+
+#ifdef _WIN32
+    FindCloseChangeNotification(m_notification);
+    CloseHandle(m_stopEvent);
+    m_notification = nullptr;
+    m_stopEvent = nullptr;
+#elif defined(__linux__)
+    close(m_inotify);
+    close(m_wakePipe[0]);
+    close(m_wakePipe[1]);
+    m_inotify = -1;
+    m_wakePipe[0] = m_wakePipe[1] = -1;
+#endif
+}
+
+bool SettingsWatcher::ConsumeChange() {
+    int64_t changedAt = m_changedAt.load(std::memory_order_acquire);
+    if (changedAt == 0) return false;
+
+    auto settle = std::chrono::duration_cast<std::chrono::steady_clock::duration>(SETTLE_TIME);
+    if (Now() - changedAt < settle.count()) return false;
+
+    // A change landing meanwhile moves the time on, and is reported after it settles
+    return m_changedAt.compare_exchange_strong(changedAt, 0, std::memory_order_acq_rel);
+}
+
+void SettingsWatcher::CheckFile() {
+    uint64_t stamp = GetSettingsFileStamp(m_path);
+    if (stamp == m_stamp) return;
+
+    m_stamp = stamp;
+    m_changedAt.store(Now(), std::memory_order_release);
+}
+
+void SettingsWatcher::ThreadMain() {
+#ifdef _WIN32
+    HANDLE handles[2] = { m_stopEvent, m_notification };
+    while (!m_stopping) {
+        DWORD result = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+        if (result != WAIT_OBJECT_0 + 1) break;
+
+        CheckFile();
+        if (!FindNextChangeNotification(m_notification)) break;
+    }
+#elif defined(__linux__)
+    pollfd fds[2] = { { m_wakePipe[0], POLLIN, 0 }, { m_inotify, POLLIN, 0 } };
+    alignas(inotify_event) char buffer[4096];
+    while (!m_stopping) {
+        if (poll(fds, 2, -1) < 0) continue;
+        if (fds[0].revents) break;
+
+        // The events only say that something in the directory changed
+        while (read(m_inotify, buffer, sizeof(buffer)) > 0) {
+        }
+        CheckFile();
+    }
+#else
+    while (!m_stopping) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        CheckFile();
+    }
+#endif
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <thread>
+
+// Watches one settings file from a background thread. The owner polls
+// ConsumeChange() from its own loop and reloads there, so settings are only
+// ever touched by the thread that uses them.
+//
+// Waits on the directory (FindFirstChangeNotification on Windows, inotify on
+// Linux, a slow poll elsewhere) and compares the file's stamp on every wake,
+// so writes to other files in the directory, such as logs, are ignored.
+// Editors save in several steps, so a change is only reported once the file
+// has been quiet for SETTLE_TIME.
+class SettingsWatcher {
+public:
+    static constexpr std::chrono::milliseconds SETTLE_TIME{ 200 };
+
+    explicit SettingsWatcher(std::filesystem::path path);
+    ~SettingsWatcher();
+
+    SettingsWatcher(const SettingsWatcher&) = delete;
+    SettingsWatcher& operator=(const SettingsWatcher&) = delete;
+
+    bool Start();
+    void Stop();
+    bool IsRunning() const { return m_thread.joinable(); }
+
+    // True once per settled change
+    bool ConsumeChange();
+
+private:
+    void ThreadMain();
+    void CheckFile();
+
+    std::filesystem::path m_path;
+    std::thread m_thread;
+    std::atomic<bool> m_stopping{ false };
+    uint64_t m_stamp = 0;                       // Watcher thread only
+    std::atomic<int64_t> m_changedAt{ 0 };      // steady_clock ticks of the last change, 0 when none is pending
+
+#ifdef _WIN32
+    void* m_stopEvent = nullptr;
+    void* m_notification = nullptr;
+#elif defined(__linux__)
+    int m_inotify = -1;
+    int m_wakePipe[2] = { -1, -1 };
+#endif
+};
@@ -0,0 +1,353 @@
+#include "sim_capture.h"
+#include "matrix_simulation.h"
+#include <cstring>
+
+namespace {
+
+// Field order of a Settings record; append only, and bump
+// SIM_CAPTURE_VERSION when it changes
+class SettingsCodec {
+public:
+    explicit SettingsCodec(std::string& out) : m_out(&out) {}
+    explicit SettingsCodec(std::string_view in) : m_in(in) {}
+
+    template<typename T>
+    void Field(T& value) {
+        if (m_out) {
+            m_out->append(reinterpret_cast<const char*>(&value), sizeof(T));
+        } else if (m_offset + sizeof(T) <= m_in.size()) {
+            std::memcpy(&value, m_in.data() + m_offset, sizeof(T));
+            m_offset += sizeof(T);
+        } else {
+            m_failed = true;
+        }
+    }
+
+    void Field(bool& value) {
+        uint8_t byte = value ? 1 : 0;
+        Field(byte);
+        value = byte != 0;
+    }
+
+    // Stored as UTF-16 so captures move between Windows and Linux
+    void Field(std::wstring& value) {
+        if (m_out) {
+            std::u16string units;
+            for (wchar_t c : value) {
+                uint32_t codePoint = static_cast<uint32_t>(c);
+                if (codePoint >= 0x10000) {
+                    codePoint -= 0x10000;
+                    units.push_back(static_cast<char16_t>(0xD800 + (codePoint >> 10)));
+                    units.push_back(static_cast<char16_t>(0xDC00 + (codePoint & 0x3FF)));
+                } else {
+                    units.push_back(static_cast<char16_t>(codePoint));
+                }
+            }
+            uint16_t count = static_cast<uint16_t>(std::min<size_t>(units.size(), 0xFFFF));
+            Field(count);
+            m_out->append(reinterpret_cast<const char*>(units.data()), count * sizeof(char16_t));
+            return;
+        }
+
+        uint16_t count = 0;
+        Field(count);
+        value.clear();
+        for (uint16_t i = 0; i < count && !m_failed; ++i) {
+            char16_t unit = 0;
+            Field(unit);
+            if constexpr (sizeof(wchar_t) == 2) {
+                value.push_back(static_cast<wchar_t>(unit));
+            } else if (unit >= 0xDC00 && unit <= 0xDFFF && !value.empty() &&
+                       value.back() >= 0xD800 && value.back() <= 0xDBFF) {
+                uint32_t high = static_cast<uint32_t>(value.back()) - 0xD800;
+                value.back() = static_cast<wchar_t>(0x10000 + (high << 10) + (unit - 0xDC00));
+            } else {
+                value.push_back(static_cast<wchar_t>(unit));
+            }
+        }
+    }
+
+    bool Failed() const { return m_failed; }
+
+private:
+    std::string* m_out = nullptr;
+    std::string_view m_in;
+    size_t m_offset = 0;
+    bool m_failed = false;
+};
+
+template<typename Codec>
+void VisitSimSettings(Codec& codec, MatrixSettings& s) {
+    codec.Field(s.density);
+    codec.Field(s.fontSize);
+    codec.Field(s.minSpeed);
+    codec.Field(s.maxSpeed);
+    codec.Field(s.fadeRate);
+    codec.Field(s.useCustomWord);
+    codec.Field(s.sequentialCharacters);
+    codec.Field(s.customWord);
+    codec.Field(s.useMask);
+    codec.Field(s.enable3DEffect);
+    codec.Field(s.enableMotionReduction);
+    codec.Field(s.enableCharacterMorphing);
+    codec.Field(s.enableGlitchEffects);
+    codec.Field(s.enableRainVariations);
+    codec.Field(s.enableSystemDisruptions);
+    codec.Field(s.morphFrequency);
+    codec.Field(s.morphSpeed);
+    codec.Field(s.glitchFrequency);
+    codec.Field(s.latinCharProbability);
+    codec.Field(s.symbolCharProbability);
+    codec.Field(s.enableCharacterVariety);
+}
+
+} // namespace
+
+void SerializeSimSettings(const MatrixSettings& settings, std::string& out) {
+    MatrixSettings copy = settings;
+    SettingsCodec codec(out);
+    VisitSimSettings(codec, copy);
+}
+
+bool DeserializeSimSettings(std::string_view data, MatrixSettings& settings) {
+    SettingsCodec codec(data);
+    VisitSimSettings(codec, settings);
+    return !codec.Failed();
+}
+
+SimRecorder::~SimRecorder() {
+    Close();
+}
+
+bool SimRecorder::Open(const std::filesystem::path& path) {
+    Close();
+
+    m_file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!m_file.is_open()) return false;
+
+    WriteBytes(SIM_CAPTURE_MAGIC, sizeof(SIM_CAPTURE_MAGIC));
+    Write(SIM_CAPTURE_VERSION);
+    Write(uint16_t(0));
+    m_frameCount = 0;
+    return true;
+}
+
+void SimRecorder::Close() {
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+}
+
+void SimRecorder::RecordInitialize(const MatrixSettings& settings, int width, int height, uint32_t seed) {
+    if (!IsOpen()) return;
+
+    RecordSettings(settings);
+    WriteKind(SimCaptureRecordKind::Initialize);
+    Write(static_cast<int32_t>(width));
+    Write(static_cast<int32_t>(height));
+    Write(seed);
+}
+
+void SimRecorder::RecordSettings(const MatrixSettings& settings) {
+    if (!IsOpen()) return;
+
+    m_scratch.clear();
+    SerializeSimSettings(settings, m_scratch);
+    WriteKind(SimCaptureRecordKind::Settings);
+    Write(static_cast<uint32_t>(m_scratch.size()));
+    WriteBytes(m_scratch.data(), m_scratch.size());
+}
+
+void SimRecorder::RecordResize(int width, int height) {
+    if (!IsOpen()) return;
+
+    WriteKind(SimCaptureRecordKind::Resize);
+    Write(static_cast<int32_t>(width));
+    Write(static_cast<int32_t>(height));
+}
+
+void SimRecorder::RecordDepthMap(int width, int height, const std::vector<uint8_t>& depthMap) {
+    if (!IsOpen()) return;
+
+    // Masks are mostly flat regions, so runs shrink them a lot
+    m_scratch.clear();
+    for (size_t i = 0; i < depthMap.size();) {
+        uint8_t value = depthMap[i];
+        size_t run = 1;
+        while (run < 255 && i + run < depthMap.size() && depthMap[i + run] == value) {
+            ++run;
+        }
+        m_scratch.push_back(static_cast<char>(run));
+        m_scratch.push_back(static_cast<char>(value));
+        i += run;
+    }
+
+    bool empty = depthMap.empty();
+    WriteKind(SimCaptureRecordKind::DepthMap);
+    Write(static_cast<int32_t>(empty ? 0 : width));
+    Write(static_cast<int32_t>(empty ? 0 : height));
+    Write(static_cast<uint32_t>(m_scratch.size()));
+    WriteBytes(m_scratch.data(), m_scratch.size());
+}
+
+void SimRecorder::RecordQuality(const SimQuality& quality) {
+    if (!IsOpen()) return;
+
+    WriteKind(SimCaptureRecordKind::Quality);
+    Write(quality.columnFraction);
+    Write(quality.effectScale);
+    Write(static_cast<int32_t>(quality.effectInterval));
+}
+
+void SimRecorder::RecordFastForward(float seconds) {
+    if (!IsOpen()) return;
+
+    WriteKind(SimCaptureRecordKind::FastForward);
+    Write(seconds);
+}
+
+void SimRecorder::RecordFrame(float deltaTime, const MatrixSimulation& simulation) {
+    if (!IsOpen()) return;
+
+    WriteKind(SimCaptureRecordKind::Frame);
+    Write(deltaTime);
+    m_frameCount++;
+
+    if (m_frameCount % CHECKPOINT_INTERVAL == 0) {
+        WriteKind(SimCaptureRecordKind::Checkpoint);
+        Write(m_frameCount);
+        Write(simulation.ComputeStateHash());
+    }
+}
+
+void SimRecorder::WriteKind(SimCaptureRecordKind kind) {
+    Write(static_cast<uint8_t>(kind));
+}
+
+void SimRecorder::WriteBytes(const void* data, size_t size) {
+    m_file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+}
+
+template<typename T>
+bool SimCaptureReader::Read(T& value) {
+    if (m_offset + sizeof(T) > m_data.size()) {
+        m_error = "truncated record at offset " + std::to_string(m_offset);
+        return false;
+    }
+    std::memcpy(&value, m_data.data() + m_offset, sizeof(T));
+    m_offset += sizeof(T);
+    return true;
+}
+
+bool SimCaptureReader::ReadBytes(size_t length, std::string_view& bytes) {
+    if (length > m_data.size() - m_offset) {
+        m_error = "truncated record at offset " + std::to_string(m_offset);
+        return false;
+    }
+    bytes = m_data.substr(m_offset, length);
+    m_offset += length;
+    return true;
+}
+
+bool SimCaptureReader::ReadHeader() {
+    std::string_view magic;
+    uint16_t version = 0;
+    uint16_t reserved = 0;
+    if (!ReadBytes(sizeof(SIM_CAPTURE_MAGIC), magic) || !Read(version) || !Read(reserved)) {
+        m_error = "missing capture header";
+        return false;
+    }
+    if (std::memcmp(magic.data(), SIM_CAPTURE_MAGIC, sizeof(SIM_CAPTURE_MAGIC)) != 0) {
+        m_error = "not a simulation capture";
+        return false;
+    }
+    if (version == 0 || version > SIM_CAPTURE_VERSION) {
+        m_error = "unsupported capture version " + std::to_string(version);
+        return false;
+    }
+
+    m_version = version;
+    m_headerRead = true;
+    return true;
+}
+
+bool SimCaptureReader::Next(SimCaptureEvent& event) {
+    if (!m_headerRead && !ReadHeader()) return false;
+    if (m_offset >= m_data.size() || HasError()) return false;
+
+    uint8_t kind = 0;
+    Read(kind);
+    event.kind = static_cast<SimCaptureRecordKind>(kind);
+
+    switch (event.kind) {
+        case SimCaptureRecordKind::Settings: {
+            uint32_t size = 0;
+            std::string_view payload;
+            if (!Read(size) || !ReadBytes(size, payload)) return false;
+            if (!DeserializeSimSettings(payload, m_settings)) {
+                m_error = "malformed settings record";
+                return false;
+            }
+            event.settings = m_settings;
+            return true;
+        }
+
+        case SimCaptureRecordKind::Initialize: {
+            int32_t width = 0;
+            int32_t height = 0;
+            if (!Read(width) || !Read(height) || !Read(event.seed)) return false;
+            event.width = width;
+            event.height = height;
+            event.settings = m_settings;
+            return true;
+        }
+
+        case SimCaptureRecordKind::Resize: {
+            int32_t width = 0;
+            int32_t height = 0;
+            if (!Read(width) || !Read(height)) return false;
+            event.width = width;
+            event.height = height;
+            return true;
+        }
+
+        case SimCaptureRecordKind::DepthMap: {
+            int32_t width = 0;
+            int32_t height = 0;
+            uint32_t size = 0;
+            std::string_view runs;
+            if (!Read(width) || !Read(height) || !Read(size) || !ReadBytes(size, runs)) return false;
+
+            event.width = width;
+            event.height = height;
+            event.depthMap.clear();
+            event.depthMap.reserve(static_cast<size_t>(std::max(width, 0)) * std::max(height, 0));
+            for (size_t i = 0; i + 1 < runs.size(); i += 2) {
+                event.depthMap.insert(event.depthMap.end(), static_cast<uint8_t>(runs[i]), static_cast<uint8_t>(runs[i + 1]));
+            }
+            if (event.depthMap.size() != static_cast<size_t>(std::max(width, 0)) * std::max(height, 0)) {
+                m_error = "depth map size mismatch";
+                return false;
+            }
+            return true;
+        }
+
+        case SimCaptureRecordKind::Frame:
+        case SimCaptureRecordKind::FastForward:
+            return Read(event.deltaTime);
+
+        case SimCaptureRecordKind::Checkpoint:
+            return Read(event.frameIndex) && Read(event.stateHash);
+
+        case SimCaptureRecordKind::Quality: {
+            int32_t interval = 1;
+            if (!Read(event.quality.columnFraction) || !Read(event.quality.effectScale) || !Read(interval)) return false;
+            event.quality.effectInterval = interval;
+            return true;
+        }
+
+        default:
+            m_error = "unknown record kind " + std::to_string(kind) + " at offset " + std::to_string(m_offset - 1);
+            return false;
+    }
+}
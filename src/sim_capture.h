@@ -0,0 +1,129 @@
+#pragma once
+
+#include "sim_types.h"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class MatrixSimulation;
+
+// Simulation capture (.mxrp): every input MatrixSimulation consumed during a
+// session, so matrix_replay can rerun it headlessly and reproduce each frame.
+//
+// Layout, little-endian:
+//   header:  "MXRP" magic, u16 version, u16 reserved
+//   records: u8 kind, then a kind-specific payload
+//     Settings    u32 size, the simulation-relevant MatrixSettings fields
+//     Initialize  i32 width, i32 height, u32 seed (uses the last Settings)
+//     Resize      i32 width, i32 height
+//     DepthMap    i32 width, i32 height, u32 size, run-length pairs
+//                 (u8 count, u8 value); 0x0 clears the mask
+//     Frame       f32 deltaTime
+//     Checkpoint  u64 frame index, u64 ComputeStateHash() after that frame
+//     Quality     f32 column fraction, f32 effect scale, i32 effect interval (v2)
+//     FastForward f32 seconds (v4)
+// Up to v2, every Settings record after Initialize restarted the columns;
+// from v3 only a change to the layout does (see SettingsInvalidation).
+// v5 to v7 changed no records but how glyphs are drawn (v5 GlyphSampler,
+// v6 glitch glyphs chosen when the glitch starts, v7 glitch glyphs weighted
+// by depth), so earlier captures replay with different glyphs and
+// checkpoint hashes.
+// A frame costs five bytes, so a day at 60 FPS stays around 30 MB.
+constexpr char SIM_CAPTURE_MAGIC[4] = { 'M', 'X', 'R', 'P' };
+constexpr uint16_t SIM_CAPTURE_VERSION = 7;          // Readers also accept versions 1 to 6
+
+enum class SimCaptureRecordKind : uint8_t {
+    Settings = 1,
+    Initialize,
+    Resize,
+    DepthMap,
+    Frame,
+    Checkpoint,
+    Quality,
+    FastForward
+};
+
+// Writes a capture as the renderer drives its simulation
+class SimRecorder {
+public:
+    static constexpr uint64_t CHECKPOINT_INTERVAL = 60;   // Frames between state hashes
+
+    SimRecorder() = default;
+    ~SimRecorder();
+
+    SimRecorder(const SimRecorder&) = delete;
+    SimRecorder& operator=(const SimRecorder&) = delete;
+
+    bool Open(const std::filesystem::path& path);
+    void Close();
+    bool IsOpen() const { return m_file.is_open(); }
+    uint64_t GetFrameCount() const { return m_frameCount; }
+
+    void RecordInitialize(const MatrixSettings& settings, int width, int height, uint32_t seed);
+    void RecordSettings(const MatrixSettings& settings);
+    void RecordResize(int width, int height);
+    void RecordDepthMap(int width, int height, const std::vector<uint8_t>& depthMap);
+    void RecordQuality(const SimQuality& quality);
+    void RecordFastForward(float seconds);
+
+    // Call after simulation.Update(deltaTime); adds a checkpoint every CHECKPOINT_INTERVAL frames
+    void RecordFrame(float deltaTime, const MatrixSimulation& simulation);
+
+private:
+    void WriteKind(SimCaptureRecordKind kind);
+    void WriteBytes(const void* data, size_t size);
+    template<typename T>
+    void Write(const T& value) { WriteBytes(&value, sizeof(T)); }
+
+    std::ofstream m_file;
+    uint64_t m_frameCount = 0;
+    std::string m_scratch;
+};
+
+// One decoded capture record
+struct SimCaptureEvent {
+    SimCaptureRecordKind kind = SimCaptureRecordKind::Frame;
+    float deltaTime = 0.0f;             // Frame; seconds for FastForward
+    int width = 0;                      // Initialize, Resize, DepthMap
+    int height = 0;
+    uint32_t seed = 0;                  // Initialize
+    MatrixSettings settings;            // Settings, and the settings in effect for Initialize
+    std::vector<uint8_t> depthMap;      // DepthMap, decoded
+    uint64_t frameIndex = 0;            // Checkpoint
+    uint64_t stateHash = 0;
+    SimQuality quality;                 // Quality
+};
+
+// Decodes a capture held in memory. Kept free of platform headers so the
+// replay tool builds anywhere.
+class SimCaptureReader {
+public:
+    explicit SimCaptureReader(std::string_view data) : m_data(data) {}
+
+    // False at the end of the data or on a malformed record (see HasError)
+    bool Next(SimCaptureEvent& event);
+
+    bool HasError() const { return !m_error.empty(); }
+    const std::string& GetError() const { return m_error; }
+    uint16_t GetVersion() const { return m_version; }      // 0 until the header is read
+
+private:
+    template<typename T>
+    bool Read(T& value);
+    bool ReadBytes(size_t length, std::string_view& bytes);
+    bool ReadHeader();
+
+    std::string_view m_data;
+    size_t m_offset = 0;
+    bool m_headerRead = false;
+    uint16_t m_version = 0;
+    MatrixSettings m_settings;          // Last Settings record
+    std::string m_error;
+};
+
+// Settings snapshot encoding, shared by the recorder and reader
+void SerializeSimSettings(const MatrixSettings& settings, std::string& out);
+bool DeserializeSimSettings(std::string_view data, MatrixSettings& settings);
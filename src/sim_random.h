@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+
+// Seeded random source for the simulation.
+//
+// std::mt19937 produces the same sequence on every standard library, but the
+// std distributions do not, so values are derived here with plain integer
+// and float arithmetic. Given the same seed and the same calls, a capture
+// taken on Windows replays identically on Linux.
+class SimRandom {
+public:
+    explicit SimRandom(uint32_t seed = 5489u) { Seed(seed); }
+
+    void Seed(uint32_t seed) {
+        m_seed = seed;
+        m_engine.seed(seed);
+    }
+
+    uint32_t GetSeed() const { return m_seed; }
+
+    uint32_t NextUInt() { return static_cast<uint32_t>(m_engine()); }
+
+    // Uniform in [0, 1), 24 bits of resolution
+    float NextFloat() {
+        return static_cast<float>(NextUInt() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Uniform in [min, max)
+    float NextFloat(float min, float max) {
+        return min + (max - min) * NextFloat();
+    }
+
+    // Uniform in [min, max], both inclusive
+    int NextInt(int min, int max) {
+        if (max <= min) return min;
+        uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(max) - min) + 1;
+        return min + static_cast<int>((static_cast<uint64_t>(NextUInt()) * range) >> 32);
+    }
+
+    // Draw from a copy so a state hash can cover the engine without advancing it
+    uint32_t Peek() const {
+        std::mt19937 copy = m_engine;
+        return static_cast<uint32_t>(copy());
+    }
+
+private:
+    std::mt19937 m_engine;
+    uint32_t m_seed = 0;
+};
+
+// Sine for values that feed simulation state. C runtimes disagree in the last
+// bit of std::sin, which is enough to make a replay drift; this uses only
+// basic arithmetic, so it rounds the same everywhere.
+inline float SimSin(float x) {
+    constexpr float PI = 3.14159265358979f;
+    constexpr float TWO_PI = 6.28318530717959f;
+
+    // Reduce to [-pi, pi]
+    float turns = static_cast<float>(static_cast<int64_t>(x * (1.0f / TWO_PI) + (x >= 0.0f ? 0.5f : -0.5f)));
+    x -= turns * TWO_PI;
+
+    // Fold to [-pi/2, pi/2]
+    if (x > PI * 0.5f) x = PI - x;
+    else if (x < -PI * 0.5f) x = -PI - x;
+
+    // Taylor series to x^11, accurate to about 1e-7 on this range
+    float x2 = x * x;
+    return x * (1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f +
+           x2 * (1.0f / 362880.0f + x2 * (-1.0f / 39916800.0f))))));
+}
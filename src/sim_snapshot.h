@@ -0,0 +1,93 @@
+#pragma once
+
+#include "sim_types.h"
+#include "frame_profiler.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// A visible cell as the renderer draws it, with effects already resolved
+struct SnapshotCell {
+    uint16_t x = 0;                     // Grid column
+    uint16_t y = 0;                     // Grid row
+    GlyphId glyph = INVALID_GLYPH;      // Base glyph
+    GlyphId displayGlyph = INVALID_GLYPH; // Glyph after morphing and glitching
+    uint8_t depth = 128;                // 0-255 maps to depth 0.0-1.0
+    uint8_t flags = 0;                  // CellFlags
+    float alpha = 0.0f;
+    float age = 0.0f;
+    float glow = 0.0f;                  // Glow intensity, 0 when glow is off
+
+    bool IsMorphing() const { return (flags & CELL_MORPHING) != 0; }
+    bool IsGlitching() const { return (flags & CELL_GLITCHING) != 0; }
+    float GetDepth() const { return depth * (1.0f / 255.0f); }
+};
+
+// A column head that may be on screen
+struct SnapshotColumn {
+    float x = 0.0f;
+    float y = 0.0f;
+    float baseFontSize = 0.0f;
+    GlyphId headGlyph = INVALID_GLYPH;
+};
+
+// The part of the simulation one output shows, in simulation pixels
+struct SimViewport {
+    uint32_t id = 0;                    // Chosen by the caller, stable while the output exists
+    int left = 0;
+    int top = 0;
+    int right = 0;
+    int bottom = 0;
+
+    int GetWidth() const { return right - left; }
+    int GetHeight() const { return bottom - top; }
+};
+
+// Where one viewport's cells and column heads sit in a FrameSnapshot
+struct SnapshotViewport {
+    SimViewport rect;
+    uint32_t firstCell = 0;
+    uint32_t cellCount = 0;
+    uint32_t firstColumn = 0;
+    uint32_t columnCount = 0;
+};
+
+// Everything the renderer needs from one simulation update. Snapshots are
+// immutable once published (see SimulationHost), so drawing never reads
+// state the simulation is changing.
+struct FrameSnapshot {
+    uint64_t frame = 0;                 // Simulation updates so far
+    int width = 0;
+    int height = 0;
+
+    // Active cells bright enough to draw and column heads near the screen,
+    // grouped by viewport; anything straddling a border is in both groups
+    std::vector<SnapshotCell> cells;
+    std::vector<SnapshotColumn> columns;
+    std::vector<SnapshotViewport> viewports;
+    uint32_t activeCells = 0;           // All active cells, drawn or not
+    uint64_t totalSpawns = 0;           // Cells spawned since the simulation started
+
+    bool systemDisrupted = false;
+    float disruptionIntensity = 0.0f;
+
+    // Phase times of the update that produced this snapshot
+    bool hasTiming = false;
+    FrameSample timing;
+    FrameProfiler::Clock::time_point timingEpoch;
+
+    const SnapshotViewport* FindViewport(uint32_t id) const {
+        for (const SnapshotViewport& viewport : viewports) {
+            if (viewport.rect.id == id) return &viewport;
+        }
+        return nullptr;
+    }
+
+    std::span<const SnapshotCell> GetCells(const SnapshotViewport& viewport) const {
+        return std::span<const SnapshotCell>(cells).subspan(viewport.firstCell, viewport.cellCount);
+    }
+
+    std::span<const SnapshotColumn> GetColumns(const SnapshotViewport& viewport) const {
+        return std::span<const SnapshotColumn>(columns).subspan(viewport.firstColumn, viewport.columnCount);
+    }
+};
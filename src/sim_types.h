@@ -0,0 +1,306 @@
+#pragma once
+
+// Plain data shared by the simulation and the renderer. Nothing here may
+// depend on Windows, so the simulation also builds for the offline replay
+// tool (see sim_capture.h).
+
+#include "glyph_table.h"
+
+#include <array>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cmath>
+
+// Matrix settings structure
+struct MatrixSettings {
+    float speed = 5.0f;
+    float density = 0.8f;
+    float messageSpeed = 3.0f;
+    float fontSize = 14.0f;
+    float minFontSize = 8.0f; // Far depth (dark mask areas)
+    float maxFontSize = 28.0f; // Near depth (bright mask areas)  
+    float minSpeed = 2.0f; // Far depth speed
+    float maxSpeed = 10.0f; // Near depth speed
+    float depthRange = 5.0f; // How dramatic the 3D depth effect is
+    float hue = 120.0f;
+    bool randomizeMessages = true;
+    bool boldFont = true;
+    bool enable3DEffect = true; // Enable 3D depth mapping
+    bool variableFontSize = true;
+    bool persistentCharacters = true;
+    bool useCustomWord = false; // Use custom word in mask areas
+    bool sequentialCharacters = true; // Use sequential characters instead of random
+    bool showMaskBackground = false; // Show mask image as background
+    bool whiteHeadCharacters = true; // Use bright white for leading characters
+    float maskBackgroundOpacity = 0.3f; // Opacity of background mask (0.0-1.0)
+    float fadeRate = 2.0f;
+    std::wstring fontName = L"Consolas";
+    std::wstring customWord = L"MATRIX"; // Custom word to display in mask areas
+    std::vector<std::wstring> customMessages;
+    std::wstring maskImagePath;
+    bool useMask = false;
+    
+    // Performance optimization features (all OFF by default)
+    bool enableBatchRendering = false; // Batch character rendering for better performance
+    bool enableFrameRateLimiting = false; // Limit frame rate to reduce CPU/GPU usage
+    int targetFrameRate = 60; // Target FPS when frame limiting is enabled
+    bool enableAdaptiveVSync = false; // Adaptive VSync for smoother rendering
+    bool showPerformanceMetrics = false; // Show FPS counter and performance stats
+    int profileWindowFrames = 120; // Frames summarized by the per-phase profiler overlay
+    bool enableFrameTrace = false; // Capture a per-frame timeline, written at shutdown
+    int frameTraceMaxFrames = 36000; // Frames kept by the capture (10 minutes at 60 FPS)
+    bool enableCountersEndpoint = false; // Publish live counters in a shared-memory page
+    bool enableCountersSocket = false; // Also serve them as JSON/Prometheus on a local socket
+    bool enableSimCapture = false; // Record simulation inputs for matrix_replay (read at startup)
+    bool enableQualityGovernor = false; // Scale effects and column count to hold the frame budget
+    bool enableSimulationThread = true; // Simulate on a worker thread, pipelined with rendering
+    bool enableDirtyRectangles = false; // Only redraw changed screen regions
+    bool enableWarmStart = true; // Resume the last session's rain instead of starting from an empty screen
+    float startupFastForward = 3.0f; // Seconds of rain simulated before the first frame without a warm start (0 = none)
+    
+    // Quality preset applied over the settings it covers when they are loaded:
+    // low-power, balanced, 4k-wall, max-effects, or auto for the richest one
+    // predicted to fit the frame budget; empty keeps the settings as they are
+    std::wstring qualityPreset;
+    float frameBudgetMs = 0.0f; // Budget auto chooses for (0 = a 60 Hz frame)
+    
+    // Advanced features (all OFF by default)
+    bool enableLogging = false; // Enable debug logging to file
+    bool binaryLogging = false; // Write the compact binary log (.mlog) instead of text
+    bool enableMotionBlur = false; // Add motion blur effect to falling characters
+    bool enableParticleEffects = false; // Add glowing particles and sparks
+    bool enableAudioVisualization = false; // React to system audio levels
+    
+    // Quality settings
+    bool enableHighQualityText = false; // Use subpixel text rendering
+    bool enableAntiAliasing = false; // Enable anti-aliasing for smoother edges
+    
+    // Visual enhancement features (all OFF by default)
+    bool enableCharacterMorphing = false; // Characters morph/change while falling
+    bool enablePhosphorGlow = false; // Add subtle glow around characters
+    bool enableGlitchEffects = false; // Occasional character glitches
+    bool enableRainVariations = false; // Vary rain intensity over time
+    bool enableSystemDisruptions = false; // Occasional screen flickers
+    bool enableMotionReduction = false; // Reduce animation for accessibility
+    
+    // Morphing settings
+    float morphFrequency = 0.1f; // How often characters morph (0.0-1.0)
+    float morphSpeed = 2.0f; // Speed of morphing animation
+    float glitchFrequency = 0.05f; // How often glitches occur
+    float glowIntensity = 0.3f; // Intensity of phosphor glow
+    
+    // Character variety settings
+    float latinCharProbability = 0.15f; // 15% chance of Latin chars
+    float symbolCharProbability = 0.05f; // 5% chance of symbols
+    bool enableCharacterVariety = true; // Use expanded character set
+};
+
+// Simulation workload chosen by the quality governor; the defaults are full
+// quality and leave the simulation exactly as it runs without a governor
+struct SimQuality {
+    float columnFraction = 1.0f;    // Share of columns dropping rain, spread evenly across the screen
+    float effectScale = 1.0f;       // Multiplier on morph and glitch start probabilities
+    int effectInterval = 1;         // Per-cell effects run every Nth update with the summed time
+    
+    bool operator==(const SimQuality&) const = default;
+};
+
+// Color utilities
+struct Color {
+    float r, g, b, a;
+    
+    Color(float red = 0.0f, float green = 0.0f, float blue = 0.0f, float alpha = 1.0f)
+        : r(red), g(green), b(blue), a(alpha) {}
+    
+    static Color FromHSV(float h, float s, float v, float a = 1.0f) {
+        float c = v * s;
+        float x = c * (1.0f - static_cast<float>(std::fabs(std::fmod(h / 60.0f, 2.0f) - 1.0f)));
+        float m = v - c;
+        
+        float r, g, b;
+        
+        if (h >= 0 && h < 60) {
+            r = c; g = x; b = 0;
+        } else if (h >= 60 && h < 120) {
+            r = x; g = c; b = 0;
+        } else if (h >= 120 && h < 180) {
+            r = 0; g = c; b = x;
+        } else if (h >= 180 && h < 240) {
+            r = 0; g = x; b = c;
+        } else if (h >= 240 && h < 300) {
+            r = x; g = 0; b = c;
+        } else {
+            r = c; g = 0; b = x;
+        }
+        
+        return Color(r + m, g + m, b + m, a);
+    }
+};
+
+// Half-precision float conversion for compact per-cell storage
+// (round to nearest, denormals flushed to zero)
+inline uint16_t FloatToHalf(float value) {
+    uint32_t bits = std::bit_cast<uint32_t>(value);
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+    
+    if (exponent <= 0) return sign;                       // Underflow to signed zero
+    if (exponent >= 31) return static_cast<uint16_t>(sign | 0x7C00); // Overflow to infinity
+    
+    uint16_t half = static_cast<uint16_t>(sign | (exponent << 10) | (mantissa >> 13));
+    if (mantissa & 0x1000) {
+        half++; // Round to nearest; a carry into the exponent is still correct
+    }
+    return half;
+}
+
+inline float HalfToFloat(uint16_t half) {
+    uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+    
+    if (exponent == 0) return std::bit_cast<float>(sign); // Zero (denormals flushed)
+    if (exponent == 31) return std::bit_cast<float>(sign | 0x7F800000 | (mantissa << 13));
+    
+    return std::bit_cast<float>(sign | ((exponent - 15 + 127) << 23) | (mantissa << 13));
+}
+
+// GridCell flag bits
+enum CellFlags : uint8_t {
+    CELL_ACTIVE    = 1 << 0,
+    CELL_MORPHING  = 1 << 1,
+    CELL_GLITCHING = 1 << 2
+};
+
+constexpr uint32_t NO_EFFECT_SLOT = 0xFFFFFFFF;
+
+// Hot per-cell state for the persistent Matrix effect, packed to 16 bytes.
+// Font size and glow are derived from depth, alpha and age at render time;
+// morph and glitch state live in a CellEffectState side table that only the
+// cells currently running an effect use.
+struct GridCell {
+    uint16_t x = 0;                 // Grid column
+    uint16_t y = 0;                 // Grid row
+    GlyphId glyph = INVALID_GLYPH;  // Interned glyph
+    uint16_t alpha = 0;             // Half-float opacity
+    uint16_t age = 0;               // Half-float seconds since spawn (cells live a few seconds at most)
+    uint8_t depth = 128;            // 0-255 maps to depth 0.0-1.0
+    uint8_t flags = 0;              // CellFlags
+    uint32_t effectSlot = NO_EFFECT_SLOT; // Index into the effect side table
+    
+    bool IsActive() const { return (flags & CELL_ACTIVE) != 0; }
+    bool IsMorphing() const { return (flags & CELL_MORPHING) != 0; }
+    bool IsGlitching() const { return (flags & CELL_GLITCHING) != 0; }
+    void SetFlag(CellFlags flag, bool enabled) {
+        flags = enabled ? static_cast<uint8_t>(flags | flag) : static_cast<uint8_t>(flags & ~flag);
+    }
+    
+    float GetAlpha() const { return HalfToFloat(alpha); }
+    void SetAlpha(float value) { alpha = FloatToHalf(value); }
+    float GetAge() const { return HalfToFloat(age); }
+    void SetAge(float value) { age = FloatToHalf(value); }
+    float GetDepth() const { return depth * (1.0f / 255.0f); }
+    void SetDepth(float value) { depth = static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f); }
+};
+
+static_assert(sizeof(GridCell) == 16, "GridCell must stay 16 bytes");
+
+// A glitch lasts at most 0.3 s and steps 20 times a second, showing a stray
+// glyph on every other step: at most three of them
+constexpr float GLITCH_STEP_RATE = 20.0f;
+constexpr size_t GLITCH_SEQUENCE_LENGTH = 3;
+
+// Cold per-cell effect state, only allocated while a cell morphs or glitches
+struct CellEffectState {
+    // Morphing animation
+    GlyphId morphTarget = INVALID_GLYPH; // Glyph to morph into
+    
+    // Stray glyphs a glitch shows, chosen when it starts
+    std::array<GlyphId, GLITCH_SEQUENCE_LENGTH> glitchGlyphs = { INVALID_GLYPH, INVALID_GLYPH, INVALID_GLYPH };
+    
+    float morphProgress = 0.0f;     // 0.0 = original, 1.0 = target
+    float morphSpeed = 0.0f;        // How fast to morph
+    
+    // Glitch effects
+    float glitchIntensity = 0.0f;   // 0.0 = no glitch, 1.0 = full glitch
+    float glitchTimer = 0.0f;
+};
+
+// Matrix column structure for moving heads
+struct MatrixColumn {
+    float x, y;
+    float baseSpeed; // Base speed for this column
+    float currentSpeed; // Current speed (varies with depth)
+    float baseFontSize; // Base font size for this column layer
+    int layer; // Which layer this column belongs to (0=large, 1=medium, 2=small)
+    int customWordIndex = 0; // Current index in custom word for this column
+    GlyphId headGlyph = INVALID_GLYPH; // Picked each update so drawing needs no randomness
+    float alpha = 1.0f;
+    bool isActive = true; // Whether this column is currently dropping
+};
+
+// Matrix characters - expanded authentic set with morphing capability
+const std::vector<std::wstring> MATRIX_CHARS = {
+    // Katakana (main characters from movie)
+    L"ア", L"イ", L"ウ", L"エ", L"オ", L"カ", L"キ", L"ク", L"ケ", L"コ", L"サ", L"シ", L"ス", L"セ", L"ソ",
+    L"タ", L"チ", L"ツ", L"テ", L"ト", L"ナ", L"ニ", L"ヌ", L"ネ", L"ノ", L"ハ", L"ヒ", L"フ", L"ヘ", L"ホ",
+    L"マ", L"ミ", L"ム", L"メ", L"モ", L"ヤ", L"ユ", L"ヨ", L"ラ", L"リ", L"ル", L"レ", L"ロ", L"ワ", L"ヲ", L"ン",
+    
+    // Additional Katakana for more variety
+    L"ァ", L"ィ", L"ゥ", L"ェ", L"ォ", L"ガ", L"ギ", L"グ", L"ゲ", L"ゴ", L"ザ", L"ジ", L"ズ", L"ゼ", L"ゾ",
+    L"ダ", L"ヂ", L"ヅ", L"デ", L"ド", L"バ", L"ビ", L"ブ", L"ベ", L"ボ", L"パ", L"ピ", L"プ", L"ペ", L"ポ",
+    L"ヴ", L"ヵ", L"ヶ", L"ヮ", L"ヰ", L"ヱ", L"ヂ", L"ヅ",
+    
+    // Hiragana (mixed in occasionally)
+    L"あ", L"い", L"う", L"え", L"お", L"か", L"き", L"く", L"け", L"こ", L"さ", L"し", L"す", L"せ", L"そ",
+    L"た", L"ち", L"つ", L"て", L"と", L"な", L"に", L"ぬ", L"ね", L"の", L"は", L"ひ", L"ふ", L"へ", L"ほ",
+    
+    // Latin letters and numbers (occasional mixing like in the movie)
+    L"0", L"1", L"2", L"3", L"4", L"5", L"6", L"7", L"8", L"9",
+    L"A", L"B", L"C", L"D", L"E", L"F", L"G", L"H", L"I", L"J", L"K", L"L", L"M",
+    L"N", L"O", L"P", L"Q", L"R", L"S", L"T", L"U", L"V", L"W", L"X", L"Y", L"Z",
+    
+    // Mathematical and special symbols (rare)
+    L"∑", L"∏", L"∫", L"∂", L"∆", L"∇", L"π", L"λ", L"μ", L"σ", L"φ", L"ψ", L"ω",
+    L"≠", L"≤", L"≥", L"±", L"∞", L"√", L"∝", L"∈", L"∉", L"⊂", L"⊃", L"⊆", L"⊇",
+    
+    // Binary-looking symbols
+    L"｜", L"‖", L"║", L"│", L"┃", L"┆", L"┇", L"┊", L"┋", L"╎", L"╏", L"╽", L"╿"
+};
+
+// Character categories for different effects
+const std::vector<std::wstring> KATAKANA_CHARS = {
+    L"ア", L"イ", L"ウ", L"エ", L"オ", L"カ", L"キ", L"ク", L"ケ", L"コ", L"サ", L"シ", L"ス", L"セ", L"ソ",
+    L"タ", L"チ", L"ツ", L"テ", L"ト", L"ナ", L"ニ", L"ヌ", L"ネ", L"ノ", L"ハ", L"ヒ", L"フ", L"ヘ", L"ホ",
+    L"マ", L"ミ", L"ム", L"メ", L"モ", L"ヤ", L"ユ", L"ヨ", L"ラ", L"リ", L"ル", L"レ", L"ロ", L"ワ", L"ヲ", L"ン"
+};
+
+const std::vector<std::wstring> LATIN_CHARS = {
+    L"0", L"1", L"2", L"3", L"4", L"5", L"6", L"7", L"8", L"9",
+    L"A", L"B", L"C", L"D", L"E", L"F", L"G", L"H", L"I", L"J", L"K", L"L", L"M",
+    L"N", L"O", L"P", L"Q", L"R", L"S", L"T", L"U", L"V", L"W", L"X", L"Y", L"Z"
+};
+
+const std::vector<std::wstring> SYMBOL_CHARS = {
+    L"∑", L"∏", L"∫", L"∂", L"∆", L"∇", L"π", L"λ", L"μ", L"σ", L"φ", L"ψ", L"ω",
+    L"｜", L"‖", L"║", L"│", L"┃", L"┆", L"┇", L"┊", L"┋", L"╎", L"╏", L"╽", L"╿"
+};
+
+// FNV-1a, used for simulation state hashes
+constexpr uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325ull;
+
+inline uint64_t HashBytes(uint64_t hash, const unsigned char* data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+// Smooth interpolation utility
+inline float Lerp(float a, float b, float t) {
+    return a + t * (b - a);
+}
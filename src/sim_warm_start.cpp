@@ -0,0 +1,147 @@
+#include "sim_warm_start.h"
+#include "matrix_simulation.h"
+#include "sim_capture.h"
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr size_t HEADER_SIZE = 4 + 2 + 2 + 8 + 4 + 4;
+
+uint64_t HashSimSettings(const MatrixSettings& settings) {
+    std::string data;
+    SerializeSimSettings(settings, data);
+    return HashBytes(FNV_OFFSET_BASIS, reinterpret_cast<const unsigned char*>(data.data()), data.size());
+}
+
+template<typename T>
+void AppendValue(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+T ReadValue(std::string_view data, size_t offset) {
+    T value;
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+} // namespace
+
+void EncodeWarmStart(const MatrixSimulation& simulation, std::string& out) {
+    out.clear();
+    out.append(WARM_START_MAGIC, sizeof(WARM_START_MAGIC));
+    AppendValue(out, WARM_START_VERSION);
+    AppendValue(out, uint16_t(0));
+    AppendValue(out, HashSimSettings(simulation.GetSettings()));
+    AppendValue(out, static_cast<int32_t>(simulation.GetWidth()));
+    AppendValue(out, static_cast<int32_t>(simulation.GetHeight()));
+    simulation.SaveWarmState(out);
+}
+
+bool DecodeWarmStart(std::string_view data, MatrixSimulation& simulation) {
+    if (data.size() < HEADER_SIZE ||
+        std::memcmp(data.data(), WARM_START_MAGIC, sizeof(WARM_START_MAGIC)) != 0 ||
+        ReadValue<uint16_t>(data, 4) != WARM_START_VERSION) {
+        return false;
+    }
+
+    if (ReadValue<uint64_t>(data, 8) != HashSimSettings(simulation.GetSettings()) ||
+        ReadValue<int32_t>(data, 16) != simulation.GetWidth() ||
+        ReadValue<int32_t>(data, 20) != simulation.GetHeight()) {
+        return false;
+    }
+
+    return simulation.RestoreWarmState(data.substr(HEADER_SIZE));
+}
+
+bool SaveWarmStart(const std::filesystem::path& path, const MatrixSimulation& simulation) {
+    std::string data;
+    EncodeWarmStart(simulation, data);
+
+    std::filesystem::path temp = path;
+    temp += ".tmp";
+    {
+        std::ofstream file(temp, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!file.good()) return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp, path, error);
+    if (error) {
+        std::filesystem::remove(temp, error);
+        return false;
+    }
+    return true;
+}
+
+bool LoadWarmStart(const std::filesystem::path& path, MatrixSimulation& simulation) {
+    MappedFile file;
+    return file.Open(path) && DecodeWarmStart(file.GetData(), simulation);
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const std::filesystem::path& path) {
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size = {};
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    CloseHandle(file);
+    if (!mapping) return false;
+
+    // The view keeps the mapping alive
+    m_view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!m_view) return false;
+    m_size = static_cast<size_t>(size.QuadPart);
+#else
+    int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) return false;
+
+    struct stat status = {};
+    void* view = MAP_FAILED;
+    if (fstat(file, &status) == 0 && status.st_size > 0) {
+        view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    }
+    close(file);
+    if (view == MAP_FAILED) return false;
+
+    m_view = view;
+    m_size = static_cast<size_t>(status.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::Close() {
+    if (!m_view) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(m_view);
+#else
+    munmap(const_cast<void*>(m_view), m_size);
+#endif
+    m_view = nullptr;
+    m_size = 0;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+class MatrixSimulation;
+
+// Warm start (.mxws): the scene a session ended on, saved at shutdown and
+// restored right after the next start lays out its columns, so the first
+// frame shows full rain instead of an empty screen filling up over seconds.
+//
+// The file is memory-mapped and decoded in place. It is only used when the
+// screen size and the simulation settings (VisitSimSettings) match those it
+// was saved with; otherwise the start is cold, as it is with no file. The
+// random stream is not part of it: a restored scene continues from the new
+// session's seed, so sessions recording a capture start cold to stay
+// reproducible.
+//
+// Layout, little-endian:
+//   header:  "MXWS" magic, u16 version, u16 reserved, u64 settings hash,
+//            i32 width, i32 height
+//   glyphs:  u16 count, then per glyph u8 count + UTF-16 units; the state
+//            below refers to glyphs by their index here (0xFFFF for none)
+//   columns: u32 count, then per column f32 y, f32 base speed,
+//            f32 current speed, i32 word index, u16 head glyph, f32 alpha,
+//            u8 active
+//   cells:   u32 count, then per cell u16 x, u16 y, u16 glyph, u16 alpha,
+//            u16 age (half floats), u8 depth, u8 flags; a morphing or
+//            glitching cell is followed by u16 morph target, f32 morph
+//            progress, f32 morph speed, f32 glitch intensity, f32 glitch timer,
+//            3 x u16 glitch glyph (v2)
+//   effects: f32 disruption timer, f32 time since disruption,
+//            f32 rain phase, i32 effect frames, f32 effect time
+constexpr char WARM_START_MAGIC[4] = { 'M', 'X', 'W', 'S' };
+constexpr uint16_t WARM_START_VERSION = 2;          // Older files start cold
+
+void EncodeWarmStart(const MatrixSimulation& simulation, std::string& out);
+bool DecodeWarmStart(std::string_view data, MatrixSimulation& simulation);
+
+// Written beside the target and renamed over it
+bool SaveWarmStart(const std::filesystem::path& path, const MatrixSimulation& simulation);
+bool LoadWarmStart(const std::filesystem::path& path, MatrixSimulation& simulation);
+
+// Read-only view of a whole file, mapped rather than read
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::filesystem::path& path);
+    void Close();
+    std::string_view GetData() const { return { static_cast<const char*>(m_view), m_size }; }
+
+private:
+    const void* m_view = nullptr;
+    size_t m_size = 0;
+};
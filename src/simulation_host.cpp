@@ -0,0 +1,146 @@
+#include "simulation_host.h"
+#include <algorithm>
+
+SimulationHost::~SimulationHost() {
+    Stop();
+}
+
+void SimulationHost::Start() {
+    if (m_thread.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = false;
+        m_pendingTime = 0.0f;
+        m_pendingFrames = 0;
+    }
+    m_aheadTime = 0.0f;
+    m_thread = std::thread(&SimulationHost::ThreadMain, this);
+}
+
+void SimulationHost::Stop() {
+    if (!m_thread.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+void SimulationHost::Post(Command command) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_commands.push_back(std::move(command));
+}
+
+void SimulationHost::StopRecording() {
+    Post([this](MatrixSimulation&, SimRecorder*) { m_recorder.reset(); });
+}
+
+void SimulationHost::SetViewports(std::vector<SimViewport> viewports) {
+    Post([this, viewports = std::move(viewports)](MatrixSimulation&, SimRecorder*) mutable {
+        m_viewports = std::move(viewports);
+    });
+}
+
+void SimulationHost::Advance(float deltaTime) {
+    if (!m_thread.joinable()) {
+        RunCommands();
+        Step(deltaTime);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pendingTime += deltaTime;
+        m_pendingFrames++;
+    }
+    m_wake.notify_one();
+}
+
+void SimulationHost::RunCommands() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_runningCommands.swap(m_commands);
+    }
+
+    for (Command& command : m_runningCommands) {
+        command(m_simulation, m_recorder.get());
+    }
+    m_runningCommands.clear();
+}
+
+void SimulationHost::ThreadMain() {
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point lastUpdate = Clock::now();
+    bool stalled = false;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        auto timeout = stalled
+            ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(m_framePeriod))
+            : std::chrono::duration_cast<Clock::duration>(STALL_TIMEOUT);
+        bool advanced = m_wake.wait_for(lock, timeout, [this] { return m_stopping || m_pendingFrames > 0; });
+        if (m_stopping) break;
+
+        float deltaTime = 0.0f;
+        Clock::time_point now = Clock::now();
+        if (advanced) {
+            float requested = m_pendingTime;
+            m_framePeriod = std::clamp(requested / m_pendingFrames, 1.0f / 240.0f, 1.0f / 24.0f);
+            m_pendingTime = 0.0f;
+            m_pendingFrames = 0;
+            stalled = false;
+
+            // Don't simulate again the time covered while the render loop stalled
+            deltaTime = std::max(requested - m_aheadTime, 0.0f);
+            m_aheadTime = std::max(m_aheadTime - requested, 0.0f);
+        } else {
+            stalled = true;
+            deltaTime = std::chrono::duration<float>(now - lastUpdate).count();
+            m_aheadTime += deltaTime;
+        }
+        lastUpdate = now;
+        lock.unlock();
+
+        RunCommands();
+        if (deltaTime > 0.0f) {
+            Step(deltaTime);
+        }
+
+        lock.lock();
+    }
+}
+
+void SimulationHost::Step(float deltaTime) {
+    bool timed = m_profiling.load(std::memory_order_relaxed);
+
+    m_simulation.Update(deltaTime, timed ? &m_profiler : nullptr);
+    m_frames++;
+    m_simulatedTime += deltaTime;
+    m_totalSpawns += m_simulation.GetFrameSpawns();
+
+    if (m_recorder) {
+        m_recorder->RecordFrame(deltaTime, m_simulation);
+    }
+
+    PublishSnapshot(timed);
+}
+
+void SimulationHost::PublishSnapshot(bool timed) {
+    FrameSnapshot& snapshot = m_snapshots.GetWriteBuffer();
+    m_simulation.BuildSnapshot(snapshot, m_viewports);
+    snapshot.frame = m_frames;
+    snapshot.totalSpawns = m_totalSpawns;
+
+    snapshot.hasTiming = false;
+    if (timed) {
+        m_profiler.EndFrame();
+        snapshot.hasTiming = m_profiler.GetLatestSample(snapshot.timing);
+        snapshot.timingEpoch = m_profiler.GetEpoch();
+    }
+
+    m_snapshots.Publish();
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "matrix_simulation.h"
+#include "sim_capture.h"
+#include "sim_snapshot.h"
+#include "triple_buffer.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs MatrixSimulation, inline or on its own thread, and publishes a
+// FrameSnapshot after every update through a triple buffer.
+//
+// Threaded, each Advance() from the render loop releases one update on the
+// simulation thread and returns at once, so simulating frame N+1 overlaps
+// drawing and presenting frame N; the renderer always draws the newest
+// complete snapshot. If the render loop stops advancing for STALL_TIMEOUT
+// (a blocked Present, a modal loop), the simulation keeps going at the last
+// frame period on its own, and the time it ran ahead is deducted from the
+// next Advance() calls so simulated and real time stay equal.
+//
+// All changes to the simulation go through Post(); commands run on the
+// simulation's thread before its next update, in order. The capture
+// recorder lives here too, so a capture records exactly what the thread ran.
+class SimulationHost {
+public:
+    using Command = std::function<void(MatrixSimulation&, SimRecorder*)>;
+
+    static constexpr std::chrono::milliseconds STALL_TIMEOUT{100};
+
+    SimulationHost() = default;
+    ~SimulationHost();
+
+    SimulationHost(const SimulationHost&) = delete;
+    SimulationHost& operator=(const SimulationHost&) = delete;
+
+    // Direct access, only while the thread is not running (setup, teardown)
+    MatrixSimulation& GetSimulation() { return m_simulation; }
+    SimRecorder* GetRecorder() { return m_recorder.get(); }
+    void SetRecorder(std::unique_ptr<SimRecorder> recorder) { m_recorder = std::move(recorder); }
+
+    void Start();
+    void Stop();
+    bool IsThreaded() const { return m_thread.joinable(); }
+
+    // Queue a change for the simulation
+    void Post(Command command);
+
+    // Close the capture after the updates already requested
+    void StopRecording();
+
+    // Outputs to cull and group the snapshots for, from the next update on
+    void SetViewports(std::vector<SimViewport> viewports);
+
+    // One frame of the render loop. Inline this runs the update before
+    // returning; threaded it only signals the simulation thread.
+    void Advance(float deltaTime);
+
+    // Render side: pick up the newest snapshot; false if there is none newer
+    bool AcquireSnapshot() { return m_snapshots.Acquire(); }
+    const FrameSnapshot& GetSnapshot() const { return m_snapshots.GetReadBuffer(); }
+
+    // Seconds simulated so far; read from a command or while the thread is not running
+    double GetSimulatedTime() const { return m_simulatedTime; }
+
+    // Time the simulation phases into the snapshots
+    void SetProfiling(bool enabled) { m_profiling.store(enabled, std::memory_order_relaxed); }
+
+private:
+    void ThreadMain();
+    void RunCommands();
+    void Step(float deltaTime);
+    void PublishSnapshot(bool timed);
+
+    MatrixSimulation m_simulation;
+    std::unique_ptr<SimRecorder> m_recorder;
+    FrameProfiler m_profiler;
+    std::atomic<bool> m_profiling{false};
+    uint64_t m_frames = 0;
+    uint64_t m_totalSpawns = 0;
+    double m_simulatedTime = 0.0;
+
+    TripleBuffer<FrameSnapshot> m_snapshots;
+
+    // Shared with the render loop, guarded by m_mutex
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<Command> m_commands;
+    float m_pendingTime = 0.0f;
+    int m_pendingFrames = 0;
+    bool m_stopping = false;
+
+    // Simulation thread only
+    std::thread m_thread;
+    std::vector<Command> m_runningCommands;
+    float m_aheadTime = 0.0f;           // Seconds simulated while the render loop stalled
+    float m_framePeriod = 1.0f / 60.0f; // Recent Advance() spacing, used to pace a stall
+    std::vector<SimViewport> m_viewports;
+};
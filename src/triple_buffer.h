@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Single-producer, single-consumer triple buffer.
+//
+// The producer fills the write slot and publishes it; the consumer picks up
+// whatever was published last. Publishing and acquiring each swap one slot
+// index with the shared middle slot in a single atomic exchange, so neither
+// side ever blocks or waits on the other, and values the consumer was too
+// slow to see are simply overwritten. Slots are reused in rotation, so T's
+// containers keep their capacity and steady-state use does not allocate.
+template<typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Producer: the slot to fill for the next Publish()
+    T& GetWriteBuffer() { return m_slots[m_back]; }
+
+    // Producer: hand the write slot to the consumer and take a free one
+    void Publish() {
+        uint8_t previous = m_middle.exchange(static_cast<uint8_t>(m_back | FRESH), std::memory_order_acq_rel);
+        m_back = previous & INDEX_MASK;
+    }
+
+    // Consumer: switch to the newest published value, if there is one since
+    // the last call. Returns false when the read slot is unchanged.
+    bool Acquire() {
+        if ((m_middle.load(std::memory_order_relaxed) & FRESH) == 0) return false;
+
+        uint8_t previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & INDEX_MASK;
+        return true;
+    }
+
+    // Consumer: the value taken by the last successful Acquire()
+    const T& GetReadBuffer() const { return m_slots[m_front]; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH = 0x4;   // Set while the middle slot holds an unread value
+
+    std::array<T, 3> m_slots;
+    uint8_t m_back = 0;                     // Producer-owned
+    alignas(64) std::atomic<uint8_t> m_middle{1};
+    alignas(64) uint8_t m_front = 2;        // Consumer-owned
+};
@@ -0,0 +1,218 @@
+// Binary log decoding (src/binary_log.h, src/binary_log_reader.h): records
+// are written by hand in the documented layout, packed with the same
+// BinaryArgWriter the logger uses, and decoded back to text.
+
+#include "binary_log_reader.h"
+#include "test_check.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 2024-05-01 12:00:00 UTC
+constexpr int64_t START_WALL_CLOCK_US = 1714564800LL * 1000000;
+constexpr int64_t TICKS_PER_SECOND = 1000;
+constexpr int64_t START_TICKS = 500;
+
+class LogBuilder {
+public:
+    const std::string& GetData() const { return m_data; }
+
+    void Session() {
+        Put(BinaryLogRecordKind::Session);
+        m_data.append(BINARY_LOG_MAGIC, sizeof(BINARY_LOG_MAGIC));
+        Put(BINARY_LOG_VERSION);
+        Put(TICKS_PER_SECOND);
+        Put(START_TICKS);
+        Put(START_WALL_CLOCK_US);
+    }
+
+    void Format(uint16_t id, std::string_view text) {
+        Put(BinaryLogRecordKind::Format);
+        Put(id);
+        Put(static_cast<uint16_t>(text.size()));
+        m_data += text;
+    }
+
+    template<typename... Args>
+    void Message(uint8_t level, uint16_t formatId, int64_t ticks, const Args&... args) {
+        char payload[256];
+        BinaryArgWriter writer(payload, sizeof(payload));
+        (writer.Add(args), ...);
+        Raw(level, formatId, ticks, std::string_view(payload, writer.GetLength()));
+    }
+
+    void Raw(uint8_t level, uint16_t formatId, int64_t ticks, std::string_view payload) {
+        Put(BinaryLogRecordKind::Message);
+        Put(level);
+        Put(formatId);
+        Put(ticks);
+        Put(static_cast<uint16_t>(payload.size()));
+        m_data += payload;
+    }
+
+    void Dropped(int64_t ticks, uint64_t count) {
+        Put(BinaryLogRecordKind::Dropped);
+        Put(ticks);
+        Put(count);
+    }
+
+private:
+    template<typename T>
+    void Put(T value) {
+        m_data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    std::string m_data;
+};
+
+std::vector<std::string> Decode(const std::string& data, std::string* error = nullptr) {
+    BinaryLogReader reader(data);
+    reader.SetUtc(true);
+    std::vector<std::string> lines;
+    std::string line;
+    while (reader.NextLine(line)) {
+        lines.push_back(line);
+    }
+    if (error) *error = reader.GetError();
+    return lines;
+}
+
+void TestRoundTrip() {
+    LogBuilder log;
+    log.Session();
+    log.Raw(1, BINARY_LOG_PLAIN_FORMAT, START_TICKS, "Logging initialized");
+    log.Format(1, "Flushed {} characters in {} draw calls ({:.1f}%)");
+    log.Message(0, 1, START_TICKS + 1234, 2048u, 12, 37.25);
+    log.Format(2, "Device {}: {} {}");
+    log.Message(3, 2, START_TICKS + 60000, std::string_view("lost"), true, 'x');
+    log.Dropped(START_TICKS + 61000, 42);
+
+    std::string error;
+    std::vector<std::string> lines = Decode(log.GetData(), &error);
+    CHECK(error.empty());
+    CHECK(lines.size() == 5);
+    if (lines.size() != 5) return;
+    CHECK(lines[0] == "===== Matrix Screensaver Started =====");
+    CHECK(lines[1] == "2024-05-01 12:00:00.000 [INFO]  Logging initialized");
+    CHECK(lines[2] == "2024-05-01 12:00:01.234 [DEBUG] Flushed 2048 characters in 12 draw calls (37.2%)");
+    CHECK(lines[3] == "2024-05-01 12:01:00.000 [ERROR] Device lost: true x");
+    CHECK(lines[4] == "2024-05-01 12:01:01.000 [WARN]  Log queue full, dropped 42 messages");
+}
+
+// Format IDs restart with each session, and a later session's banner is
+// set off by a blank line as in the text log
+void TestSessionsResetFormats() {
+    LogBuilder log;
+    log.Session();
+    log.Format(1, "first {}");
+    log.Message(1, 1, START_TICKS, 1);
+    log.Session();
+    log.Message(1, 1, START_TICKS, 2);
+
+    std::vector<std::string> lines = Decode(log.GetData());
+    CHECK(lines.size() == 4);
+    if (lines.size() != 4) return;
+    CHECK(lines[1].ends_with("first 1"));
+    CHECK(lines[2] == "\n===== Matrix Screensaver Started =====");
+    CHECK(lines[3].ends_with("<unknown format 1>"));
+}
+
+// Arguments that did not fit the writer's buffer show as "{?}"; a string
+// is cut to the room left
+void TestTruncatedArguments() {
+    char payload[12];
+    BinaryArgWriter writer(payload, sizeof(payload));
+    writer.Add(7);                                  // 9 bytes
+    writer.Add(std::string_view("abcdef"));         // Only its length fits: empty
+    writer.Add(8);                                  // No room
+    CHECK(writer.GetLength() == sizeof(payload));
+
+    LogBuilder log;
+    log.Session();
+    log.Format(1, "{} [{}] {}");
+    log.Raw(1, 1, START_TICKS, std::string_view(payload, writer.GetLength()));
+    std::vector<std::string> lines = Decode(log.GetData());
+    CHECK(lines.size() == 2);
+    if (lines.size() == 2) {
+        CHECK(lines[1].ends_with("7 [] {?}"));
+    }
+}
+
+void TestCorruptData() {
+    LogBuilder log;
+    log.Session();
+    log.Raw(1, BINARY_LOG_PLAIN_FORMAT, START_TICKS, "whole");
+    std::string data = log.GetData();
+
+    std::string error;
+    std::vector<std::string> lines = Decode(data.substr(0, data.size() - 2), &error);
+    CHECK(lines.size() == 1);
+    CHECK(error.starts_with("truncated record"));
+
+    data.push_back(static_cast<char>(99));
+    lines = Decode(data, &error);
+    CHECK(lines.size() == 2);
+    CHECK(error.starts_with("unknown record kind 99"));
+
+    // A message before any session has no time base
+    LogBuilder orphan;
+    orphan.Raw(1, BINARY_LOG_PLAIN_FORMAT, 0, "early");
+    lines = Decode(orphan.GetData());
+    CHECK(lines.size() == 1 && lines[0] == "[NO_SESSION] [INFO]  early");
+}
+
+// The decoder's formatting gives what std::format gave the text log (the
+// expected strings are std::format's output for the same spec)
+void TestFormatSpecs() {
+    auto matches = [](const BinaryLogArg& arg, std::string_view spec, const char* expected) {
+        std::string actual = FormatLogArg(arg, spec);
+        if (actual != expected) {
+            std::fprintf(stderr, "spec \"%.*s\": \"%s\", expected \"%s\"\n",
+                         static_cast<int>(spec.size()), spec.data(), actual.c_str(), expected);
+        }
+        return actual == expected;
+    };
+
+    BinaryLogArg integer;
+    integer.type = BinaryLogArgType::Int;
+    integer.i = -42;
+    CHECK(matches(integer, "", "-42"));
+    CHECK(matches(integer, ">6", "   -42"));
+    CHECK(matches(integer, "06", "-00042"));
+    CHECK(matches(integer, "*^9", "***-42***"));
+
+    BinaryLogArg unsignedValue;
+    unsignedValue.type = BinaryLogArgType::UInt;
+    unsignedValue.u = 255;
+    CHECK(matches(unsignedValue, "#x", "0xff"));
+    CHECK(matches(unsignedValue, "08b", "11111111"));
+    CHECK(matches(unsignedValue, "+", "+255"));
+
+    BinaryLogArg real;
+    real.type = BinaryLogArgType::Double;
+    real.d = 3.14159;
+    CHECK(matches(real, "", "3.14159"));
+    CHECK(matches(real, ".2f", "3.14"));
+    CHECK(matches(real, "10.3e", " 3.142e+00"));
+    CHECK(matches(real, "<8.1f", "3.1     "));
+
+    BinaryLogArg text;
+    text.type = BinaryLogArgType::String;
+    text.text = "glyph";
+    CHECK(matches(text, "", "glyph"));
+    CHECK(matches(text, "-^9", "--glyph--"));
+    CHECK(matches(text, ".3", "gly"));
+}
+
+} // namespace
+
+int main() {
+    TestRoundTrip();
+    TestSessionsResetFormats();
+    TestTruncatedArguments();
+    TestCorruptData();
+    TestFormatSpecs();
+    return TestResult();
+}
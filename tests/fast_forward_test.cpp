@@ -0,0 +1,138 @@
+// MatrixSimulation::FastForward (src/matrix_simulation.h) against stepping:
+// a simulation jumped ahead in one call looks, statistically, like its twin
+// stepped at 60 Hz for as long, and the jump is deterministic. Timing is
+// left to tools/matrix_prewarm.
+
+#include "matrix_simulation.h"
+#include "test_check.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr int WIDTH = 1920;
+constexpr int HEIGHT = 1080;
+constexpr float SECONDS = 3.0f;
+constexpr float STEP = 1.0f / 60.0f;
+constexpr int RUNS = 4;
+
+struct SceneStats {
+    double cells = 0.0;
+    double alpha = 0.0;         // Mean over the cells
+    double bands[3] = {};       // Share of the cells in the top, middle and bottom third
+    double heads = 0.0;         // Columns with a head on screen
+};
+
+SceneStats Measure(const MatrixSimulation& simulation) {
+    SceneStats stats;
+    const std::vector<GridCell>& cells = simulation.GetActiveCells();
+    stats.cells = static_cast<double>(cells.size());
+
+    int rows = 1;
+    for (const GridCell& cell : cells) {
+        rows = std::max(rows, cell.y + 1);
+    }
+    for (const GridCell& cell : cells) {
+        stats.alpha += cell.GetAlpha();
+        stats.bands[std::min(2, cell.y * 3 / rows)] += 1.0;
+    }
+    if (!cells.empty()) {
+        stats.alpha /= stats.cells;
+        for (double& band : stats.bands) {
+            band /= stats.cells;
+        }
+    }
+
+    for (const MatrixColumn& column : simulation.GetColumns()) {
+        if (column.headGlyph != INVALID_GLYPH) {
+            stats.heads += 1.0;
+        }
+    }
+    return stats;
+}
+
+void Accumulate(SceneStats& total, const SceneStats& stats) {
+    total.cells += stats.cells / RUNS;
+    total.alpha += stats.alpha / RUNS;
+    for (int i = 0; i < 3; ++i) {
+        total.bands[i] += stats.bands[i] / RUNS;
+    }
+    total.heads += stats.heads / RUNS;
+}
+
+// Averaged over a few seeds, the scenes agree as closely as matrix_prewarm
+// requires: cell count within 10%, mean alpha within 0.05
+void TestMatchesStepping(const MatrixSettings& settings) {
+    SceneStats fastTotal;
+    SceneStats steppedTotal;
+    for (int run = 0; run < RUNS; ++run) {
+        uint32_t seed = 500u + static_cast<uint32_t>(run);
+
+        MatrixSimulation fast;
+        fast.Initialize(settings, WIDTH, HEIGHT, seed);
+        fast.FastForward(SECONDS);
+        Accumulate(fastTotal, Measure(fast));
+
+        MatrixSimulation stepped;
+        stepped.Initialize(settings, WIDTH, HEIGHT, seed);
+        for (int step = 0; step < static_cast<int>(SECONDS / STEP + 0.5f); ++step) {
+            stepped.Update(STEP);
+        }
+        Accumulate(steppedTotal, Measure(stepped));
+    }
+
+    CHECK(steppedTotal.cells > 500.0);
+    CHECK_NEAR(fastTotal.cells / steppedTotal.cells, 1.0, 0.10);
+    CHECK_NEAR(fastTotal.alpha, steppedTotal.alpha, 0.05);
+    for (int i = 0; i < 3; ++i) {
+        CHECK_NEAR(fastTotal.bands[i], steppedTotal.bands[i], 0.05);
+    }
+    CHECK_NEAR(fastTotal.heads / steppedTotal.heads, 1.0, 0.10);
+}
+
+// The same seed jumps to the same state, and the simulation keeps running
+// normally afterwards
+void TestDeterministic(const MatrixSettings& settings) {
+    MatrixSimulation first;
+    first.Initialize(settings, WIDTH, HEIGHT, 77);
+    first.FastForward(SECONDS);
+
+    MatrixSimulation second;
+    second.Initialize(settings, WIDTH, HEIGHT, 77);
+    second.FastForward(SECONDS);
+    CHECK(first.ComputeStateHash() == second.ComputeStateHash());
+
+    for (int step = 0; step < 60; ++step) {
+        first.Update(STEP);
+        second.Update(STEP);
+    }
+    CHECK(first.ComputeStateHash() == second.ComputeStateHash());
+    CHECK(!first.GetActiveCells().empty());
+}
+
+void TestZeroIsNoOp(const MatrixSettings& settings) {
+    MatrixSimulation simulation;
+    simulation.Initialize(settings, WIDTH, HEIGHT, 3);
+    uint64_t before = simulation.ComputeStateHash();
+    simulation.FastForward(0.0f);
+    CHECK(simulation.ComputeStateHash() == before);
+    CHECK(simulation.GetActiveCells().empty());
+}
+
+} // namespace
+
+int main() {
+    MatrixSettings settings;
+    GlyphTable::Instance().InternWord(settings.customWord);
+
+    TestMatchesStepping(settings);
+
+    // Faster fades leave a shorter window of cells to reconstruct
+    MatrixSettings quickFade = settings;
+    quickFade.fadeRate = 4.0f;
+    TestMatchesStepping(quickFade);
+
+    TestDeterministic(settings);
+    TestZeroIsNoOp(settings);
+    return TestResult();
+}
@@ -0,0 +1,125 @@
+// FrameArena and its containers (src/frame_arena.h). Built with
+// MATRIX_COUNT_ALLOCATIONS so the steady-state check sees every heap call.
+
+#include "alloc_counter.h"
+#include "frame_arena.h"
+#include "test_check.h"
+#include <cstdint>
+
+namespace {
+
+bool IsAligned(const void* ptr, size_t alignment) {
+    return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+void TestAlignmentAndAccounting() {
+    FrameArena arena(4096);
+    void* a = arena.Allocate(3, 1);
+    void* b = arena.Allocate(8, 8);
+    void* c = arena.Allocate(16, 64);
+    CHECK(IsAligned(b, 8));
+    CHECK(IsAligned(c, 64));
+    CHECK(a != b && b != c);
+    CHECK(arena.GetBytesUsed() >= 3 + 8 + 16);
+    CHECK(arena.GetOverflowCount() == 0);
+
+    // Zero-byte requests still get distinct addresses
+    void* d = arena.Allocate(0, 1);
+    void* e = arena.Allocate(0, 1);
+    CHECK(d != e);
+}
+
+void TestResetReusesMemory() {
+    FrameArena arena(4096);
+    void* first = arena.Allocate(128);
+    arena.Reset();
+    CHECK(arena.GetBytesUsed() == 0);
+    CHECK(arena.GetHighWaterMark() >= 128);
+    CHECK(arena.Allocate(128) == first);
+}
+
+// A frame that outgrows the arena overflows once; Reset() folds the blocks
+// so the same frame fits in one block from then on
+void TestOverflowFolds() {
+    FrameArena arena(4096);
+    for (int i = 0; i < 10; ++i) {
+        arena.Allocate(1000);
+    }
+    CHECK(arena.GetOverflowCount() > 0);
+    size_t overflows = arena.GetOverflowCount();
+    size_t capacity = arena.GetCapacity();
+
+    for (int frame = 0; frame < 5; ++frame) {
+        arena.Reset();
+        CHECK(arena.GetCapacity() == capacity);
+        for (int i = 0; i < 10; ++i) {
+            arena.Allocate(1000);
+        }
+    }
+    CHECK(arena.GetOverflowCount() == overflows);
+}
+
+void TestContainers() {
+    FrameArena arena;
+    FrameVector<int> numbers{ ArenaAllocator<int>(&arena) };
+    for (int i = 0; i < 1000; ++i) {
+        numbers.push_back(i);
+    }
+    CHECK(numbers.size() == 1000);
+    CHECK(numbers[999] == 999);
+    CHECK(arena.GetBytesUsed() >= 1000 * sizeof(int));
+
+    FrameWString text{ ArenaAllocator<wchar_t>(&arena) };
+    text.assign(L"a string long enough to leave the small-string buffer");
+    text += L" and then some";
+    CHECK(text.size() > 60);
+
+    // A null arena falls back to the heap
+    FrameVector<int> heap;
+    heap.push_back(1);
+    CHECK(heap.get_allocator().GetArena() == nullptr);
+    CHECK(heap[0] == 1);
+}
+
+// Once the first frames have sized the arena, frames of the same shape
+// make no heap allocations at all
+void TestSteadyStateMakesNoHeapCalls() {
+    FrameArena arena(1024);
+    auto frame = [&arena](int frameIndex) {
+        FrameVector<int> cells{ ArenaAllocator<int>(&arena) };
+        FrameWString label{ ArenaAllocator<wchar_t>(&arena) };
+        for (int i = 0; i < 5000; ++i) {
+            cells.push_back(i + frameIndex);
+        }
+        for (int i = 0; i < 200; ++i) {
+            label += static_cast<wchar_t>(L'0' + i % 10);
+        }
+        CHECK(cells.size() == 5000);
+        CHECK(label.size() == 200);
+    };
+
+    for (int i = 0; i < 3; ++i) {
+        frame(i);
+        arena.Reset();
+    }
+
+    AllocationStats before = GetAllocationStats();
+    for (int i = 0; i < 100; ++i) {
+        frame(i);
+        arena.Reset();
+    }
+    AllocationStats after = GetAllocationStats();
+    CHECK(IsAllocationCountingEnabled());
+    CHECK(after.allocations == before.allocations);
+}
+
+} // namespace
+
+int main() {
+    TestAlignmentAndAccounting();
+    TestResetReusesMemory();
+    TestOverflowFolds();
+    TestContainers();
+    TestSteadyStateMakesNoHeapCalls();
+    return TestResult();
+}
@@ -0,0 +1,158 @@
+// FramePacer scheduling (src/frame_pacer.h) against a fake clock: deadlines
+// do not drift, the spin window tracks oversleep but stays capped, and a
+// coarse timer costs lateness rather than a spinning core.
+
+#include "frame_pacer.h"
+#include "test_check.h"
+#include <algorithm>
+
+namespace {
+
+constexpr int64_t MS = 1'000'000;
+
+// Sleeps overshoot by `oversleep`, or wake on the next `tick` boundary when
+// set, the way a coarse system timer does. Each poll while spinning costs
+// 10 us, and the time spent spinning is counted.
+class FakeClock : public PacerClock {
+public:
+    int64_t now = 1000 * MS;
+    int64_t oversleep = 0;
+    int64_t tick = 0;
+    int64_t spun = 0;
+    int sleeps = 0;
+    bool wakeEarly = false;
+
+    int64_t Now() override { return now; }
+
+    bool Sleep(int64_t duration) override {
+        sleeps++;
+        if (wakeEarly) {
+            wakeEarly = false;
+            now += duration / 2;
+            return false;
+        }
+        now += duration + oversleep;
+        if (tick > 0) {
+            now = (now + tick - 1) / tick * tick;
+        }
+        return true;
+    }
+
+    void Relax() override {
+        now += 10'000;
+        spun += 10'000;
+    }
+};
+
+// Run `frames` frames, each taking `work` of frame time, and return the
+// worst per-frame spin
+int64_t RunFrames(FramePacer& pacer, FakeClock& clock, int frames, int64_t work) {
+    int64_t worstSpin = 0;
+    for (int i = 0; i < frames; ++i) {
+        int64_t spunBefore = clock.spun;
+        while (!pacer.Wait()) {}
+        worstSpin = std::max(worstSpin, clock.spun - spunBefore);
+        pacer.BeginFrame();
+        clock.now += work;
+    }
+    return worstSpin;
+}
+
+// Frames start on anchor + k * period however long the work took
+void TestDeadlinesDoNotDrift() {
+    FakeClock clock;
+    clock.oversleep = 100'000;
+    FramePacer pacer(clock, 60.0);
+
+    int64_t start = clock.now;
+    pacer.BeginFrame();
+    RunFrames(pacer, clock, 599, 3 * MS);
+    while (!pacer.Wait()) {}
+
+    int64_t expected = start + static_cast<int64_t>(1e9 / 60.0 + 0.5) * 600;
+    CHECK(clock.now >= expected);
+    CHECK(clock.now - expected <= 20'000);
+    CHECK(pacer.GetStats().missedDeadlines == 0);
+    CHECK(pacer.GetStats().maxLatenessMs < 0.05f);
+}
+
+// A clock that oversleeps a little gets a window just past its oversleep
+void TestSpinWindowTracksOversleep() {
+    FakeClock clock;
+    clock.oversleep = 400'000;
+    FramePacer pacer(clock, 60.0);
+    pacer.BeginFrame();
+    RunFrames(pacer, clock, 300, 2 * MS);
+
+    float window = pacer.GetStats().spinWindowMs;
+    CHECK(window >= 0.6f && window < 0.7f);
+    CHECK(pacer.GetStats().maxLatenessMs < 0.05f);
+}
+
+// A 15.6 ms system tick would want a window of most of the frame; the
+// window stops at the cap and the frames run late instead
+void TestCoarseTimerIsCapped() {
+    FakeClock clock;
+    clock.tick = 15'625'000;
+    FramePacer pacer(clock, 60.0);
+    pacer.BeginFrame();
+    int64_t worstSpin = RunFrames(pacer, clock, 300, 2 * MS);
+
+    CHECK(pacer.GetStats().spinWindowMs <= 1.5f);
+    CHECK(worstSpin <= 1'500'000 + 10'000);
+    CHECK(pacer.GetStats().maxLatenessMs > 1.0f);
+}
+
+// At high rates half a period is tighter than the absolute cap
+void TestWindowWithinHalfPeriod() {
+    FakeClock clock;
+    clock.oversleep = 3 * MS;
+    FramePacer pacer(clock, 240.0);
+    pacer.BeginFrame();
+    RunFrames(pacer, clock, 100, 1 * MS);
+
+    CHECK(pacer.GetStats().spinWindowMs <= 1e3f / 240.0f / 2.0f + 0.001f);
+}
+
+// An early wakeup hands control back; the next Wait picks the schedule up
+void TestEarlyWakeup() {
+    FakeClock clock;
+    FramePacer pacer(clock, 60.0);
+    pacer.BeginFrame();
+    int64_t deadline = clock.now + static_cast<int64_t>(1e9 / 60.0 + 0.5);
+
+    clock.wakeEarly = true;
+    CHECK(!pacer.Wait());
+    CHECK(clock.now < deadline);
+    CHECK(pacer.Wait());
+    CHECK(clock.now >= deadline);
+}
+
+// A frame a whole period late re-anchors instead of bursting to catch up
+void TestMissedDeadlineReanchors() {
+    FakeClock clock;
+    FramePacer pacer(clock, 60.0);
+    pacer.BeginFrame();
+    clock.now += 50 * MS;
+    CHECK(pacer.Wait());
+    pacer.BeginFrame();
+    CHECK(pacer.GetStats().missedDeadlines == 1);
+
+    int sleepsBefore = clock.sleeps;
+    int64_t before = clock.now;
+    CHECK(pacer.Wait());
+    CHECK(clock.sleeps > sleepsBefore);
+    CHECK(clock.now - before >= 16 * MS);
+}
+
+} // namespace
+
+int main() {
+    TestDeadlinesDoNotDrift();
+    TestSpinWindowTracksOversleep();
+    TestCoarseTimerIsCapped();
+    TestWindowWithinHalfPeriod();
+    TestEarlyWakeup();
+    TestMissedDeadlineReanchors();
+    return TestResult();
+}
@@ -0,0 +1,127 @@
+// FrameProfiler phase accounting and percentiles (src/frame_profiler.h),
+// fed with synthetic time points so every result is exact.
+
+#include "frame_profiler.h"
+#include "test_check.h"
+
+namespace {
+
+using Clock = FrameProfiler::Clock;
+
+Clock::time_point At(Clock::time_point base, double ms) {
+    return base + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(ms));
+}
+
+// Phases add up within a frame, Wait is kept out of the frame time, and
+// each phase remembers where it first started
+void TestFrameAccounting() {
+    FrameProfiler profiler;
+    Clock::time_point base = profiler.GetEpoch();
+
+    FrameSample sample;
+    CHECK(!profiler.GetLatestSample(sample));
+
+    profiler.AddPhaseTime(ProfilePhase::UpdateGrid, At(base, 10.0), At(base, 12.0));
+    profiler.AddPhaseTime(ProfilePhase::Draw, At(base, 12.0), At(base, 15.0));
+    profiler.AddPhaseTime(ProfilePhase::UpdateGrid, At(base, 15.0), At(base, 16.0));
+    profiler.AddPhaseTime(ProfilePhase::Wait, At(base, 16.0), At(base, 26.0));
+    profiler.EndFrame();
+
+    CHECK(profiler.GetFrameCount() == 1);
+    CHECK(profiler.GetLatestSample(sample));
+    CHECK(sample.frameIndex == 0);
+    CHECK_NEAR(sample.startUs, 10000.0, 1.0);
+    CHECK_NEAR(sample.phaseMs[static_cast<size_t>(ProfilePhase::UpdateGrid)], 3.0, 1e-3);
+    CHECK_NEAR(sample.phaseMs[static_cast<size_t>(ProfilePhase::Draw)], 3.0, 1e-3);
+    CHECK_NEAR(sample.phaseMs[static_cast<size_t>(ProfilePhase::Wait)], 10.0, 1e-3);
+    CHECK_NEAR(sample.frameMs, 6.0, 1e-3);
+    CHECK_NEAR(sample.phaseStartMs[static_cast<size_t>(ProfilePhase::UpdateGrid)], 0.0, 1e-3);
+    CHECK_NEAR(sample.phaseStartMs[static_cast<size_t>(ProfilePhase::Draw)], 2.0, 1e-3);
+
+    // The next frame starts clean
+    profiler.AddPhaseTime(ProfilePhase::Present, At(base, 30.0), At(base, 31.0));
+    profiler.EndFrame();
+    CHECK(profiler.GetLatestSample(sample));
+    CHECK(sample.frameIndex == 1);
+    CHECK(sample.phaseMs[static_cast<size_t>(ProfilePhase::UpdateGrid)] == 0.0f);
+    CHECK_NEAR(sample.frameMs, 1.0, 1e-3);
+}
+
+// Draw takes 1, 2, ... 100 ms over 100 frames (shuffled), so the
+// nearest-rank percentiles land on whole numbers
+void TestPercentiles() {
+    FrameProfiler profiler;
+    Clock::time_point base = profiler.GetEpoch();
+
+    for (int i = 0; i < 100; ++i) {
+        int ms = (i * 37) % 100 + 1;
+        profiler.AddPhaseTime(ProfilePhase::Draw, base, At(base, ms));
+        profiler.AddPhaseTime(ProfilePhase::Present, base, At(base, 0.5));
+        profiler.EndFrame();
+    }
+
+    ProfileSummary summary = profiler.Summarize(100);
+    CHECK(summary.frameCount == 100);
+    const PhaseSummary& draw = summary.phases[static_cast<size_t>(ProfilePhase::Draw)];
+    CHECK_NEAR(draw.p50, 50.0, 1e-3);
+    CHECK_NEAR(draw.p95, 95.0, 1e-3);
+    CHECK_NEAR(draw.p99, 99.0, 1e-3);
+    CHECK_NEAR(draw.max, 100.0, 1e-3);
+    CHECK_NEAR(summary.frame.max, 100.5, 1e-3);
+    CHECK_NEAR(summary.phases[static_cast<size_t>(ProfilePhase::Present)].p99, 0.5, 1e-3);
+    CHECK(summary.phases[static_cast<size_t>(ProfilePhase::Effects)].max == 0.0f);
+
+    // A window covers only the most recent frames; the last ten are
+    // 31, 68, 5, 42, 79, 16, 53, 90, 27, 64 ms
+    ProfileSummary recent = profiler.Summarize(10);
+    CHECK(recent.frameCount == 10);
+    const PhaseSummary& recentDraw = recent.phases[static_cast<size_t>(ProfilePhase::Draw)];
+    CHECK_NEAR(recentDraw.p50, 42.0, 1e-3);
+    CHECK_NEAR(recentDraw.max, 90.0, 1e-3);
+
+    // Asking for more than was recorded covers what there is
+    CHECK(profiler.Summarize(5000).frameCount == 100);
+}
+
+// Past the ring's capacity only the newest frames are summarized
+void TestRingWraps() {
+    FrameProfiler profiler;
+    Clock::time_point base = profiler.GetEpoch();
+
+    for (size_t i = 0; i < FrameProfiler::CAPACITY + 100; ++i) {
+        double ms = i < 100 ? 1000.0 : 1.0;
+        profiler.AddPhaseTime(ProfilePhase::Draw, base, At(base, ms));
+        profiler.EndFrame();
+    }
+
+    ProfileSummary summary = profiler.Summarize(FrameProfiler::CAPACITY * 2);
+    CHECK(summary.frameCount == FrameProfiler::CAPACITY);
+    CHECK_NEAR(summary.frame.max, 1.0, 1e-3);
+    CHECK(profiler.GetFrameCount() == FrameProfiler::CAPACITY + 100);
+}
+
+void TestScopedTimer() {
+    FrameProfiler profiler;
+    {
+        ScopedPhaseTimer timer(&profiler, ProfilePhase::BatchBuild);
+    }
+    {
+        ScopedPhaseTimer timer(nullptr, ProfilePhase::BatchBuild);
+    }
+    profiler.EndFrame();
+
+    FrameSample sample;
+    CHECK(profiler.GetLatestSample(sample));
+    CHECK(sample.phaseMs[static_cast<size_t>(ProfilePhase::BatchBuild)] >= 0.0f);
+    CHECK(sample.frameMs == sample.phaseMs[static_cast<size_t>(ProfilePhase::BatchBuild)]);
+}
+
+} // namespace
+
+int main() {
+    TestFrameAccounting();
+    TestPercentiles();
+    TestRingWraps();
+    TestScopedTimer();
+    return TestResult();
+}
@@ -0,0 +1,218 @@
+// Frame trace export (src/frame_trace.h): the Chrome trace is well-formed
+// JSON with one frame span, one event per phase that ran and one counter
+// sample per frame, the frame span on the phases' track ahead of them, and
+// the CSV has its columns in phase order.
+
+#include "frame_trace.h"
+#include "test_check.h"
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+
+namespace {
+
+// Just enough JSON to read a trace back: objects, arrays, strings without
+// escapes, numbers
+struct JsonValue {
+    enum class Type { Null, Number, String, Array, Object } type = Type::Null;
+    double number = 0.0;
+    std::string text;
+    std::vector<JsonValue> items;
+    std::map<std::string, JsonValue> members;
+
+    const JsonValue* Find(const std::string& key) const {
+        auto it = members.find(key);
+        return it != members.end() ? &it->second : nullptr;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : m_text(text) {}
+
+    bool Parse(JsonValue& value) {
+        if (!ParseValue(value)) return false;
+        SkipSpace();
+        return m_offset == m_text.size();
+    }
+
+private:
+    void SkipSpace() {
+        while (m_offset < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_offset]))) m_offset++;
+    }
+
+    bool Take(char c) {
+        SkipSpace();
+        if (m_offset < m_text.size() && m_text[m_offset] == c) {
+            m_offset++;
+            return true;
+        }
+        return false;
+    }
+
+    bool ParseString(std::string& out) {
+        if (!Take('"')) return false;
+        size_t end = m_text.find('"', m_offset);
+        if (end == std::string::npos || m_text.find('\\', m_offset) < end) return false;
+        out = m_text.substr(m_offset, end - m_offset);
+        m_offset = end + 1;
+        return true;
+    }
+
+    bool ParseValue(JsonValue& value) {
+        SkipSpace();
+        if (m_offset >= m_text.size()) return false;
+
+        char c = m_text[m_offset];
+        if (c == '"') {
+            value.type = JsonValue::Type::String;
+            return ParseString(value.text);
+        }
+        if (c == '[') {
+            value.type = JsonValue::Type::Array;
+            m_offset++;
+            if (Take(']')) return true;
+            do {
+                value.items.emplace_back();
+                if (!ParseValue(value.items.back())) return false;
+            } while (Take(','));
+            return Take(']');
+        }
+        if (c == '{') {
+            value.type = JsonValue::Type::Object;
+            m_offset++;
+            if (Take('}')) return true;
+            do {
+                std::string key;
+                if (!ParseString(key) || !Take(':') || !ParseValue(value.members[key])) return false;
+            } while (Take(','));
+            return Take('}');
+        }
+
+        size_t used = 0;
+        try {
+            value.number = std::stod(m_text.substr(m_offset, 32), &used);
+        } catch (...) {
+            return false;
+        }
+        value.type = JsonValue::Type::Number;
+        m_offset += used;
+        return used > 0;
+    }
+
+    const std::string& m_text;
+    size_t m_offset = 0;
+};
+
+std::string ReadFile(const std::filesystem::path& path) {
+    std::ifstream file(path);
+    std::stringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+FrameSample MakeSample(uint64_t frameIndex, double startUs, std::initializer_list<ProfilePhase> phases) {
+    FrameSample sample;
+    sample.frameIndex = frameIndex;
+    sample.startUs = startUs;
+    float offsetMs = 0.0f;
+    for (ProfilePhase phase : phases) {
+        size_t index = static_cast<size_t>(phase);
+        sample.phaseStartMs[index] = offsetMs;
+        sample.phaseMs[index] = 1.5f;
+        offsetMs += 2.0f;
+    }
+    sample.frameMs = offsetMs;
+    return sample;
+}
+
+void TestExport(const std::filesystem::path& directory) {
+    FrameTrace trace(4);
+    FrameCounters counters;
+    counters.activeCells = 1200;
+    trace.Record(MakeSample(7, 1000.0, { ProfilePhase::UpdateColumns, ProfilePhase::UpdateGrid, ProfilePhase::Draw, ProfilePhase::Present }), counters);
+    trace.Record(MakeSample(8, 17000.0, { ProfilePhase::UpdateGrid, ProfilePhase::Effects, ProfilePhase::Draw }), counters);
+    CHECK(trace.GetFrameCount() == 2);
+
+    std::filesystem::path jsonPath = directory / "trace.json";
+    std::filesystem::path csvPath = directory / "trace.csv";
+    CHECK(trace.WriteChromeTrace(jsonPath));
+    CHECK(trace.WriteCsv(csvPath));
+
+    JsonValue root;
+    std::string json = ReadFile(jsonPath);
+    CHECK(JsonParser(json).Parse(root));
+    const JsonValue* events = root.Find("traceEvents");
+    CHECK(events && events->type == JsonValue::Type::Array);
+    if (!events) return;
+
+    // Thread name, then per frame the span, its phases and the counters
+    CHECK(events->items.size() == 1 + (1 + 4 + 1) + (1 + 3 + 1));
+
+    int frames = 0;
+    int phases = 0;
+    int counterSamples = 0;
+    double frameEndUs = 0.0;
+    for (const JsonValue& event : events->items) {
+        const JsonValue* name = event.Find("name");
+        const JsonValue* phase = event.Find("ph");
+        CHECK(name && phase);
+        if (!name || !phase) continue;
+
+        if (phase->text == "C") {
+            counterSamples++;
+            continue;
+        }
+        if (phase->text != "X") continue;
+
+        const JsonValue* tid = event.Find("tid");
+        const JsonValue* ts = event.Find("ts");
+        const JsonValue* dur = event.Find("dur");
+        CHECK(tid && tid->number == 1.0);
+        CHECK(ts && dur);
+        if (!ts || !dur) continue;
+
+        if (name->text == "Frame") {
+            frames++;
+            frameEndUs = ts->number + dur->number;
+        } else {
+            // Each phase lies inside the frame span that came before it
+            CHECK(frames > 0);
+            CHECK(ts->number + dur->number <= frameEndUs + 0.001);
+            phases++;
+        }
+    }
+    CHECK(frames == 2);
+    CHECK(phases == 7);
+    CHECK(counterSamples == 2);
+
+    std::ifstream csv(csvPath);
+    std::string header;
+    std::getline(csv, header);
+    CHECK(header == "frame,start_us,frame_ms,Columns_ms,Grid_ms,Effects_ms,Batch_ms,Draw_ms,Overlay_ms,Present_ms,Wait_ms,"
+                    "active_cells,spawns,batches,draw_calls,dirty_percent,lateness_ms,quality_columns,quality_effects,quality_glow");
+
+    std::string row;
+    std::getline(csv, row);
+    CHECK(row.rfind("7,1000.000,8.000,1.500,1.500,0.000,0.000,1.500,0.000,1.500,0.000,1200,", 0) == 0);
+    std::getline(csv, row);
+    CHECK(row.rfind("8,17000.000,6.000,0.000,1.500,1.500,0.000,1.500,", 0) == 0);
+    CHECK(!std::getline(csv, row));
+}
+
+} // namespace
+
+int main() {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "matrix_frame_trace_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    TestExport(directory);
+
+    std::filesystem::remove_all(directory);
+    return TestResult();
+}
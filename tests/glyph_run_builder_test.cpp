@@ -0,0 +1,152 @@
+// GlyphRunBuilder and GlyphMetricsCache (src/glyph_run_builder.h), without
+// DirectWrite: the cache is filled by hand the way BatchRenderer fills it.
+
+#include "glyph_run_builder.h"
+#include "test_check.h"
+
+namespace {
+
+constexpr float FONT_SIZE = 10.0f;
+
+GlyphMetrics Drawable(uint16_t fontGlyphIndex, uint8_t fontFace, float advance) {
+    GlyphMetrics metrics;
+    metrics.fontGlyphIndex = fontGlyphIndex;
+    metrics.fontFace = fontFace;
+    metrics.advance = advance;
+    metrics.drawable = true;
+    return metrics;
+}
+
+GlyphMetricsCache MakeCache() {
+    GlyphMetricsCache cache;
+    cache.SetFontMetrics(0.8f, 0.2f);
+    cache.Set(0, Drawable(100, 0, 0.5f));
+    cache.Set(1, Drawable(101, 0, 0.6f));
+    cache.Set(2, Drawable(200, 1, 1.0f));
+    cache.Set(3, Drawable(300, 2, 0.4f));
+    cache.Set(4, GlyphMetrics());           // Looked up, but no face has it
+    return cache;                           // 5 is never resolved
+}
+
+void TestCache() {
+    GlyphMetricsCache cache = MakeCache();
+    CHECK(cache.IsResolved(4));
+    CHECK(!cache.IsResolved(5));
+    CHECK(!cache.IsResolved(INVALID_GLYPH));
+    CHECK(cache.Find(2) != nullptr && cache.Find(2)->fontFace == 1);
+
+    cache.Set(INVALID_GLYPH, Drawable(1, 0, 1.0f));
+    CHECK(!cache.IsResolved(INVALID_GLYPH));
+
+    cache.Clear();
+    CHECK(!cache.IsResolved(0));
+}
+
+// A glyph sits centered in its cell the way center/center text would:
+// horizontally by its advance, vertically by the font's line box
+void TestPlacement() {
+    GlyphMetricsCache cache = MakeCache();
+    GlyphId glyph = 0;
+    GlyphCellRect rect = { 10.0f, 20.0f, 30.0f, 40.0f };
+
+    GlyphRun run;
+    GlyphRunBuilder::Build(&glyph, &rect, 1, FONT_SIZE, cache, run);
+    CHECK(run.GetGlyphCount() == 1);
+    CHECK(run.fallback.empty());
+    CHECK(run.indices[0] == 100);
+    CHECK(run.advances[0] == 0.0f);
+
+    // Width 5 in a 20 wide cell; line box 10 high with its baseline 8 down
+    CHECK_NEAR(run.offsets[0].advanceOffset, 17.5f, 1e-4);
+    CHECK_NEAR(run.offsets[0].ascenderOffset, -(20.0f + 5.0f + 8.0f), 1e-4);
+}
+
+// Glyphs are grouped by face, faces in order, one span each, and every glyph
+// keeps the position of its own cell
+void TestFaceSpans() {
+    GlyphMetricsCache cache = MakeCache();
+    const GlyphId glyphs[] = { 3, 0, 2, 4, 1, 3, 5, 2, 0 };
+    constexpr size_t COUNT = sizeof(glyphs) / sizeof(glyphs[0]);
+    GlyphCellRect rects[COUNT];
+    for (size_t i = 0; i < COUNT; ++i) {
+        float left = 20.0f * static_cast<float>(i);
+        rects[i] = { left, 0.0f, left + 20.0f, 20.0f };
+    }
+
+    FrameArena arena;
+    GlyphRun run(&arena);
+    GlyphRunBuilder::Build(glyphs, rects, COUNT, FONT_SIZE, cache, run);
+
+    CHECK(run.GetGlyphCount() == 7);
+    CHECK(run.advances.size() == 7 && run.offsets.size() == 7);
+    CHECK(run.fallback.size() == 2);
+    if (run.fallback.size() == 2) {
+        CHECK(run.fallback[0] == 3);
+        CHECK(run.fallback[1] == 6);
+    }
+
+    CHECK(run.spans.size() == 3);
+    if (run.spans.size() != 3) return;
+    const uint8_t faces[] = { 0, 1, 2 };
+    const size_t counts[] = { 3, 2, 2 };
+    size_t first = 0;
+    for (size_t s = 0; s < 3; ++s) {
+        CHECK(run.spans[s].fontFace == faces[s]);
+        CHECK(run.spans[s].first == first);
+        CHECK(run.spans[s].count == counts[s]);
+        first += counts[s];
+    }
+
+    // Within a face, glyphs keep their input order
+    const uint16_t indices[] = { 100, 101, 100, 200, 200, 300, 300 };
+    const size_t cells[] = { 1, 4, 8, 2, 7, 0, 5 };
+    for (size_t slot = 0; slot < 7; ++slot) {
+        CHECK(run.indices[slot] == indices[slot]);
+        const GlyphMetrics* metrics = cache.Find(glyphs[cells[slot]]);
+        float expected = rects[cells[slot]].left + (20.0f - metrics->advance * FONT_SIZE) * 0.5f;
+        CHECK_NEAR(run.offsets[slot].advanceOffset, expected, 1e-4);
+        CHECK(run.advances[slot] == 0.0f);
+    }
+}
+
+// A rebuild replaces everything from the last one
+void TestRebuild() {
+    GlyphMetricsCache cache = MakeCache();
+    const GlyphId first[] = { 2, 5, 3 };
+    const GlyphId second[] = { 0 };
+    GlyphCellRect rects[3] = {};
+
+    GlyphRun run;
+    GlyphRunBuilder::Build(first, rects, 3, FONT_SIZE, cache, run);
+    CHECK(run.spans.size() == 2);
+    GlyphRunBuilder::Build(second, rects, 1, FONT_SIZE, cache, run);
+    CHECK(run.GetGlyphCount() == 1);
+    CHECK(run.spans.size() == 1);
+    CHECK(run.fallback.empty());
+
+    GlyphRunBuilder::Build(first, rects, 0, FONT_SIZE, cache, run);
+    CHECK(run.GetGlyphCount() == 0);
+    CHECK(run.spans.empty());
+}
+
+// Without a font everything falls back to text
+void TestEmptyCache() {
+    const GlyphId glyphs[] = { 0, 1, 2 };
+    GlyphCellRect rects[3] = {};
+    GlyphRun run;
+    GlyphRunBuilder::Build(glyphs, rects, 3, FONT_SIZE, GlyphMetricsCache(), run);
+    CHECK(run.GetGlyphCount() == 0);
+    CHECK(run.spans.empty());
+    CHECK(run.fallback.size() == 3);
+}
+
+} // namespace
+
+int main() {
+    TestCache();
+    TestPlacement();
+    TestFaceSpans();
+    TestRebuild();
+    TestEmptyCache();
+    return TestResult();
+}
@@ -0,0 +1,128 @@
+// Alias-method glyph sampler (src/glyph_sampler.h): the table a build makes
+// gives each glyph the share of the draws its weight asks for. Checked two
+// ways, from the table (GetProbability) and by sampling draws spread evenly
+// over the 32-bit range, where a chi-square test against the weights must pass.
+
+#include "glyph_sampler.h"
+#include "test_check.h"
+#include <cmath>
+#include <map>
+
+namespace {
+
+constexpr uint32_t DRAWS = 1 << 20;
+
+using Weights = std::vector<GlyphSampler::WeightedGlyph>;
+
+// Weight per glyph, duplicates summed, as the sampler should see it
+std::map<GlyphId, double> Normalize(const Weights& weights) {
+    std::map<GlyphId, double> shares;
+    double total = 0.0;
+    for (const GlyphSampler::WeightedGlyph& entry : weights) {
+        shares[entry.glyph] += entry.weight;
+        total += entry.weight;
+    }
+    for (auto& [glyph, share] : shares) {
+        share /= total;
+    }
+    return shares;
+}
+
+// Upper 0.1% point of chi-square with the given degrees of freedom
+// (Wilson-Hilferty)
+double ChiSquareLimit(int degrees) {
+    double d = static_cast<double>(degrees);
+    double term = 1.0 - 2.0 / (9.0 * d) + 3.09 * std::sqrt(2.0 / (9.0 * d));
+    return d * term * term * term;
+}
+
+void CheckSampler(const Weights& weights) {
+    GlyphSampler sampler;
+    sampler.Build(weights);
+    std::map<GlyphId, double> expected = Normalize(weights);
+
+    double probabilitySum = 0.0;
+    for (const auto& [glyph, share] : expected) {
+        CHECK_NEAR(sampler.GetProbability(glyph), share, 1e-6);
+        probabilitySum += sampler.GetProbability(glyph);
+    }
+    CHECK_NEAR(probabilitySum, 1.0, 1e-9);
+
+    std::map<GlyphId, uint32_t> counts;
+    for (uint32_t i = 0; i < DRAWS; ++i) {
+        uint32_t draw = static_cast<uint32_t>((static_cast<uint64_t>(i) << 32) / DRAWS);
+        counts[sampler.Sample(draw)]++;
+    }
+
+    // Glyphs too rare to expect five draws only have to stay rare
+    double chiSquare = 0.0;
+    int degrees = -1;
+    for (const auto& [glyph, count] : counts) {
+        CHECK(expected.count(glyph) == 1);
+    }
+    for (const auto& [glyph, share] : expected) {
+        double expectedCount = share * DRAWS;
+        double observed = counts.count(glyph) ? counts[glyph] : 0.0;
+        if (expectedCount < 5.0) {
+            CHECK(observed <= expectedCount + 1.0);
+            continue;
+        }
+        chiSquare += (observed - expectedCount) * (observed - expectedCount) / expectedCount;
+        degrees++;
+    }
+    if (degrees > 0) {
+        CHECK(chiSquare < ChiSquareLimit(degrees));
+    }
+}
+
+void TestWeights() {
+    // Even, uneven, with duplicates
+    CheckSampler({ { 1, 1.0f }, { 2, 1.0f }, { 3, 1.0f }, { 4, 1.0f } });
+    CheckSampler({ { 10, 0.5f }, { 11, 2.0f }, { 12, 0.25f }, { 13, 7.0f }, { 14, 1.0f } });
+    CheckSampler({ { 20, 1.0f }, { 21, 3.0f }, { 20, 2.0f } });
+
+    // A weight that is most of the total, and one that is a sliver
+    CheckSampler({ { 30, 1000.0f }, { 31, 1.0f }, { 32, 1.0f }, { 33, 1.0f } });
+    CheckSampler({ { 40, 1.0e6f }, { 41, 1.0f }, { 42, 1.0e-4f } });
+
+    // Many glyphs, most of the weight spread over the first 46
+    Weights mix;
+    for (GlyphId glyph = 100; glyph < 156; ++glyph) {
+        mix.push_back({ glyph, glyph < 146 ? 0.9f / 46.0f : 0.1f / 10.0f });
+    }
+    CheckSampler(mix);
+}
+
+void TestZeroWeights() {
+    GlyphSampler sampler;
+    sampler.Build({ { 1, 0.0f }, { 2, 3.0f }, { 3, 0.0f }, { 4, 1.0f } });
+    CHECK(sampler.GetSize() == 2);
+    CHECK(sampler.GetProbability(1) == 0.0);
+    CHECK(sampler.GetProbability(3) == 0.0);
+    CHECK_NEAR(sampler.GetProbability(2), 0.75, 1e-6);
+    CheckSampler({ { 1, 0.0f }, { 2, 3.0f }, { 3, 0.0f }, { 4, 1.0f } });
+
+    sampler.Build({ { 1, 0.0f }, { 2, 0.0f } });
+    CHECK(sampler.IsEmpty());
+    CHECK(sampler.GetProbability(1) == 0.0);
+}
+
+void TestSingleEntry() {
+    GlyphSampler sampler;
+    sampler.Build({ { 7, 0.3f } });
+    CHECK(sampler.GetSize() == 1);
+    CHECK(sampler.GetProbability(7) == 1.0);
+    CHECK(sampler.GetProbability(8) == 0.0);
+    for (uint32_t draw : { 0u, 1u, 0x80000000u, 0xFFFFFFFFu }) {
+        CHECK(sampler.Sample(draw) == 7);
+    }
+}
+
+} // namespace
+
+int main() {
+    TestWeights();
+    TestZeroWeights();
+    TestSingleEntry();
+    return TestResult();
+}
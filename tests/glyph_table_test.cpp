@@ -0,0 +1,121 @@
+// GlyphTable sharing (src/glyph_table.h): several threads intern words while
+// others read glyphs back by ID, as the UI, simulation and render threads do.
+// Built with ThreadSanitizer where the compiler has it.
+
+#include "glyph_table.h"
+#include "sim_types.h"
+#include "test_check.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int WRITERS = 4;
+constexpr int WORDS_PER_WRITER = 400;   // Enough to fill several storage chunks
+
+// Even indices are the writer's own; odd ones every writer interns, so
+// they race to add the same string
+std::wstring MakeGlyph(int writer, int index) {
+    int key = index % 2 == 0 ? writer * WORDS_PER_WRITER + index : index;
+    return L"g" + std::to_wstring(key);
+}
+
+void TestBuiltInSets() {
+    const GlyphTable& table = GlyphTable::Instance();
+    CHECK(table.GetMatrixGlyphs().size() == MATRIX_CHARS.size());
+    CHECK(table.GetKatakanaGlyphs().size() == KATAKANA_CHARS.size());
+
+    GlyphId first = table.GetKatakanaGlyphs()[0];
+    CHECK(table.GetGlyph(first) == KATAKANA_CHARS[0]);
+    CHECK(table.GetCategories(first) & GLYPH_KATAKANA);
+    CHECK(table.Find(KATAKANA_CHARS[0]) == first);
+    CHECK(table.Find(L"not interned") == INVALID_GLYPH);
+    CHECK(table.GetGlyph(INVALID_GLYPH).empty());
+}
+
+// Surrogate pairs stay one glyph; interning again gives the same IDs
+void TestInternWord() {
+    GlyphTable& table = GlyphTable::Instance();
+    std::wstring word = L"A\xD83D\xDE00Z";
+    std::vector<GlyphId> ids = table.InternWord(word);
+    CHECK(ids.size() == 3);
+    if (ids.size() != 3) return;
+    CHECK(table.GetGlyph(ids[1]) == L"\xD83D\xDE00");
+    CHECK(table.GetCategories(ids[1]) == 0);
+    CHECK(table.InternWord(word) == ids);
+}
+
+void TestConcurrentInterning() {
+    GlyphTable& table = GlyphTable::Instance();
+    std::vector<std::vector<GlyphId>> results(WRITERS);
+    std::atomic<bool> done{false};
+    std::atomic<int> mismatches{0};
+
+    // Readers walk everything published so far while writers add to it
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r) {
+        readers.emplace_back([&] {
+            while (!done.load(std::memory_order_acquire)) {
+                size_t count = table.GetGlyphCount();
+                for (size_t id = 0; id < count; ++id) {
+                    const std::wstring& glyph = table.GetGlyph(static_cast<GlyphId>(id));
+                    if (glyph.empty()) mismatches.fetch_add(1, std::memory_order_relaxed);
+                    table.GetCategories(static_cast<GlyphId>(id));
+                }
+            }
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (int w = 0; w < WRITERS; ++w) {
+        writers.emplace_back([&, w] {
+            for (int i = 0; i < WORDS_PER_WRITER; ++i) {
+                std::wstring glyph = MakeGlyph(w, i);
+                GlyphId id = table.Intern(glyph);
+                results[w].push_back(id);
+                if (table.Find(glyph) != id) mismatches.fetch_add(1, std::memory_order_relaxed);
+
+                // Custom words of shared CJK characters, as settings reloads intern them
+                if (i % 8 == 0) {
+                    wchar_t word[] = { static_cast<wchar_t>(0x4E00 + i), static_cast<wchar_t>(0x4E01 + i), 0 };
+                    std::vector<GlyphId> ids = table.InternWord(word);
+                    if (ids.size() != 2 || table.GetGlyph(ids[0]) != std::wstring(1, word[0])) {
+                        mismatches.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            }
+        });
+    }
+
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    done.store(true, std::memory_order_release);
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    CHECK(mismatches.load() == 0);
+
+    // Every string got exactly one ID, whichever thread interned it first
+    int wrong = 0;
+    for (int w = 0; w < WRITERS; ++w) {
+        for (int i = 0; i < WORDS_PER_WRITER; ++i) {
+            GlyphId id = results[w][i];
+            if (id == INVALID_GLYPH || table.GetGlyph(id) != MakeGlyph(w, i)) wrong++;
+            if (i % 2 == 1 && id != results[0][i]) wrong++;
+        }
+    }
+    CHECK(wrong == 0);
+}
+
+} // namespace
+
+int main() {
+    TestBuiltInSets();
+    TestInternWord();
+    TestConcurrentInterning();
+    return TestResult();
+}
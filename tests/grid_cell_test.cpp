@@ -0,0 +1,225 @@
+// The packed GridCell and its effect side table (src/sim_types.h,
+// src/character_effects.h).
+
+#include "character_effects.h"
+#include "test_check.h"
+#include <cmath>
+
+namespace {
+
+void TestLayout() {
+    CHECK(sizeof(GridCell) == 16);
+    GridCell cell;
+    CHECK(!cell.IsActive());
+    CHECK(cell.glyph == INVALID_GLYPH);
+    CHECK(cell.effectSlot == NO_EFFECT_SLOT);
+}
+
+void TestHalfFloat() {
+    CHECK(HalfToFloat(FloatToHalf(0.0f)) == 0.0f);
+    CHECK(HalfToFloat(FloatToHalf(1.0f)) == 1.0f);
+    CHECK(HalfToFloat(FloatToHalf(0.5f)) == 0.5f);
+    CHECK(HalfToFloat(FloatToHalf(-2.0f)) == -2.0f);
+
+    // 11 significant bits: within 1/2048 relative over the range alpha and age use
+    for (float value = 0.001f; value < 30.0f; value *= 1.37f) {
+        CHECK_NEAR(HalfToFloat(FloatToHalf(value)), value, value / 2048.0f);
+    }
+
+    // Denormals flush to zero, overflow saturates to infinity
+    CHECK(HalfToFloat(FloatToHalf(1.0e-6f)) == 0.0f);
+    CHECK(std::isinf(HalfToFloat(FloatToHalf(1.0e6f))));
+}
+
+void TestAccessors() {
+    GridCell cell;
+    cell.SetAlpha(0.75f);
+    cell.SetAge(2.5f);
+    cell.SetDepth(0.3f);
+    CHECK(cell.GetAlpha() == 0.75f);
+    CHECK(cell.GetAge() == 2.5f);
+    CHECK_NEAR(cell.GetDepth(), 0.3f, 0.5f / 255.0f);
+
+    cell.SetDepth(-1.0f);
+    CHECK(cell.depth == 0);
+    cell.SetDepth(2.0f);
+    CHECK(cell.depth == 255);
+
+    cell.SetFlag(CELL_ACTIVE, true);
+    cell.SetFlag(CELL_GLITCHING, true);
+    CHECK(cell.IsActive() && cell.IsGlitching() && !cell.IsMorphing());
+    cell.SetFlag(CELL_ACTIVE, false);
+    CHECK(!cell.IsActive() && cell.IsGlitching());
+    CHECK(cell.flags == CELL_GLITCHING);
+}
+
+MatrixSettings EffectSettings() {
+    MatrixSettings settings;
+    settings.enableCharacterMorphing = true;
+    settings.enableGlitchEffects = true;
+    return settings;
+}
+
+// A cell takes a side-table entry when an effect starts, shares it between
+// effects, and gives it back once the last one ends
+void TestSideTableLifetime() {
+    SimRandom random(7);
+    CharacterEffects effects(random);
+    effects.Initialize(EffectSettings());
+
+    GridCell cell;
+    cell.glyph = GlyphTable::Instance().GetMatrixGlyphs().front();
+    cell.SetFlag(CELL_ACTIVE, true);
+    CHECK(effects.GetCellEffectState(cell) == nullptr);
+
+    effects.StartMorphing(cell, 1.0f);
+    CHECK(cell.IsMorphing());
+    CHECK(cell.effectSlot != NO_EFFECT_SLOT);
+    CHECK(effects.GetActiveEffectCount() == 1);
+    uint32_t slot = cell.effectSlot;
+
+    effects.StartGlitch(cell, 1.0f);
+    CHECK(cell.IsGlitching());
+    CHECK(cell.effectSlot == slot);
+    CHECK(effects.GetActiveEffectCount() == 1);
+    const CellEffectState* state = effects.GetCellEffectState(cell);
+    CHECK(state != nullptr);
+    if (state) {
+        for (GlyphId glyph : state->glitchGlyphs) {
+            CHECK(glyph != INVALID_GLYPH);
+        }
+    }
+
+    // Glitches last at most 0.3 s; a morph chain can restart, so end it by hand
+    effects.UpdateGlitch(cell, 0.5f);
+    CHECK(!cell.IsGlitching());
+    CHECK(cell.effectSlot == slot);
+    effects.ReleaseEffectState(cell);
+    CHECK(cell.effectSlot == NO_EFFECT_SLOT);
+    CHECK(!cell.IsMorphing());
+    CHECK(effects.GetActiveEffectCount() == 0);
+}
+
+GridCell StartGlitchedCell(CharacterEffects& effects, float depth) {
+    GridCell cell;
+    cell.glyph = GlyphTable::Instance().GetMatrixGlyphs().front();
+    cell.SetDepth(depth);
+    cell.SetFlag(CELL_ACTIVE, true);
+    effects.StartGlitch(cell, 1.0f);
+    return cell;
+}
+
+// Glitch glyphs are drawn like any glyph at the cell's depth: the draws a
+// twin stream makes through SelectCharacter give the same sequence
+void TestGlitchGlyphsFollowDepth() {
+    MatrixSettings settings;
+    settings.enableGlitchEffects = true;
+
+    for (float depth : { 0.05f, 0.5f, 0.95f }) {
+        SimRandom random(21);
+        CharacterEffects effects(random);
+        effects.Initialize(settings);
+        GridCell cell = StartGlitchedCell(effects, depth);
+        const CellEffectState* state = effects.GetCellEffectState(cell);
+        CHECK(state != nullptr);
+        if (!state) continue;
+
+        SimRandom twinRandom(21);
+        CharacterEffects twin(twinRandom);
+        twin.Initialize(settings);
+        twinRandom.NextFloat();             // The start roll
+        twinRandom.NextFloat(0.5f, 1.0f);   // Intensity
+        for (GlyphId glyph : state->glitchGlyphs) {
+            CHECK(glyph == twin.SelectCharacter(cell.GetDepth()));
+        }
+    }
+}
+
+// What a glitch shows is a function of its timer alone, however the time
+// arrives. Steps are binary fractions so every pattern lands on exactly the
+// same timer values.
+void TestGlitchIndependentOfStepSize() {
+    MatrixSettings settings;
+    settings.enableGlitchEffects = true;
+    constexpr float TICK = 1.0f / 64.0f;
+    constexpr int TICKS = 12;               // 0.1875 s; glitches last at least 0.2 s
+
+    auto run = [&](const std::vector<float>& pattern, std::vector<GlyphId>& shown) {
+        SimRandom random(33);
+        CharacterEffects effects(random);
+        effects.Initialize(settings);
+        GridCell cell = StartGlitchedCell(effects, 0.4f);
+
+        shown.assign(TICKS + 1, INVALID_GLYPH);
+        shown[0] = effects.GetGlitchedCharacter(cell);
+        for (size_t i = 0; cell.IsGlitching(); ++i) {
+            effects.UpdateGlitch(cell, pattern[i % pattern.size()]);
+            if (!cell.IsGlitching()) break;
+
+            float ticks = effects.GetCellEffectState(cell)->glitchTimer / TICK;
+            int tick = static_cast<int>(ticks);
+            if (tick > TICKS) break;
+            if (static_cast<float>(tick) == ticks) {
+                shown[tick] = effects.GetGlitchedCharacter(cell);
+            }
+        }
+    };
+
+    std::vector<GlyphId> reference;
+    run({ TICK / 2.0f }, reference);
+    bool sawGlitchGlyph = false;
+    for (GlyphId glyph : reference) {
+        CHECK(glyph != INVALID_GLYPH);
+        sawGlitchGlyph = sawGlitchGlyph || glyph != GlyphTable::Instance().GetMatrixGlyphs().front();
+    }
+    CHECK(sawGlitchGlyph);
+
+    const std::vector<std::vector<float>> patterns = {
+        { TICK },
+        { TICK * 2.0f },
+        { TICK * 3.0f, TICK },
+        { TICK / 2.0f, TICK, TICK / 2.0f },
+        { TICK / 4.0f, TICK * 3.0f / 4.0f, TICK * 2.0f },
+    };
+    for (const std::vector<float>& pattern : patterns) {
+        std::vector<GlyphId> shown;
+        run(pattern, shown);
+        for (int tick = 0; tick <= TICKS; ++tick) {
+            if (shown[tick] != INVALID_GLYPH) {
+                CHECK(shown[tick] == reference[tick]);
+            }
+        }
+    }
+}
+
+// Plain cells never touch the side table
+void TestQuietCellsStayPacked() {
+    SimRandom random(11);
+    CharacterEffects effects(random);
+    effects.Initialize(EffectSettings());
+
+    std::vector<GridCell> cells(1000);
+    for (GridCell& cell : cells) {
+        cell.glyph = effects.SelectCharacter();
+        cell.SetFlag(CELL_ACTIVE, true);
+        effects.StartMorphing(cell, 0.0f);
+        effects.StartGlitch(cell, 0.0f);
+    }
+    CHECK(effects.GetActiveEffectCount() == 0);
+    for (const GridCell& cell : cells) {
+        CHECK(cell.effectSlot == NO_EFFECT_SLOT);
+    }
+}
+
+} // namespace
+
+int main() {
+    TestLayout();
+    TestHalfFloat();
+    TestAccessors();
+    TestSideTableLifetime();
+    TestQuietCellsStayPacked();
+    TestGlitchGlyphsFollowDepth();
+    TestGlitchIndependentOfStepSize();
+    return TestResult();
+}
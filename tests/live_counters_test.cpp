@@ -0,0 +1,130 @@
+// Live counters page (src/live_counters.h): the seqlock never hands a reader
+// a torn snapshot, and the text renderings carry every field.
+
+#include "live_counters.h"
+#include "test_check.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Every field derived from the frame index, so a mix of two snapshots shows
+LiveCounters MakeCounters(uint64_t frame) {
+    LiveCounters counters;
+    counters.frameIndex = frame;
+    counters.uptimeSeconds = static_cast<double>(frame) / 60.0;
+    counters.fps = static_cast<float>(frame % 240);
+    counters.activeCells = static_cast<uint32_t>(frame * 3);
+    counters.drawCalls = static_cast<uint32_t>(frame + 7);
+    counters.workingSetBytes = frame * 4096;
+    counters.allocationsPerFrame = ~frame;
+    counters.timeToFirstFrameMs = static_cast<float>(frame % 1000);
+    return counters;
+}
+
+bool IsConsistent(const LiveCounters& counters) {
+    LiveCounters expected = MakeCounters(counters.frameIndex);
+    return counters.uptimeSeconds == expected.uptimeSeconds &&
+           counters.fps == expected.fps &&
+           counters.activeCells == expected.activeCells &&
+           counters.drawCalls == expected.drawCalls &&
+           counters.workingSetBytes == expected.workingSetBytes &&
+           counters.allocationsPerFrame == expected.allocationsPerFrame &&
+           counters.timeToFirstFrameMs == expected.timeToFirstFrameMs;
+}
+
+void TestRoundTrip() {
+    LiveCounterBlock block;
+    CHECK(block.magic == LiveCounterBlock::MAGIC);
+    CHECK(block.size == sizeof(LiveCounters));
+
+    LiveCounters counters;
+    CHECK(ReadLiveCounters(block, counters));
+    CHECK(counters.frameIndex == 0);
+
+    WriteLiveCounters(block, MakeCounters(12345));
+    CHECK(block.sequence.load() == 2);
+    CHECK(ReadLiveCounters(block, counters));
+    CHECK(counters.frameIndex == 12345);
+    CHECK(IsConsistent(counters));
+}
+
+// A reader that lands on an update in progress retries rather than copying it
+void TestBusyWriterFailsRead() {
+    LiveCounterBlock block;
+    block.sequence.store(1);
+    LiveCounters counters;
+    CHECK(!ReadLiveCounters(block, counters));
+}
+
+// One writer publishing as fast as it can, readers copying concurrently:
+// every snapshot a reader accepts is whole, and frames never go backwards
+void TestConcurrentReaders() {
+    constexpr uint64_t WRITES = 200000;
+    LiveCounterBlock block;
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::atomic<int> backwards{0};
+    std::atomic<uint64_t> reads{0};
+
+    std::thread writer([&] {
+        for (uint64_t frame = 1; frame <= WRITES; ++frame) {
+            WriteLiveCounters(block, MakeCounters(frame));
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&] {
+            uint64_t last = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                LiveCounters counters;
+                if (!ReadLiveCounters(block, counters)) continue;
+                if (!IsConsistent(counters)) torn.fetch_add(1, std::memory_order_relaxed);
+                if (counters.frameIndex < last) backwards.fetch_add(1, std::memory_order_relaxed);
+                last = counters.frameIndex;
+                reads.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    writer.join();
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    CHECK(torn.load() == 0);
+    CHECK(backwards.load() == 0);
+    LiveCounters last;
+    CHECK(ReadLiveCounters(block, last));
+    CHECK(last.frameIndex == WRITES);
+}
+
+void TestTextFormats() {
+    LiveCounters counters = MakeCounters(42);
+    counters.frameMsP99 = 18.5f;
+
+    std::string json = FormatLiveCountersJson(counters);
+    CHECK(json.starts_with("{\"frame\":42,"));
+    CHECK(json.find("\"active_cells\":126,") != std::string::npos);
+    CHECK(json.find("\"p99\":18.500") != std::string::npos);
+    CHECK(json.ends_with("}\n"));
+
+    std::string prometheus = FormatLiveCountersPrometheus(counters);
+    CHECK(prometheus.find("matrix_frames_total 42\n") != std::string::npos);
+    CHECK(prometheus.find("matrix_frame_time_ms{quantile=\"0.99\"} 18.500\n") != std::string::npos);
+    CHECK(prometheus.find("matrix_draw_calls 49\n") != std::string::npos);
+    CHECK(prometheus.ends_with("matrix_time_to_first_frame_ms 42.0\n"));
+}
+
+} // namespace
+
+int main() {
+    TestRoundTrip();
+    TestBusyWriterFailsRead();
+    TestConcurrentReaders();
+    TestTextFormats();
+    return TestResult();
+}
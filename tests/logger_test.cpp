@@ -0,0 +1,146 @@
+// Asynchronous Logger (src/logger.h): producers never block. A full ring
+// drops and counts what does not fit, the drop count is reported in the
+// log, and Shutdown() writes every record that was claimed. Built with
+// ThreadSanitizer where the compiler has it.
+
+#include "logger.h"
+#include "test_check.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A private Logger of its own, with the writer hold and counters the
+// singleton keeps to itself
+struct LoggerTestAccess {
+    static constexpr size_t RING_CAPACITY = Logger::RING_CAPACITY;
+
+    Logger logger;
+
+    void HoldWriter(bool held) { logger.m_writerHeld.store(held, std::memory_order_release); }
+    uint64_t GetDropped() const { return logger.m_droppedCount.load(std::memory_order_relaxed); }
+};
+
+namespace {
+
+constexpr int PRODUCERS = 4;
+
+struct LogContents {
+    std::vector<std::vector<int>> messages;     // Per producer, in file order
+    std::vector<std::string> dropReports;
+    int total = 0;
+};
+
+LogContents ReadLog(const std::filesystem::path& path) {
+    LogContents contents;
+    contents.messages.resize(PRODUCERS);
+
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        int producer = 0;
+        int index = 0;
+        size_t at = line.find("producer ");
+        if (at != std::string::npos && std::sscanf(line.c_str() + at, "producer %d message %d", &producer, &index) == 2 &&
+            producer >= 0 && producer < PRODUCERS) {
+            contents.messages[producer].push_back(index);
+            contents.total++;
+        } else if (line.find("dropped") != std::string::npos) {
+            contents.dropReports.push_back(line);
+        }
+    }
+    return contents;
+}
+
+void Produce(Logger& logger, int messagesEach) {
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&logger, messagesEach, p] {
+            char text[64];
+            for (int i = 0; i < messagesEach; ++i) {
+                std::snprintf(text, sizeof(text), "producer %d message %d", p, i);
+                logger.Log(LogLevel::Info, text);
+            }
+        });
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+}
+
+// Fewer messages than the ring holds: every one is written, each producer's
+// in the order it logged them
+void TestNoOverflow(const std::filesystem::path& directory) {
+    std::filesystem::path path = directory / "no_overflow.log";
+    LoggerTestAccess access;
+    access.logger.Initialize(true, LogFileFormat::Text, path.wstring());
+
+    int messagesEach = static_cast<int>(LoggerTestAccess::RING_CAPACITY) / PRODUCERS - 8;
+    Produce(access.logger, messagesEach);
+    access.logger.Shutdown();
+
+    LogContents contents = ReadLog(path);
+    CHECK(access.GetDropped() == 0);
+    CHECK(contents.dropReports.empty());
+    CHECK(contents.total == messagesEach * PRODUCERS);
+    for (const std::vector<int>& messages : contents.messages) {
+        CHECK(static_cast<int>(messages.size()) == messagesEach);
+        for (size_t i = 0; i < messages.size(); ++i) {
+            if (messages[i] != static_cast<int>(i)) {
+                CHECK(messages[i] == static_cast<int>(i));
+                break;
+            }
+        }
+    }
+}
+
+// With the writer held, the ring fills and the rest is dropped and counted.
+// Shutdown() drains the full ring without the writer ever being released.
+void TestOverflow(const std::filesystem::path& directory) {
+    std::filesystem::path path = directory / "overflow.log";
+    LoggerTestAccess access;
+    access.logger.Initialize(true, LogFileFormat::Text, path.wstring());
+    access.HoldWriter(true);
+
+    int messagesEach = static_cast<int>(LoggerTestAccess::RING_CAPACITY);
+    Produce(access.logger, messagesEach);
+    uint64_t sent = static_cast<uint64_t>(messagesEach) * PRODUCERS;
+    uint64_t dropped = access.GetDropped();
+    access.logger.Shutdown();
+
+    LogContents contents = ReadLog(path);
+    CHECK(static_cast<uint64_t>(contents.total) == LoggerTestAccess::RING_CAPACITY);
+    CHECK(dropped == sent - static_cast<uint64_t>(contents.total));
+    CHECK(access.GetDropped() == dropped);
+
+    CHECK(contents.dropReports.size() == 1);
+    if (!contents.dropReports.empty()) {
+        std::string expected = "dropped " + std::to_string(dropped) + " messages";
+        CHECK(contents.dropReports[0].find(expected) != std::string::npos);
+    }
+
+    // What was kept is each producer's earliest messages, in order
+    for (const std::vector<int>& messages : contents.messages) {
+        for (size_t i = 0; i < messages.size(); ++i) {
+            if (messages[i] != static_cast<int>(i)) {
+                CHECK(messages[i] == static_cast<int>(i));
+                break;
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "matrix_logger_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    TestNoOverflow(directory);
+    TestOverflow(directory);
+
+    std::filesystem::remove_all(directory);
+    return TestResult();
+}
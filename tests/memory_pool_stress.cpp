@@ -0,0 +1,215 @@
+// Stress test for MemoryPool (src/memory_pool.h). Built twice, under
+// ThreadSanitizer and under AddressSanitizer, where the compiler supports them.
+//
+// Each object records who holds it. Acquire() default-constructs, so an
+// object handed to two holders at once has its owner overwritten and the
+// first holder's check fails; a slot reused while still held shows up the
+// same way. The cases push the shared free list hard enough for a tag-less
+// ABA to corrupt it, and release objects on threads other than the one that
+// acquired them so they cross between thread caches.
+
+#include "memory_pool.h"
+#include "test_check.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+struct Tracked {
+    uint32_t owner = 0;
+    uint32_t sequence = 0;
+    uint64_t payload[6] = {};
+};
+
+constexpr int THREADS = 8;
+
+// Single thread: pointers survive growth and every slot is handed out once
+void TestGrowthKeepsPointers() {
+    MemoryPool<Tracked> pool(4, 4);
+    std::vector<Tracked*> held;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        Tracked* object = pool.Acquire();
+        CHECK(object != nullptr);
+        if (!object) return;
+        object->owner = 1;
+        object->sequence = i;
+        held.push_back(object);
+    }
+
+    std::unordered_set<Tracked*> unique(held.begin(), held.end());
+    CHECK(unique.size() == held.size());
+    CHECK(pool.GetTotalCount() >= held.size());
+    for (uint32_t i = 0; i < held.size(); ++i) {
+        CHECK(held[i]->sequence == i);
+        CHECK(pool.FromIndex(pool.GetIndex(held[i])) == held[i]);
+    }
+
+    for (Tracked* object : held) {
+        pool.Release(object);
+    }
+    CHECK(pool.GetAvailableCount() == pool.GetTotalCount());
+}
+
+// Every thread takes and returns batches larger than its cache, so each round
+// spills to and refills from the shared list while the others do the same
+void TestConcurrentBatches() {
+    MemoryPool<Tracked> pool(64, 64);
+    std::atomic<int> failures{0};
+
+    auto worker = [&](uint32_t id) {
+        std::vector<Tracked*> held;
+        for (uint32_t round = 0; round < 200; ++round) {
+            size_t batch = 1 + (round * 37 + id * 11) % 150;
+            for (size_t i = 0; i < batch; ++i) {
+                Tracked* object = pool.Acquire();
+                if (!object || object->owner != 0) {
+                    failures.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                object->owner = id;
+                object->sequence = round;
+                held.push_back(object);
+            }
+            for (Tracked* object : held) {
+                if (object->owner != id || object->sequence != round) {
+                    failures.fetch_add(1, std::memory_order_relaxed);
+                }
+                pool.Release(object);
+            }
+            held.clear();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t id = 1; id <= THREADS; ++id) {
+        threads.emplace_back(worker, id);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    CHECK(failures.load() == 0);
+    CHECK(pool.GetAvailableCount() == pool.GetTotalCount());
+}
+
+// Producers acquire, consumers release: every object is freed by a thread
+// other than the one that took it, through that thread's cache
+void TestCrossThreadRelease() {
+    constexpr int PER_PRODUCER = 20000;
+    constexpr int PRODUCERS = THREADS / 2;
+
+    MemoryPool<Tracked> pool(128, 128);
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::deque<Tracked*> queue;
+    int producersLeft = PRODUCERS;
+    std::atomic<int> failures{0};
+    std::atomic<int> released{0};
+
+    auto producer = [&](uint32_t id) {
+        for (int i = 0; i < PER_PRODUCER; ++i) {
+            Tracked* object = pool.Acquire();
+            if (!object || object->owner != 0) {
+                failures.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            object->owner = id;
+            object->sequence = static_cast<uint32_t>(i);
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queue.push_back(object);
+            queueReady.notify_one();
+        }
+        std::lock_guard<std::mutex> lock(queueMutex);
+        --producersLeft;
+        queueReady.notify_all();
+    };
+
+    auto consumer = [&]() {
+        while (true) {
+            Tracked* object = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueReady.wait(lock, [&] { return !queue.empty() || producersLeft == 0; });
+                if (queue.empty()) return;
+                object = queue.front();
+                queue.pop_front();
+            }
+            if (object->owner == 0 || object->owner > PRODUCERS) {
+                failures.fetch_add(1, std::memory_order_relaxed);
+            }
+            pool.Release(object);
+            released.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t id = 1; id <= PRODUCERS; ++id) {
+        threads.emplace_back(producer, id);
+    }
+    for (int i = 0; i < THREADS - PRODUCERS; ++i) {
+        threads.emplace_back(consumer);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    CHECK(failures.load() == 0);
+    CHECK(released.load() == PRODUCERS * PER_PRODUCER);
+    CHECK(pool.GetAvailableCount() == pool.GetTotalCount());
+}
+
+// Tight single acquire/release pairs around a pool no bigger than the
+// threads' caches, so the list head is recycled constantly: the pattern
+// where a stale head pointer would win its CAS without the tag
+void TestHeadChurn() {
+    MemoryPool<Tracked> pool(16, 16);
+    std::atomic<int> failures{0};
+
+    auto worker = [&](uint32_t id) {
+        Tracked* held[3] = {};
+        for (uint32_t i = 0; i < 50000; ++i) {
+            size_t slot = i % 3;
+            if (held[slot]) {
+                if (held[slot]->owner != id) failures.fetch_add(1, std::memory_order_relaxed);
+                pool.Release(held[slot]);
+            }
+            held[slot] = pool.Acquire();
+            if (!held[slot] || held[slot]->owner != 0) {
+                failures.fetch_add(1, std::memory_order_relaxed);
+                held[slot] = nullptr;
+                continue;
+            }
+            held[slot]->owner = id;
+        }
+        for (Tracked* object : held) {
+            pool.Release(object);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t id = 1; id <= THREADS; ++id) {
+        threads.emplace_back(worker, id);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    CHECK(failures.load() == 0);
+    CHECK(pool.GetAvailableCount() == pool.GetTotalCount());
+}
+
+} // namespace
+
+int main() {
+    TestGrowthKeepsPointers();
+    TestConcurrentBatches();
+    TestCrossThreadRelease();
+    TestHeadChurn();
+    return TestResult();
+}
@@ -0,0 +1,154 @@
+// QualityGovernor decisions (src/quality_governor.h) on synthetic frames:
+// overload cuts the knob behind the expensive phase, headroom brings quality
+// back slowly, and the ramp keeps changes gradual.
+
+#include "quality_governor.h"
+#include "test_check.h"
+
+namespace {
+
+constexpr float DT = 1.0f / 60.0f;
+
+FrameSample MakeFrame(float drawMs, float effectsMs, float columnsMs) {
+    FrameSample sample;
+    sample.phaseMs[static_cast<size_t>(ProfilePhase::Draw)] = drawMs;
+    sample.phaseMs[static_cast<size_t>(ProfilePhase::Effects)] = effectsMs;
+    sample.phaseMs[static_cast<size_t>(ProfilePhase::UpdateColumns)] = columnsMs;
+    sample.phaseMs[static_cast<size_t>(ProfilePhase::Present)] = 8.0f;
+    sample.phaseMs[static_cast<size_t>(ProfilePhase::Wait)] = 4.0f;
+    return sample;
+}
+
+// Feed whole windows of the same frame; returns how many changed a target
+int FeedWindows(QualityGovernor& governor, int windows, const FrameSample& sample, float latenessMs = 0.0f) {
+    int changes = 0;
+    for (int i = 0; i < windows * static_cast<int>(QualityGovernor::WINDOW_FRAMES); ++i) {
+        if (governor.Observe(sample, latenessMs, DT)) changes++;
+    }
+    return changes;
+}
+
+// Present and Wait block on the display and never count as load
+void TestBlockingPhasesIgnored() {
+    QualityGovernor governor;
+    FeedWindows(governor, 20, MakeFrame(2.0f, 1.0f, 1.0f));
+    CHECK_NEAR(governor.GetStatus().loadMs, 4.0, 1e-3);
+    CHECK(governor.GetStatus().decisions == 0);
+    CHECK(governor.GetLevels().Get(QualityKnob::Glow) == 1.0f);
+}
+
+// The knob cut is the one tied to the costliest phase
+void TestLowersCostliestKnob() {
+    QualityGovernor effectsHeavy;
+    CHECK(FeedWindows(effectsHeavy, 1, MakeFrame(3.0f, 12.0f, 1.0f)) == 1);
+    CHECK(effectsHeavy.GetStatus().lastDirection == -1);
+    CHECK(effectsHeavy.GetStatus().lastKnob == QualityKnob::Effects);
+    CHECK_NEAR(effectsHeavy.GetStatus().target.Get(QualityKnob::Effects), 0.75, 1e-6);
+
+    QualityGovernor drawHeavy;
+    FeedWindows(drawHeavy, 1, MakeFrame(14.0f, 1.0f, 1.0f));
+    CHECK(drawHeavy.GetStatus().lastKnob == QualityKnob::Glow);
+
+    // An unavailable knob is skipped even when its phase costs the most
+    QualityGovernor noGlow;
+    noGlow.SetKnobAvailable(QualityKnob::Glow, false);
+    FeedWindows(noGlow, 1, MakeFrame(14.0f, 1.0f, 0.5f));
+    CHECK(noGlow.GetStatus().lastKnob == QualityKnob::Effects);
+    CHECK(noGlow.GetStatus().target.Get(QualityKnob::Glow) == 1.0f);
+}
+
+// After a cut the next window is skipped while the ramp lands, and levels
+// move towards their targets at RAMP_PER_SECOND
+void TestSettleAndRamp() {
+    QualityGovernor governor;
+    FrameSample heavy = MakeFrame(3.0f, 12.0f, 1.0f);
+    FeedWindows(governor, 2, heavy);
+    CHECK(governor.GetStatus().decisions == 1);
+    // Two windows (one second) of ramping covers the 0.25 step
+    CHECK_NEAR(governor.GetLevels().Get(QualityKnob::Effects), 0.75, 1e-4);
+
+    FeedWindows(governor, 1, heavy);
+    CHECK(governor.GetStatus().decisions == 2);
+    CHECK_NEAR(governor.GetStatus().target.Get(QualityKnob::Effects), 0.5, 1e-6);
+    CHECK(governor.GetLevels().Get(QualityKnob::Effects) > 0.5f);
+}
+
+// Frames starting late count as overload even when busy time looks fine
+void TestLatenessLowers() {
+    QualityGovernor governor;
+    FeedWindows(governor, 1, MakeFrame(2.0f, 2.0f, 2.0f), 6.0f);
+    CHECK(governor.GetStatus().decisions == 1);
+    CHECK(governor.GetStatus().lastDirection == -1);
+}
+
+// Cuts stop at each knob's floor
+void TestFloors() {
+    QualityGovernor governor;
+    FeedWindows(governor, 200, MakeFrame(6.0f, 6.0f, 6.0f));
+    const QualityLevels& target = governor.GetStatus().target;
+    CHECK(target.Get(QualityKnob::Glow) == 0.0f);
+    CHECK(target.Get(QualityKnob::Effects) == 0.0f);
+    CHECK_NEAR(target.Get(QualityKnob::Columns), 0.4, 1e-5);
+}
+
+// Between the water marks nothing changes; below LOW_WATER quality returns
+// one step at a time, most visible knob first, after the cooldown
+void TestHysteresisAndRaise() {
+    QualityGovernor governor;
+    FeedWindows(governor, 1, MakeFrame(14.0f, 1.0f, 1.0f));
+    FeedWindows(governor, 2, MakeFrame(1.0f, 1.0f, 14.0f));     // The first window settles
+    CHECK(governor.GetStatus().decisions == 2);
+    CHECK(governor.GetStatus().lastKnob == QualityKnob::Columns);
+
+    // 12 ms of a 16.7 ms budget sits between the marks
+    CHECK(FeedWindows(governor, 20, MakeFrame(4.0f, 4.0f, 4.0f)) == 0);
+
+    // Quiet windows: the first raise waits for RAISE_WINDOWS of them
+    FrameSample light = MakeFrame(2.0f, 1.0f, 1.0f);
+    CHECK(FeedWindows(governor, QualityGovernor::RAISE_WINDOWS - 1, light) == 0);
+    CHECK(FeedWindows(governor, 1, light) == 1);
+    CHECK(governor.GetStatus().lastDirection == 1);
+    CHECK(governor.GetStatus().lastKnob == QualityKnob::Columns);
+
+    FeedWindows(governor, 40, light);
+    CHECK(governor.GetStatus().target.Get(QualityKnob::Glow) == 1.0f);
+    CHECK(governor.GetStatus().target.Get(QualityKnob::Columns) == 1.0f);
+}
+
+// No raise during the cooldown after a cut, however quiet it is
+void TestRaiseCooldown() {
+    QualityGovernor governor;
+    FeedWindows(governor, 1, MakeFrame(14.0f, 1.0f, 1.0f));
+    // Settling window plus RAISE_WINDOWS quiet ones: 2.5 s, inside the cooldown
+    CHECK(FeedWindows(governor, 1 + QualityGovernor::RAISE_WINDOWS, MakeFrame(2.0f, 1.0f, 1.0f)) == 0);
+    CHECK(governor.GetStatus().lastDirection == -1);
+}
+
+void TestRateAndReset() {
+    QualityGovernor governor;
+    governor.SetTargetRate(144.0);
+    CHECK_NEAR(governor.GetStatus().budgetMs, 1000.0 / 144.0, 1e-4);
+
+    // 6 ms is fine at 60 Hz but over the mark at 144 Hz
+    FeedWindows(governor, 1, MakeFrame(4.0f, 1.0f, 1.0f));
+    CHECK(governor.GetStatus().decisions == 1);
+
+    governor.Reset();
+    CHECK(governor.GetLevels().Get(QualityKnob::Glow) == 1.0f);
+    CHECK(governor.GetStatus().target.Get(QualityKnob::Glow) == 1.0f);
+    CHECK(governor.GetStatus().lastDirection == 0);
+}
+
+} // namespace
+
+int main() {
+    TestBlockingPhasesIgnored();
+    TestLowersCostliestKnob();
+    TestSettleAndRamp();
+    TestLatenessLowers();
+    TestFloors();
+    TestHysteresisAndRaise();
+    TestRaiseCooldown();
+    TestRateAndReset();
+    return TestResult();
+}
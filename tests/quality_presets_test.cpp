@@ -0,0 +1,212 @@
+// Quality presets (src/quality_presets.h): costs fitted from a machine's own
+// timings, the timings file format, and what "auto" may pick. Auto never
+// picks a preset that turns off the frame rate limiter or the governor,
+// however cheap it looks.
+
+#include "quality_presets.h"
+#include "test_check.h"
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+PresetTiming Timing(QualityPreset preset, int width, int height, float frameMs) {
+    PresetTiming timing;
+    timing.preset = preset;
+    timing.width = width;
+    timing.height = height;
+    timing.frameMs = frameMs;
+    return timing;
+}
+
+PresetCosts CalibratedCosts(float lowMs, float balancedMs, float wallMs, float maxMs) {
+    return FitPresetCosts({
+        Timing(QualityPreset::LowPower, 1920, 1080, lowMs),
+        Timing(QualityPreset::Balanced, 1920, 1080, balancedMs),
+        Timing(QualityPreset::FourKWall, 1920, 1080, wallMs),
+        Timing(QualityPreset::MaxEffects, 1920, 1080, maxMs),
+    });
+}
+
+void TestAutoCandidates() {
+    CHECK(IsAutoQualityPreset(QualityPreset::LowPower));
+    CHECK(IsAutoQualityPreset(QualityPreset::Balanced));
+    CHECK(IsAutoQualityPreset(QualityPreset::FourKWall));
+    CHECK(!IsAutoQualityPreset(QualityPreset::MaxEffects));
+
+    QualityPreset matched;
+    for (size_t i = 0; i < QUALITY_PRESET_COUNT; ++i) {
+        MatrixSettings settings;
+        ApplyQualityPreset(static_cast<QualityPreset>(i), settings);
+        CHECK(MatchQualityPreset(settings, matched) && matched == static_cast<QualityPreset>(i));
+    }
+    MatrixSettings custom;
+    ApplyQualityPreset(QualityPreset::Balanced, custom);
+    custom.density = 0.7f;
+    CHECK(!MatchQualityPreset(custom, matched));
+}
+
+// Two sizes give the line through them; one size a line through the origin
+void TestFit() {
+    PresetCosts costs = FitPresetCosts({
+        Timing(QualityPreset::Balanced, 1000, 1000, 3.0f),
+        Timing(QualityPreset::Balanced, 2000, 2000, 9.0f),
+        Timing(QualityPreset::FourKWall, 2000, 1000, 4.0f),
+        Timing(QualityPreset::FourKWall, 2000, 1000, 6.0f),
+    });
+    CHECK(!costs[static_cast<size_t>(QualityPreset::LowPower)].IsCalibrated());
+
+    const PresetCost& balanced = costs[static_cast<size_t>(QualityPreset::Balanced)];
+    CHECK(balanced.samples == 2);
+    CHECK_NEAR(balanced.fixedMs, 1.0, 1e-4);
+    CHECK_NEAR(balanced.msPerMegapixel, 2.0, 1e-4);
+    CHECK_NEAR(balanced.Predict(3000, 3000), 19.0, 1e-3);
+
+    const PresetCost& wall = costs[static_cast<size_t>(QualityPreset::FourKWall)];
+    CHECK(wall.samples == 2);
+    CHECK_NEAR(wall.fixedMs, 0.0, 1e-6);
+    CHECK_NEAR(wall.Predict(2000, 1000), 5.0, 1e-4);
+
+    // A line that would start below zero is pinned to the origin instead
+    PresetCosts steep = FitPresetCosts({
+        Timing(QualityPreset::LowPower, 1000, 1000, 1.0f),
+        Timing(QualityPreset::LowPower, 2000, 2000, 8.0f),
+    });
+    CHECK(steep[0].fixedMs >= 0.0f);
+    CHECK(steep[0].Predict(2000, 2000) > 4.0f);
+
+    // Only the most recent timings count
+    std::vector<PresetTiming> timings;
+    for (int i = 0; i < 100; ++i) {
+        timings.push_back(Timing(QualityPreset::LowPower, 1920, 1080, 20.0f));
+    }
+    for (int i = 0; i < 40; ++i) {
+        timings.push_back(Timing(QualityPreset::LowPower, 1920, 1080, 4.0f));
+    }
+    PresetCost recent = FitPresetCosts(timings)[0];
+    CHECK(recent.samples == 32);
+    CHECK_NEAR(recent.Predict(1920, 1080), 4.0, 1e-3);
+}
+
+void TestChoose() {
+    // Nothing measured: low power, whatever the budget
+    PresetCosts none;
+    CHECK(ChooseQualityPreset(3840, 2160, 1000.0f, none) == QualityPreset::LowPower);
+
+    // Max effects is never chosen, even when it measures cheapest
+    PresetCosts cheapMax = CalibratedCosts(2.0f, 4.0f, 6.0f, 0.1f);
+    CHECK(ChooseQualityPreset(1920, 1080, 16.6f, cheapMax) == QualityPreset::FourKWall);
+    CHECK(ChooseQualityPreset(1920, 1080, 1000.0f, cheapMax) == QualityPreset::FourKWall);
+    CHECK(ChooseQualityPreset(1920, 1080, 5.0f, cheapMax) == QualityPreset::Balanced);
+    CHECK(ChooseQualityPreset(1920, 1080, 1.0f, cheapMax) == QualityPreset::LowPower);
+
+    // The first unmeasured preset is tried only when everything below it fits
+    PresetCosts lowOnly = FitPresetCosts({ Timing(QualityPreset::LowPower, 1920, 1080, 3.0f) });
+    CHECK(ChooseQualityPreset(1920, 1080, 16.6f, lowOnly) == QualityPreset::Balanced);
+    CHECK(ChooseQualityPreset(1920, 1080, 2.0f, lowOnly) == QualityPreset::LowPower);
+
+    PresetCosts slowBalanced = FitPresetCosts({
+        Timing(QualityPreset::LowPower, 1920, 1080, 3.0f),
+        Timing(QualityPreset::Balanced, 1920, 1080, 30.0f),
+    });
+    CHECK(ChooseQualityPreset(1920, 1080, 16.6f, slowBalanced) == QualityPreset::LowPower);
+
+    // Resolving auto keeps the limiter and the governor on
+    MatrixSettings settings;
+    settings.qualityPreset = L"auto";
+    CHECK(ResolveQualityPreset(settings, 1920, 1080, cheapMax));
+    CHECK(settings.enableFrameRateLimiting && settings.enableQualityGovernor);
+    CHECK(settings.qualityPreset == L"auto");
+
+    // Named presets apply as they are, calibrated or not
+    MatrixSettings named;
+    named.qualityPreset = L"max-effects";
+    CHECK(ResolveQualityPreset(named, 1920, 1080, none));
+    CHECK(!named.enableQualityGovernor);
+
+    MatrixSettings unknown;
+    unknown.qualityPreset = L"ultra";
+    CHECK(!ResolveQualityPreset(unknown, 1920, 1080, none));
+}
+
+void TestTimingsFile(const std::filesystem::path& directory) {
+    PresetTiming timing = Timing(QualityPreset::FourKWall, 3840, 2160, 7.25f);
+    CHECK(FormatPresetTiming(timing) == "4k-wall,3840,2160,7.250\n");
+
+    PresetTiming parsed;
+    CHECK(ParsePresetTiming("balanced,1920,1080,5.5\r\n", parsed));
+    CHECK(parsed.preset == QualityPreset::Balanced && parsed.width == 1920 && parsed.frameMs == 5.5f);
+    CHECK(!ParsePresetTiming("preset,width,height,frame_ms", parsed));
+    CHECK(!ParsePresetTiming("ultra,1920,1080,5", parsed));
+    CHECK(!ParsePresetTiming("balanced,1920,1080", parsed));
+    CHECK(!ParsePresetTiming("balanced,1920,1080,5,6", parsed));
+    CHECK(!ParsePresetTiming("balanced,0,1080,5", parsed));
+    CHECK(!ParsePresetTiming("balanced,1920,1080,-1", parsed));
+
+    std::filesystem::path path = directory / "preset_timings.csv";
+    CHECK(LoadPresetTimings(path).empty());
+    CHECK(AppendPresetTiming(path, timing));
+    CHECK(AppendPresetTiming(path, Timing(QualityPreset::LowPower, 1920, 1080, 2.0f)));
+
+    // A torn last line is skipped
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::app);
+        file << "balanced,1920,10";
+    }
+    std::vector<PresetTiming> timings = LoadPresetTimings(path);
+    CHECK(timings.size() == 2);
+    if (timings.size() == 2) {
+        CHECK(timings[0].preset == QualityPreset::FourKWall && timings[0].frameMs == 7.25f);
+        CHECK(timings[1].preset == QualityPreset::LowPower);
+    }
+
+    std::ifstream file(path);
+    std::string header;
+    std::getline(file, header);
+    CHECK(header == "preset,width,height,frame_ms");
+}
+
+// Warm-up frames and frames with the governor cutting are left out
+void TestSampler() {
+    PresetTimingSampler sampler;
+    float median = 0.0f;
+    for (size_t i = 0; i < PresetTimingSampler::WARMUP_FRAMES; ++i) {
+        sampler.AddFrame(100.0f, true);
+    }
+    CHECK(!sampler.GetMedian(median));
+
+    for (size_t i = 0; i < PresetTimingSampler::MIN_FRAMES - 1; ++i) {
+        sampler.AddFrame(i % 2 == 0 ? 5.0f : 7.0f, true);
+        sampler.AddFrame(1.0f, false);
+    }
+    CHECK(!sampler.GetMedian(median));
+    sampler.AddFrame(6.0f, true);
+    CHECK(sampler.GetMedian(median));
+    CHECK(median >= 5.0f && median <= 7.0f);
+
+    // The ring keeps the most recent frames
+    for (size_t i = 0; i < PresetTimingSampler::CAPACITY; ++i) {
+        sampler.AddFrame(9.0f, true);
+    }
+    CHECK(sampler.GetMedian(median) && median == 9.0f);
+
+    sampler.Reset();
+    CHECK(!sampler.GetMedian(median));
+}
+
+} // namespace
+
+int main() {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "matrix_quality_presets_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    TestAutoCandidates();
+    TestFit();
+    TestChoose();
+    TestTimingsFile(directory);
+    TestSampler();
+
+    std::filesystem::remove_all(directory);
+    return TestResult();
+}
@@ -0,0 +1,86 @@
+// What a settings change invalidates (src/settings_schema.h) and what
+// MatrixSimulation::UpdateSettings does with it: color and effect changes
+// keep the rain where it is, layout changes restart it.
+
+#include "matrix_simulation.h"
+#include "test_check.h"
+#include <cstring>
+
+namespace {
+
+bool SameCells(const std::vector<GridCell>& a, const std::vector<GridCell>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(GridCell)) == 0;
+}
+
+bool SameColumns(const std::vector<MatrixColumn>& a, const std::vector<MatrixColumn>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].headGlyph != b[i].headGlyph) return false;
+    }
+    return true;
+}
+
+void TestClassify() {
+    const MatrixSettings before;
+
+    CHECK(ClassifySettingsChange(before, before) == SettingsInvalidation::None);
+
+    MatrixSettings after = before;
+    after.hue += 40.0f;
+    CHECK(ClassifySettingsChange(before, after) == SettingsInvalidation::Palette);
+
+    after = before;
+    after.fontSize += 2.0f;
+    CHECK(ClassifySettingsChange(before, after) == (SettingsInvalidation::Font | SettingsInvalidation::Layout));
+
+    after = before;
+    after.maskImagePath = L"mask.png";
+    CHECK(ClassifySettingsChange(before, after) == SettingsInvalidation::Mask);
+
+    // Changes add up
+    after = before;
+    after.hue += 40.0f;
+    after.fadeRate += 1.0f;
+    CHECK(ClassifySettingsChange(before, after) == (SettingsInvalidation::Palette | SettingsInvalidation::Effects));
+}
+
+void TestTrailsSurvive() {
+    MatrixSettings settings;
+    GlyphTable::Instance().InternWord(settings.customWord);
+    MatrixSimulation simulation;
+    simulation.Initialize(settings, 1280, 720, 99);
+    for (int frame = 0; frame < 120; ++frame) {
+        simulation.Update(1.0f / 60.0f);
+    }
+    CHECK(!simulation.GetActiveCells().empty());
+
+    std::vector<GridCell> cells = simulation.GetActiveCells();
+    std::vector<MatrixColumn> columns = simulation.GetColumns();
+
+    settings.hue += 90.0f;
+    settings.whiteHeadCharacters = !settings.whiteHeadCharacters;
+    CHECK(ClassifySettingsChange(simulation.GetSettings(), settings) == SettingsInvalidation::Palette);
+    simulation.UpdateSettings(settings);
+    CHECK(SameCells(simulation.GetActiveCells(), cells));
+    CHECK(SameColumns(simulation.GetColumns(), columns));
+
+    settings.fadeRate += 1.0f;
+    settings.speed += 2.0f;
+    CHECK(ClassifySettingsChange(simulation.GetSettings(), settings) == SettingsInvalidation::Effects);
+    simulation.UpdateSettings(settings);
+    CHECK(SameCells(simulation.GetActiveCells(), cells));
+    CHECK(SameColumns(simulation.GetColumns(), columns));
+
+    // A layout change lays the columns out again
+    settings.density *= 2.0f;
+    simulation.UpdateSettings(settings);
+    CHECK(!SameColumns(simulation.GetColumns(), columns));
+}
+
+} // namespace
+
+int main() {
+    TestClassify();
+    TestTrailsSurvive();
+    return TestResult();
+}
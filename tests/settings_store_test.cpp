@@ -0,0 +1,179 @@
+// File-based settings (src/settings_store.h, src/settings_watcher.h): the
+// text format and the compiled snapshot carry every stored field, bad lines
+// are reported without losing the good ones, the snapshot is only trusted
+// while it matches its text, and the watcher reports a settled save.
+
+#include "settings_schema.h"
+#include "settings_store.h"
+#include "settings_watcher.h"
+#include "test_check.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace {
+
+MatrixSettings ChangedSettings() {
+    MatrixSettings settings;
+    settings.density = 1.25f;
+    settings.hue = 275.5f;
+    settings.targetFrameRate = 144;
+    settings.boldFont = false;
+    settings.fontName = L"Cascadia \"Mono\"";
+    settings.customWord = L"\x30CD\x30AA \U0001F600";
+    settings.maskImagePath = L"C:\\masks\\logo.png";
+    settings.customMessages = { L"WAKE UP", L"FOLLOW | THE RABBIT" };
+    return settings;
+}
+
+void WriteText(const std::filesystem::path& path, const std::string& text) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << text;
+}
+
+void TestTextRoundTrip() {
+    MatrixSettings settings = ChangedSettings();
+    std::string text = FormatSettingsText(settings);
+    CHECK(text.find("CustomMessages = \"FOLLOW | THE RABBIT\"\n") != std::string::npos);
+
+    MatrixSettings parsed;
+    std::vector<std::string> errors;
+    CHECK(ParseSettingsText(text, parsed, &errors));
+    CHECK(errors.empty());
+    CHECK(DiffSettings(settings, parsed).empty());
+    CHECK(parsed.customMessages == settings.customMessages);
+}
+
+// Missing and rejected names take their stored defaults; bad lines are
+// reported by line number and the rest still apply
+void TestTextErrors() {
+    std::string text =
+        "\xEF\xBB\xBF# comment\n"
+        "Hue = 30\n"
+        "Density = lots\n"
+        "NoSuchSetting = 1\n"
+        "just words\n"
+        "FontName = \"unterminated\n"
+        "BoldFont = false\n";
+
+    MatrixSettings settings;
+    std::vector<std::string> errors;
+    CHECK(!ParseSettingsText(text, settings, &errors));
+    CHECK(errors.size() == 4);
+    CHECK(settings.hue == 30.0f);
+    CHECK(!settings.boldFont);
+    CHECK(settings.density == 0.6f);
+    CHECK(settings.fontName == L"Consolas");
+    CHECK(settings.customMessages.empty());
+
+    bool unknownReported = false;
+    for (const std::string& error : errors) {
+        if (error.find("line 4") != std::string::npos && error.find("NoSuchSetting") != std::string::npos) {
+            unknownReported = true;
+        }
+    }
+    CHECK(unknownReported);
+}
+
+void TestSnapshot() {
+    MatrixSettings settings = ChangedSettings();
+    std::string data;
+    EncodeSettingsSnapshot(settings, 1234, data);
+
+    MatrixSettings decoded;
+    uint64_t stamp = 0;
+    CHECK(DecodeSettingsSnapshot(data, decoded, stamp));
+    CHECK(stamp == 1234);
+    CHECK(DiffSettings(settings, decoded).empty());
+    CHECK(decoded.customWord == settings.customWord);
+    CHECK(decoded.customMessages == settings.customMessages);
+
+    // A bad snapshot leaves the settings as they were
+    MatrixSettings untouched;
+    CHECK(!DecodeSettingsSnapshot(std::string_view(data).substr(0, data.size() - 1), untouched, stamp));
+    CHECK(DiffSettings(MatrixSettings(), untouched).empty());
+    std::string badMagic = data;
+    badMagic[0] = 'X';
+    CHECK(!DecodeSettingsSnapshot(badMagic, untouched, stamp));
+}
+
+// The snapshot is used only while its stamp matches the text
+void TestStore(const std::filesystem::path& directory) {
+    SettingsStore store(directory / "settings.ini");
+    CHECK(!store.Exists());
+    MatrixSettings settings;
+    CHECK(!store.Load(settings));
+
+    CHECK(store.Save(ChangedSettings()));
+    CHECK(store.Exists());
+    CHECK(std::filesystem::exists(store.GetSnapshotPath()));
+    CHECK(store.Load(settings));
+    CHECK(store.LoadedFromSnapshot());
+    CHECK(DiffSettings(ChangedSettings(), settings).empty());
+
+    // Edited text: parsed and recompiled, then the snapshot is current again
+    WriteText(store.GetTextPath(), "Hue = 10\nTargetFrameRate = 30\n");
+    MatrixSettings edited;
+    CHECK(store.Load(edited));
+    CHECK(!store.LoadedFromSnapshot());
+    CHECK(edited.hue == 10.0f && edited.targetFrameRate == 30);
+    CHECK(store.Load(edited));
+    CHECK(store.LoadedFromSnapshot());
+
+    // Text with errors is never compiled, so the errors show on every load
+    WriteText(store.GetTextPath(), "Hue = 20\nHue = blue\n");
+    CHECK(store.Load(edited));
+    CHECK(!store.GetErrors().empty());
+    CHECK(store.Load(edited));
+    CHECK(!store.LoadedFromSnapshot());
+    CHECK(!store.GetErrors().empty());
+}
+
+bool WaitForChange(SettingsWatcher& watcher, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (watcher.ConsumeChange()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return false;
+}
+
+void TestWatcher(const std::filesystem::path& directory) {
+    std::filesystem::path path = directory / "watched.ini";
+    WriteText(path, "Hue = 1\n");
+
+    SettingsWatcher watcher(path);
+    CHECK(watcher.Start());
+    CHECK(!WaitForChange(watcher, std::chrono::milliseconds(300)));
+
+    // Other files in the directory are not changes
+    WriteText(directory / "unrelated.log", "noise\n");
+    CHECK(!WaitForChange(watcher, std::chrono::milliseconds(400)));
+
+    // A rename-over save, as editors do, reported once after it settles
+    WriteText(directory / "watched.ini.tmp", "Hue = 2\nDensity = 0.9\n");
+    std::filesystem::rename(directory / "watched.ini.tmp", path);
+    CHECK(WaitForChange(watcher, std::chrono::seconds(5)));
+    CHECK(!watcher.ConsumeChange());
+
+    watcher.Stop();
+    CHECK(!watcher.IsRunning());
+}
+
+} // namespace
+
+int main() {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "matrix_settings_store_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    TestTextRoundTrip();
+    TestTextErrors();
+    TestSnapshot();
+    TestStore(directory);
+    TestWatcher(directory);
+
+    std::filesystem::remove_all(directory);
+    return TestResult();
+}
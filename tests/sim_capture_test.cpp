@@ -0,0 +1,219 @@
+// Simulation capture and replay (src/sim_capture.h): a recorded session
+// decodes to the same inputs and, fed to a fresh simulation the way
+// matrix_replay does, reproduces every checkpoint hash.
+
+#include "matrix_simulation.h"
+#include "sim_capture.h"
+#include "test_check.h"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+constexpr uint32_t SEED = 1234;
+constexpr int FRAMES = 600;
+
+MatrixSettings CaptureSettings() {
+    MatrixSettings settings;
+    settings.enableCharacterMorphing = true;
+    settings.enableGlitchEffects = true;
+    settings.enableRainVariations = true;
+    return settings;
+}
+
+// Uneven frame times, as a message-loop timer produces
+float FrameTime(int frame) {
+    return 1.0f / 60.0f + 0.004f * std::sin(static_cast<float>(frame) * 0.7f);
+}
+
+std::vector<uint8_t> MakeDepthMap(int width, int height) {
+    std::vector<uint8_t> depthMap(static_cast<size_t>(width) * height);
+    for (size_t i = 0; i < depthMap.size(); ++i) {
+        depthMap[i] = static_cast<uint8_t>((i / 7) % 3 * 100);
+    }
+    return depthMap;
+}
+
+// Drive a simulation and record it the way the renderer does
+void RecordSession(const std::filesystem::path& path) {
+    GlyphTable::Instance().InternWord(CaptureSettings().customWord);
+
+    SimRecorder recorder;
+    CHECK(recorder.Open(path));
+
+    MatrixSimulation simulation;
+    MatrixSettings settings = CaptureSettings();
+    recorder.RecordInitialize(settings, 1280, 720, SEED);
+    simulation.Initialize(settings, 1280, 720, SEED);
+    recorder.RecordFastForward(2.0f);
+    simulation.FastForward(2.0f);
+
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        if (frame == 150) {
+            settings.glitchFrequency = 0.2f;
+            settings.enableSystemDisruptions = true;
+            recorder.RecordSettings(settings);
+            simulation.UpdateSettings(settings);
+        }
+        if (frame == 250) {
+            recorder.RecordResize(1024, 768);
+            simulation.Resize(1024, 768);
+        }
+        if (frame == 300) {
+            std::vector<uint8_t> depthMap = MakeDepthMap(64, 48);
+            recorder.RecordDepthMap(64, 48, depthMap);
+            simulation.SetDepthMap(64, 48, std::move(depthMap));
+        }
+        if (frame == 400) {
+            SimQuality quality;
+            quality.columnFraction = 0.75f;
+            quality.effectScale = 0.5f;
+            quality.effectInterval = 2;
+            recorder.RecordQuality(quality);
+            simulation.SetQuality(quality);
+        }
+
+        float deltaTime = FrameTime(frame);
+        simulation.Update(deltaTime);
+        recorder.RecordFrame(deltaTime, simulation);
+    }
+
+    CHECK(recorder.GetFrameCount() == FRAMES);
+    recorder.Close();
+}
+
+std::string ReadFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+struct ReplayResult {
+    uint64_t frames = 0;
+    uint64_t checkpoints = 0;
+    uint64_t mismatches = 0;
+    int resizes = 0;
+    int depthMaps = 0;
+    int qualityChanges = 0;
+    int settingsChanges = 0;
+    bool error = false;
+};
+
+// seedOffset != 0 replays from the wrong seed, which must be caught
+ReplayResult Replay(std::string_view data, uint32_t seedOffset = 0) {
+    ReplayResult result;
+    SimCaptureReader reader(data);
+    SimCaptureEvent event;
+    MatrixSimulation simulation;
+    bool initialized = false;
+
+    while (reader.Next(event)) {
+        switch (event.kind) {
+            case SimCaptureRecordKind::Settings:
+                if (initialized) {
+                    simulation.UpdateSettings(event.settings);
+                    result.settingsChanges++;
+                    CHECK(event.settings.glitchFrequency == 0.2f);
+                    CHECK(event.settings.enableSystemDisruptions);
+                }
+                break;
+            case SimCaptureRecordKind::Initialize:
+                CHECK(event.width == 1280 && event.height == 720 && event.seed == SEED);
+                simulation.Initialize(event.settings, event.width, event.height, event.seed + seedOffset);
+                initialized = true;
+                break;
+            case SimCaptureRecordKind::Resize:
+                simulation.Resize(event.width, event.height);
+                result.resizes++;
+                break;
+            case SimCaptureRecordKind::DepthMap:
+                CHECK(event.depthMap == MakeDepthMap(64, 48));
+                simulation.SetDepthMap(event.width, event.height, std::move(event.depthMap));
+                result.depthMaps++;
+                break;
+            case SimCaptureRecordKind::Frame:
+                CHECK(event.deltaTime == FrameTime(static_cast<int>(result.frames)));
+                simulation.Update(event.deltaTime);
+                result.frames++;
+                break;
+            case SimCaptureRecordKind::FastForward:
+                simulation.FastForward(event.deltaTime);
+                break;
+            case SimCaptureRecordKind::Quality:
+                CHECK(event.quality.effectInterval == 2);
+                simulation.SetQuality(event.quality);
+                result.qualityChanges++;
+                break;
+            case SimCaptureRecordKind::Checkpoint:
+                result.checkpoints++;
+                if (event.frameIndex != result.frames || event.stateHash != simulation.ComputeStateHash()) {
+                    result.mismatches++;
+                }
+                break;
+        }
+    }
+    result.error = reader.HasError();
+    return result;
+}
+
+void TestReplayReproducesSession(const std::string& data) {
+    ReplayResult result = Replay(data);
+    CHECK(!result.error);
+    CHECK(result.frames == FRAMES);
+    CHECK(result.checkpoints == FRAMES / SimRecorder::CHECKPOINT_INTERVAL);
+    CHECK(result.mismatches == 0);
+    CHECK(result.settingsChanges == 1);
+    CHECK(result.resizes == 1);
+    CHECK(result.depthMaps == 1);
+    CHECK(result.qualityChanges == 1);
+
+    // The checkpoints are what catch a divergence
+    ReplayResult wrongSeed = Replay(data, 1);
+    CHECK(wrongSeed.mismatches == wrongSeed.checkpoints);
+}
+
+void TestMalformedData(const std::string& data) {
+    ReplayResult truncated = Replay(std::string_view(data).substr(0, data.size() - 3));
+    CHECK(truncated.error);
+
+    std::string badMagic = data;
+    badMagic[0] = 'X';
+    SimCaptureReader reader(badMagic);
+    SimCaptureEvent event;
+    CHECK(!reader.Next(event));
+    CHECK(reader.HasError());
+}
+
+void TestSettingsEncoding() {
+    MatrixSettings settings = CaptureSettings();
+    settings.density = 1.7f;
+    settings.fontSize = 22.0f;
+    settings.customWord = L"NEO";
+
+    std::string encoded;
+    SerializeSimSettings(settings, encoded);
+    MatrixSettings decoded;
+    CHECK(DeserializeSimSettings(encoded, decoded));
+    CHECK(decoded.density == 1.7f);
+    CHECK(decoded.fontSize == 22.0f);
+    CHECK(decoded.enableGlitchEffects);
+    CHECK(decoded.customWord == L"NEO");
+
+    CHECK(!DeserializeSimSettings(std::string_view(encoded).substr(0, 3), decoded));
+}
+
+} // namespace
+
+int main() {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "matrix_sim_capture_test.mxrp";
+    RecordSession(path);
+    std::string data = ReadFile(path);
+    std::filesystem::remove(path);
+    CHECK(!data.empty());
+
+    TestReplayReproducesSession(data);
+    TestMalformedData(data);
+    TestSettingsEncoding();
+    return TestResult();
+}
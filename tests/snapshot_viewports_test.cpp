@@ -0,0 +1,108 @@
+// Snapshot cells grouped by viewport (MatrixSimulation::BuildSnapshot in
+// src/matrix_simulation.h): each viewport gets exactly the drawn cells and
+// heads within VIEWPORT_MARGIN of it, cells near a shared edge go to both
+// sides, and cells no viewport shows are left out.
+
+#include "matrix_simulation.h"
+#include "test_check.h"
+#include <utility>
+
+namespace {
+
+constexpr int WIDTH = 1920;
+constexpr int HEIGHT = 1080;
+
+using CellPosition = std::pair<int, int>;
+
+bool IsDrawn(const GridCell& cell) {
+    return cell.IsActive() && cell.GetAlpha() >= 0.05f && cell.glyph != INVALID_GLYPH;
+}
+
+bool Contains(const SimViewport& viewport, float x, float y) {
+    const float margin = MatrixSimulation::VIEWPORT_MARGIN;
+    return x >= viewport.left - margin && x <= viewport.right + margin &&
+           y >= viewport.top - margin && y <= viewport.bottom + margin;
+}
+
+std::vector<CellPosition> Group(const FrameSnapshot& snapshot, size_t index) {
+    const SnapshotViewport& viewport = snapshot.viewports[index];
+    std::vector<CellPosition> cells;
+    for (uint32_t i = 0; i < viewport.cellCount; ++i) {
+        const SnapshotCell& cell = snapshot.cells[viewport.firstCell + i];
+        cells.push_back({ cell.x, cell.y });
+    }
+    return cells;
+}
+
+void TestViewportGroups() {
+    MatrixSettings settings;
+    GlyphTable::Instance().InternWord(settings.customWord);
+    MatrixSimulation simulation;
+    simulation.Initialize(settings, WIDTH, HEIGHT, 5);
+    simulation.FastForward(4.0f);
+
+    // Two side by side, and a third over the top half of the right side only
+    const SimViewport viewports[] = {
+        { 1, 0, 0, 640, HEIGHT },
+        { 2, 640, 0, 1280, HEIGHT },
+        { 3, 1280, 0, WIDTH, HEIGHT / 2 },
+    };
+    FrameSnapshot snapshot;
+    simulation.BuildSnapshot(snapshot, viewports);
+    // A second build into the same snapshot reuses its storage and agrees
+    simulation.BuildSnapshot(snapshot, viewports);
+    CHECK(snapshot.viewports.size() == 3);
+    if (snapshot.viewports.size() != 3) return;
+
+    float cellWidth = settings.fontSize * 0.8f;
+    float cellHeight = settings.fontSize * 0.9f;
+    std::vector<CellPosition> expected[3];
+    size_t shared = 0;
+    size_t unseen = 0;
+    for (const GridCell& cell : simulation.GetActiveCells()) {
+        if (!IsDrawn(cell)) continue;
+
+        float x = cell.x * cellWidth;
+        float y = cell.y * cellHeight;
+        int showing = 0;
+        for (size_t i = 0; i < 3; ++i) {
+            if (Contains(viewports[i], x, y)) {
+                expected[i].push_back({ cell.x, cell.y });
+                showing++;
+            }
+        }
+        if (Contains(viewports[0], x, y) && Contains(viewports[1], x, y)) shared++;
+        if (showing == 0) unseen++;
+    }
+    CHECK(shared > 0);
+    CHECK(unseen > 0);
+
+    size_t total = 0;
+    for (size_t i = 0; i < 3; ++i) {
+        const SnapshotViewport& viewport = snapshot.viewports[i];
+        CHECK(viewport.rect.id == viewports[i].id);
+        CHECK(viewport.cellCount == expected[i].size());
+        CHECK(Group(snapshot, i) == expected[i]);
+        total += viewport.cellCount;
+
+        uint32_t heads = 0;
+        for (const MatrixColumn& column : simulation.GetColumns()) {
+            if (column.isActive && Contains(viewports[i], column.x, column.y)) heads++;
+        }
+        CHECK(viewport.columnCount == heads);
+    }
+    // Shared cells are in two groups; unseen ones in none
+    CHECK(snapshot.cells.size() == total);
+
+    // Without viewports the whole screen is one
+    simulation.BuildSnapshot(snapshot);
+    CHECK(snapshot.viewports.size() == 1);
+    CHECK(snapshot.viewports[0].rect.right == WIDTH && snapshot.viewports[0].rect.bottom == HEIGHT);
+}
+
+} // namespace
+
+int main() {
+    TestViewportGroups();
+    return TestResult();
+}
@@ -0,0 +1,133 @@
+// Steps the simulation and the glyph run builder headlessly and fails if any
+// of 10,000 frames after the warm-up touches the global heap.
+// Built with MATRIX_COUNT_ALLOCATIONS (see src/alloc_counter.h).
+//
+// Each frame does what the renderer does between presents, minus the
+// DirectWrite calls: Update, BuildSnapshot, then batches of glyphs and cell
+// rects in the frame arena turned into glyph runs.
+
+#include "alloc_counter.h"
+#include "frame_arena.h"
+#include "glyph_run_builder.h"
+#include "matrix_simulation.h"
+#include "test_check.h"
+#include <array>
+#include <cstdio>
+
+namespace {
+
+// The screen fills within a few seconds, but the rain variations keep
+// pushing the cell count to new highs, and the frame arena grows with
+// them, for about 15 s more; the warm-up waits that out
+constexpr int WARMUP_FRAMES = 1200;
+constexpr int FRAMES = 10000;       // Measured after the warm-up
+constexpr float STEP = 1.0f / 60.0f;
+constexpr int WIDTH = 1920;
+constexpr int HEIGHT = 1080;
+constexpr size_t DEPTH_BATCHES = 4;  // Font sizes the renderer batches by
+
+MatrixSettings TestSettings() {
+    MatrixSettings settings;
+    settings.enableCharacterMorphing = true;
+    settings.enableGlitchEffects = true;
+    settings.enablePhosphorGlow = true;
+    settings.enableRainVariations = true;
+    settings.enableSystemDisruptions = true;
+    return settings;
+}
+
+// Every interned glyph drawable from one face, as a font that has them all
+void FillMetrics(GlyphMetricsCache& cache) {
+    const GlyphTable& table = GlyphTable::Instance();
+    for (size_t id = 0; id < table.GetGlyphCount(); ++id) {
+        GlyphMetrics metrics;
+        metrics.fontGlyphIndex = static_cast<uint16_t>(id + 1);
+        metrics.advance = 0.6f;
+        metrics.drawable = true;
+        cache.Set(static_cast<GlyphId>(id), metrics);
+    }
+}
+
+struct Batch {
+    FrameVector<GlyphId> glyphs;
+    FrameVector<GlyphCellRect> rects;
+
+    Batch() = default;
+    explicit Batch(FrameArena* arena)
+        : glyphs(ArenaAllocator<GlyphId>(arena)),
+          rects(ArenaAllocator<GlyphCellRect>(arena)) {}
+};
+
+// Returns the glyphs drawn so the work is not optimized away
+size_t DrawFrame(const FrameSnapshot& snapshot, const GlyphMetricsCache& cache,
+                 FrameArena& arena, float cellSize) {
+    std::array<Batch, DEPTH_BATCHES> batches;
+    for (Batch& batch : batches) {
+        batch = Batch(&arena);
+    }
+
+    for (const SnapshotCell& cell : snapshot.cells) {
+        Batch& batch = batches[cell.depth * DEPTH_BATCHES / 256];
+        float left = cell.x * cellSize;
+        float top = cell.y * cellSize;
+        batch.glyphs.push_back(cell.displayGlyph);
+        batch.rects.push_back({ left, top, left + cellSize, top + cellSize });
+    }
+
+    size_t drawn = 0;
+    GlyphRun run(&arena);
+    for (size_t i = 0; i < DEPTH_BATCHES; ++i) {
+        float fontSize = cellSize * (0.6f + 0.2f * static_cast<float>(i));
+        GlyphRunBuilder::Build(batches[i].glyphs.data(), batches[i].rects.data(), batches[i].glyphs.size(),
+                               fontSize, cache, run);
+        drawn += run.GetGlyphCount() + run.fallback.size();
+    }
+    return drawn;
+}
+
+} // namespace
+
+int main() {
+    CHECK(IsAllocationCountingEnabled());
+
+    MatrixSettings settings = TestSettings();
+    GlyphTable::Instance().InternWord(settings.customWord);
+
+    MatrixSimulation simulation;
+    simulation.Initialize(settings, WIDTH, HEIGHT, 1);
+    FrameSnapshot snapshot;
+    FrameArena arena;
+    GlyphMetricsCache cache;
+    FillMetrics(cache);
+
+    int allocatingFrames = 0;
+    uint64_t allocations = 0;
+    size_t drawn = 0;
+    for (int frame = 0; frame < WARMUP_FRAMES + FRAMES; ++frame) {
+        AllocationStats before = GetAllocationStats();
+
+        simulation.Update(STEP);
+        simulation.BuildSnapshot(snapshot);
+        drawn += DrawFrame(snapshot, cache, arena, settings.fontSize);
+        arena.Reset();
+
+        AllocationStats after = GetAllocationStats();
+        uint64_t frameAllocations = after.allocations - before.allocations;
+        if (frame >= WARMUP_FRAMES && frameAllocations > 0) {
+            if (allocatingFrames < 10) {
+                std::fprintf(stderr, "frame %d: %llu allocations, %llu bytes\n", frame,
+                             static_cast<unsigned long long>(frameAllocations),
+                             static_cast<unsigned long long>(after.bytes - before.bytes));
+            }
+            allocatingFrames++;
+            allocations += frameAllocations;
+        }
+    }
+
+    std::printf("%d frames after a %d-frame warm-up: %d allocated (%llu allocations), %zu glyphs drawn\n",
+                FRAMES, WARMUP_FRAMES, allocatingFrames,
+                static_cast<unsigned long long>(allocations), drawn);
+    CHECK(drawn > 0);
+    CHECK(allocatingFrames == 0);
+    return TestResult();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal checks shared by the tests in this directory. A failed CHECK prints
+// where it failed and carries on, so one run reports every broken case;
+// main() returns TestResult() so CTest sees the failure.
+
+inline int& TestFailureCount() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++TestFailureCount();                                                     \
+        }                                                                             \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                       \
+    do {                                                                              \
+        double checkActual = static_cast<double>(actual);                             \
+        double checkExpected = static_cast<double>(expected);                         \
+        double checkDiff = checkActual - checkExpected;                               \
+        if (checkDiff < -(tolerance) || checkDiff > (tolerance)) {                    \
+            std::fprintf(stderr, "%s:%d: CHECK_NEAR(%s, %s) failed: %g vs %g\n",      \
+                         __FILE__, __LINE__, #actual, #expected, checkActual, checkExpected); \
+            ++TestFailureCount();                                                     \
+        }                                                                             \
+    } while (0)
+
+inline int TestResult() {
+    if (TestFailureCount() == 0) return 0;
+    std::fprintf(stderr, "%d check(s) failed\n", TestFailureCount());
+    return 1;
+}
@@ -0,0 +1,186 @@
+// Warm start files (src/sim_warm_start.h): a saved scene restores to the same
+// state, glitch glyphs and effect slots included, and a file that does not
+// fit the running simulation is refused without touching the scene or the
+// glyph table.
+
+#include "matrix_simulation.h"
+#include "sim_warm_start.h"
+#include "test_check.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+constexpr uint32_t SEED = 4321;
+constexpr int WIDTH = 1280;
+constexpr int HEIGHT = 720;
+constexpr int FRAMES = 180;
+constexpr size_t HEADER_SIZE = 4 + 2 + 2 + 8 + 4 + 4;
+
+MatrixSettings WarmSettings() {
+    MatrixSettings settings;
+    settings.enableCharacterMorphing = true;
+    settings.enableGlitchEffects = true;
+    settings.glitchFrequency = 1.0f;
+    return settings;
+}
+
+// Two calls with the same arguments give the same scene and random stream
+void RunScene(MatrixSimulation& simulation, const MatrixSettings& settings, int width, int height) {
+    simulation.Initialize(settings, width, height, SEED);
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        simulation.Update(1.0f / 60.0f);
+    }
+}
+
+void WriteFile(const std::filesystem::path& path, const std::string& data) {
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+// The file's glyph list: the offset just past it and the offset of each entry
+size_t SkipGlyphs(const std::string& data, std::vector<size_t>& entries) {
+    uint16_t count = 0;
+    std::memcpy(&count, data.data() + HEADER_SIZE, sizeof(count));
+    size_t offset = HEADER_SIZE + sizeof(count);
+    for (uint16_t i = 0; i < count; ++i) {
+        entries.push_back(offset);
+        offset += 1 + static_cast<uint8_t>(data[offset]) * sizeof(char16_t);
+    }
+    return offset;
+}
+
+void TestRoundTrip(const std::filesystem::path& directory) {
+    std::filesystem::path path = directory / "round_trip.mxws";
+    MatrixSimulation original;
+    RunScene(original, WarmSettings(), WIDTH, HEIGHT);
+
+    size_t glitching = 0;
+    for (const GridCell& cell : original.GetActiveCells()) {
+        if (cell.IsGlitching()) glitching++;
+    }
+    CHECK(glitching > 0);
+    CHECK(original.GetCharacterEffects().GetActiveEffectCount() > 0);
+    CHECK(SaveWarmStart(path, original));
+
+    // The twin has the original's random stream, so with its scene cleared
+    // and restored the whole state hash matches
+    MatrixSimulation twin;
+    RunScene(twin, WarmSettings(), WIDTH, HEIGHT);
+    twin.Clear();
+    CHECK(twin.ComputeStateHash() != original.ComputeStateHash());
+    CHECK(LoadWarmStart(path, twin));
+    CHECK(twin.ComputeStateHash() == original.ComputeStateHash());
+    CHECK(twin.GetCharacterEffects().GetActiveEffectCount() ==
+          original.GetCharacterEffects().GetActiveEffectCount());
+
+    const std::vector<GridCell>& before = original.GetActiveCells();
+    const std::vector<GridCell>& after = twin.GetActiveCells();
+    CHECK(before.size() == after.size());
+    for (size_t i = 0; i < before.size() && i < after.size(); ++i) {
+        const CellEffectState* saved = original.GetCharacterEffects().GetCellEffectState(before[i]);
+        const CellEffectState* restored = twin.GetCharacterEffects().GetCellEffectState(after[i]);
+        CHECK((saved == nullptr) == (restored == nullptr));
+        if (saved && restored) {
+            CHECK(after[i].effectSlot != NO_EFFECT_SLOT);
+            CHECK(restored->glitchGlyphs == saved->glitchGlyphs);
+        }
+    }
+
+    // A fresh simulation with its own random stream takes the same scene
+    MatrixSimulation fresh;
+    fresh.Initialize(WarmSettings(), WIDTH, HEIGHT, SEED + 1);
+    CHECK(LoadWarmStart(path, fresh));
+    std::string saved;
+    std::string resaved;
+    EncodeWarmStart(original, saved);
+    EncodeWarmStart(fresh, resaved);
+    CHECK(saved == resaved);
+}
+
+// Each refusal leaves the scene and the glyph table as they were
+void CheckRefused(const std::string& data, MatrixSimulation& simulation, const std::filesystem::path& path) {
+    WriteFile(path, data);
+    uint64_t hash = simulation.ComputeStateHash();
+    size_t glyphCount = GlyphTable::Instance().GetGlyphCount();
+    CHECK(!LoadWarmStart(path, simulation));
+    CHECK(simulation.ComputeStateHash() == hash);
+    CHECK(GlyphTable::Instance().GetGlyphCount() == glyphCount);
+}
+
+void TestRefused(const std::filesystem::path& directory) {
+    std::filesystem::path path = directory / "refused.mxws";
+    MatrixSimulation original;
+    RunScene(original, WarmSettings(), WIDTH, HEIGHT);
+    std::string data;
+    EncodeWarmStart(original, data);
+
+    MatrixSimulation target;
+    RunScene(target, WarmSettings(), WIDTH, HEIGHT);
+    target.Update(0.5f);                    // So a wrongful restore would show
+
+    // Another screen size, either way
+    MatrixSimulation wider;
+    RunScene(wider, WarmSettings(), WIDTH + 8, HEIGHT);
+    CheckRefused(data, wider, path);
+    MatrixSimulation taller;
+    RunScene(taller, WarmSettings(), WIDTH, HEIGHT + 8);
+    CheckRefused(data, taller, path);
+
+    // Other simulation settings
+    MatrixSettings faster = WarmSettings();
+    faster.maxSpeed += 1.0f;
+    MatrixSimulation other;
+    RunScene(other, faster, WIDTH, HEIGHT);
+    CheckRefused(data, other, path);
+
+    // Cut short anywhere: in the header, the glyph list or the cells
+    for (size_t size : { HEADER_SIZE - 1, HEADER_SIZE + 3, data.size() / 2, data.size() - 1 }) {
+        CheckRefused(data.substr(0, size), target, path);
+    }
+
+    // Version 1 files had no glitch glyphs
+    std::string versionOne = data;
+    uint16_t version = 1;
+    std::memcpy(versionOne.data() + 4, &version, sizeof(version));
+    CheckRefused(versionOne, target, path);
+
+    // A glyph list one entry short, its last entry a glyph never seen before:
+    // the state refers past the end of the list, and the new glyph must not
+    // be interned on the way to finding that out
+    std::vector<size_t> entries;
+    size_t glyphsEnd = SkipGlyphs(data, entries);
+    CHECK(entries.size() > 2);
+    if (entries.size() > 2) {
+        std::string mismatch = data.substr(0, HEADER_SIZE);
+        uint16_t count = static_cast<uint16_t>(entries.size() - 1);
+        mismatch.append(reinterpret_cast<const char*>(&count), sizeof(count));
+        mismatch.append(data, entries[0], entries[entries.size() - 2] - entries[0]);
+        char16_t unseen = u'\xE5A1';
+        mismatch.push_back(1);
+        mismatch.append(reinterpret_cast<const char*>(&unseen), sizeof(unseen));
+        mismatch.append(data, glyphsEnd, std::string::npos);
+        CheckRefused(mismatch, target, path);
+    }
+
+    // Unaltered, the same file fits
+    WriteFile(path, data);
+    CHECK(LoadWarmStart(path, target));
+}
+
+} // namespace
+
+int main() {
+    GlyphTable::Instance().InternWord(WarmSettings().customWord);
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "matrix_warm_start_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    TestRoundTrip(directory);
+    TestRefused(directory);
+
+    std::filesystem::remove_all(directory);
+    return TestResult();
+}
@@ -0,0 +1,77 @@
+// matrix_logdump: decode binary screensaver logs (.mlog) to text.
+//
+//   matrix_logdump [--utc] <file.mlog>...
+//
+// Lines go to stdout in the same layout as the text log. Builds on any
+// platform from src/binary_log_reader.cpp alone.
+
+#include "binary_log_reader.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool ReadFile(const char* path, std::string& data) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) return false;
+
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+}
+
+void PrintUsage() {
+    std::fprintf(stderr, "usage: matrix_logdump [--utc] <file.mlog>...\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool utc = false;
+    std::vector<const char*> paths;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--utc") == 0) {
+            utc = true;
+        } else if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0) {
+            PrintUsage();
+            return 0;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    if (paths.empty()) {
+        PrintUsage();
+        return 2;
+    }
+
+    int status = 0;
+    std::string data;
+    std::string line;
+
+    for (const char* path : paths) {
+        if (!ReadFile(path, data)) {
+            std::fprintf(stderr, "matrix_logdump: cannot read %s\n", path);
+            status = 1;
+            continue;
+        }
+
+        BinaryLogReader reader(data);
+        reader.SetUtc(utc);
+        while (reader.NextLine(line)) {
+            std::fwrite(line.data(), 1, line.size(), stdout);
+            std::fputc('\n', stdout);
+        }
+
+        if (reader.HasError()) {
+            std::fprintf(stderr, "matrix_logdump: %s: %s\n", path, reader.GetError().c_str());
+            status = 1;
+        }
+    }
+
+    return status;
+}
@@ -0,0 +1,196 @@
+// matrix_poolbench: compare MemoryPool (src/memory_pool.h) with new/delete.
+//
+//   matrix_poolbench [--threads <n>] [--ops <n>]
+//
+// Each pattern runs on 1 thread and on n threads (default: the hardware
+// thread count) and prints nanoseconds per acquire/release pair:
+//
+//   pairs    acquire then release at once, the per-cell effect pattern
+//   batch    acquire 256, release them in reverse, the per-frame particle pattern
+//   cross    half the threads acquire and the other half release, through a
+//            locked hand-off queue shared by both allocators
+//
+// Build optimized; the numbers are only as good as the build that produced them.
+
+#include "memory_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Roughly the size of a cell effect record
+struct Payload {
+    uint64_t words[8] = {};
+};
+
+constexpr size_t BATCH = 256;
+
+void PrintUsage() {
+    std::fprintf(stderr, "usage: matrix_poolbench [--threads <n>] [--ops <n>]\n");
+}
+
+struct PoolAllocator {
+    MemoryPool<Payload> pool{ 4096, 1024 };
+
+    Payload* Acquire() { return pool.Acquire(); }
+    void Release(Payload* object) { pool.Release(object); }
+};
+
+struct HeapAllocator {
+    Payload* Acquire() { return new Payload{}; }
+    void Release(Payload* object) { delete object; }
+};
+
+// Keep the optimizer from dropping allocations whose result goes unused
+void Touch(Payload* object, size_t value) {
+    object->words[0] = value;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+template<typename Allocator>
+void RunPairs(Allocator& allocator, size_t ops) {
+    for (size_t i = 0; i < ops; ++i) {
+        Payload* object = allocator.Acquire();
+        Touch(object, i);
+        allocator.Release(object);
+    }
+}
+
+template<typename Allocator>
+void RunBatch(Allocator& allocator, size_t ops) {
+    std::vector<Payload*> held(BATCH);
+    for (size_t done = 0; done < ops; done += BATCH) {
+        for (size_t i = 0; i < BATCH; ++i) {
+            held[i] = allocator.Acquire();
+            Touch(held[i], i);
+        }
+        for (size_t i = BATCH; i-- > 0;) {
+            allocator.Release(held[i]);
+        }
+    }
+}
+
+// Producers hand whole batches over so the lock is not what gets measured
+struct HandOff {
+    std::mutex mutex;
+    std::vector<std::vector<Payload*>> batches;
+    size_t producersLeft = 0;
+};
+
+template<typename Allocator>
+void RunProducer(Allocator& allocator, HandOff& handOff, size_t ops) {
+    for (size_t done = 0; done < ops; done += BATCH) {
+        std::vector<Payload*> batch(BATCH);
+        for (size_t i = 0; i < BATCH; ++i) {
+            batch[i] = allocator.Acquire();
+            Touch(batch[i], i);
+        }
+        std::lock_guard<std::mutex> lock(handOff.mutex);
+        handOff.batches.push_back(std::move(batch));
+    }
+    std::lock_guard<std::mutex> lock(handOff.mutex);
+    --handOff.producersLeft;
+}
+
+template<typename Allocator>
+void RunConsumer(Allocator& allocator, HandOff& handOff) {
+    while (true) {
+        std::vector<Payload*> batch;
+        {
+            std::lock_guard<std::mutex> lock(handOff.mutex);
+            if (!handOff.batches.empty()) {
+                batch = std::move(handOff.batches.back());
+                handOff.batches.pop_back();
+            } else if (handOff.producersLeft == 0) {
+                return;
+            }
+        }
+        if (batch.empty()) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (Payload* object : batch) {
+            allocator.Release(object);
+        }
+    }
+}
+
+// Nanoseconds per acquire/release pair across all threads
+template<typename Allocator>
+double Measure(const char* pattern, int threads, size_t ops) {
+    Allocator allocator;
+    std::vector<std::thread> workers;
+    Clock::time_point start = Clock::now();
+
+    if (std::strcmp(pattern, "cross") == 0) {
+        HandOff handOff;
+        int producers = std::max(1, threads / 2);
+        handOff.producersLeft = static_cast<size_t>(producers);
+        for (int t = 0; t < producers; ++t) {
+            workers.emplace_back([&] { RunProducer(allocator, handOff, ops); });
+        }
+        for (int t = 0; t < std::max(1, threads - producers); ++t) {
+            workers.emplace_back([&] { RunConsumer(allocator, handOff); });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        ops *= static_cast<size_t>(producers);
+    } else {
+        bool pairs = std::strcmp(pattern, "pairs") == 0;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&] {
+                if (pairs) {
+                    RunPairs(allocator, ops);
+                } else {
+                    RunBatch(allocator, ops);
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        ops *= static_cast<size_t>(threads);
+    }
+
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    return ns / static_cast<double>(ops);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int threads = std::max(2u, std::thread::hardware_concurrency());
+    size_t ops = 2000000;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+            ops = static_cast<size_t>(std::max(1L, std::atol(argv[++i])));
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+    ops = std::max(BATCH, ops / BATCH * BATCH);
+
+    std::printf("%-8s %8s %14s %14s %8s\n", "pattern", "threads", "pool ns/op", "new ns/op", "ratio");
+    for (const char* pattern : { "pairs", "batch", "cross" }) {
+        for (int count : { 1, threads }) {
+            if (std::strcmp(pattern, "cross") == 0 && count < 2) continue;
+            double pool = Measure<PoolAllocator>(pattern, count, ops);
+            double heap = Measure<HeapAllocator>(pattern, count, ops);
+            std::printf("%-8s %8d %14.1f %14.1f %7.2fx\n", pattern, count, pool, heap, heap / pool);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,134 @@
+// matrix_presets: query the quality presets (see src/quality_presets.h).
+//
+//   matrix_presets list                                 the settings each preset changes from the defaults
+//   matrix_presets fit <timings.csv>                    fitted cost per preset, predicted at common resolutions
+//   matrix_presets choose <width>x<height> <ms> [csv]   the preset "auto" picks for a screen and budget
+//
+// Costs come from the preset_timings.csv a screensaver session writes to its
+// data directory: full frame times measured on that machine, so copy the file
+// from the machine in question. Without one every preset is uncalibrated and
+// "auto" stays on low-power.
+
+#include "quality_presets.h"
+#include "settings_schema.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct Resolution {
+    int width;
+    int height;
+};
+
+constexpr Resolution RESOLUTIONS[] = {
+    { 1280, 720 },
+    { 1920, 1080 },
+    { 2560, 1440 },
+    { 3840, 2160 },
+};
+
+void PrintUsage() {
+    std::fprintf(stderr, "usage: matrix_presets list\n"
+                         "       matrix_presets fit <timings.csv>\n"
+                         "       matrix_presets choose <width>x<height> <budget-ms> [timings.csv]\n");
+}
+
+// Narrow for printing; preset names are ASCII
+std::string Narrow(const wchar_t* text) {
+    std::string out;
+    for (; *text; ++text) {
+        out.push_back(static_cast<char>(*text));
+    }
+    return out;
+}
+
+int List() {
+    const MatrixSettings defaults;
+    for (size_t i = 0; i < QUALITY_PRESET_COUNT; ++i) {
+        const QualityPresetInfo& info = GetQualityPresetInfo(static_cast<QualityPreset>(i));
+        MatrixSettings settings;
+        ApplyQualityPreset(info.preset, settings);
+
+        std::printf("%-12s%s", Narrow(info.name).c_str(), IsAutoQualityPreset(info.preset) ? "" : " (never auto)");
+        for (const char* name : DiffSettings(defaults, settings)) {
+            std::printf(" %s", name);
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
+
+int Fit(const char* path) {
+    std::vector<PresetTiming> timings = LoadPresetTimings(path);
+    if (timings.empty()) {
+        std::fprintf(stderr, "no timings in %s\n", path);
+        return 1;
+    }
+    PresetCosts costs = FitPresetCosts(timings);
+
+    std::printf("%-12s %8s %8s %8s", "preset", "timings", "fixed", "ms/MP");
+    for (const Resolution& resolution : RESOLUTIONS) {
+        std::printf("  %7dx%-4d", resolution.width, resolution.height);
+    }
+    std::printf("\n");
+
+    for (size_t i = 0; i < QUALITY_PRESET_COUNT; ++i) {
+        const QualityPresetInfo& info = GetQualityPresetInfo(static_cast<QualityPreset>(i));
+        const PresetCost& cost = costs[i];
+        std::printf("%-12s %8u", Narrow(info.name).c_str(), cost.samples);
+        if (!cost.IsCalibrated()) {
+            std::printf("  uncalibrated\n");
+            continue;
+        }
+        std::printf(" %8.3f %8.3f", cost.fixedMs, cost.msPerMegapixel);
+        for (const Resolution& resolution : RESOLUTIONS) {
+            std::printf("  %9.3f ms", cost.Predict(resolution.width, resolution.height));
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
+
+int Choose(const char* size, const char* budget, const char* path) {
+    int width = 0;
+    int height = 0;
+    if (std::sscanf(size, "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+        PrintUsage();
+        return 2;
+    }
+    float budgetMs = std::strtof(budget, nullptr);
+
+    PresetCosts costs = FitPresetCosts(path ? LoadPresetTimings(path) : std::vector<PresetTiming>());
+    QualityPreset preset = ChooseQualityPreset(width, height, budgetMs, costs);
+    const QualityPresetInfo& info = GetQualityPresetInfo(preset);
+    const PresetCost& cost = costs[static_cast<size_t>(preset)];
+    if (!cost.IsCalibrated()) {
+        std::printf("%s (uncalibrated)\n", Narrow(info.name).c_str());
+        return 0;
+    }
+
+    float predicted = cost.Predict(width, height);
+    std::printf("%s (predicted %.3f ms of %.3f ms)%s\n", Narrow(info.name).c_str(), predicted, budgetMs,
+                predicted > budgetMs ? ", nothing fits" : "");
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc == 2 && std::strcmp(argv[1], "list") == 0) {
+        return List();
+    }
+    if (argc == 3 && std::strcmp(argv[1], "fit") == 0) {
+        return Fit(argv[2]);
+    }
+    if ((argc == 4 || argc == 5) && std::strcmp(argv[1], "choose") == 0) {
+        return Choose(argv[2], argv[3], argc == 5 ? argv[4] : nullptr);
+    }
+
+    PrintUsage();
+    return 2;
+}
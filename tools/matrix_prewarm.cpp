@@ -0,0 +1,154 @@
+// matrix_prewarm: time MatrixSimulation::FastForward and compare it with stepping.
+//
+//   matrix_prewarm [--size <width>x<height>] [--seconds <s>] [--runs <n>]
+//
+// Each run lays out two simulations with the same seed, fast-forwards one and
+// steps the other at 60 Hz for as long, then prints the fast-forward time and
+// the statistics of both scenes. Fails if a fast-forward takes longer than
+// its 10 ms budget, or if the scenes differ by more than 10% in cell count or
+// 0.05 in mean alpha. Defaults to 3 s on a 4K screen.
+
+#include "matrix_simulation.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr double BUDGET_MS = 10.0;
+constexpr double MAX_CELL_DIFFERENCE = 0.10;
+constexpr double MAX_ALPHA_DIFFERENCE = 0.05;
+
+struct SceneStats {
+    double cells = 0.0;
+    double alpha = 0.0;         // Mean over the cells
+    double age = 0.0;
+    double bands[3] = {};       // Share of the cells in the top, middle and bottom third
+    double visibleHeads = 0.0;
+};
+
+SceneStats Measure(const MatrixSimulation& simulation) {
+    SceneStats stats;
+    const std::vector<GridCell>& cells = simulation.GetActiveCells();
+    stats.cells = static_cast<double>(cells.size());
+
+    int rows = 1;
+    for (const GridCell& cell : cells) {
+        rows = std::max(rows, cell.y + 1);
+    }
+    for (const GridCell& cell : cells) {
+        stats.alpha += cell.GetAlpha();
+        stats.age += cell.GetAge();
+        stats.bands[std::min(2, cell.y * 3 / rows)] += 1.0;
+    }
+    if (!cells.empty()) {
+        stats.alpha /= stats.cells;
+        stats.age /= stats.cells;
+        for (double& band : stats.bands) {
+            band /= stats.cells;
+        }
+    }
+
+    for (const MatrixColumn& column : simulation.GetColumns()) {
+        if (column.headGlyph != INVALID_GLYPH) {
+            stats.visibleHeads += 1.0;
+        }
+    }
+    return stats;
+}
+
+void Accumulate(SceneStats& total, const SceneStats& stats) {
+    total.cells += stats.cells;
+    total.alpha += stats.alpha;
+    total.age += stats.age;
+    for (int i = 0; i < 3; ++i) {
+        total.bands[i] += stats.bands[i];
+    }
+    total.visibleHeads += stats.visibleHeads;
+}
+
+void Print(const char* label, const SceneStats& total, int runs) {
+    std::printf("%-13s cells %8.0f  alpha %.3f  age %.3f s  bands %.2f/%.2f/%.2f  heads %5.0f\n", label,
+                total.cells / runs, total.alpha / runs, total.age / runs,
+                total.bands[0] / runs, total.bands[1] / runs, total.bands[2] / runs, total.visibleHeads / runs);
+}
+
+void PrintUsage() {
+    std::fprintf(stderr, "usage: matrix_prewarm [--size <width>x<height>] [--seconds <s>] [--runs <n>]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int width = 3840;
+    int height = 2160;
+    float seconds = 3.0f;
+    int runs = 5;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                PrintUsage();
+                return 2;
+            }
+        } else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = std::strtof(argv[++i], nullptr);
+        } else if (std::strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = std::max(1, std::atoi(argv[++i]));
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    MatrixSettings settings;
+    GlyphTable::Instance().InternWord(settings.customWord);
+
+    using Clock = std::chrono::steady_clock;
+    constexpr float STEP = 1.0f / 60.0f;
+    int steps = static_cast<int>(std::lround(seconds / STEP));
+
+    SceneStats fastTotal;
+    SceneStats steppedTotal;
+    std::vector<double> fastMs;
+    double steppedMs = 0.0;
+
+    for (int run = 0; run < runs; ++run) {
+        uint32_t seed = 1000u + static_cast<uint32_t>(run);
+
+        MatrixSimulation fast;
+        fast.Initialize(settings, width, height, seed);
+        Clock::time_point start = Clock::now();
+        fast.FastForward(seconds);
+        fastMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        Accumulate(fastTotal, Measure(fast));
+
+        MatrixSimulation stepped;
+        stepped.Initialize(settings, width, height, seed);
+        start = Clock::now();
+        for (int step = 0; step < steps; ++step) {
+            stepped.Update(STEP);
+        }
+        steppedMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        Accumulate(steppedTotal, Measure(stepped));
+    }
+
+    std::sort(fastMs.begin(), fastMs.end());
+    std::printf("%dx%d, %.1f s, %d runs\n", width, height, seconds, runs);
+    std::printf("fast-forward  p50 %.3f ms  max %.3f ms (budget %.0f ms)\n", fastMs[fastMs.size() / 2], fastMs.back(), BUDGET_MS);
+    std::printf("stepping      mean %.3f ms for %d updates\n", steppedMs / runs, steps);
+    Print("fast-forward", fastTotal, runs);
+    Print("stepping", steppedTotal, runs);
+
+    double cellDifference = steppedTotal.cells > 0.0 ? std::fabs(fastTotal.cells - steppedTotal.cells) / steppedTotal.cells : 0.0;
+    double alphaDifference = std::fabs(fastTotal.alpha - steppedTotal.alpha) / runs;
+    bool withinBudget = fastMs.back() <= BUDGET_MS;
+    bool similar = cellDifference <= MAX_CELL_DIFFERENCE && alphaDifference <= MAX_ALPHA_DIFFERENCE;
+    std::printf("cells differ by %.1f%%, mean alpha by %.3f: %s\n", cellDifference * 100.0, alphaDifference,
+                !withinBudget ? "OVER BUDGET" : similar ? "ok" : "DIFFERENT");
+    return withinBudget && similar ? 0 : 1;
+}
@@ -0,0 +1,250 @@
+// matrix_replay: rerun a simulation capture (.mxrp) headlessly.
+//
+//   matrix_replay [--realtime] [--hashes] [--until <frame>] [--slowest <n>]
+//                 [--warm-start <file.mxws>] <file.mxrp>
+//
+// Feeds the recorded seed, settings, resizes, masks and frame times into
+// MatrixSimulation, checks the state hash at every recorded checkpoint, and
+// reports how long each Update took so the frames that stuttered in the field
+// can be found and profiled. Runs as fast as possible unless --realtime asks
+// for the original pacing. --warm-start saves the final scene as a warm start
+// (see sim_warm_start.h) and checks that it restores exactly. Builds on any
+// platform from the simulation sources.
+
+#include "matrix_simulation.h"
+#include "sim_capture.h"
+#include "sim_warm_start.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct FrameTiming {
+    uint64_t frame = 0;
+    double updateMs = 0.0;
+    size_t activeCells = 0;
+};
+
+bool ReadFile(const char* path, std::string& data) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) return false;
+
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+}
+
+void PrintUsage() {
+    std::fprintf(stderr, "usage: matrix_replay [--realtime] [--hashes] [--until <frame>] [--slowest <n>]\n"
+                         "                     [--warm-start <file.mxws>] <file.mxrp>\n");
+}
+
+double Percentile(std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// Save the scene, load it back over a fresh simulation with the same layout,
+// and compare the two states
+bool CheckWarmStart(const char* path, const MatrixSimulation& simulation) {
+    using Clock = std::chrono::steady_clock;
+    if (!SaveWarmStart(path, simulation)) {
+        std::fprintf(stderr, "matrix_replay: cannot write %s\n", path);
+        return false;
+    }
+
+    MatrixSimulation restored;
+    restored.Initialize(simulation.GetSettings(), simulation.GetWidth(), simulation.GetHeight(), simulation.GetSeed());
+    restored.SetQuality(simulation.GetQuality());
+
+    Clock::time_point start = Clock::now();
+    bool loaded = LoadWarmStart(path, restored);
+    double loadMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::string saved;
+    std::string reloaded;
+    EncodeWarmStart(simulation, saved);
+    EncodeWarmStart(restored, reloaded);
+    bool identical = loaded && saved == reloaded;
+
+    std::printf("warm start: %zu bytes, %zu cells, restored in %.3f ms, %s\n", saved.size(),
+                restored.GetActiveCells().size(), loadMs, !loaded ? "REJECTED" : identical ? "identical" : "DIFFERENT");
+    return identical;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool realtime = false;
+    bool printHashes = false;
+    uint64_t untilFrame = 0;
+    size_t slowestCount = 10;
+    const char* warmStartPath = nullptr;
+    const char* path = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--realtime") == 0) {
+            realtime = true;
+        } else if (std::strcmp(argv[i], "--hashes") == 0) {
+            printHashes = true;
+        } else if (std::strcmp(argv[i], "--until") == 0 && i + 1 < argc) {
+            untilFrame = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--slowest") == 0 && i + 1 < argc) {
+            slowestCount = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--warm-start") == 0 && i + 1 < argc) {
+            warmStartPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0) {
+            PrintUsage();
+            return 0;
+        } else if (!path) {
+            path = argv[i];
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    if (!path) {
+        PrintUsage();
+        return 2;
+    }
+
+    std::string data;
+    if (!ReadFile(path, data)) {
+        std::fprintf(stderr, "matrix_replay: cannot read %s\n", path);
+        return 1;
+    }
+
+    SimCaptureReader reader(data);
+    SimCaptureEvent event;
+    MatrixSimulation simulation;
+    bool initialized = false;
+
+    std::vector<FrameTiming> timings;
+    uint64_t frame = 0;
+    uint64_t checkpoints = 0;
+    uint64_t mismatches = 0;
+    double capturedSeconds = 0.0;
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+
+    while (reader.Next(event)) {
+        switch (event.kind) {
+            case SimCaptureRecordKind::Settings:
+                if (initialized) {
+                    simulation.UpdateSettings(event.settings, reader.GetVersion() < 3 ? SettingsInvalidation::All
+                                                                                      : SettingsInvalidation::None);
+                }
+                break;
+
+            case SimCaptureRecordKind::Initialize:
+                simulation.Initialize(event.settings, event.width, event.height, event.seed);
+                initialized = true;
+                std::printf("initialize %dx%d seed %u at frame %" PRIu64 "\n", event.width, event.height, event.seed, frame);
+                break;
+
+            case SimCaptureRecordKind::Resize:
+                simulation.Resize(event.width, event.height);
+                std::printf("resize %dx%d at frame %" PRIu64 "\n", event.width, event.height, frame);
+                break;
+
+            case SimCaptureRecordKind::DepthMap:
+                simulation.SetDepthMap(event.width, event.height, std::move(event.depthMap));
+                break;
+
+            case SimCaptureRecordKind::Frame: {
+                if (!initialized) break;
+
+                capturedSeconds += event.deltaTime;
+                if (realtime) {
+                    std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(
+                        std::chrono::duration<double>(capturedSeconds)));
+                }
+
+                Clock::time_point updateStart = Clock::now();
+                simulation.Update(event.deltaTime);
+                double updateMs = std::chrono::duration<double, std::milli>(Clock::now() - updateStart).count();
+
+                frame++;
+                timings.push_back({frame, updateMs, simulation.GetActiveCells().size()});
+                if (printHashes) {
+                    std::printf("frame %" PRIu64 " dt %.6f hash %016" PRIx64 "\n",
+                                frame, event.deltaTime, simulation.ComputeStateHash());
+                }
+                break;
+            }
+
+            case SimCaptureRecordKind::FastForward:
+                if (!initialized) break;
+                simulation.FastForward(event.deltaTime);
+                std::printf("fast-forward %.2f s at frame %" PRIu64 "\n", event.deltaTime, frame);
+                break;
+
+            case SimCaptureRecordKind::Quality:
+                simulation.SetQuality(event.quality);
+                std::printf("quality columns %.2f effects %.2f every %d at frame %" PRIu64 "\n",
+                            event.quality.columnFraction, event.quality.effectScale, event.quality.effectInterval, frame);
+                break;
+
+            case SimCaptureRecordKind::Checkpoint: {
+                checkpoints++;
+                uint64_t hash = simulation.ComputeStateHash();
+                if (event.frameIndex != frame || hash != event.stateHash) {
+                    if (mismatches == 0) {
+                        std::printf("DIVERGED at frame %" PRIu64 ": hash %016" PRIx64 ", captured %016" PRIx64 " (frame %" PRIu64 ")\n",
+                                    frame, hash, event.stateHash, event.frameIndex);
+                    }
+                    mismatches++;
+                }
+                break;
+            }
+        }
+
+        if (untilFrame != 0 && frame >= untilFrame) break;
+    }
+
+    if (reader.HasError()) {
+        std::fprintf(stderr, "matrix_replay: %s: %s\n", path, reader.GetError().c_str());
+    }
+
+    double wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::printf("%" PRIu64 " frames (%.1f s captured) replayed in %.3f s\n", frame, capturedSeconds, wallSeconds);
+    std::printf("checkpoints: %" PRIu64 " checked, %" PRIu64 " mismatched\n", checkpoints, mismatches);
+    if (mismatches > 0 && reader.GetVersion() < SIM_CAPTURE_VERSION) {
+        std::printf("(captures before version %d drew glyphs differently and are not expected to match)\n",
+                    static_cast<int>(SIM_CAPTURE_VERSION));
+    }
+
+    if (!timings.empty()) {
+        std::vector<double> sorted;
+        sorted.reserve(timings.size());
+        for (const FrameTiming& timing : timings) {
+            sorted.push_back(timing.updateMs);
+        }
+        std::sort(sorted.begin(), sorted.end());
+        std::printf("update ms: p50 %.4f  p95 %.4f  p99 %.4f  max %.4f\n",
+                    Percentile(sorted, 0.50), Percentile(sorted, 0.95), Percentile(sorted, 0.99), sorted.back());
+
+        size_t count = std::min(slowestCount, timings.size());
+        std::partial_sort(timings.begin(), timings.begin() + count, timings.end(),
+                          [](const FrameTiming& a, const FrameTiming& b) { return a.updateMs > b.updateMs; });
+        for (size_t i = 0; i < count; ++i) {
+            std::printf("  slow frame %" PRIu64 ": %.4f ms, %zu active cells\n",
+                        timings[i].frame, timings[i].updateMs, timings[i].activeCells);
+        }
+    }
+
+    bool warmStartFailed = warmStartPath && initialized && !CheckWarmStart(warmStartPath, simulation);
+
+    return (reader.HasError() || mismatches > 0 || warmStartFailed) ? 1 : 0;
+}
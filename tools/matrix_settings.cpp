@@ -0,0 +1,129 @@
+// matrix_settings: check, compile and watch settings files (see src/settings_store.h).
+//
+//   matrix_settings defaults                 print a settings file with every default
+//   matrix_settings check <settings.ini>     report rejected lines
+//   matrix_settings compile <settings.ini>   refresh the .bin snapshot next to it
+//   matrix_settings dump <settings.ini>      print the settings as loaded
+//   matrix_settings watch <settings.ini>     print the settings that change on each save
+//
+// Lets a fleet's settings be prepared and validated before they are copied
+// out, on any platform, with the same code the screensaver loads them with.
+
+#include "settings_schema.h"
+#include "settings_store.h"
+#include "settings_watcher.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+namespace {
+
+bool ReadFile(const char* path, std::string& data) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) return false;
+
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+}
+
+void PrintUsage() {
+    std::fprintf(stderr, "usage: matrix_settings defaults\n"
+                         "       matrix_settings check|compile|dump|watch <settings.ini>\n");
+}
+
+MatrixSettings GetDefaults() {
+    MatrixSettings settings;
+    ParseSettingsText({}, settings);
+    return settings;
+}
+
+bool Load(SettingsStore& store, MatrixSettings& settings) {
+    if (!store.Load(settings)) {
+        std::fprintf(stderr, "matrix_settings: cannot read %s\n", store.GetTextPath().string().c_str());
+        return false;
+    }
+    for (const std::string& error : store.GetErrors()) {
+        std::fprintf(stderr, "%s: %s\n", store.GetTextPath().string().c_str(), error.c_str());
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc == 2 && std::strcmp(argv[1], "defaults") == 0) {
+        std::fputs(FormatSettingsText(GetDefaults()).c_str(), stdout);
+        return 0;
+    }
+    if (argc != 3) {
+        PrintUsage();
+        return 2;
+    }
+
+    const char* command = argv[1];
+    const char* path = argv[2];
+
+    if (std::strcmp(command, "check") == 0) {
+        std::string text;
+        if (!ReadFile(path, text)) {
+            std::fprintf(stderr, "matrix_settings: cannot read %s\n", path);
+            return 1;
+        }
+        MatrixSettings settings;
+        std::vector<std::string> errors;
+        bool valid = ParseSettingsText(text, settings, &errors);
+        for (const std::string& error : errors) {
+            std::fprintf(stderr, "%s: %s\n", path, error.c_str());
+        }
+        std::printf("%s: %s\n", path, valid ? "ok" : "invalid");
+        return valid ? 0 : 1;
+    }
+
+    SettingsStore store(path);
+    MatrixSettings settings = GetDefaults();
+
+    if (std::strcmp(command, "compile") == 0) {
+        if (!Load(store, settings)) return 1;
+        const char* state = !store.GetErrors().empty() ? "not compiled, fix the errors above" :
+                            store.LoadedFromSnapshot() ? "up to date" : "compiled";
+        std::printf("%s: %s\n", store.GetSnapshotPath().string().c_str(), state);
+        return store.GetErrors().empty() ? 0 : 1;
+    }
+
+    if (std::strcmp(command, "dump") == 0) {
+        if (!Load(store, settings)) return 1;
+        std::fputs(FormatSettingsText(settings).c_str(), stdout);
+        return 0;
+    }
+
+    if (std::strcmp(command, "watch") == 0) {
+        if (!Load(store, settings)) return 1;
+
+        SettingsWatcher watcher(path);
+        if (!watcher.Start()) {
+            std::fprintf(stderr, "matrix_settings: cannot watch %s\n", path);
+            return 1;
+        }
+        std::printf("watching %s\n", path);
+        std::fflush(stdout);
+
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            if (!watcher.ConsumeChange()) continue;
+
+            MatrixSettings updated = settings;
+            if (!Load(store, updated)) continue;
+            for (const char* name : DiffSettings(settings, updated)) {
+                std::printf("changed %s\n", name);
+            }
+            std::fflush(stdout);
+            settings = updated;
+        }
+    }
+
+    PrintUsage();
+    return 2;
+}